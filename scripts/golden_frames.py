@@ -0,0 +1,171 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+オフスクリーン描画フレームのゴールデン画像比較スクリプト
+
+/api/render で6パレット×4表情のフレーム（画面サイズの RGB565 BMP）を取得し、
+ゴールデン画像（PNG）と比較します。
+ゴールデン画像はホストのテスト（test/test_frame_renderer）と共通です。/api/renderbench で描画fpsも表示します。
+
+使い方:
+    python3 scripts/golden_frames.py 192.168.1.100 --update   # ゴールデン画像を作成・更新
+    python3 scripts/golden_frames.py 192.168.1.100            # 比較（差分があれば終了コード1）
+    python3 scripts/golden_frames.py 192.168.1.100 --bench 120
+
+標準ライブラリのみで動作します。
+"""
+
+import argparse
+import json
+import os
+import struct
+import sys
+import urllib.parse
+import urllib.request
+import zlib
+
+PALETTES = 6
+EXPRESSIONS = 4
+GOLDEN_TEXT = "こんにちは、スタックチャンです"
+
+
+def fetch(host, path, params, timeout=30):
+    url = "http://%s%s?%s" % (host, path, urllib.parse.urlencode(params))
+    with urllib.request.urlopen(url, timeout=timeout) as res:
+        return res.read()
+
+
+def decode_bmp565(data):
+    """/api/render のBMP（16bit BI_BITFIELDS, トップダウン）を RGB888 の行リストにする"""
+    if data[:2] != b"BM":
+        raise ValueError("BMPではありません")
+    offset = struct.unpack_from("<I", data, 10)[0]
+    width, height = struct.unpack_from("<ii", data, 18)
+    bpp = struct.unpack_from("<H", data, 28)[0]
+    if bpp != 16:
+        raise ValueError("16bit BMPのみ対応しています (bpp=%d)" % bpp)
+    top_down = height < 0
+    height = abs(height)
+    stride = (width * 2 + 3) & ~3
+    rows = []
+    for y in range(height):
+        row = bytearray()
+        base = offset + y * stride
+        for x in range(width):
+            v = struct.unpack_from("<H", data, base + x * 2)[0]
+            r = (v >> 11) & 0x1F
+            g = (v >> 5) & 0x3F
+            b = v & 0x1F
+            row += bytes(((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2)))
+        rows.append(bytes(row))
+    if not top_down:
+        rows.reverse()
+    return width, height, rows
+
+
+def write_png(path, width, height, rows):
+    def chunk(kind, body):
+        c = struct.pack(">I", len(body)) + kind + body
+        return c + struct.pack(">I", zlib.crc32(kind + body) & 0xFFFFFFFF)
+
+    raw = b"".join(b"\x00" + r for r in rows)
+    with open(path, "wb") as f:
+        f.write(b"\x89PNG\r\n\x1a\n")
+        f.write(chunk(b"IHDR", struct.pack(">IIBBBBB", width, height, 8, 2, 0, 0, 0)))
+        f.write(chunk(b"IDAT", zlib.compress(raw, 9)))
+        f.write(chunk(b"IEND", b""))
+
+
+def read_png(path):
+    """write_png で書いたPNG（8bit RGB, フィルタなし）を読む"""
+    with open(path, "rb") as f:
+        data = f.read()
+    pos = 8
+    idat = b""
+    width = height = 0
+    while pos < len(data):
+        length = struct.unpack_from(">I", data, pos)[0]
+        kind = data[pos + 4:pos + 8]
+        body = data[pos + 8:pos + 8 + length]
+        if kind == b"IHDR":
+            width, height, depth, ctype = struct.unpack_from(">IIBB", body)
+            if depth != 8 or ctype != 2:
+                raise ValueError("8bit RGB のPNGのみ対応しています: %s" % path)
+        elif kind == b"IDAT":
+            idat += body
+        pos += 12 + length
+    raw = zlib.decompress(idat)
+    stride = width * 3 + 1
+    rows = []
+    for y in range(height):
+        line = raw[y * stride:(y + 1) * stride]
+        if line[0] != 0:
+            raise ValueError("フィルタ付きPNGには対応していません: %s" % path)
+        rows.append(line[1:])
+    return width, height, rows
+
+
+def diff_pixels(rows_a, rows_b):
+    count = 0
+    for a, b in zip(rows_a, rows_b):
+        for x in range(0, len(a), 3):
+            if a[x:x + 3] != b[x:x + 3]:
+                count += 1
+    return count
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Stack-chan フレームのゴールデン画像比較")
+    parser.add_argument("host", help="スタックチャンのIPアドレス")
+    parser.add_argument("--golden", default=os.path.join(os.path.dirname(__file__), os.pardir,
+                                                         "test", "test_frame_renderer", "golden"),
+                        help="ゴールデン画像の保存先（既定はホストテストと共通の test/test_frame_renderer/golden）")
+    parser.add_argument("--update", action="store_true", help="ゴールデン画像を作り直す")
+    parser.add_argument("--tolerance", type=int, default=0, help="許容する差分ピクセル数")
+    parser.add_argument("--bench", type=int, default=0, metavar="FRAMES", help="描画ベンチマークのフレーム数")
+    args = parser.parse_args()
+
+    os.makedirs(args.golden, exist_ok=True)
+    failed = 0
+
+    for palette in range(PALETTES):
+        for expression in range(EXPRESSIONS):
+            name = "palette%d_expr%d.png" % (palette, expression)
+            golden_path = os.path.join(args.golden, name)
+            bmp = fetch(args.host, "/api/render",
+                        {"palette": palette, "expression": expression, "text": GOLDEN_TEXT})
+            width, height, rows = decode_bmp565(bmp)
+
+            if args.update or not os.path.exists(golden_path):
+                write_png(golden_path, width, height, rows)
+                print("保存: %s" % name)
+                continue
+
+            gw, gh, grows = read_png(golden_path)
+            if (gw, gh) != (width, height):
+                print("NG  : %s サイズ不一致 %dx%d != %dx%d" % (name, width, height, gw, gh))
+                failed += 1
+                continue
+
+            diff = diff_pixels(rows, grows)
+            if diff > args.tolerance:
+                actual_path = os.path.join(args.golden, "actual_" + name)
+                write_png(actual_path, width, height, rows)
+                print("NG  : %s 差分 %d px（%s に保存）" % (name, diff, actual_path))
+                failed += 1
+            else:
+                print("OK  : %s" % name)
+
+    if args.bench > 0:
+        result = json.loads(fetch(args.host, "/api/renderbench", {"frames": args.bench}, timeout=120))
+        print("描画ベンチ: %d frames, 平均 %d us/frame, 最大 %d us, %.1f fps (%d bands/frame)" % (
+            result["frames"], result["avg_frame_us"], result["max_frame_us"],
+            result["fps"], result["bands_per_frame"]))
+
+    if failed:
+        print("%d 枚のフレームがゴールデン画像と一致しませんでした" % failed)
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,87 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+loop() の応答遅延（HTTP接続の検知 → 応答送信完了）とボタン操作が画面に出るまでの遅延を測るスクリプト
+
+/api/loop?reset=1 で集計を空にしてから、間隔を空けて HTTP リクエストを送り（loop() が待機に入ってから届くように）、
+端末側の集計（request_latency_us / input_latency_us）と、こちらから見た往復時間をまとめて表示します。
+--presses を指定すると、その回数だけボタンAが押されるまで待ってボタンの遅延も読みます。
+
+イベント駆動（既定）と従来の delay(50) ループ（-DLOOP_EVENT_DRIVEN=0 でビルド）をそれぞれ書き込んで
+同じ条件で実行すると、前後の比較になります。
+
+使い方:
+    python3 scripts/measure_loop_latency.py --host 192.168.1.100
+    python3 scripts/measure_loop_latency.py --host 192.168.1.100 --requests 100 --presses 20
+
+標準ライブラリのみで動作します。
+"""
+
+import argparse
+import json
+import sys
+import time
+import urllib.request
+
+
+def get_loop(base, reset=False):
+    url = base + "/api/loop" + ("?reset=1" if reset else "")
+    with urllib.request.urlopen(url, timeout=5) as response:
+        return json.loads(response.read().decode("utf-8"))
+
+
+def percentile(values, p):
+    if not values:
+        return 0.0
+    ordered = sorted(values)
+    index = min(len(ordered) - 1, int(round(p / 100.0 * (len(ordered) - 1))))
+    return ordered[index]
+
+
+def main():
+    parser = argparse.ArgumentParser(description="loop() の応答・ボタン遅延を測る")
+    parser.add_argument("--host", required=True, help="スタックチャンのIPアドレス")
+    parser.add_argument("--port", type=int, default=80)
+    parser.add_argument("--requests", type=int, default=50, help="送るリクエスト数")
+    parser.add_argument("--interval", type=float, default=0.2, help="リクエストの間隔（秒）")
+    parser.add_argument("--presses", type=int, default=0, help="待つボタンAの押下回数（0: 測らない）")
+    parser.add_argument("--timeout", type=float, default=120.0, help="ボタンを待つ上限（秒）")
+    args = parser.parse_args()
+
+    base = "http://%s:%d" % (args.host, args.port)
+    get_loop(base, reset=True)
+
+    round_trips_ms = []
+    for _ in range(args.requests):
+        time.sleep(args.interval)
+        start = time.perf_counter()
+        get_loop(base)
+        round_trips_ms.append((time.perf_counter() - start) * 1000.0)
+
+    loop = get_loop(base)
+    if args.presses > 0:
+        wanted = loop["input_latency_us"]["count"] + args.presses
+        print("ボタンAを %d 回押してください（1回ごとに少し間を空ける）" % args.presses)
+        deadline = time.time() + args.timeout
+        while loop["input_latency_us"]["count"] < wanted:
+            if time.time() > deadline:
+                print("ボタンの押下が足りないまま時間切れになりました", file=sys.stderr)
+                break
+            time.sleep(1.0)
+            loop = get_loop(base)
+
+    request = loop["request_latency_us"]
+    button = loop["input_latency_us"]
+    print("loop: %s" % ("イベント駆動" if loop["event_driven"] else "delay(50) 周期"))
+    print("HTTP 接続検知 → 応答送信: %d回 平均 %.2fms 最大 %.2fms" %
+          (request["count"], request["avg"] / 1000.0, request["max"] / 1000.0))
+    print("HTTP 往復（こちらから）: 中央値 %.2fms p95 %.2fms 最大 %.2fms" %
+          (percentile(round_trips_ms, 50), percentile(round_trips_ms, 95), max(round_trips_ms or [0.0])))
+    if args.presses > 0:
+        print("ボタン → 画面: %d回 平均 %.2fms 最大 %.2fms" %
+              (button["count"], button["avg"] / 1000.0, button["max"] / 1000.0))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
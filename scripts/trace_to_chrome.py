@@ -0,0 +1,142 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+/api/trace のバイナリダンプを Chrome Trace Event JSON に変換するスクリプト
+
+出力は chrome://tracing または https://ui.perfetto.dev で開けます。
+タスクごとに1行（tid）で表示され、区間は B/E、単発イベントは i になります。
+
+使い方:
+    python3 scripts/trace_to_chrome.py --host 192.168.1.100 -o trace.json   # 取得して変換
+    curl -o stackchan.trace http://192.168.1.100/api/trace
+    python3 scripts/trace_to_chrome.py stackchan.trace -o trace.json          # 保存済みのダンプを変換
+
+標準ライブラリのみで動作します。
+"""
+
+import argparse
+import json
+import struct
+import sys
+import urllib.request
+
+MAGIC = b"STKT"
+VERSION = 1
+NAME_LEN = 16
+
+BUTTON_NAMES = ["A", "B", "C"]
+BUTTON_EVENT_NAMES = ["press", "hold", "release"]
+POWER_LEVEL_NAMES = ["active", "dim", "sleep"]
+
+
+def fetch(host, timeout=30):
+    url = "http://%s/api/trace" % host
+    with urllib.request.urlopen(url, timeout=timeout) as res:
+        return res.read()
+
+
+def read_names(data, offset):
+    count = data[offset]
+    offset += 1
+    names = []
+    for i in range(count):
+        raw = data[offset:offset + NAME_LEN]
+        names.append(raw.split(b"\x00", 1)[0].decode("utf-8", "replace"))
+        offset += NAME_LEN
+    return names, offset
+
+
+def parse_dump(data):
+    """ダンプを (tasks, events, overwritten, records) にする。records は (ts_us, phase, task, event, arg)"""
+    if data[:4] != MAGIC:
+        raise ValueError("トレースのダンプではありません")
+    version, record_size, count, overwritten = struct.unpack_from("<HHII", data, 4)
+    if version != VERSION:
+        raise ValueError("未対応のバージョンです (version=%d)" % version)
+    offset = 16
+    tasks, offset = read_names(data, offset)
+    events, offset = read_names(data, offset)
+
+    records = []
+    for i in range(count):
+        ts, phase, task, event, arg = struct.unpack_from("<IBBBB", data, offset)
+        records.append((ts, chr(phase), task, event, arg))
+        offset += record_size
+    return tasks, events, overwritten, records
+
+
+def unwrap_timestamps(records):
+    """32ビットのマイクロ秒（約71分で一周）を単調増加に直す"""
+    result = []
+    base = 0
+    last = None
+    for ts, phase, task, event, arg in records:
+        if last is not None and ts < last:
+            base += 1 << 32
+        last = ts
+        result.append((base + ts, phase, task, event, arg))
+    return result
+
+
+def describe_arg(name, arg):
+    if name == "button":
+        button, kind = arg & 0x0F, arg >> 4
+        if button < len(BUTTON_NAMES) and kind < len(BUTTON_EVENT_NAMES):
+            return "%s %s" % (BUTTON_NAMES[button], BUTTON_EVENT_NAMES[kind])
+    if name == "power_level" and arg < len(POWER_LEVEL_NAMES):
+        return POWER_LEVEL_NAMES[arg]
+    return arg
+
+
+def to_chrome(tasks, events, records, pid=1):
+    trace = [{"name": "process_name", "ph": "M", "pid": pid, "args": {"name": "Stack-chan"}}]
+    used = sorted(set(r[2] for r in records))
+    for tid in used:
+        name = tasks[tid] if tid < len(tasks) and tasks[tid] else "task%d" % tid
+        trace.append({"name": "thread_name", "ph": "M", "pid": pid, "tid": tid, "args": {"name": name}})
+
+    for ts, phase, task, event, arg in records:
+        name = events[event] if event < len(events) else "event%d" % event
+        e = {"name": name, "ph": phase, "ts": ts, "pid": pid, "tid": task}
+        if phase == "i":
+            e["s"] = "t"
+            e["args"] = {"arg": describe_arg(name, arg)}
+        trace.append(e)
+    return {"traceEvents": trace, "displayTimeUnit": "ms"}
+
+
+def main():
+    parser = argparse.ArgumentParser(description="/api/trace のダンプを Chrome Trace Event JSON に変換")
+    parser.add_argument("dump", nargs="?", help="保存済みのダンプファイル")
+    parser.add_argument("--host", help="スタックチャンのIPアドレス（指定するとダンプを取得する）")
+    parser.add_argument("-o", "--output", default="trace.json", help="出力ファイル（既定: trace.json）")
+    args = parser.parse_args()
+
+    if args.host:
+        data = fetch(args.host)
+    elif args.dump:
+        with open(args.dump, "rb") as f:
+            data = f.read()
+    else:
+        parser.error("ダンプファイルか --host を指定してください")
+
+    try:
+        tasks, events, overwritten, records = parse_dump(data)
+    except (ValueError, struct.error) as e:
+        print("エラー: %s" % e, file=sys.stderr)
+        return 1
+
+    records = unwrap_timestamps(records)
+    with open(args.output, "w") as f:
+        json.dump(to_chrome(tasks, events, records), f)
+
+    span_ms = (records[-1][0] - records[0][0]) / 1000.0 if records else 0
+    print("%d レコード, %d タスク, %.1f ms -> %s" % (len(records), len(set(r[2] for r in records)), span_ms,
+                                                  args.output))
+    if overwritten:
+        print("注意: リングが一周して古い %d レコードが上書きされています" % overwritten)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,21 @@
+/*
+ * App Clock for Stack-chan
+ * 実機の時計（millis()・micros()・delay() が元）
+ */
+
+#include "app_clock.h"
+#include <Arduino.h>
+
+static uint32_t arduinoMillis() {
+  return millis();
+}
+
+static uint32_t arduinoMicros() {
+  return micros();
+}
+
+static void arduinoDelay(uint32_t ms) {
+  delay(ms);
+}
+
+AppClock app_clock(arduinoMillis, arduinoMicros, arduinoDelay);
@@ -0,0 +1,58 @@
+/*
+ * App Clock for Stack-chan
+ * main.cpp の周期処理（セリフの自動クリア・ランダムセリフ・WiFi監視・システム監視・起動時の接続待ち）が読む時計
+ * 時刻の元（既定は millis() と micros()）と待ち（既定は delay()）を差し替えられ、advance() で周期処理の時計だけ先へ進められる
+ * ホスト上では仮想時計を元にして1日分の動作を数秒で回し、実機では /api/clock（APP_CLOCK_DEBUG_API=1 のときだけ）で周期処理を早回しする
+ * 通信の待ち時間・稼働時間は uptime() で測る（advance() で進めても接続を待たずに諦めたりしない）
+ * Arduino に依存しないので、ホスト上でもそのまま動かせる
+ */
+
+#ifndef APP_CLOCK_H
+#define APP_CLOCK_H
+
+#include <stdint.h>
+
+// 1 で /api/clock を登録する（LAN の誰でも周期処理の時計を進められるので、デバッグ・テスト用のビルドだけで有効にする）
+#ifndef APP_CLOCK_DEBUG_API
+#define APP_CLOCK_DEBUG_API 0
+#endif
+
+#define APP_CLOCK_MAX_ADVANCE_MS 86400000L  // /api/clock で一度に進められる上限（1日）
+
+typedef uint32_t (*ClockSource)();
+typedef void (*ClockDelay)(uint32_t ms);
+
+class AppClock {
+public:
+  constexpr AppClock(ClockSource source, ClockSource source_us, ClockDelay wait)
+    : source(source), source_us(source_us), wait(wait), offset_ms(0) {}
+
+  // 周期処理の時刻（ms、元の時計 + 進めた分。millis() と同じく約49日で一周する）
+  uint32_t now() const { return source() + offset_ms; }
+  // 起動からの経過時間（ms、進めた分を含まない。通信の待ち時間・稼働時間の表示に使う）
+  uint32_t uptime() const { return source(); }
+  // 起動からの経過時間（us、約71分で一周する。処理時間の計測に使う）
+  uint32_t uptimeUs() const { return source_us(); }
+  // ms だけ待つ（ホストの仮想時計なら待たずに時計を進める）
+  void delay(uint32_t ms) const { wait(ms); }
+
+  // 時刻の元と待ちを差し替える（ホストの仮想時計など）
+  void setSource(ClockSource s, ClockSource s_us, ClockDelay d) {
+    source = s;
+    source_us = s_us;
+    wait = d;
+  }
+  // 時計を ms だけ進める（期限の来た周期処理は次の run() でまとめて実行される）
+  void advance(uint32_t ms) { offset_ms += ms; }
+  uint32_t offset() const { return offset_ms; }
+
+private:
+  ClockSource source;
+  ClockSource source_us;
+  ClockDelay wait;
+  uint32_t offset_ms;  // 書くのは loop タスクだけ
+};
+
+extern AppClock app_clock;
+
+#endif
@@ -0,0 +1,191 @@
+/*
+ * App State for Stack-chan
+ * Seqlock で守った状態の読み書きと、変化の配信
+ */
+
+#include "app_state.h"
+#include <esp_timer.h>
+
+AppStateStore app_state;
+
+// 配信の計測値だけを守る（購読者はロックの外で呼ぶ）
+static portMUX_TYPE dispatch_mux = portMUX_INITIALIZER_UNLOCKED;
+// 書き手の登録（登録は1回だけなので、引くときも同じロックで済ませる）
+static portMUX_TYPE writer_lock = portMUX_INITIALIZER_UNLOCKED;
+
+AppStateStore::AppStateStore() : next_stamp(0), reads(0), read_retries(0), read_yields(0) {
+  memset(&local, 0, sizeof(local));
+  writes = 0;
+  events = 0;
+  deliveries = 0;
+  memset(&dispatch, 0, sizeof(dispatch));
+  dispatch_total_us = 0;
+  writer_task = nullptr;
+  // 初期値（通し番号 0 のまま）
+  strncpy(local.state.message, "スタックちゃん", sizeof(local.state.message) - 1);
+  slot.write(local);
+}
+
+void AppStateStore::begin() {
+  registerWriter();
+}
+
+void AppStateStore::registerWriter() {
+  TaskHandle_t task = xTaskGetCurrentTaskHandle();
+  portENTER_CRITICAL(&writer_lock);
+  // 別のタスクも書くと、書き込み1つの Seqlock が壊れる
+  bool taken = writer_task != nullptr && writer_task != task;
+  if (!taken) writer_task = task;
+  portEXIT_CRITICAL(&writer_lock);
+  configASSERT(!taken);
+}
+
+// 登録した書き手のタスクか（begin() の前、setup() の最初はどのタスクからでも書ける）
+void AppStateStore::checkWriter() const {
+  TaskHandle_t task = xTaskGetCurrentTaskHandle();
+  portENTER_CRITICAL(&writer_lock);
+  bool ok = writer_task == nullptr || writer_task == task;
+  portEXIT_CRITICAL(&writer_lock);
+  configASSERT(ok);
+}
+
+AppStateStore::Slot& AppStateStore::beginWrite(AppStateField field) {
+  checkWriter();
+  local.stamps[field] = next_stamp.fetch_add(1, std::memory_order_relaxed) + 1;
+  return local;
+}
+
+// 枠に書いてから購読者へ配る（購読者が snapshot() を読めば、この変化はもう見える）
+void AppStateStore::publish(AppStateField field, int32_t value, const char* text, uint16_t arg) {
+  slot.write(local);
+  writes++;
+
+  StateEvent event;
+  event.type = field;
+  event.reserved = 0;
+  event.arg = arg;
+  event.value = value;
+  event.text = text;
+  event.version = local.stamps[field];
+
+  int64_t start = esp_timer_get_time();
+  uint32_t delivered = state_bus.publish(event);
+  uint32_t us = (uint32_t)(esp_timer_get_time() - start);
+
+  portENTER_CRITICAL(&dispatch_mux);
+  events++;
+  deliveries += delivered;
+  LoopEvents::recordLatency(dispatch, dispatch_total_us, us);
+  portEXIT_CRITICAL(&dispatch_mux);
+}
+
+void AppStateStore::setMessage(const char* text) {
+  Slot& s = beginWrite(APP_FIELD_MESSAGE);
+  strncpy(s.state.message, text ? text : "", sizeof(s.state.message) - 1);
+  s.state.message[sizeof(s.state.message) - 1] = '\0';
+  publish(APP_FIELD_MESSAGE, 0, s.state.message);
+}
+
+void AppStateStore::setExpression(int value, uint16_t duration_ms) {
+  beginWrite(APP_FIELD_EXPRESSION).state.expression = value;
+  publish(APP_FIELD_EXPRESSION, value, nullptr, duration_ms);
+}
+
+int AppStateStore::cycleExpression(uint16_t duration_ms) {
+  int value = (local.state.expression + 1) % FACE_EXPRESSION_COUNT;
+  setExpression(value, duration_ms);
+  return value;
+}
+
+void AppStateStore::setSpeechByUser(bool by_user) {
+  beginWrite(APP_FIELD_USER_SPEECH).state.speech_set_by_user = by_user;
+  publish(APP_FIELD_USER_SPEECH, by_user);
+}
+
+void AppStateStore::setSpeaking(bool speaking) {
+  beginWrite(APP_FIELD_SPEAKING).state.is_speaking = speaking;
+  publish(APP_FIELD_SPEAKING, speaking);
+}
+
+void AppStateStore::setRandomSpeech(bool enabled) {
+  beginWrite(APP_FIELD_RANDOM_SPEECH).state.random_speech_enabled = enabled;
+  publish(APP_FIELD_RANDOM_SPEECH, enabled);
+}
+
+void AppStateStore::setWiFi(bool connected, const char* ip) {
+  Slot& s = beginWrite(APP_FIELD_WIFI);
+  s.state.wifi_connected = connected;
+  strncpy(s.state.ip, connected && ip ? ip : "", sizeof(s.state.ip) - 1);
+  s.state.ip[sizeof(s.state.ip) - 1] = '\0';
+  publish(APP_FIELD_WIFI, connected, s.state.ip);
+}
+
+void AppStateStore::setBleMode(bool ble) {
+  beginWrite(APP_FIELD_BLE_MODE).state.connection_mode_ble = ble;
+  publish(APP_FIELD_BLE_MODE, ble);
+}
+
+void AppStateStore::setBleEnabled(bool enabled) {
+  beginWrite(APP_FIELD_BLE_ENABLED).state.ble_enabled = enabled;
+  publish(APP_FIELD_BLE_ENABLED, enabled);
+}
+
+// 書き込みと重なったら読み直す（書き込みは数百バイトのコピーだけなので、普通は1回で読める）
+void AppStateStore::readSlot(Slot& out) const {
+  uint32_t retries = 0;
+  while (!slot.tryRead(out)) {
+    if (++retries % APP_STATE_READ_SPINS == 0) {
+      // 同じコアの低い優先度のタスクが書きかけのまま止まっている
+      read_yields.fetch_add(1, std::memory_order_relaxed);
+      vTaskDelay(1);
+    }
+  }
+  if (retries) read_retries.fetch_add(retries, std::memory_order_relaxed);
+}
+
+void AppStateStore::snapshot(AppState& out) const {
+  Slot current;
+  readSlot(current);
+  reads.fetch_add(1, std::memory_order_relaxed);
+
+  // 版数は項目ごとの通し番号のうち最新のもの
+  current.state.version = 0;
+  for (int f = 0; f < APP_FIELD_COUNT; f++) {
+    if (current.stamps[f] > current.state.version) current.state.version = current.stamps[f];
+  }
+  out = current.state;
+}
+
+AppState AppStateStore::snapshot() const {
+  AppState state;
+  snapshot(state);
+  return state;
+}
+
+AppStateStats AppStateStore::getStats() const {
+  AppStateStats s;
+  s.writes = writes;
+  s.reads = reads.load(std::memory_order_relaxed);
+  s.read_retries = read_retries.load(std::memory_order_relaxed);
+  s.read_yields = read_yields.load(std::memory_order_relaxed);
+  portENTER_CRITICAL(&dispatch_mux);
+  s.events = events;
+  s.deliveries = deliveries;
+  s.dispatch = dispatch;
+  portEXIT_CRITICAL(&dispatch_mux);
+  return s;
+}
+
+const char* AppStateStore::fieldName(uint8_t field) {
+  switch (field) {
+    case APP_FIELD_MESSAGE:       return "message";
+    case APP_FIELD_EXPRESSION:    return "expression";
+    case APP_FIELD_USER_SPEECH:   return "speech_set_by_user";
+    case APP_FIELD_SPEAKING:      return "is_speaking";
+    case APP_FIELD_RANDOM_SPEECH: return "random_speech_enabled";
+    case APP_FIELD_WIFI:          return "wifi";
+    case APP_FIELD_BLE_MODE:      return "connection_mode_ble";
+    case APP_FIELD_BLE_ENABLED:   return "ble_enabled";
+    default:                      return "unknown";
+  }
+}
@@ -0,0 +1,137 @@
+/*
+ * App State for Stack-chan
+ * セリフ・表情・通信状態など、複数のタスクが読み書きする状態を1つの版数付き構造体にまとめる
+ * 書き込むのは loop タスクだけ（BLE の要求も loop() で反映する）で、Seqlock で守った1つの枠に書く
+ * 書き手は registerWriter() で登録し、別のタスクから書くと configASSERT で止める
+ * 書き込みは誰も待たず、読み出し（HTTP・BLE の応答、HTML、周期処理）はロックを取らない
+ * 書き込むたびに変化を StateEvent として state_bus の購読者へ配る（描画への反映・ログなどは購読者の側に置く）
+ */
+
+#ifndef APP_STATE_H
+#define APP_STATE_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "loop_events.h"
+#include "seqlock.h"
+#include "event_bus.h"
+#include "avatar_commands.h"
+#include "speech_balloon.h"
+
+// 1 にすると状態の変化をすべてシリアルに出す（購読者 "log"）
+#ifndef STATE_EVENT_LOG
+#define STATE_EVENT_LOG 0
+#endif
+
+#define APP_STATE_READ_SPINS 64  // 読み直しがこの回数続いたら1tick 譲る（同じコアの書き込みを先に進める）
+
+// 書き込みの単位（項目ごとに通し番号を持つ）
+enum AppStateField {
+  APP_FIELD_MESSAGE = 0,   // message
+  APP_FIELD_EXPRESSION,    // expression
+  APP_FIELD_USER_SPEECH,   // speech_set_by_user
+  APP_FIELD_SPEAKING,      // is_speaking
+  APP_FIELD_RANDOM_SPEECH, // random_speech_enabled
+  APP_FIELD_WIFI,          // wifi_connected と ip
+  APP_FIELD_BLE_MODE,      // connection_mode_ble
+  APP_FIELD_BLE_ENABLED,   // ble_enabled
+  APP_FIELD_COUNT
+};
+
+struct AppState {
+  uint32_t version;                      // 最後に変わったときの通し番号（0: 初期値のまま）
+  char message[SPEECH_TEXT_MAX_BYTES];   // 表示中のセリフ
+  char ip[16];                           // WiFi 接続中の IP アドレス（未接続は空）
+  int8_t expression;                     // 表情（0-3）
+  bool wifi_connected;
+  bool connection_mode_ble;              // true: BLEモード, false: WiFiモード
+  bool ble_enabled;
+  bool is_speaking;                      // 音声状態
+  bool speech_set_by_user;               // ユーザーが設定したセリフ（自動クリアの対象）
+  bool random_speech_enabled;
+  uint8_t reserved;
+};
+
+// 状態の変化（type は AppStateField）
+struct StateEvent {
+  uint8_t type;
+  uint8_t reserved;
+  uint16_t arg;       // 表情: 補間時間(ms)
+  int32_t value;      // 表情・フラグの新しい値（WiFi は接続中なら 1）
+  const char* text;   // セリフ・IP アドレス（配信の間だけ有効）
+  uint32_t version;   // この変化の通し番号
+};
+
+// 購読者の表（main.cpp でコンパイル時に決める）
+extern const EventBus<StateEvent> state_bus;
+
+struct AppStateStats {
+  uint32_t writes;
+  uint32_t reads;
+  uint32_t read_retries;  // 書き込みと重なって読み直した回数
+  uint32_t read_yields;   // 読み直しが続いて譲った回数
+  uint32_t events;        // 配った変化の数
+  uint32_t deliveries;    // 購読者を呼んだ回数
+  LoopLatency dispatch;   // publish から最後の購読者が戻るまで
+};
+
+class AppStateStore {
+public:
+  AppStateStore();
+
+  // setup() の最初に呼ぶ（呼んだタスクを書き手として登録する）
+  void begin();
+
+  // 呼んだタスクを書き手として登録する（書けるのは1タスクだけ）
+  void registerWriter();
+
+  // === 読み出し（どのタスクからも） ===
+  void snapshot(AppState& out) const;
+  AppState snapshot() const;
+  // 最後に割り当てた通し番号（中身を読まずに変化だけ調べる）
+  uint32_t version() const { return next_stamp.load(std::memory_order_acquire); }
+
+  // === 書き込み（登録した書き手だけ） ===
+  void setMessage(const char* text);
+  void setExpression(int expression, uint16_t duration_ms = FACE_TRANSITION_MS);
+  // 次の表情へ進めて新しい表情を返す
+  int cycleExpression(uint16_t duration_ms = FACE_TRANSITION_MS);
+  void setSpeechByUser(bool by_user);
+  void setSpeaking(bool speaking);
+  void setRandomSpeech(bool enabled);
+  void setWiFi(bool connected, const char* ip);
+  void setBleMode(bool ble);
+  void setBleEnabled(bool enabled);
+
+  AppStateStats getStats() const;
+
+  static const char* fieldName(uint8_t field);
+
+private:
+  struct Slot {
+    AppState state;
+    uint32_t stamps[APP_FIELD_COUNT];  // 項目ごとの通し番号（0: 書いていない）
+  };
+
+  Seqlock<Slot> slot;
+  Slot local;  // 書きかけ（書き手のタスクだけが触る）
+  std::atomic<uint32_t> next_stamp;
+  TaskHandle_t writer_task;
+  uint32_t writes;
+  uint32_t events;
+  uint32_t deliveries;
+  LoopLatency dispatch;
+  uint64_t dispatch_total_us;
+  mutable std::atomic<uint32_t> reads;
+  mutable std::atomic<uint32_t> read_retries;
+  mutable std::atomic<uint32_t> read_yields;
+
+  void checkWriter() const;
+  Slot& beginWrite(AppStateField field);
+  void publish(AppStateField field, int32_t value = 0, const char* text = nullptr, uint16_t arg = 0);
+  void readSlot(Slot& out) const;
+};
+
+extern AppStateStore app_state;
+
+#endif
@@ -0,0 +1,151 @@
+/*
+ * Avatar Commands for Stack-chan
+ * loop タスクから描画タスクへの SPSC キューと、描画タスクでの反映
+ */
+
+#include "avatar_commands.h"
+#include "power_governor.h"
+#include <string.h>
+
+AvatarCommands avatar_commands;
+
+extern Avatar avatar;
+
+// 生産者の登録（登録は1回だけなので、引くときも同じロックで済ませる）
+static portMUX_TYPE producer_lock = portMUX_INITIALIZER_UNLOCKED;
+
+AvatarCommands::AvatarCommands() {
+  producer_task = nullptr;
+  started = false;
+  memset(&stats, 0, sizeof(stats));
+}
+
+void AvatarCommands::begin() {
+  registerProducer();
+  started = true;
+}
+
+void AvatarCommands::registerProducer() {
+  TaskHandle_t task = xTaskGetCurrentTaskHandle();
+  portENTER_CRITICAL(&producer_lock);
+  // 別のタスクも積むと、生産者1つの前提が崩れる
+  bool taken = producer_task != nullptr && producer_task != task;
+  if (!taken) producer_task = task;
+  portEXIT_CRITICAL(&producer_lock);
+  configASSERT(!taken);
+}
+
+// 満杯なら描画タスクを起こして空くのを待つ（描画タスクからは呼ばない）
+AvatarCommand* AvatarCommands::reserve(bool wait) {
+  if (!started) return nullptr;
+  TaskHandle_t task = xTaskGetCurrentTaskHandle();
+  portENTER_CRITICAL(&producer_lock);
+  bool registered = producer_task == task;
+  portEXIT_CRITICAL(&producer_lock);
+  // 登録していないタスクからは積めない
+  configASSERT(registered);
+  AvatarCommand* slot = queue.reserve();
+  if (slot) return slot;
+  if (!wait) {
+    // 描画タスクを起こして空けておく（捨てた分は呼び出し元が後で積み直す）
+    stats.dropped++;
+    power_governor.interruptFrame();
+    return nullptr;
+  }
+
+  stats.waits++;
+  unsigned long start = millis();
+  while (!slot && millis() - start < AVATAR_COMMAND_WAIT_MS) {
+    // 描画の間隔の待ちだけを切り上げる（省電力の段階・画面の明るさは変えない）
+    power_governor.interruptFrame();
+    vTaskDelay(1);
+    slot = queue.reserve();
+  }
+  if (!slot) {
+    stats.dropped++;
+    Serial.println("AvatarCommands: キューが満杯のため命令を捨てました");
+  }
+  return slot;
+}
+
+void AvatarCommands::commit() {
+  queue.commit();
+  stats.pushed++;
+}
+
+bool AvatarCommands::setExpression(int expression, uint16_t duration_ms, bool wait) {
+  if (expression < 0 || expression >= FACE_EXPRESSION_COUNT) return false;
+  AvatarCommand* c = reserve(wait);
+  if (!c) return false;
+  c->type = AVATAR_CMD_EXPRESSION;
+  c->expression = expression;
+  c->duration_ms = duration_ms;
+  commit();
+  return true;
+}
+
+bool AvatarCommands::setSpeech(const char* text, bool wait) {
+  AvatarCommand* c = reserve(wait);
+  if (!c) return false;
+  c->type = AVATAR_CMD_SPEECH;
+  strncpy(c->text, text ? text : "", sizeof(c->text) - 1);
+  c->text[sizeof(c->text) - 1] = '\0';
+  commit();
+  return true;
+}
+
+bool AvatarCommands::setPalette(const PaletteDef& palette, uint16_t fade_ms, bool wait) {
+  AvatarCommand* c = reserve(wait);
+  if (!c) return false;
+  c->type = AVATAR_CMD_PALETTE;
+  c->duration_ms = fade_ms;
+  c->palette = palette;
+  commit();
+  return true;
+}
+
+// 登録済みパレットそのものの色なら変換済みのものを渡し、フェード途中の色だけ毎回書き換える
+// 描画中のフレームはこの後の部品から新しい色になる（同じタスクなので途中で書き換わることはない）
+void AvatarCommands::showPalette(const PaletteDef& palette) {
+  int index = palette_bank.activeIndex();
+  const PaletteDef* active = palette_bank.get(index);
+  if (active && PaletteBank::sameColors(*active, palette)) {
+    avatar.setColorPalette(palette_bank.colorPalette(index));
+  } else {
+    PaletteBank::toColorPalette(palette, fade_palette);
+    avatar.setColorPalette(fade_palette);
+  }
+}
+
+void AvatarCommands::apply(const AvatarCommand& command) {
+  switch (command.type) {
+    case AVATAR_CMD_EXPRESSION:
+      face_animator.setExpression(command.expression, command.duration_ms);
+      break;
+    case AVATAR_CMD_SPEECH:
+      speech_balloon.setText(command.text);
+      break;
+    case AVATAR_CMD_PALETTE:
+      // フェードの途中で切り替えた場合も、いま表示している色から始まる
+      palette_fader.start(command.palette, command.duration_ms);
+      break;
+  }
+}
+
+void AvatarCommands::drain() {
+  uint32_t depth = queue.size();
+  if (depth > stats.max_depth) stats.max_depth = depth;
+  AvatarCommand* c;
+  while ((c = queue.front()) != nullptr) {
+    apply(*c);
+    queue.release();
+    stats.applied++;
+  }
+
+  // パレットのクロスフェード（合成比率の段階が進んだときだけ Avatar へ反映）
+  PaletteDef faded;
+  if (palette_fader.update(faded)) {
+    showPalette(faded);
+    palette_fader.stepApplied();
+  }
+}
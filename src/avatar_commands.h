@@ -0,0 +1,83 @@
+/*
+ * Avatar Commands for Stack-chan
+ * 表情・セリフ・パレットの変更を命令としてキューに積み、描画タスクがフレームの先頭でまとめて反映する
+ * 積むのは loop タスク（HTTP・ボタン・周期処理。BLE の要求も loop() で反映する）だけで、SPSC キュー1つで渡す
+ * 生産者のタスクは registerProducer() で登録し、別のタスクから積むと configASSERT で止める
+ * パレットのクロスフェードも描画タスクが進めるので、描画中の状態を他のタスクが書き換えることがない
+ */
+
+#ifndef AVATAR_COMMANDS_H
+#define AVATAR_COMMANDS_H
+
+#include <Arduino.h>
+#include "spsc_queue.h"
+#include "color_palettes.h"
+#include "face_animator.h"
+#include "speech_balloon.h"
+#include "palette_fader.h"
+
+#define AVATAR_COMMAND_DEPTH   8   // キューの長さ（2 のべき乗）
+#define AVATAR_COMMAND_WAIT_MS 50  // 満杯のとき描画タスクが取り出すのを待つ上限（wait=true のとき）
+
+enum AvatarCommandType {
+  AVATAR_CMD_EXPRESSION = 0,
+  AVATAR_CMD_SPEECH,
+  AVATAR_CMD_PALETTE
+};
+
+struct AvatarCommand {
+  uint8_t type;                      // AvatarCommandType
+  uint8_t expression;
+  uint16_t duration_ms;              // 表情の補間時間・パレットのフェード時間
+  PaletteDef palette;                // 切り替え先の色
+  char text[SPEECH_TEXT_MAX_BYTES];
+};
+
+struct AvatarCommandStats {
+  uint32_t pushed;
+  uint32_t applied;
+  uint32_t waits;      // 満杯で待った回数
+  uint32_t dropped;    // 空かずに捨てた数（待たない呼び出しも含む）
+  uint8_t max_depth;   // 取り出すときに溜まっていた最大数
+};
+
+class AvatarCommands {
+public:
+  AvatarCommands();
+
+  // avatar.init() の後に setup() から呼ぶ（呼んだタスクを生産者として登録する）
+  // 呼ぶまで（Avatar の初期化に失敗した場合も）命令は積まずに捨てる
+  void begin();
+
+  // 呼んだタスクをキューの書き手として登録する（書けるのは1タスクだけ）
+  void registerProducer();
+
+  // === 生産側（登録した生産者だけ） ===
+  // wait=false なら満杯のときに待たずに false を返す（呼び出し元を止められない購読者などから）
+  bool setExpression(int expression, uint16_t duration_ms = FACE_TRANSITION_MS, bool wait = true);
+  bool setSpeech(const char* text, bool wait = true);
+  // 表示中の色から palette へ fade_ms かけて切り替える（フェードは描画タスクがフレームごとに進める）
+  bool setPalette(const PaletteDef& palette, uint16_t fade_ms = 0, bool wait = true);
+
+  // === 消費側（描画タスクだけ） ===
+  // 溜まった命令を積んだ順で反映し、パレットのフェードを1段進める
+  void drain();
+
+  AvatarCommandStats getStats() const { return stats; }
+
+private:
+  SpscQueue<AvatarCommand, AVATAR_COMMAND_DEPTH> queue;
+  TaskHandle_t producer_task;
+  bool started;
+  AvatarCommandStats stats;
+  ColorPalette fade_palette;  // フェード途中の色（毎回書き換えて使い回す）
+
+  AvatarCommand* reserve(bool wait);
+  void commit();
+  void apply(const AvatarCommand& command);
+  void showPalette(const PaletteDef& palette);
+};
+
+extern AvatarCommands avatar_commands;
+
+#endif
@@ -0,0 +1,209 @@
+/*
+ * Balloon Cache for Stack-chan
+ * 描画済みの吹き出し画像をセリフのハッシュと配色をキーにLRUで保持する
+ */
+
+#include "balloon_cache.h"
+
+uint32_t balloonTextHash(const char* text) {
+  uint32_t h = 2166136261u;
+  for (const uint8_t* p = (const uint8_t*)text; *p; p++) {
+    h ^= *p;
+    h *= 16777619u;
+  }
+  return h;
+}
+
+bool canvasRowGeometry(M5Canvas* canvas, int x, int y, int w, int h, RowGeometry& g) {
+  if (!canvas || !canvas->getBuffer()) return false;
+  if (x < 0 || y < 0 || w <= 0 || h <= 0) return false;
+  if (x + w > canvas->width() || y + h > canvas->height()) return false;
+
+  int bits = canvas->getColorDepth() & 0xFF;
+  if (bits == 1) {
+    // 1bppはバイト境界に揃っている場合だけ（吹き出しは x=16, w=288）
+    if ((x & 7) || (w & 7)) return false;
+    g.stride = (canvas->width() + 7) / 8;
+    g.offset = y * g.stride + x / 8;
+    g.row_bytes = w / 8;
+  } else if (bits == 8 || bits == 16) {
+    size_t bpp = bits / 8;
+    g.stride = canvas->width() * bpp;
+    g.offset = y * g.stride + x * bpp;
+    g.row_bytes = w * bpp;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+static bool sameKey(const BalloonCacheKey& a, const BalloonCacheKey& b) {
+  return a.text_hash == b.text_hash && a.foreground == b.foreground && a.background == b.background &&
+         a.backdrop == b.backdrop && a.scroll_step == b.scroll_step && a.color_depth == b.color_depth;
+}
+
+BalloonCache::BalloonCache() {
+  memset(entries, 0, sizeof(entries));
+  budget = 0;
+  used_bytes = 0;
+  use_clock = 0;
+  use_psram = false;
+  memset(&stats, 0, sizeof(stats));
+  memset(&last_key, 0, sizeof(last_key));
+  has_last = false;
+}
+
+BalloonCache::~BalloonCache() {
+  end();
+}
+
+void BalloonCache::begin(size_t budget_bytes) {
+  end();
+  use_psram = psramFound();
+#ifdef BALLOON_CACHE_BUDGET
+  budget = budget_bytes ? budget_bytes : BALLOON_CACHE_BUDGET;
+#else
+  if (budget_bytes) {
+    budget = budget_bytes;
+  } else if (DisplayProfile::balloon_cache_budget) {
+    budget = DisplayProfile::balloon_cache_budget;
+  } else {
+    budget = use_psram ? BALLOON_CACHE_BUDGET_PSRAM : BALLOON_CACHE_BUDGET_INTERNAL;
+  }
+#endif
+  Serial.printf("BalloonCache: 予算 %u bytes (%s)\n", (unsigned)budget, use_psram ? "PSRAM" : "内部RAM");
+}
+
+void BalloonCache::end() {
+  clear();
+  budget = 0;
+}
+
+void BalloonCache::clear() {
+  for (int i = 0; i < BALLOON_CACHE_MAX_ENTRIES; i++) {
+    if (entries[i].pixels) evict(i);
+  }
+  has_last = false;
+}
+
+bool BalloonCache::canCache(M5Canvas* canvas, int x, int y, int w, int h) {
+  RowGeometry g;
+  return canvasRowGeometry(canvas, x, y, w, h, g);
+}
+
+int BalloonCache::find(const BalloonCacheKey& key) const {
+  for (int i = 0; i < BALLOON_CACHE_MAX_ENTRIES; i++) {
+    if (entries[i].pixels && sameKey(entries[i].key, key)) return i;
+  }
+  return -1;
+}
+
+void BalloonCache::evict(int index) {
+  Entry& e = entries[index];
+  heap_caps_free(e.pixels);
+  used_bytes -= e.bytes;
+  e.pixels = nullptr;
+  e.bytes = 0;
+}
+
+// 最も長く使われていないエントリを捨てて、その番号を返す（空なら -1）
+int BalloonCache::evictOldest() {
+  int oldest = -1;
+  for (int i = 0; i < BALLOON_CACHE_MAX_ENTRIES; i++) {
+    if (!entries[i].pixels) continue;
+    if (oldest < 0 || entries[i].last_used < entries[oldest].last_used) oldest = i;
+  }
+  if (oldest >= 0) {
+    evict(oldest);
+    stats.evictions++;
+  }
+  return oldest;
+}
+
+bool BalloonCache::blit(const BalloonCacheKey& key, M5Canvas* canvas, int x, int y, int w, int h) {
+  RowGeometry g;
+  if (!budget || !canvasRowGeometry(canvas, x, y, w, h, g)) return false;
+
+  // 描画先は毎フレーム作り直されるので、同じ吹き出しが続く間も毎回コピーする
+  // そのコピーはヒットと数えず、表示が切り替わったときにキャッシュが描き直しを省けたかだけをヒット率にする
+  bool repeat = has_last && sameKey(last_key, key);
+  last_key = key;
+  has_last = true;
+
+  int index = find(key);
+  if (index < 0 || entries[index].bytes != g.row_bytes * h) {
+    stats.misses++;
+    return false;
+  }
+
+  Entry& e = entries[index];
+  uint8_t* dst = (uint8_t*)canvas->getBuffer() + g.offset;
+  const uint8_t* src = e.pixels;
+  for (int row = 0; row < h; row++) {
+    memcpy(dst, src, g.row_bytes);
+    dst += g.stride;
+    src += g.row_bytes;
+  }
+  e.last_used = ++use_clock;
+  if (repeat) {
+    stats.repeats++;
+  } else {
+    stats.hits++;
+  }
+  return true;
+}
+
+void BalloonCache::store(const BalloonCacheKey& key, M5Canvas* canvas, int x, int y, int w, int h) {
+  RowGeometry g;
+  if (!budget || !canvasRowGeometry(canvas, x, y, w, h, g)) return;
+
+  size_t bytes = g.row_bytes * h;
+  if (bytes > budget) return;
+
+  int existing = find(key);
+  if (existing >= 0) evict(existing);
+
+  while (used_bytes + bytes > budget) {
+    if (evictOldest() < 0) break;
+  }
+
+  int slot = -1;
+  for (int i = 0; i < BALLOON_CACHE_MAX_ENTRIES; i++) {
+    if (!entries[i].pixels) {
+      slot = i;
+      break;
+    }
+  }
+  if (slot < 0) slot = evictOldest();
+  if (slot < 0) return;
+
+  uint32_t caps = use_psram ? (MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT) : MALLOC_CAP_8BIT;
+  uint8_t* pixels = static_cast<uint8_t*>(heap_caps_malloc(bytes, caps));
+  if (!pixels) return;
+
+  const uint8_t* src = (const uint8_t*)canvas->getBuffer() + g.offset;
+  uint8_t* dst = pixels;
+  for (int row = 0; row < h; row++) {
+    memcpy(dst, src, g.row_bytes);
+    src += g.stride;
+    dst += g.row_bytes;
+  }
+
+  Entry& e = entries[slot];
+  e.key = key;
+  e.pixels = pixels;
+  e.bytes = bytes;
+  e.last_used = ++use_clock;
+  used_bytes += bytes;
+}
+
+BalloonCacheStats BalloonCache::getStats() const {
+  BalloonCacheStats s = stats;
+  s.entries = 0;
+  for (int i = 0; i < BALLOON_CACHE_MAX_ENTRIES; i++) {
+    if (entries[i].pixels) s.entries++;
+  }
+  s.bytes = used_bytes;
+  s.budget = budget;
+  return s;
+}
@@ -0,0 +1,99 @@
+/*
+ * Balloon Cache for Stack-chan
+ * 描画済みの吹き出し画像をセリフのハッシュと配色をキーにLRUで保持する
+ * 同じセリフの再表示はフレームバッファへの行コピー1回で済む
+ */
+
+#ifndef BALLOON_CACHE_H
+#define BALLOON_CACHE_H
+
+#include <M5Unified.h>
+#include "display_profile.h"
+
+// 画像に使うメモリの上限（build_flags で環境ごとに上書き可能）
+#ifndef BALLOON_CACHE_BUDGET_PSRAM
+#define BALLOON_CACHE_BUDGET_PSRAM    (256 * 1024)
+#endif
+#ifndef BALLOON_CACHE_BUDGET_INTERNAL
+#define BALLOON_CACHE_BUDGET_INTERNAL (12 * 1024)
+#endif
+// BALLOON_CACHE_BUDGET を定義するとPSRAMの有無に関わらずその値を使う
+// 未定義なら DisplayProfile::balloon_cache_budget（0 ならPSRAMの有無で決める）
+
+#define BALLOON_CACHE_MAX_ENTRIES 16
+
+struct BalloonCacheKey {
+  uint32_t text_hash;
+  uint16_t foreground;
+  uint16_t background;
+  uint16_t backdrop;     // 角の外側（顔の背景色）
+  uint8_t scroll_step;
+  uint8_t color_depth;
+};
+
+struct BalloonCacheStats {
+  uint32_t hits;         // 直前のフレームと違う吹き出し（再表示のセリフ・スクロール位置）をコピーで済ませた数
+  uint32_t misses;       // 描き直した数
+  uint32_t repeats;      // 直前のフレームと同じ吹き出しのコピー（ヒット率には含めない）
+  uint32_t evictions;
+  uint16_t entries;
+  size_t bytes;
+  size_t budget;
+};
+
+// FNV-1a（セリフのハッシュ用）
+uint32_t balloonTextHash(const char* text);
+
+// フレームバッファ上の矩形を行単位でコピーするための寸法
+struct RowGeometry {
+  size_t stride;      // canvas の1行のバイト数
+  size_t offset;      // 矩形左上のバイト位置
+  size_t row_bytes;   // 矩形1行のバイト数
+};
+
+// canvas 上の矩形が行コピーできる配置なら寸法を g に入れて true（1bpp はバイト境界に揃っている場合だけ）
+bool canvasRowGeometry(M5Canvas* canvas, int x, int y, int w, int h, RowGeometry& g);
+
+class BalloonCache {
+public:
+  BalloonCache();
+  ~BalloonCache();
+
+  void begin(size_t budget_bytes = 0);  // 0: PSRAMの有無から決定
+  void end();
+
+  // canvas 上の (x, y, w, h) がキャッシュ可能な配置か（全体が収まり、行コピーできる）
+  static bool canCache(M5Canvas* canvas, int x, int y, int w, int h);
+
+  // ヒットしたら canvas へコピーして true
+  bool blit(const BalloonCacheKey& key, M5Canvas* canvas, int x, int y, int w, int h);
+
+  // canvas に描いたばかりの領域を取り込む（予算を超える分は古いものから捨てる）
+  void store(const BalloonCacheKey& key, M5Canvas* canvas, int x, int y, int w, int h);
+
+  void clear();
+  BalloonCacheStats getStats() const;
+
+private:
+  struct Entry {
+    BalloonCacheKey key;
+    uint8_t* pixels;
+    size_t bytes;
+    uint32_t last_used;
+  };
+
+  Entry entries[BALLOON_CACHE_MAX_ENTRIES];
+  size_t budget;
+  size_t used_bytes;
+  uint32_t use_clock;
+  bool use_psram;
+  BalloonCacheStats stats;
+  BalloonCacheKey last_key;  // 直前に blit() で引いたキー
+  bool has_last;
+
+  int find(const BalloonCacheKey& key) const;
+  void evict(int index);
+  int evictOldest();
+};
+
+#endif
@@ -4,10 +4,9 @@
  */
 
 #include "ble_webui.h"
-
-// main.cppのグローバル変数（外部参照）
-extern bool is_speaking;
-extern bool connection_mode_ble;
+#include "stall_detector.h"
+#include "app_state.h"
+#include "app_clock.h"
 
 BLEWebUIHandler::BLEWebUIHandler() {
     pServer = nullptr;
@@ -20,7 +19,7 @@ void BLEWebUIHandler::begin() {
     Serial.println("BLE WebUI初期化開始");
     
     // BLEモードフラグを設定
-    connection_mode_ble = true;
+    app_state.setBleMode(true);
     
     // BLEデバイス初期化（確実な発見のための設定）
     BLEDevice::init(BLE_DEVICE_NAME);
@@ -80,13 +79,16 @@ void BLEWebUIHandler::begin() {
 }
 
 void BLEWebUIHandler::restart() {
+    StallGuard stall(STALL_BLE_RESTART);
     Serial.println("BLE再起動中...");
     
     // 既存のBLE接続を停止
     if (pServer) {
         BLEDevice::stopAdvertising();
+        stall_detector.enter(STALL_BLE_DEINIT);
         BLEDevice::deinit();
-        delay(1000); // 1秒待機
+        stall_detector.exit(STALL_BLE_DEINIT);
+        app_clock.delay(1000); // 1秒待機
     }
     
     // BLEを再初期化
@@ -95,7 +97,7 @@ void BLEWebUIHandler::restart() {
 
 void BLEWebUIHandler::handleBLERequest() {
     // 定期的な処理（必要に応じて追加）
-    delay(10);
+    // リクエストはBLEのコールバックで処理済み。接続・書き込みは LoopEvents で loop() を起こす
 }
 
 // 外部関数の実装（weakリンクされたデフォルト実装）
@@ -13,6 +13,9 @@
 #include <BLE2902.h>
 #include <ArduinoJson.h>
 #include "esp_gap_ble_api.h"
+#include "loop_events.h"
+#include "trace_recorder.h"
+#include "breadcrumbs.h"
 
 // main.cppの関数宣言
 extern String generateWebUIHTML();
@@ -61,17 +64,23 @@ public:
     
     void onConnect(BLEServer* pServer) {
         Serial.println("BLEクライアント接続");
+        TRACE_INSTANT(TRACE_BLE_CONNECT, 0);
+        breadcrumbs.add(CRUMB_BLE_CONNECT);
         if (handler) {
             handler->setDeviceConnected(true);
         }
+        loop_events.notify(LOOP_EVENT_BLE);
     }
     
     void onDisconnect(BLEServer* pServer) {
         Serial.println("BLEクライアント切断 - アドバタイズ再開");
+        TRACE_INSTANT(TRACE_BLE_DISCONNECT, 0);
+        breadcrumbs.add(CRUMB_BLE_DISCONNECT);
         if (handler) {
             handler->setDeviceConnected(false);
         }
         BLEDevice::startAdvertising();
+        loop_events.notify(LOOP_EVENT_BLE);
     }
 };
 
@@ -87,6 +96,7 @@ public:
         std::string value = pCharacteristic->getValue();
         
         if (value.length() > 0) {
+            TRACE_BEGIN(TRACE_BLE_WRITE);
             String request = String(value.c_str());
             Serial.println("BLE Request: " + request);
             
@@ -94,6 +104,9 @@ public:
             if (request.startsWith("GET ")) {
                 processHTTPRequest(request);
             }
+            // 状態が変わった（パレットのフェード等）ので loop() を起こす
+            loop_events.notify(LOOP_EVENT_BLE);
+            TRACE_END(TRACE_BLE_WRITE);
         }
     }
     
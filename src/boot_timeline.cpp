@@ -0,0 +1,41 @@
+/*
+ * Boot Timeline for Stack-chan
+ * 起動段階の時刻の記録
+ */
+
+#include "boot_timeline.h"
+#include <esp_timer.h>
+#include <string.h>
+
+BootTimeline boot_timeline;
+
+BootTimeline::BootTimeline() {
+  memset((void*)at_us, 0, sizeof(at_us));
+  frames = 0;
+}
+
+void BootTimeline::mark(BootPhase phase) {
+  if (at_us[phase]) return;
+  uint32_t now = (uint32_t)esp_timer_get_time();
+  at_us[phase] = now ? now : 1;
+  Serial.printf("BootTimeline: %s %lu.%03lums\n", phaseName(phase), (unsigned long)(now / 1000),
+                (unsigned long)(now % 1000));
+}
+
+void BootTimeline::frameCheckpoint() {
+  if (frames >= 2) return;
+  if (++frames == 2) mark(BOOT_FIRST_FRAME);
+}
+
+const char* BootTimeline::phaseName(uint8_t phase) {
+  switch (phase) {
+    case BOOT_SERIAL:      return "serial";
+    case BOOT_M5:          return "m5";
+    case BOOT_AVATAR:      return "avatar";
+    case BOOT_INTERACTIVE: return "interactive";
+    case BOOT_FIRST_FRAME: return "first_frame";
+    case BOOT_NETWORK:     return "network";
+    case BOOT_FIRST_HTTP:  return "first_http";
+    default:               return "unknown";
+  }
+}
@@ -0,0 +1,44 @@
+/*
+ * Boot Timeline for Stack-chan
+ * 起動の各段階に達した時刻（esp_timer、起動からのマイクロ秒）を一度だけ記録する
+ * 最初のフレームの表示・ネットワークの準備完了・最初の HTTP 応答は setup() の後に loop() や描画タスクで届く
+ */
+
+#ifndef BOOT_TIMELINE_H
+#define BOOT_TIMELINE_H
+
+#include <Arduino.h>
+
+enum BootPhase {
+  BOOT_SERIAL = 0,    // シリアル・ブレッドクラム
+  BOOT_M5,            // M5.begin() と入力・監視の開始
+  BOOT_AVATAR,        // Avatar・パレット・フォントの初期化
+  BOOT_INTERACTIVE,   // setup() が終わり、ボタンと表情の操作を受け付ける
+  BOOT_FIRST_FRAME,   // 最初のフレームの転送完了
+  BOOT_NETWORK,       // WiFi 接続と WebServer 開始、または BLE の開始
+  BOOT_FIRST_HTTP,    // 最初の HTTP 応答の送信完了
+  BOOT_PHASE_COUNT
+};
+
+class BootTimeline {
+public:
+  BootTimeline();
+
+  // 初めて達したときだけ記録してシリアルに出す（どのタスクからも呼べる）
+  void mark(BootPhase phase);
+  // 描画タスク: 毎フレームの先頭（2回目の呼び出しで最初のフレームの転送が終わっている）
+  void frameCheckpoint();
+
+  bool reached(BootPhase phase) const { return at_us[phase] != 0; }
+  uint32_t atUs(BootPhase phase) const { return at_us[phase]; }
+
+  static const char* phaseName(uint8_t phase);
+
+private:
+  volatile uint32_t at_us[BOOT_PHASE_COUNT];  // 0: まだ
+  volatile uint8_t frames;
+};
+
+extern BootTimeline boot_timeline;
+
+#endif
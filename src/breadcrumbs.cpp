@@ -0,0 +1,131 @@
+/*
+ * Breadcrumbs for Stack-chan
+ * RTC メモリの出来事のリングと、起動時の前回分の取り出し
+ */
+
+#include "breadcrumbs.h"
+#include "loop_profiler.h"
+#include <esp_system.h>
+#include <string.h>
+
+Breadcrumbs breadcrumbs;
+
+#define BREADCRUMB_MAGIC 0x43524d42UL  // "CRMB"
+
+// リセットでは初期化されない（電源投入時は不定）
+RTC_NOINIT_ATTR static BreadcrumbLog rtc_breadcrumbs;
+
+static portMUX_TYPE crumb_mux = portMUX_INITIALIZER_UNLOCKED;
+
+Breadcrumbs::Breadcrumbs() {
+  log = &rtc_breadcrumbs;
+  memset(&previous, 0, sizeof(previous));
+  previous_valid = false;
+}
+
+bool Breadcrumbs::isValid(const BreadcrumbLog& log) {
+  return log.magic == BREADCRUMB_MAGIC && log.head < BREADCRUMB_COUNT && log.count <= BREADCRUMB_COUNT &&
+         (log.last_stage < LOOP_STAGE_COUNT || log.last_stage == BREADCRUMB_NO_STAGE);
+}
+
+void Breadcrumbs::begin() {
+  esp_reset_reason_t reason = esp_reset_reason();
+  // 電源投入時の RTC メモリは不定なので前回の記録として扱わない
+  previous_valid = reason != ESP_RST_POWERON && isValid(rtc_breadcrumbs);
+  if (previous_valid) previous = rtc_breadcrumbs;
+
+  memset(&rtc_breadcrumbs, 0, sizeof(rtc_breadcrumbs));
+  rtc_breadcrumbs.boot_count = previous_valid ? previous.boot_count + 1 : 1;
+  rtc_breadcrumbs.reset_reason = reason;
+  rtc_breadcrumbs.min_free_heap = ESP.getFreeHeap();
+  rtc_breadcrumbs.min_largest_block = ESP.getMaxAllocHeap();
+  rtc_breadcrumbs.last_stage = BREADCRUMB_NO_STAGE;
+  rtc_breadcrumbs.magic = BREADCRUMB_MAGIC;
+  add(CRUMB_BOOT, reason);
+
+  Serial.printf("Breadcrumbs: 起動 #%lu（リセット理由 %s）\n", (unsigned long)rtc_breadcrumbs.boot_count,
+                resetReasonName(reason));
+  if (previous_valid) printPrevious();
+}
+
+void Breadcrumbs::printPrevious() const {
+  Serial.printf("Breadcrumbs: 前回は %lus 稼働、最後に終えた段階 %s、最小空きヒープ %luB、最大空きブロックの最小 %luB\n",
+                (unsigned long)(previous.uptime_ms / 1000), stageName(previous.last_stage),
+                (unsigned long)previous.min_free_heap, (unsigned long)previous.min_largest_block);
+  for (int i = 0; i < previous.count; i++) {
+    const Breadcrumb& c = at(previous, i);
+    Serial.printf("  %8lums %-14s arg=%u (%s)\n", (unsigned long)c.uptime_ms, eventName(c.event), (unsigned)c.arg,
+                  stageName(c.stage));
+  }
+}
+
+void Breadcrumbs::add(BreadcrumbEvent event, uint16_t arg) {
+  uint32_t now = millis();
+  portENTER_CRITICAL(&crumb_mux);
+  Breadcrumb& c = log->events[log->head];
+  c.uptime_ms = now;
+  c.arg = arg;
+  c.event = event;
+  c.stage = log->last_stage;
+  log->head = (log->head + 1) % BREADCRUMB_COUNT;
+  if (log->count < BREADCRUMB_COUNT) log->count++;
+  log->uptime_ms = now;
+  portEXIT_CRITICAL(&crumb_mux);
+}
+
+void Breadcrumbs::sampleHeap() {
+  uint32_t free_heap = ESP.getFreeHeap();
+  uint32_t largest = ESP.getMaxAllocHeap();
+  log->uptime_ms = millis();
+  if (free_heap < log->min_free_heap) log->min_free_heap = free_heap;
+  if (largest < log->min_largest_block) log->min_largest_block = largest;
+
+  if (!log->heap_low && free_heap < BREADCRUMB_HEAP_LOW) {
+    log->heap_low = true;
+    add(CRUMB_HEAP_LOW, free_heap / 1024);
+  } else if (log->heap_low && free_heap > BREADCRUMB_HEAP_LOW + 4096) {
+    log->heap_low = false;
+  }
+}
+
+const Breadcrumb& Breadcrumbs::at(const BreadcrumbLog& log, uint8_t index) {
+  uint8_t oldest = (log.head + BREADCRUMB_COUNT - log.count) % BREADCRUMB_COUNT;
+  return log.events[(oldest + index) % BREADCRUMB_COUNT];
+}
+
+const char* Breadcrumbs::eventName(uint8_t event) {
+  switch (event) {
+    case CRUMB_BOOT:           return "boot";
+    case CRUMB_WIFI_CONNECTED: return "wifi_connected";
+    case CRUMB_WIFI_FAILED:    return "wifi_failed";
+    case CRUMB_WIFI_LOST:      return "wifi_lost";
+    case CRUMB_MODE_SWITCH:    return "mode_switch";
+    case CRUMB_BLE_CONNECT:    return "ble_connect";
+    case CRUMB_BLE_DISCONNECT: return "ble_disconnect";
+    case CRUMB_POWER_LEVEL:    return "power_level";
+    case CRUMB_HEAP_LOW:       return "heap_low";
+    case CRUMB_STALL:          return "stall";
+    case CRUMB_STALL_TRIP:     return "stall_trip";
+    default:                   return "unknown";
+  }
+}
+
+const char* Breadcrumbs::stageName(uint8_t stage) {
+  return stage < LOOP_STAGE_COUNT ? loopStageName((LoopStage)stage) : "none";
+}
+
+const char* Breadcrumbs::resetReasonName(uint32_t reason) {
+  switch (reason) {
+    case ESP_RST_POWERON:   return "poweron";
+    case ESP_RST_EXT:       return "external";
+    case ESP_RST_SW:        return "software";
+    case ESP_RST_PANIC:     return "panic";
+    case ESP_RST_INT_WDT:   return "int_wdt";
+    case ESP_RST_TASK_WDT:  return "task_wdt";
+    case ESP_RST_WDT:       return "wdt";
+    case ESP_RST_DEEPSLEEP: return "deepsleep";
+    case ESP_RST_BROWNOUT:  return "brownout";
+    case ESP_RST_SDIO:      return "sdio";
+    default:                return "unknown";
+  }
+}
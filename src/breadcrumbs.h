@@ -0,0 +1,94 @@
+/*
+ * Breadcrumbs for Stack-chan
+ * 直近の出来事・最後に終えた loop() の段階・最小空きヒープ・最大の空きブロックを RTC メモリに残し、
+ * ソフトリセット（パニック・ウォッチドッグ・ESP.restart()）の後の起動で前回の分として報告する
+ * 電源を切ると消える（電源投入時の起動では前回の記録はない）
+ */
+
+#ifndef BREADCRUMBS_H
+#define BREADCRUMBS_H
+
+#include <Arduino.h>
+
+#define BREADCRUMB_COUNT 16           // 残す出来事の数（古いものから上書き）
+#define BREADCRUMB_NO_STAGE 0xFF
+
+// 空きヒープがこれを下回ったら出来事として残す（4KB 戻るまで再度は残さない）
+#ifndef BREADCRUMB_HEAP_LOW
+#define BREADCRUMB_HEAP_LOW (24 * 1024)
+#endif
+
+enum BreadcrumbEvent {
+  CRUMB_BOOT = 0,        // arg: リセット理由（esp_reset_reason_t）
+  CRUMB_WIFI_CONNECTED,
+  CRUMB_WIFI_FAILED,
+  CRUMB_WIFI_LOST,
+  CRUMB_MODE_SWITCH,     // arg: 1 = BLE へ、0 = WiFi へ
+  CRUMB_BLE_CONNECT,
+  CRUMB_BLE_DISCONNECT,
+  CRUMB_POWER_LEVEL,     // arg: PowerLevel
+  CRUMB_HEAP_LOW,        // arg: 空きヒープ（KB）
+  CRUMB_STALL,           // arg: StallRegion（予算超過）
+  CRUMB_STALL_TRIP,      // arg: StallRegion（ウォッチドッグで再起動させる）
+  CRUMB_EVENT_COUNT
+};
+
+struct Breadcrumb {
+  uint32_t uptime_ms;
+  uint16_t arg;
+  uint8_t event;   // BreadcrumbEvent
+  uint8_t stage;   // そのときの最後に終えた loop() の段階
+};
+
+// RTC メモリに置く形そのもの
+struct BreadcrumbLog {
+  uint32_t magic;
+  uint32_t boot_count;         // 電源投入からの起動回数
+  uint32_t reset_reason;       // この起動のリセット理由
+  uint32_t uptime_ms;          // 最後に記録した時刻（ヒープの見回りで1秒ごとに進む）
+  uint32_t min_free_heap;
+  uint32_t min_largest_block;
+  uint8_t last_stage;          // LoopStage（BREADCRUMB_NO_STAGE: まだない）
+  uint8_t head;
+  uint8_t count;
+  uint8_t heap_low;            // 空きヒープが閾値を下回っている
+  Breadcrumb events[BREADCRUMB_COUNT];
+};
+
+class Breadcrumbs {
+public:
+  Breadcrumbs();
+
+  // 前回の記録を取り出してシリアルに出し、この起動の記録を始める（setup() の最初に呼ぶ）
+  void begin();
+
+  // どのタスクからも呼べる
+  void add(BreadcrumbEvent event, uint16_t arg = 0);
+  // loop() の段階の区切り（LOOP_PROFILE_MARK から呼ばれる）
+  void setStage(uint8_t stage) { log->last_stage = stage; }
+  // 空きヒープと最大の空きブロックの最小値を更新する（周期処理から）
+  void sampleHeap();
+
+  bool hasPrevious() const { return previous_valid; }
+  const BreadcrumbLog& getPrevious() const { return previous; }
+  const BreadcrumbLog& getCurrent() const { return *log; }
+
+  // 古い順に index 番目の出来事
+  static const Breadcrumb& at(const BreadcrumbLog& log, uint8_t index);
+
+  static const char* eventName(uint8_t event);
+  static const char* stageName(uint8_t stage);
+  static const char* resetReasonName(uint32_t reason);
+
+private:
+  BreadcrumbLog* log;
+  BreadcrumbLog previous;
+  bool previous_valid;
+
+  static bool isValid(const BreadcrumbLog& log);
+  void printPrevious() const;
+};
+
+extern Breadcrumbs breadcrumbs;
+
+#endif
@@ -0,0 +1,266 @@
+/*
+ * Button Input for Stack-chan
+ * GPIO割り込み → 読み取りタスクでチャタリング除去 → 時刻付きイベントのキュー
+ */
+
+#include "button_input.h"
+#include "loop_events.h"
+#include "trace_recorder.h"
+#include <driver/gpio.h>
+#include <esp_timer.h>
+#include <string.h>
+
+ButtonInput button_input;
+
+ButtonInput::ButtonInput() {
+  queue = nullptr;
+  task = nullptr;
+  pin_count = 0;
+  polled_mask = 0;
+  memset(pins, 0, sizeof(pins));
+  memset(states, 0, sizeof(states));
+  lookahead_count = 0;
+  memset(&stats, 0, sizeof(stats));
+  wake_requested = false;
+  wake_fired = false;
+  wake_armed = false;
+}
+
+void IRAM_ATTR ButtonInput::onEdge() {
+  BaseType_t woken = pdFALSE;
+  vTaskNotifyGiveFromISR(button_input.task, &woken);
+  if (woken) portYIELD_FROM_ISR();
+}
+
+// 押されている間は割り込みが続くので、止めてから読み取りタスクに任せる
+void IRAM_ATTR ButtonInput::onWakeLevel() {
+  for (int i = 0; i < button_input.pin_count; i++) {
+    gpio_intr_disable((gpio_num_t)button_input.pins[i]);
+  }
+  button_input.wake_fired = true;
+  BaseType_t woken = pdFALSE;
+  vTaskNotifyGiveFromISR(button_input.task, &woken);
+  if (woken) portYIELD_FROM_ISR();
+}
+
+// ESP32 の GPIO36/39 は RTC の周辺（ADC・無線）が動くたびに短くLOWに引かれ、偽のエッジ割り込みが入る
+bool ButtonInput::hasGlitchErrata(uint8_t pin) {
+#if CONFIG_IDF_TARGET_ESP32
+  return pin == 36 || pin == 39;
+#else
+  return false;
+#endif
+}
+
+void ButtonInput::begin() {
+  if (queue) return;
+  queue = xQueueCreate(BUTTON_QUEUE_LENGTH, sizeof(ButtonEvent));
+
+  // 物理ボタンの機種だけ割り込みで読む（どれも押すと LOW）
+  switch (M5.getBoard()) {
+    case m5::board_t::board_M5Stack:
+      pins[BUTTON_A] = 39;
+      pins[BUTTON_B] = 38;
+      pins[BUTTON_C] = 37;
+      pin_count = 3;
+      break;
+    case m5::board_t::board_M5StickC:
+    case m5::board_t::board_M5StickCPlus:
+      pins[BUTTON_A] = 37;
+      pins[BUTTON_B] = 39;
+      pin_count = 2;
+      break;
+    case m5::board_t::board_M5AtomS3:
+      pins[BUTTON_A] = 41;
+      pin_count = 1;
+      break;
+    default:
+      break;
+  }
+  if (pin_count == 0) {
+    Serial.println("ButtonInput: タッチボタン（loop() で見回り）");
+    return;
+  }
+
+  // loop() より高い優先度で動かす（loop() が何をしていても読み取りが遅れないように）
+  xTaskCreatePinnedToCore(sampleTask, "btn_input", 2048, this, 3, &task, ARDUINO_RUNNING_CORE);
+  int interrupts = 0;
+  for (int i = 0; i < pin_count; i++) {
+    if (hasGlitchErrata(pins[i])) {
+      polled_mask |= 1 << i;
+      continue;
+    }
+    attachInterrupt(digitalPinToInterrupt(pins[i]), onEdge, CHANGE);
+    interrupts++;
+  }
+  Serial.printf("ButtonInput: ボタン割り込み %d本・見回り %d本（%dms x %d で確定、長押し %dms）\n", interrupts,
+                pin_count - interrupts, BUTTON_SAMPLE_MS, BUTTON_DEBOUNCE_SAMPLES, BUTTON_HOLD_MS);
+}
+
+void ButtonInput::push(uint8_t button, ButtonEventType type, uint32_t held_ms, int64_t time_us) {
+  ButtonEvent event;
+  event.button = button;
+  event.type = type;
+  event.held_ms = held_ms;
+  event.time_us = time_us;
+  if (xQueueSend(queue, &event, 0) == pdTRUE) {
+    stats.events++;
+  } else {
+    stats.dropped++;
+  }
+  TRACE_INSTANT(TRACE_BUTTON, (type << 4) | button);
+  loop_events.notify(LOOP_EVENT_INPUT);
+}
+
+// 全ボタンを1回読む。離されていて確定待ちもなければ true（割り込みまで眠ってよい）
+bool ButtonInput::sample() {
+  int64_t now = esp_timer_get_time();
+  bool idle = true;
+  for (int i = 0; i < pin_count; i++) {
+    ButtonState& s = states[i];
+    bool level = digitalRead(pins[i]) == LOW;
+
+    if (level == s.pressed) {
+      if (s.count) stats.bounces++;
+      s.count = 0;
+    } else {
+      if (s.count == 0) s.change_us = now;
+      if (++s.count >= BUTTON_DEBOUNCE_SAMPLES) {
+        s.pressed = level;
+        s.count = 0;
+        if (s.pressed) {
+          s.pressed_us = s.change_us;
+          s.hold_sent = false;
+          push(i, BUTTON_PRESS, 0, s.change_us);
+        } else {
+          push(i, BUTTON_RELEASE, (uint32_t)((s.change_us - s.pressed_us) / 1000), s.change_us);
+        }
+      }
+    }
+
+    if (s.pressed && !s.hold_sent && now - s.pressed_us >= (int64_t)BUTTON_HOLD_MS * 1000) {
+      s.hold_sent = true;
+      push(i, BUTTON_HOLD, (uint32_t)((now - s.pressed_us) / 1000), now);
+    }
+
+    if (s.pressed || s.count) idle = false;
+  }
+  return idle;
+}
+
+// 割り込みの設定は読み取りタスクだけが変える
+void ButtonInput::applyWakeMode() {
+  bool want = wake_requested;
+  if (wake_fired) {
+    wake_fired = false;
+    wake_requested = false;
+    want = false;
+  }
+  if (want == wake_armed) return;
+  for (int i = 0; i < pin_count; i++) {
+    // 見回りのボタンはレベルでも偽の起床が入るので、眠っている間は次の見回りで読む
+    if (polled_mask & (1 << i)) continue;
+    gpio_num_t pin = (gpio_num_t)pins[i];
+    detachInterrupt(digitalPinToInterrupt(pins[i]));
+    if (want) {
+      attachInterrupt(digitalPinToInterrupt(pins[i]), onWakeLevel, ONLOW);
+      gpio_wakeup_enable(pin, GPIO_INTR_LOW_LEVEL);
+    } else {
+      gpio_wakeup_disable(pin);
+      attachInterrupt(digitalPinToInterrupt(pins[i]), onEdge, CHANGE);
+    }
+  }
+  wake_armed = want;
+}
+
+// 割り込みで起き、押されている間と確定するまでは一定間隔で読み続ける
+// 割り込みを使わないボタンがあれば、離されている間も BUTTON_POLL_MS ごとに読む
+void ButtonInput::sampleTask(void* arg) {
+  ButtonInput* self = static_cast<ButtonInput*>(arg);
+  TickType_t idle_wait = self->polled_mask ? pdMS_TO_TICKS(BUTTON_POLL_MS) : portMAX_DELAY;
+  bool idle = self->sample();
+  for (;;) {
+    if (idle) {
+      ulTaskNotifyTake(pdTRUE, idle_wait);
+    } else {
+      vTaskDelay(pdMS_TO_TICKS(BUTTON_SAMPLE_MS));
+    }
+    self->applyWakeMode();
+    idle = self->sample();
+  }
+}
+
+void ButtonInput::setSleepWake(bool enable) {
+  if (pin_count == 0 || enable == wake_requested) return;
+  wake_requested = enable;
+  xTaskNotifyGive(task);
+}
+
+bool ButtonInput::isActive() const {
+  if (pin_count == 0) return M5.BtnA.isPressed() || M5.BtnB.isPressed() || M5.BtnC.isPressed();
+  for (int i = 0; i < pin_count; i++) {
+    if (states[i].pressed || states[i].count) return true;
+  }
+  return false;
+}
+
+void ButtonInput::pollM5() {
+  if (pin_count > 0 || !queue) return;
+  int64_t now = esp_timer_get_time();
+  for (int i = 0; i < BUTTON_COUNT; i++) {
+    ButtonState& s = states[i];
+    bool pressed = i == BUTTON_A ? M5.BtnA.wasPressed() : i == BUTTON_B ? M5.BtnB.wasPressed() : M5.BtnC.wasPressed();
+    bool hold = i == BUTTON_A ? M5.BtnA.wasHold() : i == BUTTON_B ? M5.BtnB.wasHold() : M5.BtnC.wasHold();
+    bool released = i == BUTTON_A ? M5.BtnA.wasReleased() : i == BUTTON_B ? M5.BtnB.wasReleased() : M5.BtnC.wasReleased();
+    if (pressed) {
+      s.pressed_us = now;
+      push(i, BUTTON_PRESS, 0, now);
+    }
+    if (hold) push(i, BUTTON_HOLD, (uint32_t)((now - s.pressed_us) / 1000), now);
+    if (released) push(i, BUTTON_RELEASE, (uint32_t)((now - s.pressed_us) / 1000), now);
+  }
+}
+
+bool ButtonInput::next(ButtonEvent& event) {
+  if (lookahead_count > 0) {
+    event = lookahead[0];
+    lookahead_count--;
+    memmove(lookahead, lookahead + 1, lookahead_count * sizeof(ButtonEvent));
+    return true;
+  }
+  return queue && xQueueReceive(queue, &event, 0) == pdTRUE;
+}
+
+bool ButtonInput::take(ButtonId button, ButtonEventType type) {
+  // キューの中身を先読みに移してから探す（取り出した順は next() でそのまま返る）
+  while (queue && lookahead_count < BUTTON_QUEUE_LENGTH &&
+         xQueueReceive(queue, &lookahead[lookahead_count], 0) == pdTRUE) {
+    lookahead_count++;
+  }
+  for (int i = 0; i < lookahead_count; i++) {
+    if (lookahead[i].button == button && lookahead[i].type == type) {
+      lookahead_count--;
+      memmove(lookahead + i, lookahead + i + 1, (lookahead_count - i) * sizeof(ButtonEvent));
+      return true;
+    }
+  }
+  return false;
+}
+
+const char* ButtonInput::buttonName(uint8_t button) {
+  switch (button) {
+    case BUTTON_A: return "A";
+    case BUTTON_B: return "B";
+    case BUTTON_C: return "C";
+    default:       return "?";
+  }
+}
+
+const char* ButtonInput::typeName(uint8_t type) {
+  switch (type) {
+    case BUTTON_PRESS:   return "press";
+    case BUTTON_HOLD:    return "hold";
+    case BUTTON_RELEASE: return "release";
+    default:             return "unknown";
+  }
+}
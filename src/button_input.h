@@ -0,0 +1,114 @@
+/*
+ * Button Input for Stack-chan
+ * 物理ボタンをGPIO割り込みで検知し、専用タスクが数msごとに読み取ってチャタリングを除き、
+ * 押下・長押し・離した を時刻付きのイベントとしてキューに積む
+ * loop() が connectToWiFi() やBLE再起動で止まっていても、操作は取りこぼさず押した時刻のまま届く
+ * タッチボタンの機種（Core2 / CoreS3）は M5.update() の結果を同じイベントに変換する
+ */
+
+#ifndef BUTTON_INPUT_H
+#define BUTTON_INPUT_H
+
+#include <M5Unified.h>
+#include <freertos/queue.h>
+
+#define BUTTON_SAMPLE_MS        5    // 押されている間・変化の直後の読み取り間隔
+#define BUTTON_DEBOUNCE_SAMPLES 4    // この回数続けて同じ値なら確定（5ms x 4 = 20ms）
+#ifndef BUTTON_HOLD_MS
+#define BUTTON_HOLD_MS          500  // M5Unified の長押し判定と同じ
+#endif
+#define BUTTON_QUEUE_LENGTH     16
+// GPIO36/39 は ESP32 のエラッタで無線・ADCの動作中に偽のエッジが入るので、割り込みを使わずこの間隔で見回る
+#define BUTTON_POLL_MS          20
+
+enum ButtonId {
+  BUTTON_A = 0,
+  BUTTON_B,
+  BUTTON_C,
+  BUTTON_COUNT
+};
+
+enum ButtonEventType {
+  BUTTON_PRESS = 0,
+  BUTTON_HOLD,
+  BUTTON_RELEASE
+};
+
+struct ButtonEvent {
+  uint8_t button;    // ButtonId
+  uint8_t type;      // ButtonEventType
+  uint32_t held_ms;  // HOLD / RELEASE: 押してからの時間
+  int64_t time_us;   // 変化が始まった時刻（esp_timer）
+};
+
+struct ButtonInputStats {
+  uint32_t events;
+  uint32_t dropped;  // キューが一杯で捨てた数
+  uint32_t bounces;  // 確定前に元に戻った変化（チャタリング）
+};
+
+class ButtonInput {
+public:
+  ButtonInput();
+
+  // 機種ごとのボタンのピンに割り込みを登録し、読み取りタスクを起動する（M5.begin() の後に呼ぶ）
+  void begin();
+
+  // GPIO割り込みで検知できる機種か（タッチボタンの機種は loop() での見回りが必要）
+  bool isInterruptDriven() const { return pin_count > 0; }
+
+  // タッチボタンの機種用: M5.update() の後に呼ぶ（割り込みの機種では何もしない）
+  void pollM5();
+
+  // 押されている・確定待ちのボタンがあるか
+  bool isActive() const;
+
+  // ライトスリープ中はエッジの割り込みが届かないので、押されたレベルで起きる設定に切り替える
+  // 押されて起きたら読み取りタスクがエッジの割り込みに戻す（次に眠るときにまた呼ぶ）
+  void setSleepWake(bool enable);
+
+  // 以下は消費側（loop タスク）だけが呼ぶ
+  // 次のイベントを取り出す（なければ false、待たない）
+  bool next(ButtonEvent& event);
+  // 指定のイベントだけを取り出す（他のイベントは順番を保って残す）
+  bool take(ButtonId button, ButtonEventType type);
+
+  ButtonInputStats getStats() const { return stats; }
+
+  static const char* buttonName(uint8_t button);
+  static const char* typeName(uint8_t type);
+
+private:
+  struct ButtonState {
+    bool pressed;        // 確定した状態
+    uint8_t count;       // 確定と違う値が続いた回数
+    int64_t change_us;   // 違う値を最初に読んだ時刻
+    int64_t pressed_us;  // 押下が確定したときの変化の時刻
+    bool hold_sent;
+  };
+
+  QueueHandle_t queue;
+  TaskHandle_t task;
+  uint8_t pins[BUTTON_COUNT];
+  uint8_t pin_count;
+  uint8_t polled_mask;  // 割り込みを使わず見回るボタン（GPIO36/39）
+  ButtonState states[BUTTON_COUNT];
+  ButtonEvent lookahead[BUTTON_QUEUE_LENGTH];  // take() で先読みした分
+  uint8_t lookahead_count;
+  ButtonInputStats stats;
+  volatile bool wake_requested;  // loop() が眠る前に要求した
+  volatile bool wake_fired;      // レベルの割り込みが来た
+  bool wake_armed;               // 読み取りタスクが設定済み
+
+  void push(uint8_t button, ButtonEventType type, uint32_t held_ms, int64_t time_us);
+  bool sample();
+  void applyWakeMode();
+  static bool hasGlitchErrata(uint8_t pin);
+  static void IRAM_ATTR onEdge();
+  static void IRAM_ATTR onWakeLevel();
+  static void sampleTask(void* arg);
+};
+
+extern ButtonInput button_input;
+
+#endif
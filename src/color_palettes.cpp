@@ -0,0 +1,134 @@
+/*
+ * Color Palettes for Stack-chan
+ * 組み込みパレットはフラッシュ上の定数テーブル、カスタムパレットは固定スロットに保持する
+ */
+
+#include "color_palettes.h"
+
+PaletteBank palette_bank;
+
+// 組み込みパレット（constexpr なので .rodata＝フラッシュに置かれ、起動時の初期化処理もない）
+// 吹き出し色などは M5Stack-Avatar の ColorPalette 既定値と同じ
+static constexpr PaletteDef BUILTIN_PALETTES[PALETTE_BUILTIN_COUNT] = {
+  //  名前          primary     secondary  background  balloon_fg  balloon_bg
+  { "標準色",     TFT_WHITE,  TFT_BLACK, TFT_BLACK,  TFT_BLACK,  TFT_WHITE },
+  { "青系",       TFT_YELLOW, TFT_BLACK, TFT_BLUE,   TFT_BLACK,  TFT_WHITE },
+  { "緑系",       TFT_WHITE,  TFT_BLACK, TFT_GREEN,  TFT_BLACK,  TFT_WHITE },
+  { "赤系",       TFT_WHITE,  TFT_BLACK, TFT_RED,    TFT_BLACK,  TFT_WHITE },
+  { "紫系",       TFT_YELLOW, TFT_BLACK, TFT_PURPLE, TFT_BLACK,  TFT_WHITE },
+  { "オレンジ系", TFT_BLACK,  TFT_BLACK, TFT_ORANGE, TFT_BLACK,  TFT_WHITE },
+};
+
+PaletteBank::PaletteBank() {
+  memset(custom, 0, sizeof(custom));
+  for (int i = 0; i < PALETTE_COUNT; i++) {
+    version[i] = 1;
+    converted_version[i] = 0;
+  }
+  current = &BUILTIN_PALETTES[0];
+  current_index = 0;
+}
+
+const PaletteDef* PaletteBank::get(int index) const {
+  if (index >= 0 && index < PALETTE_BUILTIN_COUNT) return &BUILTIN_PALETTES[index];
+  int slot = index - PALETTE_BUILTIN_COUNT;
+  if (slot >= 0 && slot < PALETTE_CUSTOM_SLOTS && custom[slot].used) return &custom[slot].def;
+  return nullptr;
+}
+
+bool PaletteBank::isDefined(int index) const {
+  return get(index) != nullptr;
+}
+
+bool PaletteBank::select(int index) {
+  const PaletteDef* def = get(index);
+  if (!def) return false;
+  current = def;
+  current_index = index;
+  return true;
+}
+
+int PaletteBank::nextIndex(int index) const {
+  for (int i = 1; i <= PALETTE_COUNT; i++) {
+    int next = (index + i) % PALETTE_COUNT;
+    if (isDefined(next)) return next;
+  }
+  return 0;
+}
+
+bool PaletteBank::setCustom(int slot, const char* name, const PaletteDef& colors) {
+  if (slot < 0 || slot >= PALETTE_CUSTOM_SLOTS) return false;
+
+  CustomSlot& s = custom[slot];
+  if (name && name[0]) {
+    // 収まらない名前は UTF-8 の文字の途中で切らない（継続バイトの手前まで戻る）
+    size_t len = strlen(name);
+    if (len > sizeof(s.name) - 1) {
+      len = sizeof(s.name) - 1;
+      while (len > 0 && ((uint8_t)name[len] & 0xC0) == 0x80) len--;
+    }
+    memcpy(s.name, name, len);
+    s.name[len] = '\0';
+  } else {
+    snprintf(s.name, sizeof(s.name), "カスタム%d", slot + 1);
+  }
+  s.def = colors;
+  s.def.name = s.name;
+  s.used = true;
+  // 色を書き終えてから進める（書き換え中に変換した色は次の colorPalette() で作り直される）
+  // 0 は「未変換」に使うので飛ばす
+  uint8_t v = version[PALETTE_BUILTIN_COUNT + slot] + 1;
+  version[PALETTE_BUILTIN_COUNT + slot] = v ? v : 1;
+  return true;
+}
+
+bool PaletteBank::clearCustom(int slot) {
+  if (slot < 0 || slot >= PALETTE_CUSTOM_SLOTS) return false;
+  // 使用中のスロットは消さない（表示中の色が参照しているため）
+  if (current == &custom[slot].def) return false;
+  custom[slot].used = false;
+  return true;
+}
+
+const ColorPalette& PaletteBank::colorPalette(int index) {
+  const PaletteDef* def = get(index);
+  if (!def) return colorPalette(0);
+  uint8_t v = version[index];
+  if (converted_version[index] != v) {
+    toColorPalette(*def, converted[index]);
+    converted_version[index] = v;
+  }
+  return converted[index];
+}
+
+void PaletteBank::toColorPalette(const PaletteDef& def, ColorPalette& out) {
+  out.set(COLOR_PRIMARY, def.primary);
+  out.set(COLOR_SECONDARY, def.secondary);
+  out.set(COLOR_BACKGROUND, def.background);
+  out.set(COLOR_BALLOON_FOREGROUND, def.balloon_foreground);
+  out.set(COLOR_BALLOON_BACKGROUND, def.balloon_background);
+}
+
+bool PaletteBank::sameColors(const PaletteDef& a, const PaletteDef& b) {
+  return a.primary == b.primary && a.secondary == b.secondary && a.background == b.background &&
+         a.balloon_foreground == b.balloon_foreground && a.balloon_background == b.balloon_background;
+}
+
+bool PaletteBank::parseHexColor(const String& text, uint16_t& out) {
+  const char* p = text.c_str();
+  if (*p == '#') p++;
+  if (strlen(p) != 6) return false;
+
+  uint32_t rgb = 0;
+  for (int i = 0; i < 6; i++) {
+    char c = p[i];
+    uint32_t v;
+    if (c >= '0' && c <= '9') v = c - '0';
+    else if (c >= 'a' && c <= 'f') v = c - 'a' + 10;
+    else if (c >= 'A' && c <= 'F') v = c - 'A' + 10;
+    else return false;
+    rgb = (rgb << 4) | v;
+  }
+  out = lgfx::color565((rgb >> 16) & 0xFF, (rgb >> 8) & 0xFF, rgb & 0xFF);
+  return true;
+}
@@ -0,0 +1,78 @@
+/*
+ * Color Palettes for Stack-chan
+ * 組み込みパレットはフラッシュ上の定数テーブル、カスタムパレットは固定スロットに保持する
+ * 切り替えはポインタの差し替えだけで行い、ヒープ確保はしない
+ */
+
+#ifndef COLOR_PALETTES_H
+#define COLOR_PALETTES_H
+
+#include <M5Unified.h>
+#include <Avatar.h>
+
+using namespace m5avatar;
+
+#define PALETTE_BUILTIN_COUNT 6
+#ifndef PALETTE_CUSTOM_SLOTS
+#define PALETTE_CUSTOM_SLOTS  4
+#endif
+#define PALETTE_COUNT (PALETTE_BUILTIN_COUNT + PALETTE_CUSTOM_SLOTS)
+#define PALETTE_NAME_MAX 24  // カスタムパレット名（UTF-8バイト数、終端含む。超える分は文字の境目で切る）
+
+// 色はすべて RGB565（ColorPalette と同じ）
+struct PaletteDef {
+  const char* name;
+  uint16_t primary;
+  uint16_t secondary;
+  uint16_t background;
+  uint16_t balloon_foreground;
+  uint16_t balloon_background;
+};
+
+class PaletteBank {
+public:
+  PaletteBank();
+
+  // 使用中のパレット（ポインタを返すだけ）
+  const PaletteDef* active() const { return current; }
+  int activeIndex() const { return current_index; }
+
+  // index: 0-5 組み込み, 6- カスタムスロット。未登録スロットなら false
+  bool select(int index);
+  const PaletteDef* get(int index) const;
+  bool isDefined(int index) const;
+
+  // 次の登録済みパレット番号（空きスロットは飛ばす）
+  int nextIndex(int index) const;
+
+  // カスタムパレットをスロットへ書き込む（slot: 0 - PALETTE_CUSTOM_SLOTS-1）
+  bool setCustom(int slot, const char* name, const PaletteDef& colors);
+  bool clearCustom(int slot);
+
+  // Avatar へ渡す形（登録済みパレットは一度だけ変換して使い回す。描画タスクから呼ぶ）
+  const ColorPalette& colorPalette(int index);
+  // out の色を def で書き換える（キーは既にあるので map の節点は作り直さない）
+  static void toColorPalette(const PaletteDef& def, ColorPalette& out);
+  // 名前以外の色がすべて同じか
+  static bool sameColors(const PaletteDef& a, const PaletteDef& b);
+  // "#RRGGBB" / "RRGGBB" を RGB565 へ。書式不正なら false
+  static bool parseHexColor(const String& text, uint16_t& out);
+
+private:
+  struct CustomSlot {
+    PaletteDef def;
+    char name[PALETTE_NAME_MAX];
+    bool used;
+  };
+
+  CustomSlot custom[PALETTE_CUSTOM_SLOTS];
+  ColorPalette converted[PALETTE_COUNT];  // colorPalette() の変換済みの色（描画タスクだけが書く）
+  uint8_t converted_version[PALETTE_COUNT];
+  volatile uint8_t version[PALETTE_COUNT];  // setCustom() のたびに進め、変換済みの色を作り直させる
+  const PaletteDef* volatile current;
+  volatile int current_index;
+};
+
+extern PaletteBank palette_bank;
+
+#endif
@@ -0,0 +1,130 @@
+/*
+ * Display Profile for Stack-chan
+ * 画面サイズごとのレイアウト・フォント・バッファ量をコンパイル時に決める
+ * platformio.ini の環境ごとに -DDISPLAY_PROFILE=... で選択する（省略時は 320x240 の Core 系）
+ */
+
+#ifndef DISPLAY_PROFILE_H
+#define DISPLAY_PROFILE_H
+
+#include <M5Unified.h>
+
+#define DISPLAY_PROFILE_CORE   0  // M5Stack Core / Core2 / CoreS3 / Fire（320x240）
+#define DISPLAY_PROFILE_STICKC 1  // M5StickC（160x80、横向き）
+#define DISPLAY_PROFILE_ATOMS3 2  // AtomS3（128x128）
+
+#ifndef DISPLAY_PROFILE
+#define DISPLAY_PROFILE DISPLAY_PROFILE_CORE
+#endif
+
+// 顔パーツは M5Stack-Avatar 標準Face（320x240）の座標で書き、
+// face_scale_num / face_scale_den 倍して face_offset_x/y だけずらした位置に描く
+template <int Profile>
+struct DisplayTraits;
+
+template <>
+struct DisplayTraits<DISPLAY_PROFILE_CORE> {
+  static constexpr const char* name = "core";
+  static constexpr int width = 320;
+  static constexpr int height = 240;
+  static constexpr int rotation = -1;  // M5Unified の既定のまま
+
+  static constexpr int face_scale_num = 1;
+  static constexpr int face_scale_den = 1;
+  static constexpr int face_offset_x = 0;
+  static constexpr int face_offset_y = 0;
+
+  // 吹き出し（口の下の帯領域）
+  static constexpr int balloon_x = 16;
+  static constexpr int balloon_y = 186;
+  static constexpr int balloon_width = 288;
+  static constexpr int balloon_height = 48;
+  static constexpr int balloon_radius = 8;
+  static constexpr int balloon_padding = 8;
+  static constexpr int balloon_lines = 2;
+
+  static constexpr int glyph_slots = 0;            // 0: GlyphCache の既定値（PSRAM有無で決める）
+  static constexpr size_t balloon_cache_budget = 0;  // 0: BalloonCache の既定値
+  static constexpr int frame_band_height = 40;
+  static constexpr bool hud_visible = true;
+
+  static const lgfx::IFont* font() { return &fonts::efontJA_12; }
+};
+
+template <>
+struct DisplayTraits<DISPLAY_PROFILE_STICKC> {
+  static constexpr const char* name = "m5stick-c";
+  static constexpr int width = 160;
+  static constexpr int height = 80;
+  static constexpr int rotation = 1;
+
+  // 顔の部分（y=60〜180）を 1/2 にして上に詰める
+  static constexpr int face_scale_num = 1;
+  static constexpr int face_scale_den = 2;
+  static constexpr int face_offset_x = 0;
+  static constexpr int face_offset_y = -26;
+
+  // 1行の吹き出しを下端に（1bppキャッシュのため x と幅は8の倍数）
+  static constexpr int balloon_x = 0;
+  static constexpr int balloon_y = 60;
+  static constexpr int balloon_width = 160;
+  static constexpr int balloon_height = 20;
+  static constexpr int balloon_radius = 4;
+  static constexpr int balloon_padding = 2;
+  static constexpr int balloon_lines = 1;
+
+  static constexpr int glyph_slots = 48;
+  static constexpr size_t balloon_cache_budget = 4096;
+  static constexpr int frame_band_height = 20;
+  static constexpr bool hud_visible = false;  // 画面の1/5を覆うので既定では隠す
+
+  static const lgfx::IFont* font() { return &fonts::efontJA_10; }
+};
+
+template <>
+struct DisplayTraits<DISPLAY_PROFILE_ATOMS3> {
+  static constexpr const char* name = "m5atoms3";
+  static constexpr int width = 128;
+  static constexpr int height = 128;
+  static constexpr int rotation = -1;
+
+  static constexpr int face_scale_num = 2;
+  static constexpr int face_scale_den = 5;
+  static constexpr int face_offset_x = 0;
+  static constexpr int face_offset_y = 0;
+
+  static constexpr int balloon_x = 0;
+  static constexpr int balloon_y = 88;
+  static constexpr int balloon_width = 128;
+  static constexpr int balloon_height = 38;
+  static constexpr int balloon_radius = 4;
+  static constexpr int balloon_padding = 2;
+  static constexpr int balloon_lines = 2;
+
+  static constexpr int glyph_slots = 64;
+  static constexpr size_t balloon_cache_budget = 4096;
+  static constexpr int frame_band_height = 32;
+  static constexpr bool hud_visible = false;
+
+  static const lgfx::IFont* font() { return &fonts::efontJA_12; }
+};
+
+typedef DisplayTraits<DISPLAY_PROFILE> DisplayProfile;
+
+// Face座標系の長さをこの画面の長さに変換する（正の値は 0 にしない）
+constexpr int faceScale(int v) {
+  return v > 0 && v * DisplayProfile::face_scale_num < DisplayProfile::face_scale_den
+             ? 1
+             : v * DisplayProfile::face_scale_num / DisplayProfile::face_scale_den;
+}
+
+// Face座標系の位置をこの画面の位置に変換する
+constexpr int faceX(int x) { return x * DisplayProfile::face_scale_num / DisplayProfile::face_scale_den + DisplayProfile::face_offset_x; }
+constexpr int faceY(int y) { return y * DisplayProfile::face_scale_num / DisplayProfile::face_scale_den + DisplayProfile::face_offset_y; }
+
+static_assert(DisplayProfile::balloon_x + DisplayProfile::balloon_width <= DisplayProfile::width,
+              "吹き出しが画面の右端からはみ出しています");
+static_assert(DisplayProfile::balloon_y + DisplayProfile::balloon_height <= DisplayProfile::height,
+              "吹き出しが画面の下端からはみ出しています");
+
+#endif
@@ -0,0 +1,52 @@
+/*
+ * Event Bus for Stack-chan
+ * 種類ごとの購読者を呼び分ける同期型の配信
+ * 購読者はコンパイル時に決まる定数の表（フラッシュに置かれ、起動時の登録もヒープも使わない）
+ * publish() は表を順に見て、呼んだタスクでそのまま購読者を呼ぶ（キューもコピーもない）
+ * Arduino に依存しないので、ホスト上でもそのまま動かせる
+ */
+
+#ifndef EVENT_BUS_H
+#define EVENT_BUS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define EVENT_BIT(type) (1UL << (type))
+
+// Event は type（0-31）を持つ構造体
+template <typename Event>
+struct EventSubscriber {
+  const char* name;
+  uint32_t mask;                       // 受け取る種類（EVENT_BIT の組み合わせ）
+  void (*handler)(const Event& event);
+};
+
+template <typename Event>
+class EventBus {
+public:
+  template <size_t N>
+  constexpr explicit EventBus(const EventSubscriber<Event> (&table)[N]) : subscribers(table), count(N) {}
+
+  // 購読者を表の順に呼ぶ。呼んだ数を返す
+  uint32_t publish(const Event& event) const {
+    uint32_t bit = EVENT_BIT(event.type);
+    uint32_t delivered = 0;
+    for (size_t i = 0; i < count; i++) {
+      if (subscribers[i].mask & bit) {
+        subscribers[i].handler(event);
+        delivered++;
+      }
+    }
+    return delivered;
+  }
+
+  size_t subscriberCount() const { return count; }
+  const EventSubscriber<Event>& subscriber(size_t index) const { return subscribers[index]; }
+
+private:
+  const EventSubscriber<Event>* subscribers;
+  size_t count;
+};
+
+#endif
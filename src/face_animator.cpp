@@ -0,0 +1,191 @@
+/*
+ * Face Animator for Stack-chan
+ * 表情パラメータ（目・眉・口）を固定小数点のキーフレームで補間し、まばたきを重ねる
+ */
+
+#include "face_animator.h"
+
+FaceAnimator face_animator;
+
+// トラック・姿勢はタイマータスクと loop の両方から触るため短いクリティカルセクションで保護
+static portMUX_TYPE anim_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// 表情ごとの目標姿勢（Q8）
+static const FacePose EXPRESSION_POSES[FACE_EXPRESSION_COUNT] = {
+  //  eye_open eye_smile brow_w brow_tilt brow_lift mouth_w mouth_open
+  {   256,     0,        0,     0,        0,        256,    0   },  // 普通
+  {   256,     256,      0,     0,        0,        256,    40  },  // 嬉しい
+  {   40,      0,        0,     0,        0,        200,    0   },  // 眠い
+  {   180,     0,        256,   77,       768,      150,    0   },  // 困った
+};
+
+// まばたき（eye_open を倍率として使うオーバーレイ）: 閉じる40ms→保持20ms→開く80ms
+static const uint8_t BLINK_KEY_COUNT = 4;
+static const uint16_t BLINK_TICKS[BLINK_KEY_COUNT] = { 0, 2, 3, 7 };
+static const fx8_t BLINK_OPEN[BLINK_KEY_COUNT] = { FX8_ONE, 0, 0, FX8_ONE };
+
+static fx8_t lerpFx8(fx8_t a, fx8_t b, int32_t t) {
+  return a + (((int32_t)(b - a) * t) >> 8);
+}
+
+FaceAnimator::FaceAnimator() {
+  memset(&base, 0, sizeof(base));
+  memset(&overlay, 0, sizeof(overlay));
+  pose = EXPRESSION_POSES[FACE_NEUTRAL];
+  base.frames[0].pose = pose;
+  base.count = 1;
+  expression = FACE_NEUTRAL;
+  auto_blink = true;
+  ticks_to_blink = FACE_BLINK_INTERVAL_MIN / FACE_ANIM_TICK_MS;
+  rng = 0x2545F491;
+  tick_count = 0;
+  timer = nullptr;
+}
+
+void FaceAnimator::begin() {
+  if (timer) return;
+
+  esp_timer_create_args_t args = {};
+  args.callback = &FaceAnimator::onTimer;
+  args.arg = this;
+  args.dispatch_method = ESP_TIMER_TASK;
+  args.name = "face_anim";
+  if (esp_timer_create(&args, &timer) != ESP_OK) {
+    Serial.println("FaceAnimator: タイマー作成に失敗");
+    timer = nullptr;
+    return;
+  }
+  esp_timer_start_periodic(timer, FACE_ANIM_TICK_MS * 1000ULL);
+  Serial.printf("FaceAnimator: %dms ティックで開始\n", FACE_ANIM_TICK_MS);
+}
+
+void FaceAnimator::onTimer(void* arg) {
+  static_cast<FaceAnimator*>(arg)->tick();
+}
+
+void FaceAnimator::setExpression(int e, uint16_t duration_ms) {
+  if (e < 0 || e >= FACE_EXPRESSION_COUNT) return;
+
+  uint16_t ticks = duration_ms / FACE_ANIM_TICK_MS;
+  if (ticks == 0) ticks = 1;
+
+  portENTER_CRITICAL(&anim_lock);
+  // 補間中に割り込まれても途切れないよう、現在のベース姿勢から始める
+  FacePose from;
+  evaluate(base, from);
+  base.frames[0].tick = 0;
+  base.frames[0].pose = from;
+  base.frames[1].tick = ticks;
+  base.frames[1].pose = EXPRESSION_POSES[e];
+  base.count = 2;
+  base.position = 0;
+  base.playing = true;
+  expression = e;
+  portEXIT_CRITICAL(&anim_lock);
+}
+
+void FaceAnimator::startBlinkLocked() {
+  memset(&overlay.frames[0].pose, 0, sizeof(FacePose));
+  for (uint8_t i = 0; i < BLINK_KEY_COUNT; i++) {
+    overlay.frames[i].tick = BLINK_TICKS[i];
+    overlay.frames[i].pose = overlay.frames[0].pose;
+    overlay.frames[i].pose.eye_open = BLINK_OPEN[i];
+  }
+  overlay.count = BLINK_KEY_COUNT;
+  overlay.position = 0;
+  overlay.playing = true;
+  ticks_to_blink = nextBlinkTicks();
+}
+
+void FaceAnimator::blink() {
+  portENTER_CRITICAL(&anim_lock);
+  startBlinkLocked();
+  portEXIT_CRITICAL(&anim_lock);
+}
+
+void FaceAnimator::setAutoBlink(bool enabled) {
+  portENTER_CRITICAL(&anim_lock);
+  auto_blink = enabled;
+  portEXIT_CRITICAL(&anim_lock);
+}
+
+uint16_t FaceAnimator::nextBlinkTicks() {
+  // xorshift32（タイマーコンテキストでも使える軽量乱数）
+  rng ^= rng << 13;
+  rng ^= rng >> 17;
+  rng ^= rng << 5;
+  uint32_t span = FACE_BLINK_INTERVAL_MAX - FACE_BLINK_INTERVAL_MIN;
+  return (FACE_BLINK_INTERVAL_MIN + rng % (span + 1)) / FACE_ANIM_TICK_MS;
+}
+
+FacePose FaceAnimator::poseForExpression(int e) {
+  if (e < 0 || e >= FACE_EXPRESSION_COUNT) e = FACE_NEUTRAL;
+  return EXPRESSION_POSES[e];
+}
+
+FacePose FaceAnimator::getPose() {
+  portENTER_CRITICAL(&anim_lock);
+  FacePose p = pose;
+  portEXIT_CRITICAL(&anim_lock);
+  return p;
+}
+
+void FaceAnimator::evaluate(const FaceTrack& track, FacePose& out) {
+  if (track.count == 0) return;
+
+  const FaceKeyframe* f = track.frames;
+  if (track.count == 1 || track.position <= f[0].tick) {
+    out = f[0].pose;
+    return;
+  }
+  if (track.position >= f[track.count - 1].tick) {
+    out = f[track.count - 1].pose;
+    return;
+  }
+
+  uint8_t k = 0;
+  while (k + 1 < track.count - 1 && track.position >= f[k + 1].tick) k++;
+
+  const FacePose& a = f[k].pose;
+  const FacePose& b = f[k + 1].pose;
+  int32_t span = f[k + 1].tick - f[k].tick;
+  int32_t t = ((int32_t)(track.position - f[k].tick) << 8) / span;
+  // smoothstep: t^2 (3 - 2t) をQ8で計算
+  int32_t e = (t * t * (3 * FX8_ONE - 2 * t)) >> 16;
+
+  out.eye_open = lerpFx8(a.eye_open, b.eye_open, e);
+  out.eye_smile = lerpFx8(a.eye_smile, b.eye_smile, e);
+  out.brow_weight = lerpFx8(a.brow_weight, b.brow_weight, e);
+  out.brow_tilt = lerpFx8(a.brow_tilt, b.brow_tilt, e);
+  out.brow_lift = lerpFx8(a.brow_lift, b.brow_lift, e);
+  out.mouth_width = lerpFx8(a.mouth_width, b.mouth_width, e);
+  out.mouth_open = lerpFx8(a.mouth_open, b.mouth_open, e);
+}
+
+void FaceAnimator::tick() {
+  portENTER_CRITICAL(&anim_lock);
+  tick_count++;
+
+  if (base.playing) {
+    if (++base.position >= base.frames[base.count - 1].tick) base.playing = false;
+  }
+  if (overlay.playing) {
+    if (++overlay.position >= overlay.frames[overlay.count - 1].tick) overlay.playing = false;
+  } else if (auto_blink) {
+    if (ticks_to_blink > 0) {
+      ticks_to_blink--;
+    } else {
+      startBlinkLocked();
+    }
+  }
+
+  FacePose p;
+  evaluate(base, p);
+  if (overlay.playing) {
+    FacePose o;
+    evaluate(overlay, o);
+    p.eye_open = ((int32_t)p.eye_open * o.eye_open) >> 8;
+  }
+  pose = p;
+  portEXIT_CRITICAL(&anim_lock);
+}
@@ -0,0 +1,102 @@
+/*
+ * Face Animator for Stack-chan
+ * 表情パラメータ（目・眉・口）を固定小数点のキーフレームで補間し、まばたきを重ねる
+ */
+
+#ifndef FACE_ANIMATOR_H
+#define FACE_ANIMATOR_H
+
+#include <Arduino.h>
+#include <esp_timer.h>
+
+#ifndef FACE_ANIM_TICK_MS
+#define FACE_ANIM_TICK_MS        20    // アニメーションの固定ティック（ms）
+#endif
+#ifndef FACE_TRANSITION_MS
+#define FACE_TRANSITION_MS       300   // 表情切り替えの補間時間（ms）
+#endif
+#ifndef FACE_BLINK_INTERVAL_MIN
+#define FACE_BLINK_INTERVAL_MIN  2500  // まばたき間隔の下限（ms）
+#endif
+#ifndef FACE_BLINK_INTERVAL_MAX
+#define FACE_BLINK_INTERVAL_MAX  6000  // まばたき間隔の上限（ms）
+#endif
+#define FACE_ANIM_MAX_KEYFRAMES  6     // 1トラックあたりの最大キーフレーム数
+
+// Q8固定小数点（256 = 1.0）
+typedef int16_t fx8_t;
+#define FX8_ONE 256
+
+// 表情番号（current_expression と同じ並び）
+enum FaceExpression {
+  FACE_NEUTRAL = 0,
+  FACE_HAPPY,
+  FACE_SLEEPY,
+  FACE_DOUBT,
+  FACE_EXPRESSION_COUNT
+};
+
+struct FacePose {
+  fx8_t eye_open;      // 目の開き 0..1
+  fx8_t eye_smile;     // 笑い目（下側を弧状に欠く量）0..1
+  fx8_t brow_weight;   // 眉の太さ 0..1（0で非表示）
+  fx8_t brow_tilt;     // 眉の傾き -1..1（+で内側が上がる）
+  fx8_t brow_lift;     // 眉の上下オフセット（px、+で上）
+  fx8_t mouth_width;   // 口幅 0..1（最小幅〜最大幅）
+  fx8_t mouth_open;    // 口の開き 0..1
+};
+
+struct FaceKeyframe {
+  uint16_t tick;       // トラック開始からのティック数
+  FacePose pose;
+};
+
+// 固定長タイムライン（ヒープ確保なし）
+struct FaceTrack {
+  FaceKeyframe frames[FACE_ANIM_MAX_KEYFRAMES];
+  uint8_t count;
+  uint16_t position;   // 現在のティック
+  bool playing;
+};
+
+class FaceAnimator {
+public:
+  FaceAnimator();
+  void begin();
+
+  // ベーストラック: 現在の姿勢から指定表情へ補間
+  void setExpression(int expression, uint16_t duration_ms = FACE_TRANSITION_MS);
+  // オーバーレイトラック: ベースの表情を変えずにまばたき
+  void blink();
+  void setAutoBlink(bool enabled);
+
+  // 描画側から呼ぶ（スナップショットを返す）
+  FacePose getPose();
+  // 補間なしの表情ごとの目標姿勢（オフスクリーン描画用）
+  static FacePose poseForExpression(int expression);
+  int getExpression() const { return expression; }
+  uint32_t getTickCount() const { return tick_count; }
+
+  // 固定ティックで1ステップ進める
+  void tick();
+
+private:
+  FaceTrack base;
+  FaceTrack overlay;
+  FacePose pose;
+  int expression;
+  bool auto_blink;
+  uint16_t ticks_to_blink;
+  uint32_t rng;
+  uint32_t tick_count;
+  esp_timer_handle_t timer;
+
+  static void onTimer(void* arg);
+  static void evaluate(const FaceTrack& track, FacePose& out);
+  void startBlinkLocked();
+  uint16_t nextBlinkTicks();
+};
+
+extern FaceAnimator face_animator;
+
+#endif
@@ -0,0 +1,53 @@
+/*
+ * Face Parts for Stack-chan
+ * 目・眉・口を FacePose から描く関数
+ */
+
+#include "face_parts.h"
+
+void drawEyePart(M5Canvas* spi, int cx, int cy, int radius, const PartStyle& style, const FacePose& pose) {
+  int r = radius;
+  int y = cy + style.breath_px;
+  int ry = (r * pose.eye_open) >> 8;
+
+  // ほぼ閉じている場合は横線
+  if (ry < 2) {
+    spi->fillRect(cx - r, y - 1, r * 2, 2, style.primary);
+    return;
+  }
+
+  spi->fillEllipse(cx, y, r, ry, style.primary);
+
+  // 笑い目: 下側を背景色の楕円で欠いて弧にする
+  if (pose.eye_smile > 0) {
+    int cut = (r * pose.eye_smile) >> 8;
+    if (cut > 0) spi->fillEllipse(cx, y + ry, r + 1, cut, style.background);
+  }
+}
+
+void drawEyebrowPart(M5Canvas* spi, int cx, int cy, int width, bool is_left, const PartStyle& style,
+                     const FacePose& pose) {
+  int thick = (FACE_EYEBROW_THICK * pose.brow_weight) >> 8;
+  if (thick <= 0) return;  // 標準Faceと同じく通常時は眉なし
+
+  int half = width / 2;
+  int y = cy - faceScale(pose.brow_lift >> 8) + style.breath_px;
+  int dy = (half * pose.brow_tilt) >> 8;
+
+  // 内側（顔の中心寄り）の端を持ち上げる
+  int x0 = cx - half;
+  int x1 = cx + half;
+  int y0 = is_left ? y - dy : y + dy;
+  int y1 = is_left ? y + dy : y - dy;
+
+  spi->fillTriangle(x0, y0, x1, y1, x1, y1 + thick, style.primary);
+  spi->fillTriangle(x0, y0, x0, y0 + thick, x1, y1 + thick, style.primary);
+}
+
+void drawMouthPart(M5Canvas* spi, int cx, int cy, int min_width, int max_width, int min_height, int max_height,
+                   const PartStyle& style, const FacePose& pose, fx8_t lip_sync) {
+  fx8_t open = pose.mouth_open > lip_sync ? pose.mouth_open : lip_sync;
+  int w = min_width + (((max_width - min_width) * pose.mouth_width) >> 8);
+  int h = min_height + (((max_height - min_height) * open) >> 8);
+  spi->fillRect(cx - w / 2, cy - h / 2 + style.breath_px, w, h, style.primary);
+}
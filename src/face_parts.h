@@ -0,0 +1,51 @@
+/*
+ * Face Parts for Stack-chan
+ * 目・眉・口を FacePose から描く関数（Avatar の Face からも、オフスクリーン描画からも使う）
+ * M5Stack-Avatar に依存しないので、ホスト上でも M5GFX だけで描画できる
+ */
+
+#ifndef FACE_PARTS_H
+#define FACE_PARTS_H
+
+#include <M5Unified.h>
+#include "face_animator.h"
+#include "display_profile.h"
+
+// パーツ配置（中心位置、M5Stack-Avatar 標準Faceの値を DisplayProfile の画面に合わせて縮める）
+#define FACE_MOUTH_X       faceX(163)
+#define FACE_MOUTH_Y       faceY(148)
+#define FACE_EYE_R_X       faceX(90)
+#define FACE_EYE_R_Y       faceY(93)
+#define FACE_EYE_L_X       faceX(230)
+#define FACE_EYE_L_Y       faceY(96)
+#define FACE_EYEBROW_R_X   faceX(96)
+#define FACE_EYEBROW_R_Y   faceY(67)
+#define FACE_EYEBROW_L_X   faceX(230)
+#define FACE_EYEBROW_L_Y   faceY(72)
+#define FACE_EYE_RADIUS    faceScale(8)
+#define FACE_EYEBROW_WIDTH faceScale(32)
+#define FACE_EYEBROW_THICK faceScale(4)
+#define FACE_MOUTH_MIN_W   faceScale(50)
+#define FACE_MOUTH_MAX_W   faceScale(90)
+#define FACE_MOUTH_MIN_H   faceScale(4)
+#define FACE_MOUTH_MAX_H   faceScale(60)
+#define FACE_BREATH_PX     faceScale(3)
+
+// パーツ描画に必要な色と呼吸オフセット
+struct PartStyle {
+  uint16_t primary;
+  uint16_t background;
+  uint16_t balloon_foreground;
+  uint16_t balloon_background;
+  int breath_px;
+};
+
+// (cx, cy) はパーツの中心
+void drawEyePart(M5Canvas* spi, int cx, int cy, int radius, const PartStyle& style, const FacePose& pose);
+void drawEyebrowPart(M5Canvas* spi, int cx, int cy, int width, bool is_left, const PartStyle& style,
+                     const FacePose& pose);
+// 表情の開きとリップシンク（setMouthOpenRatio）の大きい方で口を開く
+void drawMouthPart(M5Canvas* spi, int cx, int cy, int min_width, int max_width, int min_height, int max_height,
+                   const PartStyle& style, const FacePose& pose, fx8_t lip_sync);
+
+#endif
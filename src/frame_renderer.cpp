@@ -0,0 +1,111 @@
+/*
+ * Frame Renderer for Stack-chan
+ * Avatar描画タスクとは独立に、顔1フレームを横帯（バンド）単位でメモリ上に描画する
+ */
+
+#include "frame_renderer.h"
+
+FrameRenderer frame_renderer;
+
+FrameRenderer::FrameRenderer() : band_height(FRAME_BAND_HEIGHT), ready(false) {}
+
+FrameColors frameColorsFor(const PaletteDef* def) {
+  FrameColors colors;
+  colors.primary = def->primary;
+  colors.background = def->background;
+  colors.balloon_foreground = def->balloon_foreground;
+  colors.balloon_background = def->balloon_background;
+  return colors;
+}
+
+bool FrameRenderer::begin(const lgfx::IFont* font, int h) {
+  if (ready) end();
+
+  band_height = (h < 1 || h > FRAME_HEIGHT) ? FRAME_BAND_HEIGHT : h;
+  band.setColorDepth(16);
+  band.setPsram(psramFound());
+  if (!band.createSprite(FRAME_WIDTH, band_height)) {
+    Serial.printf("FrameRenderer: 帯スプライト確保失敗 (%dx%d)\n", FRAME_WIDTH, band_height);
+    return false;
+  }
+
+  balloon.begin(font, FRAME_GLYPH_SLOTS);
+  ready = true;
+  return true;
+}
+
+void FrameRenderer::end() {
+  band.deleteSprite();
+  balloon.end();
+  ready = false;
+}
+
+void FrameRenderer::setText(const char* text) {
+  balloon.setText(text);
+}
+
+void FrameRenderer::drawBand(int top, const PartStyle& style, const FacePose& pose) {
+  band.fillSprite(style.background);
+
+  // 帯の上端を原点にずらして描く（はみ出した部分はスプライト側で切り取られる）
+  drawEyebrowPart(&band, FACE_EYEBROW_R_X, FACE_EYEBROW_R_Y - top, FACE_EYEBROW_WIDTH, false, style, pose);
+  drawEyebrowPart(&band, FACE_EYEBROW_L_X, FACE_EYEBROW_L_Y - top, FACE_EYEBROW_WIDTH, true, style, pose);
+  drawEyePart(&band, FACE_EYE_R_X, FACE_EYE_R_Y - top, FACE_EYE_RADIUS, style, pose);
+  drawEyePart(&band, FACE_EYE_L_X, FACE_EYE_L_Y - top, FACE_EYE_RADIUS, style, pose);
+  drawMouthPart(&band, FACE_MOUTH_X, FACE_MOUTH_Y - top, FACE_MOUTH_MIN_W, FACE_MOUTH_MAX_W, FACE_MOUTH_MIN_H,
+                FACE_MOUTH_MAX_H, style, pose, 0);
+
+  BalloonStyle balloon_style;
+  balloon_style.foreground = style.balloon_foreground;
+  balloon_style.background = style.balloon_background;
+  balloon_style.backdrop = style.background;
+  balloon.draw(&band, balloon_style, top);
+}
+
+uint32_t FrameRenderer::render(const FrameColors& colors, const FacePose& pose, FrameBandSink sink, void* user) {
+  if (!ready) return 0;
+
+  PartStyle style;
+  style.primary = colors.primary;
+  style.background = colors.background;
+  style.balloon_foreground = colors.balloon_foreground;
+  style.balloon_background = colors.balloon_background;
+  style.breath_px = 0;  // 呼吸は時間依存なので検証用フレームでは止める
+
+  uint32_t start = micros();
+  for (int top = 0; top < FRAME_HEIGHT; top += band_height) {
+    int rows = FRAME_HEIGHT - top < band_height ? FRAME_HEIGHT - top : band_height;
+    drawBand(top, style, pose);
+    if (!sink) continue;
+
+    // スプライトはSPI転送用にビッグエンディアンで持っているので、そのまま入れ替えて渡す
+    uint8_t* px = (uint8_t*)band.getBuffer();
+    size_t bytes = (size_t)FRAME_WIDTH * rows * 2;
+    for (size_t i = 0; i < bytes; i += 2) {
+      uint8_t t = px[i];
+      px[i] = px[i + 1];
+      px[i + 1] = t;
+    }
+    if (!sink(px, bytes, top, rows, user)) return 0;
+  }
+  return micros() - start;
+}
+
+FrameBenchResult FrameRenderer::benchmark(const FrameColors* palettes, int palette_count, int frames) {
+  FrameBenchResult r;
+  memset(&r, 0, sizeof(r));
+  if (!ready || palette_count <= 0 || frames <= 0) return r;
+
+  r.bands_per_frame = (FRAME_HEIGHT + band_height - 1) / band_height;
+  for (int i = 0; i < frames; i++) {
+    FacePose pose = FaceAnimator::poseForExpression(i % FACE_EXPRESSION_COUNT);
+    uint32_t us = render(palettes[i % palette_count], pose, nullptr, nullptr);
+    r.total_us += us;
+    if (us > r.max_frame_us) r.max_frame_us = us;
+    r.frames++;
+    if ((i & 7) == 7) yield();  // 長時間ループでWDTを起こさない
+  }
+  r.avg_frame_us = r.total_us / r.frames;
+  r.fps = r.total_us ? r.frames * 1000000.0f / r.total_us : 0;
+  return r;
+}
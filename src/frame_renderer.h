@@ -0,0 +1,84 @@
+/*
+ * Frame Renderer for Stack-chan
+ * Avatar描画タスクとは独立に、顔1フレームを横帯（バンド）単位でメモリ上に描画する
+ * 画面やFaceのフルフレームスプライトを使わないため、検証用の画像出力や描画ベンチマークに使える
+ */
+
+#ifndef FRAME_RENDERER_H
+#define FRAME_RENDERER_H
+
+#include <M5Unified.h>
+#include "face_parts.h"
+#include "speech_balloon.h"
+#include "color_palettes.h"
+
+// 出力フレームサイズ（画面と同じ）
+#define FRAME_WIDTH  DisplayProfile::width
+#define FRAME_HEIGHT DisplayProfile::height
+
+// 帯の高さ（Core系は RGB565 で 320 x 40 x 2 = 25.6KB）
+#ifndef FRAME_BAND_HEIGHT
+#define FRAME_BAND_HEIGHT DisplayProfile::frame_band_height
+#endif
+
+// オフスクリーン用吹き出しのグリフキャッシュ（常駐しないので小さめ）
+#ifndef FRAME_GLYPH_SLOTS
+#define FRAME_GLYPH_SLOTS 64
+#endif
+
+// 描画に使う色（RGB565、ColorPalette::get() の値）
+struct FrameColors {
+  uint16_t primary;
+  uint16_t background;
+  uint16_t balloon_foreground;
+  uint16_t balloon_background;
+};
+
+// パレットの色から描画に使う色を取り出す
+FrameColors frameColorsFor(const PaletteDef* def);
+
+struct FrameBenchResult {
+  uint32_t frames;
+  uint32_t bands_per_frame;
+  uint32_t total_us;
+  uint32_t avg_frame_us;
+  uint32_t max_frame_us;
+  float fps;
+};
+
+// 1帯描画ごとに呼ばれる。pixels はリトルエンディアン RGB565（uint16_t 配列としてそのまま読める）
+// false を返すと描画を中断する
+typedef bool (*FrameBandSink)(const uint8_t* pixels, size_t bytes, int y, int rows, void* user);
+
+class FrameRenderer {
+public:
+  FrameRenderer();
+
+  // 帯スプライトと吹き出し用キャッシュを確保する（使い終わったら end() で解放）
+  bool begin(const lgfx::IFont* font, int band_height = FRAME_BAND_HEIGHT);
+  void end();
+
+  // 吹き出しのセリフ（空文字なら吹き出しなし）
+  void setText(const char* text);
+
+  // 1フレームを上から順に帯単位で描画する。sink が nullptr なら描画のみ（ベンチマーク用）
+  // 戻り値は描画にかかった時間（us、sink の時間を含む）。中断・未初期化時は 0
+  uint32_t render(const FrameColors& colors, const FacePose& pose, FrameBandSink sink, void* user);
+
+  // 表情・パレットを切り替えながら frames 枚描画して fps を測る
+  FrameBenchResult benchmark(const FrameColors* palettes, int palette_count, int frames);
+
+  int getBandHeight() const { return band_height; }
+
+private:
+  M5Canvas band;
+  int band_height;
+  bool ready;
+  SpeechBalloon balloon;
+
+  void drawBand(int top, const PartStyle& style, const FacePose& pose);
+};
+
+extern FrameRenderer frame_renderer;
+
+#endif
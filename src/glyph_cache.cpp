@@ -0,0 +1,311 @@
+/*
+ * Glyph Cache for Stack-chan
+ * efontJA_12 等の圧縮フォントから展開したグリフを1bppビットマップで保持するLRUキャッシュ
+ */
+
+#include "glyph_cache.h"
+#include <esp_heap_caps.h>
+
+uint32_t utf8NextCodepoint(const char*& p) {
+  const uint8_t* s = reinterpret_cast<const uint8_t*>(p);
+  uint32_t c = s[0];
+  if (c == 0) return 0;
+
+  int extra = 0;
+  if (c < 0x80) {
+    extra = 0;
+  } else if ((c & 0xE0) == 0xC0) {
+    c &= 0x1F; extra = 1;
+  } else if ((c & 0xF0) == 0xE0) {
+    c &= 0x0F; extra = 2;
+  } else if ((c & 0xF8) == 0xF0) {
+    c &= 0x07; extra = 3;
+  } else {
+    // 不正な先頭バイトは1バイト読み飛ばして '?' 扱い
+    p++;
+    return '?';
+  }
+
+  int i = 1;
+  for (; i <= extra; i++) {
+    if ((s[i] & 0xC0) != 0x80) break;  // 途中で切れた文字
+    c = (c << 6) | (s[i] & 0x3F);
+  }
+  p += i;
+  return (i == extra + 1) ? c : '?';
+}
+
+// コードポイントを1文字分のUTF-8文字列に戻す（ラスタライズ用）
+static void encodeUtf8(uint32_t c, char* out) {
+  if (c < 0x80) {
+    out[0] = c; out[1] = 0;
+  } else if (c < 0x800) {
+    out[0] = 0xC0 | (c >> 6); out[1] = 0x80 | (c & 0x3F); out[2] = 0;
+  } else if (c < 0x10000) {
+    out[0] = 0xE0 | (c >> 12); out[1] = 0x80 | ((c >> 6) & 0x3F);
+    out[2] = 0x80 | (c & 0x3F); out[3] = 0;
+  } else {
+    out[0] = 0xF0 | (c >> 18); out[1] = 0x80 | ((c >> 12) & 0x3F);
+    out[2] = 0x80 | ((c >> 6) & 0x3F); out[3] = 0x80 | (c & 0x3F); out[4] = 0;
+  }
+}
+
+GlyphCache::GlyphCache() {
+  font = nullptr;
+  slots = nullptr;
+  buckets = nullptr;
+  slot_count = 0;
+  bucket_mask = 0;
+  used = 0;
+  lru_head = NONE;
+  lru_tail = NONE;
+  font_height = 0;
+  in_psram = false;
+  hits = 0;
+  misses = 0;
+}
+
+GlyphCache::~GlyphCache() {
+  end();
+}
+
+bool GlyphCache::begin(const lgfx::IFont* f, uint16_t count) {
+  end();
+  font = f;
+
+  if (count == 0) {
+    count = psramFound() ? GLYPH_CACHE_SLOTS_PSRAM : GLYPH_CACHE_SLOTS_INTERNAL;
+  }
+
+  // バケット数はスロット数以上の2の累乗
+  uint16_t bucket_count = 1;
+  while (bucket_count < count) bucket_count <<= 1;
+
+  size_t slot_bytes = sizeof(Glyph) * count;
+  size_t bucket_bytes = sizeof(uint16_t) * bucket_count;
+
+  // グリフ本体はPSRAM優先、ハッシュ表は参照頻度が高いので内蔵RAM
+  in_psram = false;
+  if (psramFound()) {
+    slots = static_cast<Glyph*>(heap_caps_malloc(slot_bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+    in_psram = (slots != nullptr);
+  }
+  if (!slots) {
+    slots = static_cast<Glyph*>(heap_caps_malloc(slot_bytes, MALLOC_CAP_8BIT));
+  }
+  buckets = static_cast<uint16_t*>(heap_caps_malloc(bucket_bytes, MALLOC_CAP_8BIT));
+
+  if (!slots || !buckets) {
+    Serial.println("GlyphCache: メモリ確保に失敗");
+    end();
+    return false;
+  }
+
+  slot_count = count;
+  bucket_mask = bucket_count - 1;
+  for (uint16_t i = 0; i < bucket_count; i++) buckets[i] = NONE;
+
+  scratch.setColorDepth(1);
+  scratch.createSprite(GLYPH_CELL_WIDTH, GLYPH_CELL_HEIGHT);
+  scratch.setFont(font);
+  scratch.setTextDatum(top_left);
+  scratch.setTextColor(1, 0);
+  font_height = scratch.fontHeight();
+  if (font_height > GLYPH_CELL_HEIGHT) font_height = GLYPH_CELL_HEIGHT;
+
+  Serial.printf("GlyphCache: %d slots, %d bytes (%s)\n",
+                slot_count, (int)getMemoryBytes(), in_psram ? "PSRAM" : "内蔵RAM");
+  return true;
+}
+
+void GlyphCache::end() {
+  if (slots) heap_caps_free(slots);
+  if (buckets) heap_caps_free(buckets);
+  slots = nullptr;
+  buckets = nullptr;
+  scratch.deleteSprite();
+  slot_count = 0;
+  used = 0;
+  lru_head = NONE;
+  lru_tail = NONE;
+}
+
+size_t GlyphCache::getMemoryBytes() const {
+  return sizeof(Glyph) * slot_count + sizeof(uint16_t) * (bucket_mask + 1);
+}
+
+void GlyphCache::unlinkLRU(uint16_t index) {
+  Glyph& g = slots[index];
+  if (g.prev != NONE) slots[g.prev].next = g.next; else lru_head = g.next;
+  if (g.next != NONE) slots[g.next].prev = g.prev; else lru_tail = g.prev;
+}
+
+void GlyphCache::pushFrontLRU(uint16_t index) {
+  Glyph& g = slots[index];
+  g.prev = NONE;
+  g.next = lru_head;
+  if (lru_head != NONE) slots[lru_head].prev = index;
+  lru_head = index;
+  if (lru_tail == NONE) lru_tail = index;
+}
+
+void GlyphCache::unlinkBucket(uint16_t index) {
+  uint16_t* link = &buckets[bucketOf(slots[index].codepoint)];
+  while (*link != NONE) {
+    if (*link == index) {
+      *link = slots[index].chain;
+      return;
+    }
+    link = &slots[*link].chain;
+  }
+}
+
+void GlyphCache::rasterize(Glyph& glyph, uint32_t codepoint) {
+  char utf8[5];
+  encodeUtf8(codepoint, utf8);
+
+  scratch.fillSprite(0);
+  scratch.drawString(utf8, 0, 0);
+
+  int advance = scratch.textWidth(utf8);
+  glyph.advance = advance > GLYPH_CELL_WIDTH ? GLYPH_CELL_WIDTH : advance;
+  glyph.height = font_height;
+
+  memset(glyph.bits, 0, sizeof(glyph.bits));
+  for (int y = 0; y < font_height; y++) {
+    uint8_t* row = &glyph.bits[y * (GLYPH_CELL_WIDTH / 8)];
+    for (int x = 0; x < glyph.advance; x++) {
+      if (scratch.readPixel(x, y)) {
+        row[x >> 3] |= 0x80 >> (x & 7);
+      }
+    }
+  }
+}
+
+const GlyphCache::Glyph* GlyphCache::get(uint32_t codepoint) {
+  if (!slots) return nullptr;
+
+  uint16_t bucket = bucketOf(codepoint);
+  for (uint16_t i = buckets[bucket]; i != NONE; i = slots[i].chain) {
+    if (slots[i].codepoint == codepoint) {
+      hits++;
+      if (lru_head != i) {
+        unlinkLRU(i);
+        pushFrontLRU(i);
+      }
+      return &slots[i];
+    }
+  }
+
+  misses++;
+
+  // 空きスロットがなければ最も古いグリフを追い出す
+  uint16_t index;
+  if (used < slot_count) {
+    index = used++;
+  } else {
+    index = lru_tail;
+    unlinkLRU(index);
+    unlinkBucket(index);
+  }
+
+  Glyph& g = slots[index];
+  g.codepoint = codepoint;
+  rasterize(g, codepoint);
+  g.chain = buckets[bucket];
+  buckets[bucket] = index;
+  pushFrontLRU(index);
+  return &g;
+}
+
+int GlyphCache::drawText(LovyanGFX* dst, int x, int y, const char* utf8, uint16_t color) {
+  return drawText(dst, x, y, utf8, strlen(utf8), color);
+}
+
+int GlyphCache::drawText(LovyanGFX* dst, int x, int y, const char* utf8, size_t bytes, uint16_t color) {
+  int start_x = x;
+  const char* p = utf8;
+  const char* end = utf8 + bytes;
+  uint32_t c;
+  while (p < end && (c = utf8NextCodepoint(p)) != 0) {
+    const Glyph* g = get(c);
+    if (!g) break;
+    dst->drawBitmap(x, y, g->bits, GLYPH_CELL_WIDTH, g->height, color);
+    x += g->advance;
+  }
+  return x - start_x;
+}
+
+int GlyphCache::textWidth(const char* utf8) {
+  int width = 0;
+  const char* p = utf8;
+  uint32_t c;
+  while ((c = utf8NextCodepoint(p)) != 0) {
+    const Glyph* g = get(c);
+    if (!g) break;
+    width += g->advance;
+  }
+  return width;
+}
+
+GlyphBenchResult GlyphCache::benchmark(const lgfx::IFont* font, const char* const* texts, int rounds) {
+  GlyphBenchResult result;
+  memset(&result, 0, sizeof(result));
+
+  M5Canvas canvas;
+  canvas.setColorDepth(1);
+  if (!canvas.createSprite(320, GLYPH_CELL_HEIGHT)) {
+    Serial.println("GlyphBench: キャンバス確保に失敗");
+    return result;
+  }
+  canvas.setFont(font);
+  canvas.setTextDatum(top_left);
+  canvas.setTextColor(1, 0);
+
+  // 1文字ずつ数えておく
+  uint32_t glyphs_per_round = 0;
+  for (int i = 0; texts[i] != nullptr; i++) {
+    const char* p = texts[i];
+    while (utf8NextCodepoint(p) != 0) glyphs_per_round++;
+  }
+  result.glyphs = glyphs_per_round * rounds;
+  if (result.glyphs == 0) {
+    canvas.deleteSprite();
+    return result;
+  }
+
+  // キャッシュなし: Avatar標準の吹き出しと同じく毎回フォントから展開
+  uint32_t start = micros();
+  for (int r = 0; r < rounds; r++) {
+    for (int i = 0; texts[i] != nullptr; i++) {
+      canvas.fillSprite(0);
+      canvas.drawString(texts[i], 0, 0);
+    }
+  }
+  result.uncached_us = micros() - start;
+
+  // キャッシュあり: 独立したキャッシュを使い、稼働中の統計には影響させない
+  GlyphCache cache;
+  if (cache.begin(font)) {
+    start = micros();
+    for (int r = 0; r < rounds; r++) {
+      for (int i = 0; texts[i] != nullptr; i++) {
+        canvas.fillSprite(0);
+        cache.drawText(&canvas, 0, 0, texts[i], (uint16_t)1);
+      }
+    }
+    result.cached_us = micros() - start;
+    result.hits = cache.getHits();
+    result.misses = cache.getMisses();
+  }
+
+  canvas.deleteSprite();
+
+  if (result.uncached_us > 0) {
+    result.uncached_gps = (uint64_t)result.glyphs * 1000000 / result.uncached_us;
+  }
+  if (result.cached_us > 0) {
+    result.cached_gps = (uint64_t)result.glyphs * 1000000 / result.cached_us;
+  }
+  return result;
+}
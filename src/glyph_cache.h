@@ -0,0 +1,102 @@
+/*
+ * Glyph Cache for Stack-chan
+ * efontJA_12 等の圧縮フォントから展開したグリフを1bppビットマップで保持するLRUキャッシュ
+ */
+
+#ifndef GLYPH_CACHE_H
+#define GLYPH_CACHE_H
+
+#include <M5Unified.h>
+
+// キャッシュ設定（build_flags で上書き可能）
+#ifndef GLYPH_CACHE_SLOTS_PSRAM
+#define GLYPH_CACHE_SLOTS_PSRAM    512   // PSRAM搭載機のスロット数
+#endif
+#ifndef GLYPH_CACHE_SLOTS_INTERNAL
+#define GLYPH_CACHE_SLOTS_INTERNAL 128   // PSRAM非搭載機のスロット数
+#endif
+
+// 1グリフ分のセルサイズ（efontJA_12は12x12に収まる）
+#define GLYPH_CELL_WIDTH   16
+#define GLYPH_CELL_HEIGHT  16
+#define GLYPH_CELL_BYTES   ((GLYPH_CELL_WIDTH / 8) * GLYPH_CELL_HEIGHT)
+
+// UTF-8文字列から1文字分のコードポイントを取り出してポインタを進める（終端なら0）
+uint32_t utf8NextCodepoint(const char*& p);
+
+struct GlyphBenchResult {
+  uint32_t glyphs;           // 描画したグリフ総数
+  uint32_t uncached_us;      // キャッシュなし（drawString毎回展開）の所要時間
+  uint32_t cached_us;        // キャッシュありの所要時間
+  uint32_t uncached_gps;     // glyphs/s（キャッシュなし）
+  uint32_t cached_gps;       // glyphs/s（キャッシュあり）
+  uint32_t hits;
+  uint32_t misses;
+};
+
+class GlyphCache {
+public:
+  struct Glyph {
+    uint32_t codepoint;
+    uint16_t prev;      // LRUリスト（先頭が最近使用）
+    uint16_t next;
+    uint16_t chain;     // ハッシュバケット内の次要素
+    uint8_t advance;    // 文字送り幅
+    uint8_t height;
+    uint8_t bits[GLYPH_CELL_BYTES];  // MSBファースト、1行 GLYPH_CELL_WIDTH/8 バイト
+  };
+
+  GlyphCache();
+  ~GlyphCache();
+
+  // slots=0 の場合はPSRAMの有無からスロット数を決定
+  bool begin(const lgfx::IFont* font, uint16_t slots = 0);
+  void end();
+
+  // グリフ取得（ミス時はラスタライズして最も古いスロットを置き換える）
+  const Glyph* get(uint32_t codepoint);
+
+  // キャッシュ済みグリフでテキストを描画し、描画幅を返す（color は RGB565）
+  int drawText(LovyanGFX* dst, int x, int y, const char* utf8, uint16_t color);
+  int drawText(LovyanGFX* dst, int x, int y, const char* utf8, size_t bytes, uint16_t color);
+  // LovyanGFX は uint32_t の色を RGB888 として読むので、uint32_t の色では呼べないようにしておく
+  int drawText(LovyanGFX* dst, int x, int y, const char* utf8, uint32_t color) = delete;
+  int drawText(LovyanGFX* dst, int x, int y, const char* utf8, size_t bytes, uint32_t color) = delete;
+  int textWidth(const char* utf8);
+
+  uint16_t fontHeight() const { return font_height; }
+  uint32_t getHits() const { return hits; }
+  uint32_t getMisses() const { return misses; }
+  uint16_t getSlotCount() const { return slot_count; }
+  size_t getMemoryBytes() const;
+  bool isInPsram() const { return in_psram; }
+  void resetStats() { hits = 0; misses = 0; }
+
+  // random_speeches等のテキストを繰り返し描画してキャッシュ有無の速度を比較
+  static GlyphBenchResult benchmark(const lgfx::IFont* font, const char* const* texts, int rounds);
+
+private:
+  static const uint16_t NONE = 0xFFFF;
+
+  const lgfx::IFont* font;
+  M5Canvas scratch;          // ラスタライズ用1bppキャンバス
+  Glyph* slots;
+  uint16_t* buckets;
+  uint16_t slot_count;
+  uint16_t bucket_mask;
+  uint16_t used;
+  uint16_t lru_head;
+  uint16_t lru_tail;
+  uint16_t font_height;
+  bool in_psram;
+  uint32_t hits;
+  uint32_t misses;
+
+  uint16_t bucketOf(uint32_t codepoint) const { return ((codepoint * 2654435761u) >> 16) & bucket_mask; }
+  void unlinkLRU(uint16_t index);
+  void pushFrontLRU(uint16_t index);
+  void unlinkBucket(uint16_t index);
+  void rasterize(Glyph& glyph, uint32_t codepoint);
+};
+
+#endif
@@ -0,0 +1,108 @@
+/*
+ * HUD Overlay for Stack-chan
+ * 接続状態・空きヒープ・fps を顔の上端に重ねる小さなオーバーレイ
+ */
+
+#include "hud_overlay.h"
+
+HudOverlay hud_overlay;
+
+HudOverlay::HudOverlay() {
+  glyphs = nullptr;
+  mutex = nullptr;
+  status[0] = '\0';
+  heap_kb = 0;
+  revision = 1;
+  visible = HUD_DEFAULT_VISIBLE;
+  rendered_revision = 0;
+  rendered_fps = 0;
+  fps_window_start = 0;
+  fps_frames = 0;
+  memset(&stats, 0, sizeof(stats));
+}
+
+bool HudOverlay::begin(GlyphCache* g) {
+  glyphs = g;
+  if (!mutex) {
+    mutex = xSemaphoreCreateMutex();
+  }
+  strip.setColorDepth(1);
+  if (!strip.createSprite(HUD_WIDTH, HUD_HEIGHT)) {
+    Serial.println("HudOverlay: 帯スプライト確保失敗");
+    return false;
+  }
+  return true;
+}
+
+void HudOverlay::setStatus(const char* text) {
+  if (!mutex) return;
+  xSemaphoreTake(mutex, portMAX_DELAY);
+  if (strncmp(status, text, sizeof(status) - 1) != 0) {
+    strncpy(status, text, sizeof(status) - 1);
+    status[sizeof(status) - 1] = '\0';
+    revision++;
+  }
+  xSemaphoreGive(mutex);
+}
+
+void HudOverlay::setFreeHeap(uint32_t bytes) {
+  if (!mutex) return;
+  uint16_t kb = bytes / 1024;
+  if (kb == heap_kb) return;  // KB単位で変わったときだけ描き直す
+  xSemaphoreTake(mutex, portMAX_DELAY);
+  heap_kb = kb;
+  revision++;
+  xSemaphoreGive(mutex);
+}
+
+void HudOverlay::setVisible(bool v) {
+  visible = v;
+}
+
+// 左に接続状態、右に「heap fps」を描く
+void HudOverlay::render() {
+  char text[HUD_STATUS_MAX_BYTES];
+  char metrics[32];
+
+  xSemaphoreTake(mutex, portMAX_DELAY);
+  memcpy(text, status, sizeof(text));
+  snprintf(metrics, sizeof(metrics), "%uK %ufps", heap_kb, rendered_fps);
+  rendered_revision = revision;
+  xSemaphoreGive(mutex);
+
+  strip.fillSprite(0);
+  int metrics_w = glyphs->textWidth(metrics);
+  int metrics_x = HUD_WIDTH - HUD_MARGIN - metrics_w;
+  glyphs->drawText(&strip, metrics_x, 0, metrics, (uint16_t)1);
+
+  // 状態表示が長い場合は右側の数値にかからない所で切る
+  strip.setClipRect(0, 0, metrics_x - HUD_MARGIN, HUD_HEIGHT);
+  glyphs->drawText(&strip, HUD_MARGIN, 0, text, (uint16_t)1);
+  strip.clearClipRect();
+
+  stats.renders++;
+}
+
+void HudOverlay::draw(LovyanGFX* dst, uint16_t color) {
+  if (!mutex || !glyphs) return;
+
+  // fps は描画タスクのフレーム数を1秒ごとに数える
+  unsigned long now = millis();
+  fps_frames++;
+  if (now - fps_window_start >= 1000) {
+    stats.fps = fps_frames * 1000 / (now - fps_window_start);
+    fps_window_start = now;
+    fps_frames = 0;
+  }
+
+  if (!visible) return;
+
+  if (rendered_revision != revision || rendered_fps != stats.fps) {
+    rendered_fps = stats.fps;
+    render();
+  }
+
+  // 透過（1のビットだけ）で顔に重ねる
+  dst->drawBitmap(HUD_X, HUD_Y, (const uint8_t*)strip.getBuffer(), HUD_WIDTH, HUD_HEIGHT, color);
+  stats.frames++;
+}
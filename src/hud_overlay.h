@@ -0,0 +1,72 @@
+/*
+ * HUD Overlay for Stack-chan
+ * 接続状態・空きヒープ・fps を顔の上端に重ねる小さなオーバーレイ
+ * 表示内容が変わったときだけ1bppの帯を描き直し、毎フレームは帯を重ねるだけ
+ */
+
+#ifndef HUD_OVERLAY_H
+#define HUD_OVERLAY_H
+
+#include <M5Unified.h>
+#include "glyph_cache.h"
+#include "display_profile.h"
+
+#define HUD_X            0
+#define HUD_Y            2
+#define HUD_WIDTH        DisplayProfile::width
+#define HUD_HEIGHT       GLYPH_CELL_HEIGHT
+#define HUD_MARGIN       4
+#define HUD_STATUS_MAX_BYTES 96
+
+#ifndef HUD_DEFAULT_VISIBLE
+#define HUD_DEFAULT_VISIBLE DisplayProfile::hud_visible
+#endif
+
+struct HudStats {
+  uint32_t renders;     // 帯を描き直した回数
+  uint32_t frames;      // 重ねたフレーム数
+  uint16_t fps;         // 直近1秒の描画フレーム数
+};
+
+class HudOverlay {
+public:
+  HudOverlay();
+
+  // glyphs は吹き出しと共用（描画タスク内でのみ使う）
+  bool begin(GlyphCache* glyphs);
+
+  // loop側から呼ぶ（値が変わったときだけ再描画を予約する）
+  void setStatus(const char* text);
+  void setFreeHeap(uint32_t bytes);
+  void setVisible(bool visible);
+  bool isVisible() const { return visible; }
+
+  // 描画タスクから毎フレーム呼ぶ
+  void draw(LovyanGFX* dst, uint16_t color);
+
+  HudStats getStats() const { return stats; }
+
+private:
+  M5Canvas strip;           // 1bpp（1=文字）
+  GlyphCache* glyphs;
+  SemaphoreHandle_t mutex;
+
+  // loop側が書き込む値（mutexで保護）
+  char status[HUD_STATUS_MAX_BYTES];
+  uint16_t heap_kb;
+  uint32_t revision;
+  volatile bool visible;
+
+  // 以下は描画タスク専用
+  uint32_t rendered_revision;
+  uint16_t rendered_fps;
+  unsigned long fps_window_start;
+  uint16_t fps_frames;
+  HudStats stats;
+
+  void render();
+};
+
+extern HudOverlay hud_overlay;
+
+#endif
@@ -0,0 +1,78 @@
+/*
+ * Idle Governor for Stack-chan
+ * 最後の操作からの経過時間で 通常 → 減光 → 休止 と段階を下げる状態遷移
+ */
+
+#include "idle_governor.h"
+#include <string.h>
+
+IdleGovernor::IdleGovernor() {
+  memset(&config, 0, sizeof(config));
+  current = POWER_ACTIVE;
+  last_activity_ms = 0;
+  entered_ms = 0;
+  memset(level_ms, 0, sizeof(level_ms));
+  transition_count = 0;
+}
+
+void IdleGovernor::configure(const IdleGovernorConfig& c, uint32_t now_ms) {
+  config = c;
+  // 短くした結果すでに閾値を過ぎていても、次の update() で段階を合わせる
+  update(now_ms);
+}
+
+PowerLevel IdleGovernor::levelFor(uint32_t idle_ms) const {
+  if (config.sleep_after_ms && idle_ms >= config.sleep_after_ms) return POWER_SLEEP;
+  if (config.dim_after_ms && idle_ms >= config.dim_after_ms) return POWER_DIM;
+  return POWER_ACTIVE;
+}
+
+void IdleGovernor::enter(PowerLevel level, uint32_t now_ms) {
+  level_ms[current] += now_ms - entered_ms;
+  entered_ms = now_ms;
+  current = level;
+  transition_count++;
+}
+
+bool IdleGovernor::activity(uint32_t now_ms) {
+  last_activity_ms = now_ms;
+  if (current == POWER_ACTIVE) return false;
+  enter(POWER_ACTIVE, now_ms);
+  return true;
+}
+
+bool IdleGovernor::update(uint32_t now_ms) {
+  PowerLevel target = levelFor(idleMs(now_ms));
+  // 操作なしで段階が上がることはない（設定を延ばしても次の操作までは今の段階のまま）
+  if (target <= current) return false;
+  enter(target, now_ms);
+  return true;
+}
+
+uint32_t IdleGovernor::msUntilNextLevel(uint32_t now_ms) const {
+  uint32_t idle = idleMs(now_ms);
+  uint32_t next = UINT32_MAX;
+  if (current < POWER_DIM && config.dim_after_ms) {
+    next = config.dim_after_ms > idle ? config.dim_after_ms - idle : 0;
+  }
+  if (current < POWER_SLEEP && config.sleep_after_ms) {
+    uint32_t ms = config.sleep_after_ms > idle ? config.sleep_after_ms - idle : 0;
+    if (ms < next) next = ms;
+  }
+  return next;
+}
+
+uint32_t IdleGovernor::timeInLevel(PowerLevel level, uint32_t now_ms) const {
+  uint32_t ms = level_ms[level];
+  if (level == current) ms += now_ms - entered_ms;
+  return ms;
+}
+
+const char* IdleGovernor::levelName(PowerLevel level) {
+  switch (level) {
+    case POWER_ACTIVE: return "active";
+    case POWER_DIM:    return "dim";
+    case POWER_SLEEP:  return "sleep";
+    default:           return "unknown";
+  }
+}
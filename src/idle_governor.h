@@ -0,0 +1,66 @@
+/*
+ * Idle Governor for Stack-chan
+ * 最後の操作からの経過時間で 通常 → 減光 → 休止 と段階を下げる状態遷移
+ * 時刻は呼び出し側が渡す（Arduino に依存しないので、ホスト上でも疑似時計で同じコードを動かせる）
+ */
+
+#ifndef IDLE_GOVERNOR_H
+#define IDLE_GOVERNOR_H
+
+#include <stdint.h>
+
+enum PowerLevel {
+  POWER_ACTIVE = 0,
+  POWER_DIM,
+  POWER_SLEEP,
+  POWER_LEVEL_COUNT
+};
+
+// 段階ごとの描画間隔と明るさ
+struct PowerLevelConfig {
+  uint16_t frame_interval_ms;  // 0: 制限なし（描画タスクの最大速度）
+  uint8_t brightness;          // 0-255
+};
+
+struct IdleGovernorConfig {
+  uint32_t dim_after_ms;    // 無操作でこの時間が経つと減光（0 で無効）
+  uint32_t sleep_after_ms;  // 無操作でこの時間が経つと休止（0 で無効）
+  PowerLevelConfig levels[POWER_LEVEL_COUNT];
+};
+
+class IdleGovernor {
+public:
+  IdleGovernor();
+
+  void configure(const IdleGovernorConfig& config, uint32_t now_ms);
+  const IdleGovernorConfig& getConfig() const { return config; }
+
+  // 操作があった（すぐに通常段階へ戻す）。段階が変わったら true
+  bool activity(uint32_t now_ms);
+  // 経過時間に応じて段階を下げる。段階が変わったら true
+  bool update(uint32_t now_ms);
+
+  PowerLevel level() const { return current; }
+  const PowerLevelConfig& levelConfig() const { return config.levels[current]; }
+  uint32_t idleMs(uint32_t now_ms) const { return now_ms - last_activity_ms; }
+  uint32_t transitions() const { return transition_count; }
+  // 次に段階が下がるまでの時間（これ以上下がらなければ UINT32_MAX）
+  uint32_t msUntilNextLevel(uint32_t now_ms) const;
+  // 各段階に滞在した累計時間（現在の段階は now_ms までを含む）
+  uint32_t timeInLevel(PowerLevel level, uint32_t now_ms) const;
+
+  static const char* levelName(PowerLevel level);
+
+private:
+  IdleGovernorConfig config;
+  PowerLevel current;
+  uint32_t last_activity_ms;
+  uint32_t entered_ms;
+  uint32_t level_ms[POWER_LEVEL_COUNT];
+  uint32_t transition_count;
+
+  PowerLevel levelFor(uint32_t idle_ms) const;
+  void enter(PowerLevel level, uint32_t now_ms);
+};
+
+#endif
@@ -0,0 +1,205 @@
+/*
+ * Loop Events for Stack-chan
+ * loop() を固定の delay(50) で回す代わりに、ボタン・ネットワーク・BLE の通知か
+ * 次の期限が来るまで FreeRTOS のイベントグループで待つ
+ */
+
+#include "loop_events.h"
+#include <esp_timer.h>
+#include <lwip/sockets.h>
+
+LoopEvents loop_events;
+
+// 遅延の集計（描画タスクの frameCheckpoint() と loop の getStats()・resetLatency() が重なる）
+static portMUX_TYPE stats_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// 他タスクに渡す時刻（0 は「なし」に使うので最下位ビットを立てる。1us の誤差）
+static uint32_t stampUs(int64_t us) {
+  return (uint32_t)us | 1;
+}
+
+LoopEvents::LoopEvents() {
+  group = nullptr;
+  rearm = nullptr;
+  listen_fd = -1;
+  notified_us = 0;
+  pending_input_us = 0;
+  pending_frames = 0;
+  network_ready_us = 0;
+  request_start_us = 0;
+  rate_window_start = 0;
+  rate_iterations = 0;
+  memset(&stats, 0, sizeof(stats));
+  input_total_us = 0;
+  request_total_us = 0;
+}
+
+void LoopEvents::begin() {
+  if (group) return;
+  group = xEventGroupCreate();
+  rearm = xSemaphoreCreateBinary();
+
+  xTaskCreatePinnedToCore(networkTask, "loop_net", 2048, this, 1, nullptr, ARDUINO_RUNNING_CORE);
+}
+
+void LoopEvents::notify(EventBits_t bits) {
+  if (!notified_us) notified_us = stampUs(esp_timer_get_time());
+  if (group) xEventGroupSetBits(group, bits);
+}
+
+uint32_t LoopEvents::takeNotifyTime() {
+  uint32_t t = notified_us;
+  notified_us = 0;
+  return t;
+}
+
+void LoopEvents::countIteration(EventBits_t bits) {
+  unsigned long now = millis();
+  rate_iterations++;
+  bool rate_window_done = now - rate_window_start >= 1000;
+
+  portENTER_CRITICAL(&stats_mux);
+  stats.iterations++;
+  if (bits & LOOP_EVENT_INPUT) stats.wakes_input++;
+  if (bits & LOOP_EVENT_NETWORK) stats.wakes_network++;
+  if (bits & LOOP_EVENT_BLE) stats.wakes_ble++;
+  if (!(bits & LOOP_EVENT_ALL)) stats.wakes_timeout++;
+  if (rate_window_done) stats.iterations_per_s = rate_iterations * 1000 / (now - rate_window_start);
+  portEXIT_CRITICAL(&stats_mux);
+
+  if (rate_window_done) {
+    rate_window_start = now;
+    rate_iterations = 0;
+  }
+}
+
+EventBits_t LoopEvents::wait(uint32_t timeout_ms) {
+  if (!group) {
+    delay(timeout_ms);
+    return 0;
+  }
+  EventBits_t bits = xEventGroupWaitBits(group, LOOP_EVENT_ALL, pdTRUE, pdFALSE, pdMS_TO_TICKS(timeout_ms));
+  countIteration(bits);
+  return bits;
+}
+
+void LoopEvents::legacyDelay() {
+  delay(LOOP_LEGACY_DELAY_MS);
+  countIteration(0);
+}
+
+// === HTTP 待ち受けソケットの監視 ===
+
+// WebServer は待ち受けソケットを公開していないので、指定ポートで LISTEN 中のソケットを探す
+void LoopEvents::watchServerPort(uint16_t port) {
+  int found = -1;
+  for (int fd = LWIP_SOCKET_OFFSET; fd < LWIP_SOCKET_OFFSET + CONFIG_LWIP_MAX_SOCKETS; fd++) {
+    int listening = 0;
+    socklen_t len = sizeof(listening);
+    if (getsockopt(fd, SOL_SOCKET, SO_ACCEPTCONN, &listening, &len) != 0 || !listening) continue;
+
+    struct sockaddr_in addr;
+    socklen_t addr_len = sizeof(addr);
+    if (getsockname(fd, (struct sockaddr*)&addr, &addr_len) == 0 && ntohs(addr.sin_port) == port) {
+      found = fd;
+      break;
+    }
+  }
+  listen_fd = found;
+  if (rearm) xSemaphoreGive(rearm);
+  Serial.printf("LoopEvents: HTTP 待ち受け %s\n", found >= 0 ? "を監視" : "が見つからないため見回り");
+}
+
+void LoopEvents::serverPolled() {
+  if (rearm) xSemaphoreGive(rearm);
+}
+
+// 接続待ちが来たら loop() を起こし、loop() が受け付けるまで次の監視を止める
+void LoopEvents::networkTask(void* arg) {
+  LoopEvents* self = static_cast<LoopEvents*>(arg);
+  for (;;) {
+    int fd = self->listen_fd;
+    if (fd < 0) {
+      xSemaphoreTake(self->rearm, portMAX_DELAY);
+      continue;
+    }
+
+    fd_set readable;
+    FD_ZERO(&readable);
+    FD_SET(fd, &readable);
+    struct timeval timeout = {1, 0};
+    int n = select(fd + 1, &readable, nullptr, nullptr, &timeout);
+    if (n > 0) {
+      // 従来ループでも接続が来た時刻は記録する（loop() が気づくまでの待ちも遅延に含める）
+      self->network_ready_us = stampUs(esp_timer_get_time());
+      self->notify(LOOP_EVENT_NETWORK);
+      xSemaphoreTake(self->rearm, pdMS_TO_TICKS(LOOP_MAX_WAIT_MS));
+    } else if (n < 0) {
+      // WiFi切断などでソケットが閉じた（次の watchServerPort() まで見回りに戻る）
+      if (self->listen_fd == fd) self->listen_fd = -1;
+    }
+  }
+}
+
+// === 遅延の計測 ===
+
+void LoopEvents::recordLatency(LoopLatency& l, uint64_t& total, uint32_t us) {
+  l.count++;
+  l.last_us = us;
+  total += us;
+  l.avg_us = total / l.count;
+  if (us > l.max_us) l.max_us = us;
+}
+
+// ボタンが変化した時刻から測る（loop() が他の処理で止まっていた時間も遅延に含める）
+void LoopEvents::inputApplied(int64_t edge_us) {
+  pending_frames = 0;
+  pending_input_us = stampUs(edge_us ? edge_us : esp_timer_get_time());
+}
+
+// 反映後の最初のフレームで描かれ、次のフレームの開始時点で転送が終わっている
+// 差は符号なしの引き算で出す（esp_timer の下位32ビットは約71分で一周する）
+void LoopEvents::frameCheckpoint() {
+  uint32_t edge = pending_input_us;
+  if (!edge) return;
+  if (++pending_frames < 2) return;
+  uint32_t us = (uint32_t)esp_timer_get_time() - edge;
+  pending_input_us = 0;
+  portENTER_CRITICAL(&stats_mux);
+  recordLatency(stats.input, input_total_us, us);
+  portEXIT_CRITICAL(&stats_mux);
+}
+
+void LoopEvents::requestStarted() {
+  request_start_us = stampUs(esp_timer_get_time());
+}
+
+void LoopEvents::requestFinished() {
+  if (!request_start_us) return;
+  // 接続を検知した時刻から（監視していない場合や古い検知は振り分け開始から）
+  uint32_t ready = network_ready_us;
+  uint32_t waited = request_start_us - ready;
+  uint32_t from = (ready && (int32_t)waited >= 0 && waited < 1000000) ? ready : request_start_us;
+  uint32_t us = (uint32_t)esp_timer_get_time() - from;
+  portENTER_CRITICAL(&stats_mux);
+  recordLatency(stats.request, request_total_us, us);
+  portEXIT_CRITICAL(&stats_mux);
+  request_start_us = 0;
+  network_ready_us = 0;
+}
+
+LoopStats LoopEvents::getStats() const {
+  portENTER_CRITICAL(&stats_mux);
+  LoopStats copy = stats;
+  portEXIT_CRITICAL(&stats_mux);
+  return copy;
+}
+
+void LoopEvents::resetLatency() {
+  portENTER_CRITICAL(&stats_mux);
+  memset(&stats.input, 0, sizeof(stats.input));
+  memset(&stats.request, 0, sizeof(stats.request));
+  input_total_us = 0;
+  request_total_us = 0;
+  portEXIT_CRITICAL(&stats_mux);
+}
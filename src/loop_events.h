@@ -0,0 +1,108 @@
+/*
+ * Loop Events for Stack-chan
+ * loop() を固定の delay(50) で回す代わりに、ボタン・ネットワーク・BLE の通知か
+ * 次の期限が来るまで FreeRTOS のイベントグループで待つ
+ */
+
+#ifndef LOOP_EVENTS_H
+#define LOOP_EVENTS_H
+
+#include <M5Unified.h>
+#include <freertos/event_groups.h>
+
+// 0 にすると従来の delay(50) ループ（遅延の比較用）
+#ifndef LOOP_EVENT_DRIVEN
+#define LOOP_EVENT_DRIVEN 1
+#endif
+
+#define LOOP_LEGACY_DELAY_MS 50
+
+#define LOOP_EVENT_INPUT   (1 << 0)  // ボタンのイベント（ButtonInput）
+#define LOOP_EVENT_NETWORK (1 << 1)  // HTTP の接続待ちがある
+#define LOOP_EVENT_BLE     (1 << 2)  // BLE の接続・切断・書き込み
+#define LOOP_EVENT_ALL     (LOOP_EVENT_INPUT | LOOP_EVENT_NETWORK | LOOP_EVENT_BLE)
+
+// 通知が来ない状態の見回り間隔
+#define LOOP_INPUT_POLL_MS   10    // タッチボタンの機種
+#define LOOP_CLIENT_POLL_MS  2     // HTTP クライアントの受信・応答中
+#define LOOP_NETWORK_POLL_MS 10    // 待ち受けソケットが見つからないとき
+#define LOOP_MAX_WAIT_MS     1000
+
+struct LoopLatency {
+  uint32_t count;
+  uint32_t last_us;
+  uint32_t avg_us;
+  uint32_t max_us;
+};
+
+struct LoopStats {
+  uint32_t iterations;
+  uint16_t iterations_per_s;  // 直近1秒の loop() 回数
+  uint32_t wakes_input;
+  uint32_t wakes_network;
+  uint32_t wakes_ble;
+  uint32_t wakes_timeout;
+  LoopLatency input;          // ボタンの変化 → 反映したフレームの転送完了
+  LoopLatency request;        // HTTP 接続の検知 → 応答送信完了
+};
+
+class LoopEvents {
+public:
+  LoopEvents();
+
+  // setup() から呼ぶ（loop() と同じタスク）
+  void begin();
+
+  // 他タスクから loop() を起こす（最初の通知の時刻を残し、起床までの遅延を測る）
+  void notify(EventBits_t bits);
+  // 前回取り出してから最初に notify() された時刻（esp_timer の下位32ビット、0: 通知なし）を取り出す
+  uint32_t takeNotifyTime();
+
+  // 次の通知か timeout_ms が経つまで待つ。起きた理由のビットを返す（0 はタイムアウト）
+  EventBits_t wait(uint32_t timeout_ms);
+  // 従来ループ用（delay して回数だけ数える）
+  void legacyDelay();
+
+  // HTTP の待ち受けソケットを監視する（server.begin() の後に呼ぶ）
+  void watchServerPort(uint16_t port);
+  bool isWatchingServer() const { return listen_fd >= 0; }
+  // loop() が handleClient() を呼んだ後に呼ぶ（次の接続の監視を再開する）
+  void serverPolled();
+
+  // 遅延の計測
+  void inputApplied(int64_t edge_us);  // loop(): edge_us に起きたボタン操作を反映した
+  void frameCheckpoint();        // 描画タスク: 毎フレーム
+  void requestStarted();         // HTTP ハンドラの振り分け開始
+  void requestFinished();        // handleClient() から戻った
+
+  LoopStats getStats() const;
+  // 遅延の集計だけを空にする（ビルドを変えて比べるときに、起動直後の値を除く）
+  void resetLatency();
+
+  // 遅延の記録（SleepManager の起床遅延も同じ形で集計する）
+  static void recordLatency(LoopLatency& l, uint64_t& total, uint32_t us);
+
+private:
+  EventGroupHandle_t group;
+  SemaphoreHandle_t rearm;
+  volatile int listen_fd;
+  volatile uint32_t notified_us;  // 32ビットなので他タスクと読み書きが分かれない
+
+  // 計測用（他タスクと読み書きする時刻は notified_us と同じく esp_timer の下位32ビット、0: なし）
+  volatile uint32_t pending_input_us;  // 反映待ちのボタン操作（loop が書き、描画タスクが読んで消す）
+  volatile uint8_t pending_frames;
+  volatile uint32_t network_ready_us;  // 接続待ちを検知した時刻（loop_net が書き、loop が読む）
+  uint32_t request_start_us;
+  unsigned long rate_window_start;
+  uint16_t rate_iterations;
+  LoopStats stats;  // input は描画タスクが書くので、読み書きとも stats_mux で守る
+  uint64_t input_total_us;
+  uint64_t request_total_us;
+
+  void countIteration(EventBits_t bits);
+  static void networkTask(void* arg);
+};
+
+extern LoopEvents loop_events;
+
+#endif
@@ -0,0 +1,93 @@
+/*
+ * Loop Profiler for Stack-chan
+ * 段階ごとのリングバッファと min/avg/max/p99 の集計
+ */
+
+#include "loop_profiler.h"
+
+#if LOOP_PROFILER_ENABLED
+
+#include <algorithm>
+#include <string.h>
+
+LoopProfiler loop_profiler;
+
+LoopProfiler::LoopProfiler() {
+  start_us = 0;
+  last_us = 0;
+  reset();
+}
+
+void LoopProfiler::reset() {
+  memset(rings, 0, sizeof(rings));
+}
+
+LoopStageSummary LoopProfiler::summarize(LoopStage stage) const {
+  LoopStageSummary s;
+  memset(&s, 0, sizeof(s));
+  const StageRing& r = rings[stage];
+  s.count = r.count;
+  s.window = r.filled;
+  if (r.filled == 0) return s;
+
+  // 計測中に書き換わっても壊れないよう、コピーしてから並べる
+  uint32_t sorted[LOOP_PROFILE_SAMPLES];
+  uint16_t n = r.filled;
+  memcpy(sorted, r.us, n * sizeof(uint32_t));
+  std::sort(sorted, sorted + n);
+
+  uint64_t total = 0;
+  for (uint16_t i = 0; i < n; i++) total += sorted[i];
+
+  uint16_t p99 = (uint16_t)((n * 99 + 99) / 100) - 1;  // 切り上げの順位
+  s.min_us = sorted[0];
+  s.max_us = sorted[n - 1];
+  s.avg_us = (uint32_t)(total / n);
+  s.p99_us = sorted[p99];
+  return s;
+}
+
+String LoopProfiler::toJSON() const {
+  String json = "{\"enabled\":true,\"samples\":" + String(LOOP_PROFILE_SAMPLES) +
+                ",\"cpu_mhz\":" + String(ESP.getCpuFreqMHz()) + ",\"stages\":{";
+  for (int i = 0; i < LOOP_STAGE_COUNT; i++) {
+    LoopStageSummary s = summarize((LoopStage)i);
+    if (i > 0) json += ",";
+    json += "\"" + String(loopStageName((LoopStage)i)) + "\":{" +
+            "\"count\":" + String(s.count) +
+            ",\"window\":" + String(s.window) +
+            ",\"min_us\":" + String(s.min_us) +
+            ",\"avg_us\":" + String(s.avg_us) +
+            ",\"max_us\":" + String(s.max_us) +
+            ",\"p99_us\":" + String(s.p99_us) + "}";
+  }
+  json += "}}";
+  return json;
+}
+
+void LoopProfiler::printSerial() const {
+  Serial.println("=== loop profile (us) ===");
+  Serial.println("stage        count   min     avg     max     p99");
+  for (int i = 0; i < LOOP_STAGE_COUNT; i++) {
+    LoopStageSummary s = summarize((LoopStage)i);
+    if (s.window == 0) continue;
+    Serial.printf("%-10s %7u %7u %7u %7u %7u\n", loopStageName((LoopStage)i), (unsigned)s.count, (unsigned)s.min_us,
+                  (unsigned)s.avg_us, (unsigned)s.max_us, (unsigned)s.p99_us);
+  }
+}
+
+#endif
+
+const char* loopStageName(LoopStage stage) {
+  switch (stage) {
+    case LOOP_STAGE_UPDATE:  return "update";
+    case LOOP_STAGE_HTTP:    return "http";
+    case LOOP_STAGE_BLE:     return "ble";
+    case LOOP_STAGE_BUTTONS: return "buttons";
+    case LOOP_STAGE_AVATAR:  return "avatar";
+    case LOOP_STAGE_TIMERS:  return "timers";
+    case LOOP_STAGE_BUSY:    return "busy";
+    case LOOP_STAGE_WAIT:    return "wait";
+    default:                 return "unknown";
+  }
+}
@@ -0,0 +1,120 @@
+/*
+ * Loop Profiler for Stack-chan
+ * loop() の各段階（M5.update・HTTP/BLE・ボタン処理・Avatar更新・周期処理・待機）の所要時間を
+ * esp_timer（us）で測り、段階ごとのリングバッファに残す
+ * CPUのサイクルカウンタは省電力の周波数切り替え（DFS）やライトスリープで進み方が変わるので使わない
+ * LOOP_PROFILER_ENABLED=0 でビルドすると計測コードは完全に消える（最後に終えた段階の記録だけ残る）
+ */
+
+#ifndef LOOP_PROFILER_H
+#define LOOP_PROFILER_H
+
+#include <Arduino.h>
+#include <esp_timer.h>
+#include "breadcrumbs.h"
+
+#ifndef LOOP_PROFILER_ENABLED
+#define LOOP_PROFILER_ENABLED 1
+#endif
+
+// 段階ごとに保持するサンプル数（min/avg/max/p99 はこの窓で集計）
+#ifndef LOOP_PROFILE_SAMPLES
+#define LOOP_PROFILE_SAMPLES 128
+#endif
+
+// シリアルへ集計を出す間隔（0 で出さない）
+#ifndef LOOP_PROFILE_SERIAL_MS
+#define LOOP_PROFILE_SERIAL_MS 30000
+#endif
+
+enum LoopStage {
+  LOOP_STAGE_UPDATE = 0,  // M5.update() とタッチボタンの読み取り
+  LOOP_STAGE_HTTP,        // server.handleClient()
+  LOOP_STAGE_BLE,         // handleBLERequest()
+  LOOP_STAGE_BUTTONS,     // ボタンイベントの処理
+  LOOP_STAGE_AVATAR,      // 省電力・パレットフェードの反映
+  LOOP_STAGE_TIMERS,      // タイマーホイール（WiFi監視・セリフ自動切り替えなど）
+  LOOP_STAGE_BUSY,        // loop() 先頭から待機直前まで（上の段階の合計）
+  LOOP_STAGE_WAIT,        // イベント待ち（delay）
+  LOOP_STAGE_COUNT
+};
+
+struct LoopStageSummary {
+  uint32_t count;   // 計測した回数（累計）
+  uint16_t window;  // 集計に使ったサンプル数
+  uint32_t min_us;
+  uint32_t avg_us;
+  uint32_t max_us;
+  uint32_t p99_us;
+};
+
+const char* loopStageName(LoopStage stage);
+
+#if LOOP_PROFILER_ENABLED
+
+class LoopProfiler {
+public:
+  LoopProfiler();
+
+  // loop() の先頭で呼ぶ
+  void start() {
+    start_us = last_us = (uint32_t)esp_timer_get_time();
+  }
+  // 直前の mark() / start() からの時間を stage に記録する
+  void mark(LoopStage stage) {
+    uint32_t now = (uint32_t)esp_timer_get_time();
+    record(stage, now - last_us);
+    last_us = now;
+  }
+  // 待機の直前で呼ぶ（loop() 先頭からの時間を LOOP_STAGE_BUSY に記録する）
+  void finish() {
+    uint32_t now = (uint32_t)esp_timer_get_time();
+    record(LOOP_STAGE_BUSY, now - start_us);
+    last_us = now;
+  }
+
+  void reset();
+
+  // リングバッファの窓で集計する（ソートするのでHTTP/シリアル出力時だけ呼ぶ）
+  LoopStageSummary summarize(LoopStage stage) const;
+
+  String toJSON() const;
+  void printSerial() const;
+
+private:
+  struct StageRing {
+    uint32_t us[LOOP_PROFILE_SAMPLES];
+    uint16_t head;
+    uint16_t filled;
+    uint32_t count;
+  };
+
+  StageRing rings[LOOP_STAGE_COUNT];
+  uint32_t start_us;
+  uint32_t last_us;
+
+  void record(LoopStage stage, uint32_t us) {
+    StageRing& r = rings[stage];
+    r.us[r.head] = us;
+    r.head = (r.head + 1) % LOOP_PROFILE_SAMPLES;
+    if (r.filled < LOOP_PROFILE_SAMPLES) r.filled++;
+    r.count++;
+  }
+};
+
+extern LoopProfiler loop_profiler;
+
+#define LOOP_PROFILE_START()      loop_profiler.start()
+#define LOOP_PROFILE_MARK(stage)  do { loop_profiler.mark(stage); breadcrumbs.setStage(stage); } while (0)
+#define LOOP_PROFILE_FINISH()     loop_profiler.finish()
+
+#else
+
+// 計測を外しても、最後に終えた段階だけはブレッドクラムに残す
+#define LOOP_PROFILE_START()      do {} while (0)
+#define LOOP_PROFILE_MARK(stage)  breadcrumbs.setStage(stage)
+#define LOOP_PROFILE_FINISH()     do {} while (0)
+
+#endif
+
+#endif
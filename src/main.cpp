@@ -9,74 +9,217 @@
 #include <WebServer.h>
 #include "simple_wifi_config.h"
 #include "ble_webui.h"
+#include "speech_balloon.h"
+#include "face_animator.h"
+#include "stackchan_face.h"
+#include "frame_renderer.h"
+#include "color_palettes.h"
+#include "palette_fader.h"
+#include "avatar_commands.h"
+#include "spsc_queue.h"
+#include "app_state.h"
+#include "app_clock.h"
+#include "hud_overlay.h"
+#include "screen_capture.h"
+#include "power_governor.h"
+#include "sleep_manager.h"
+#include "loop_events.h"
+#include "timer_wheel.h"
+#include "loop_profiler.h"
+#include "trace_recorder.h"
+#include "button_input.h"
+#include "stall_detector.h"
+#include "breadcrumbs.h"
+#include "boot_timeline.h"
 
 using namespace m5avatar;
 
 // Avatar関連
 Avatar avatar;
-ColorPalette* cps[6];  // 6色に拡張
 bool avatar_initialized = false;
 
 // WiFi & WebServer関連
 WebServer server(WEBSERVER_PORT);
-bool wifi_connected = false;
-String current_ip = "";
-unsigned long last_wifi_check = 0;
 
 // BLE関連
-bool ble_enabled = false;
-bool connection_mode_ble = false;  // true: BLEモード, false: WiFiモード
 BLEWebUIHandler* bleWebUI = nullptr;  // BLE WebUIハンドラー
 
-// 表示制御
-String current_message = "スタックちゃん";
-unsigned long last_expression_change = 0;
-int current_expression = 0;
-bool is_speaking = false;  // 音声状態管理
+// セリフ・表情・通信状態は app_state（BLE のコールバックや HTTP の応答からも読むため）
+
+// BLE からの表情・色・セリフの変更（BLE のコールバックで積み、loop() で反映する）
+// PowerGovernor・パレットの選択・タイマーは loop() だけが触るので、BLE タスクからは直接呼ばない
+enum BleRequestType : uint8_t {
+  BLE_REQUEST_EXPRESSION,
+  BLE_REQUEST_COLOR,
+  BLE_REQUEST_SPEECH
+};
+struct BleRequest {
+  uint8_t type;
+  int16_t id;          // 表情・パレット番号（-1: サイクル変更）
+  int8_t expression;   // セリフと一緒に変える表情（-1: 変えない）
+  char text[SPEECH_TEXT_MAX_BYTES];
+};
+#define BLE_REQUEST_DEPTH 8
+SpscQueue<BleRequest, BLE_REQUEST_DEPTH> ble_requests;
 
 // セリフ自動制御
-unsigned long last_speech_time = 0;
-bool speech_set_by_user = false;
-bool random_speech_enabled = false;
+volatile bool speech_timer_restart = false;  // BLEタスクからの要求（loop() でタイマーに反映）
+
+// 周期処理（loop() の中でだけ操作する）
+TimerWheel loop_timers;
+int speech_timer = -1;
 
-// 色制御
-int current_color_index = 0;
+// 起動時のWiFi接続（setup() で始めて loop() で進める。-1: 接続中でない）
+#define BOOT_WIFI_POLL_MS 100
+int boot_wifi_network = -1;
+uint32_t boot_wifi_started = 0;
+bool boot_wifi_finished = false;  // 完了・中止のどちらかを済ませた
+
+// HTTPリクエストの区間をトレースに記録中（RequestProbe で開始、handleClient() の後で終了）
+bool http_request_open = false;
 
 // 関数プロトタイプ宣言
 bool connectToWiFi();
+bool tryWiFiNetworks();
+void onWiFiConnected();
+void startBootWiFi();
+void pollBootWiFi();
+void cancelBootWiFi();
+static void finishBootWiFi(bool connected);
 void setupWebServer();
+void stopWebServer();
 void handleRoot();
 void handleApiExpression();
 void handleApiColor();
 void handleApiSetColor();
 void handleApiSet();
+void handleApiStatus();
+void handleApiGlyphBench();
+void handleApiPalette();
+void handleApiMarquee();
+void handleApiPalettes();
+bool applyColorPalette(int index, uint16_t fade_ms = PALETTE_FADE_MS);
+void handleApiRender();
+void handleApiScreenshot();
+bool sendImageBytes(const uint8_t* data, size_t bytes, void* user);
+void handleApiRenderBench();
 void handle404();
 String generateWebUIHTML();  // 共通HTML生成関数
+String jsonEscape(const char* text);
 void checkRandomSpeechConfig();
 String getRandomSpeech();
-void updateSpeechLoop();
+void onSpeechTimer(void* user);
+void restartSpeechTimer();
+void setupLoopTimers();
+String getTimersJSON();
+void handleApiTimers();
+String getProfileJSON();
+void handleApiProfile();
+String getLoopJSON();
+void handleApiLoop();
+String getTraceJSON();
+void handleApiTrace();
+String getStallsJSON();
+void handleApiStalls();
+String getSleepJSON();
+String getBreadcrumbsJSON();
+String getBootJSON();
+void handleApiSleep();
+#if APP_CLOCK_DEBUG_API
+void handleApiClock();
+#endif
+uint32_t nextLoopWaitMs();
+SleepInputs sleepInputs();
+bool handleButtonEvent(const ButtonEvent& event);
 void initializeBLE();
 void toggleConnectionMode();
+void showStatus(const String& text);
+void handleApiHud();
+void handleApiPower();
 
 // BLE WebUI用の外部関数（ble_webui.cppから呼び出される）
 void changeExpressionById(int id);
 void changeColorById(int id);
 void setSpeechText(const String& text, int expression = -1);
+void postBleRequest(uint8_t type, int id, int expression, const char* text);
+void applyBleRequests();
+void wakeDrawForCapture();
 String getSystemStatusJSON();
+String getPowerJSON();
+
+// === 状態変化の購読者（送り先を増やすときは関数を書いて表に足す） ===
+// 購読者は状態を書いたタスクでそのまま呼ばれる（書いたタスクを待たせないよう、待ちや重い処理はしない）
+
+// 描画タスクへ渡せなかった変化がある（loop() が最新の状態を積み直す）
+volatile bool avatar_resync = false;
+
+// 表情・セリフを描画タスクへ渡す（書いたタスクの命令キューに積む。満杯でも待たない）
+static void onStateAvatar(const StateEvent& event) {
+  bool queued;
+  if (event.type == APP_FIELD_EXPRESSION) {
+    queued = avatar_commands.setExpression(event.value, event.arg, false);
+  } else {
+    queued = avatar_commands.setSpeech(event.text, false);
+  }
+  if (!queued) avatar_resync = true;
+}
+
+// セリフの自動クリア・ランダムセリフの時間をやり直す（ユーザーのセリフ設定・ランダムセリフの有効化）
+static void onStateSpeechTimer(const StateEvent& event) {
+  if (event.type == APP_FIELD_USER_SPEECH || event.value) restartSpeechTimer();
+}
+
+// WiFi の接続・切断を HUD に出す（変わったときだけ）
+static void onStateHud(const StateEvent& event) {
+  static bool connected = false;
+  if ((event.value != 0) == connected) return;
+  connected = event.value != 0;
+  showStatus(connected ? String("WebUI: ") + event.text : String("WiFi切断"));
+}
+
+#if STATE_EVENT_LOG
+static void onStateLog(const StateEvent& event) {
+  Serial.printf("State: %s=%ld%s%s (v%lu)\n", AppStateStore::fieldName(event.type), (long)event.value,
+                event.text ? " " : "", event.text ? event.text : "", (unsigned long)event.version);
+}
+#endif
+
+static const EventSubscriber<StateEvent> state_subscribers[] = {
+  { "avatar", EVENT_BIT(APP_FIELD_EXPRESSION) | EVENT_BIT(APP_FIELD_MESSAGE), onStateAvatar },
+  { "speech_timer", EVENT_BIT(APP_FIELD_USER_SPEECH) | EVENT_BIT(APP_FIELD_RANDOM_SPEECH), onStateSpeechTimer },
+  { "hud", EVENT_BIT(APP_FIELD_WIFI), onStateHud },
+#if STATE_EVENT_LOG
+  { "log", EVENT_BIT(APP_FIELD_COUNT) - 1, onStateLog },
+#endif
+};
+const EventBus<StateEvent> state_bus(state_subscribers);
 
 void setup() {
   // M5Stack基本初期化
   Serial.begin(115200);
-  delay(100); // シリアル安定化
   Serial.println("=== Stack-chan Avatar + WiFi + WebServer Edition ===");
   Serial.println("setup() 開始");
+  breadcrumbs.begin();  // 前回リセットまでの記録（M5 の初期化で止まっても残るよう最初に）
+  app_state.begin();
+  boot_timeline.mark(BOOT_SERIAL);
   Serial.printf("起動時メモリ: %d bytes\n", ESP.getFreeHeap());
   
   Serial.println("M5.config() 設定中...");
   auto cfg = M5.config();
   Serial.println("M5.begin() 実行中...");
   M5.begin(cfg);
+  if (DisplayProfile::rotation >= 0) {
+    M5.Display.setRotation(DisplayProfile::rotation);
+  }
   Serial.println("M5Stack初期化完了");
+  Serial.printf("表示プロファイル: %s (%dx%d)\n", DisplayProfile::name, DisplayProfile::width, DisplayProfile::height);
+  loop_events.begin();
+  button_input.begin();
+#if TRACE_ENABLED
+  trace_recorder.begin();
+#endif
+  stall_detector.begin();
+  boot_timeline.mark(BOOT_M5);
   Serial.printf("M5初期化後メモリ: %d bytes\n", ESP.getFreeHeap());
   
   // 初期表示
@@ -90,57 +233,36 @@ void setup() {
   
   // Avatar初期化（シンプル構成）
   try {
-    Serial.println("ColorPalette作成開始");
-    // 6つの色パレットを作成
-    for (int i = 0; i < 6; i++) {
-      cps[i] = new ColorPalette();
-    }
-    Serial.println("ColorPalette作成完了");
-    
-    Serial.println("ColorPalette設定開始");
-    // 0: 標準色（デフォルト）
-    // 標準設定のまま
-    
-    // 1: 青系
-    cps[1]->set(COLOR_PRIMARY, TFT_YELLOW);
-    cps[1]->set(COLOR_BACKGROUND, TFT_BLUE);
-    
-    // 2: 緑系
-    cps[2]->set(COLOR_PRIMARY, TFT_WHITE);
-    cps[2]->set(COLOR_BACKGROUND, TFT_GREEN);
-    
-    // 3: 赤系
-    cps[3]->set(COLOR_PRIMARY, TFT_WHITE);
-    cps[3]->set(COLOR_BACKGROUND, TFT_RED);
-    
-    // 4: 紫系
-    cps[4]->set(COLOR_PRIMARY, TFT_YELLOW);
-    cps[4]->set(COLOR_BACKGROUND, TFT_PURPLE);
-    
-    // 5: オレンジ系
-    cps[5]->set(COLOR_PRIMARY, TFT_BLACK);
-    cps[5]->set(COLOR_BACKGROUND, TFT_ORANGE);
-    
-    Serial.println("ColorPalette設定完了");
-    
     Serial.println("Avatar.init()実行開始");
+    // 吹き出しは独自レイヤーで描画する（Avatar標準の吹き出しは使わない）
+    avatar.setFace(new StackchanFace(&face_animator, &speech_balloon, &hud_overlay));
+    palette_fader.begin(*palette_bank.active());  // フェードは描画タスクが進める（動き出す前に初期化）
     avatar.init();
+    avatar_commands.begin();  // 以降の表情・セリフ・色の変更は描画タスクが反映する
     Serial.println("Avatar.init()実行完了");
     
     Serial.println("ColorPalette適用開始");
-    avatar.setColorPalette(*cps[current_color_index]);
+    // 組み込みパレットはフラッシュ上の定数テーブル（起動時の生成・設定処理なし）
+    avatar_commands.setPalette(*palette_bank.active());
     Serial.println("ColorPalette適用完了");
     
     Serial.println("フォント設定開始");
-    avatar.setSpeechFont(&fonts::efontJA_12);
+    speech_balloon.begin(DisplayProfile::font(), DisplayProfile::glyph_slots);
+    speech_balloon.enableCache();
+    hud_overlay.begin(&speech_balloon.getGlyphCache());
+    hud_overlay.setFreeHeap(ESP.getFreeHeap());
+    screen_capture.begin();
+    power_governor.begin();
+    screen_capture.setDrawWakeup(wakeDrawForCapture);
     Serial.println("フォント設定完了");
     
     Serial.println("初期表情設定開始");
-    avatar.setExpression(Expression::Neutral);
+    face_animator.setExpression(FACE_NEUTRAL, 0);
+    face_animator.begin();
     Serial.println("初期表情設定完了");
     
     Serial.println("初期セリフ設定開始");
-    avatar.setSpeechText(current_message.c_str());
+    avatar_commands.setSpeech(app_state.snapshot().message);
     Serial.println("初期セリフ設定完了");
     
     avatar_initialized = true;
@@ -158,235 +280,415 @@ void setup() {
     M5.Display.println("Basic Mode");
     Serial.println("Avatar初期化失敗 - フォールバックモードで継続");
   }
+  boot_timeline.mark(BOOT_AVATAR);
   
   // 接続モード決定（WiFi優先、Bボタンで割り込み可能）
+  // 接続は loop() で進めるので、Avatar とボタンは接続を待たずに動き始める
   Serial.println("通信モード初期化開始");
-  current_message = "WiFi接続中... (Bボタン=BLE切替)";
-  if (avatar_initialized) {
-    avatar.setSpeechText(current_message.c_str());
-  }
-  
-  if (connectToWiFi()) {
-    // WiFiモード
-    connection_mode_ble = false;
-    Serial.println("WiFiモードで起動");
-    
-    // WebServer初期化
-    Serial.println("WebServer初期化開始");
-    setupWebServer();
-    
-    current_message = String("WebUI: ") + current_ip;
-    if (avatar_initialized) {
-      avatar.setSpeechText(current_message.c_str());
-    }
-  } else {
-    // BLEモード（WiFi失敗またはBボタン割り込み）
-    connection_mode_ble = true;
-    Serial.println("BLEペアリングモードで起動");
-    
-    current_message = "BLEペアリングモード初期化中...";
-    if (avatar_initialized) {
-      avatar.setSpeechText(current_message.c_str());
-    }
-    
-    initializeBLE();
-    
-    current_message = "BLE: " + String(BLE_DEVICE_NAME) + " (ペアリング待機中)";
-    if (avatar_initialized) {
-      avatar.setSpeechText(current_message.c_str());
-    }
-  }
+  app_state.setBleMode(false);
+  showStatus("WiFi接続中... (Bボタン=BLE切替)");
+  startBootWiFi();
   
-  Serial.println("初期化完了 - Avatar + WiFi/BLE + WebServer モード");
+  Serial.println("初期化完了 - Avatar + WiFi/BLE + WebServer モード（接続はバックグラウンド）");
   
   // ランダムセリフ設定確認
   checkRandomSpeechConfig();
+  setupLoopTimers();
+  sleep_manager.begin();
+  boot_timeline.mark(BOOT_INTERACTIVE);
 }
 
 void loop() {
+  LOOP_PROFILE_START();
+  stall_detector.enter(STALL_LOOP);
   M5.update();
+  button_input.pollM5();  // タッチボタンの機種だけ（物理ボタンは割り込みで読み取り済み）
+  LOOP_PROFILE_MARK(LOOP_STAGE_UPDATE);
   
-  // ボタン処理を最優先で実行
-  if (avatar_initialized) {
-    // Button B: 通信モード切り替え（WiFi ⟷ BLE）- 最優先処理
-    if (M5.BtnB.wasPressed()) {
-      Serial.println("Button B: 即座に通信モード切り替え");
-      
-      // 切り替え中のメッセージ表示
-      if (connection_mode_ble) {
-        current_message = "WiFiモードに切り替え中...";
-      } else {
-        current_message = "BLEペアリングモードに切り替え中...";
-      }
-      
-      if (avatar_initialized) {
-        avatar.setSpeechText(current_message.c_str());
-      }
-      
-      // 即座に切り替え実行
-      toggleConnectionMode();
-      return; // loop()の残りをスキップして次のループへ
+  // ボタン処理を最優先で実行（押した順に、loop() が止まっていた間の操作も含めて処理する）
+  ButtonEvent button_event;
+  while (button_input.next(button_event)) {
+    if (button_event.type == BUTTON_PRESS) {
+      // ボタン操作で減光・休止から即座に復帰（操作自体もそのまま処理する）
+      power_governor.wake();
+      loop_events.inputApplied(button_event.time_us);
+    }
+    if (handleButtonEvent(button_event)) {
+      stall_detector.exit(STALL_LOOP);
+      return; // 通信モードを切り替えたので loop()の残りをスキップして次のループへ（残りのイベントも次で処理）
     }
   }
+  LOOP_PROFILE_MARK(LOOP_STAGE_BUTTONS);
+  
+  // 起動時のWiFi接続を進める（接続できたらこの回から応答する）
+  if (boot_wifi_network >= 0) pollBootWiFi();
   
   // 通信処理
-  if (!connection_mode_ble && wifi_connected) {
+  AppState state = app_state.snapshot();
+  if (!state.connection_mode_ble && state.wifi_connected) {
     // WiFiモード
     server.handleClient();
-  } else if (connection_mode_ble && ble_enabled) {
+    if (http_request_open) {
+      http_request_open = false;
+      TRACE_END(TRACE_HTTP_REQUEST);
+      stall_detector.exit(STALL_HTTP_REQUEST);
+      boot_timeline.mark(BOOT_FIRST_HTTP);
+    }
+    loop_events.requestFinished();
+    loop_events.serverPolled();
+    LOOP_PROFILE_MARK(LOOP_STAGE_HTTP);
+  } else if (state.connection_mode_ble && state.ble_enabled) {
     // BLEモード
     if (bleWebUI) {
       bleWebUI->handleBLERequest();
     }
+    applyBleRequests();
+    LOOP_PROFILE_MARK(LOOP_STAGE_BLE);
   }
   
   if (avatar_initialized) {
-    // Button A: 表情変更（4種類をサイクル）
-    if (M5.BtnA.wasPressed()) {
-      Serial.println("Button A: 表情変更");
-      current_expression = (current_expression + 1) % 4;
-      
-      switch (current_expression) {
-        case 0:
-          avatar.setExpression(Expression::Neutral);
-          current_message = "普通";
-          break;
-        case 1:
-          avatar.setExpression(Expression::Happy);
-          current_message = "嬉しい";
-          break;
-        case 2:
-          avatar.setExpression(Expression::Sleepy);
-          current_message = "眠い";
-          break;
-        case 3:
-          avatar.setExpression(Expression::Doubt);
-          current_message = "困った";
-          break;
-      }
-      
-      avatar.setSpeechText(current_message.c_str());
-      Serial.printf("表情: %s\n", current_message.c_str());
-    }
-    
-    // Button A 長押し: BLE再起動（BLEモード時のみ）
-    if (M5.BtnA.wasHold() && connection_mode_ble && ble_enabled && bleWebUI) {
-      Serial.println("Button A 長押し: BLE再起動");
-      current_message = "BLE再起動中...";
-      avatar.setSpeechText(current_message.c_str());
-      
-      bleWebUI->restart();
-      
-      current_message = String("BLE: ") + BLE_DEVICE_NAME + " (再起動完了)";
-      avatar.setSpeechText(current_message.c_str());
+    // BLEクライアントの接続・切断をHUDに反映
+    static bool last_ble_connected = false;
+    bool ble_connected = state.connection_mode_ble && state.ble_enabled && bleWebUI && bleWebUI->isConnected();
+    if (state.connection_mode_ble && ble_connected != last_ble_connected) {
+      showStatus(String("BLE: ") + BLE_DEVICE_NAME + (ble_connected ? " (クライアント接続中)" : " (ペアリング待機中)"));
     }
+    last_ble_connected = ble_connected;
     
-    // Button C: IP/BLE状態表示
-    if (M5.BtnC.wasPressed()) {
-      Serial.println("Button C: 状態表示");
-      if (connection_mode_ble) {
-        current_message = String("BLE: ") + BLE_DEVICE_NAME;
-        if (ble_enabled && bleWebUI && bleWebUI->isConnected()) {
-          current_message += " (クライアント接続中)";
-        } else {
-          current_message += " (ペアリング待機中)";
-        }
-      } else if (wifi_connected) {
-        current_message = String("WiFi: ") + current_ip;
-      } else {
-        current_message = "WiFi未接続";
+    // 命令キューが満杯で描画タスクへ渡せなかった表情・セリフを、最新の状態で積み直す
+    if (avatar_resync) {
+      avatar_resync = false;
+      AppState latest = app_state.snapshot();
+      if (!avatar_commands.setExpression(latest.expression, 0, false) ||
+          !avatar_commands.setSpeech(latest.message, false)) {
+        avatar_resync = true;
       }
-      avatar.setSpeechText(current_message.c_str());
-      Serial.printf("状態表示: %s\n", current_message.c_str());
-    }
-    
-    // 自動まばたき（10秒ごと）
-    if (millis() - last_expression_change > 10000) {
-      avatar.setExpression(Expression::Neutral);
-      last_expression_change = millis();
     }
-    
-    // セリフ自動ループ処理
-    updateSpeechLoop();
-    
-  } else {
+
+    // 無操作時間に応じて明るさとフレームレートを下げる
+    power_governor.update();
+
+    // まばたきは FaceAnimator のオーバーレイトラックで自動実行（表情は上書きしない）
+    // パレットのクロスフェードは描画タスクがフレームごとに進める（AvatarCommands::drain()）
+    LOOP_PROFILE_MARK(LOOP_STAGE_AVATAR);
+  }
+  
+  // セリフ設定で自動クリアまでの時間をやり直す（HTTP・BLEの処理より後で反映する）
+  if (speech_timer_restart) {
+    speech_timer_restart = false;
+    loop_timers.reschedule(speech_timer, SPEECH_AUTO_CLEAR_TIME, app_clock.now());
+  }
+  
+  // 周期処理（WiFi監視・システム監視・セリフ自動切り替え・HUDのヒープ表示）
+  uint32_t now = app_clock.now();
+  bool timers_due = loop_timers.msUntilNext(now) == 0;
+  if (timers_due) TRACE_BEGIN(TRACE_TIMERS);
+  loop_timers.run(now);
+  if (timers_due) TRACE_END(TRACE_TIMERS);
+  LOOP_PROFILE_MARK(LOOP_STAGE_TIMERS);
+  LOOP_PROFILE_FINISH();
+  stall_detector.exit(STALL_LOOP);
+  
+#if LOOP_EVENT_DRIVEN
+  // ボタン・HTTP接続・BLEの通知か、次の期限が来るまで眠る（減光・休止中は自動ライトスリープも許す）
+  uint32_t wait_ms = nextLoopWaitMs();
+  sleep_manager.beforeWait(sleepInputs(), wait_ms);
+  EventBits_t woke = loop_events.wait(wait_ms);
+  sleep_manager.afterWait(woke);
+#else
+  loop_events.legacyDelay();
+#endif
+  LOOP_PROFILE_MARK(LOOP_STAGE_WAIT);
+}
+
+// ボタンイベント1件の処理。通信モードを切り替えたら true
+bool handleButtonEvent(const ButtonEvent& event) {
+  if (!avatar_initialized) {
     // Avatar失敗時の基本操作
-    if (M5.BtnA.wasPressed()) {
+    if (event.type != BUTTON_PRESS) return false;
+    if (event.button == BUTTON_A) {
       M5.Display.fillScreen(TFT_GREEN);
       M5.Display.setCursor(10, 10);
       M5.Display.println("Button A");
-      delay(500);
-    }
-    
-    if (M5.BtnB.wasPressed()) {
+      app_clock.delay(500);
+    } else if (event.button == BUTTON_B) {
       M5.Display.fillScreen(TFT_BLUE);
       M5.Display.setCursor(10, 10);
       M5.Display.println("WiFi Retry");
       connectToWiFi();
-      delay(500);
-    }
-    
-    if (M5.BtnC.wasPressed()) {
+      app_clock.delay(500);
+    } else if (event.button == BUTTON_C) {
       M5.Display.fillScreen(TFT_YELLOW);
       M5.Display.setCursor(10, 10);
       M5.Display.println("Button C");
-      delay(500);
+      app_clock.delay(500);
     }
+    return false;
   }
   
-  // WiFi接続状態監視（30秒ごと）
-  if (millis() - last_wifi_check > 30000) {
-    if (wifi_connected && WiFi.status() != WL_CONNECTED) {
-      Serial.println("WiFi接続が切断されました");
-      wifi_connected = false;
-      current_ip = "";
-      current_message = "WiFi切断";
-      if (avatar_initialized) {
-        avatar.setSpeechText(current_message.c_str());
-      }
+  AppState state = app_state.snapshot();
+  
+  // Button B: 通信モード切り替え（WiFi ⟷ BLE）- 最優先処理
+  if (event.button == BUTTON_B && event.type == BUTTON_PRESS) {
+    Serial.println("Button B: 即座に通信モード切り替え");
+    
+    // 切り替え中のメッセージ表示
+    if (state.connection_mode_ble) {
+      showStatus("WiFiモードに切り替え中...");
+    } else {
+      showStatus("BLEペアリングモードに切り替え中...");
+    }
+    
+    // 即座に切り替え実行
+    toggleConnectionMode();
+    return true;
+  }
+  
+  // Button A: 表情変更（4種類をサイクル）
+  if (event.button == BUTTON_A && event.type == BUTTON_PRESS) {
+    Serial.println("Button A: 表情変更");
+    int expression = app_state.cycleExpression();
+    const char* message = "";
+    
+    switch (expression) {
+      case 0:
+        message = "普通";
+        break;
+      case 1:
+        message = "嬉しい";
+        break;
+      case 2:
+        message = "眠い";
+        break;
+      case 3:
+        message = "困った";
+        break;
     }
-    last_wifi_check = millis();
+    app_state.setMessage(message);
+    Serial.printf("表情: %s\n", message);
   }
   
-  // システム監視（10秒ごと）
-  static unsigned long last_heartbeat = 0;
-  if (millis() - last_heartbeat > 10000) {
-    Serial.printf("Avatar=%s, WiFi=%s, Memory=%dKB, Uptime=%lus\n", 
-                  avatar_initialized ? "OK" : "NG",
-                  wifi_connected ? "OK" : "NG", 
-                  ESP.getFreeHeap() / 1024, 
-                  millis() / 1000);
-    last_heartbeat = millis();
+  // Button A 長押し: BLE再起動（BLEモード時のみ）
+  if (event.button == BUTTON_A && event.type == BUTTON_HOLD && state.connection_mode_ble && state.ble_enabled && bleWebUI) {
+    Serial.println("Button A 長押し: BLE再起動");
+    showStatus("BLE再起動中...");
+    
+    bleWebUI->restart();
+    
+    showStatus(String("BLE: ") + BLE_DEVICE_NAME + " (再起動完了)");
   }
   
-  delay(50);
+  // Button C: IP/BLE状態表示（HUDの表示切り替え、セリフは上書きしない）
+  if (event.button == BUTTON_C && event.type == BUTTON_PRESS) {
+    hud_overlay.setVisible(!hud_overlay.isVisible());
+    Serial.printf("Button C: HUD %s\n", hud_overlay.isVisible() ? "表示" : "非表示");
+  }
+  return false;
 }
 
-// WebServer設定関数
-void setupWebServer() {
+static void limitWait(uint32_t& wait, uint32_t ms) {
+  if (ms < wait) wait = ms;
+}
+
+// loop() が次に起きなければならないまでの時間
+uint32_t nextLoopWaitMs() {
+  uint32_t wait = LOOP_MAX_WAIT_MS;
+  
+  // タッチボタンの機種は M5.update() で読むので見回る（物理ボタンは ButtonInput が起こす）
+  if (!button_input.isInterruptDriven()) {
+    limitWait(wait, LOOP_INPUT_POLL_MS);
+  }
+  
+  if (boot_wifi_network >= 0) {
+    limitWait(wait, BOOT_WIFI_POLL_MS);
+  }
+  
+  AppState state = app_state.snapshot();
+  if (!state.connection_mode_ble && state.wifi_connected) {
+    if (server.client().connected()) {
+      limitWait(wait, LOOP_CLIENT_POLL_MS);
+    } else if (!loop_events.isWatchingServer()) {
+      limitWait(wait, LOOP_NETWORK_POLL_MS);
+    }
+  }
+  
+  if (avatar_initialized) {
+    // 省電力の段階は PowerGovernor 自身が起動からの時間で進める（app_clock を進めても変わらない）
+    limitWait(wait, power_governor.getGovernor().msUntilNextLevel(app_clock.uptime()));
+  }
+  
+  limitWait(wait, loop_timers.msUntilNext(app_clock.now()));
+  return wait;
+}
+
+// 待機中にライトスリープしてよいかの判定材料（enabled は SleepManager が埋める）
+SleepInputs sleepInputs() {
+  SleepInputs inputs;
+  inputs.enabled = true;
+  inputs.power_level = avatar_initialized ? power_governor.getGovernor().level() : POWER_ACTIVE;
+  inputs.buttons_active = button_input.isActive();
+  AppState state = app_state.snapshot();
+  inputs.network_active = !state.connection_mode_ble && state.wifi_connected && server.client().connected();
+  inputs.fading = avatar_initialized && palette_fader.isFading();
+  return inputs;
+}
+
+// === 周期処理 ===
+
+// WiFi接続状態監視（30秒ごと）
+void onWifiCheckTimer(void* user) {
+  if (app_state.snapshot().wifi_connected && WiFi.status() != WL_CONNECTED) {
+    Serial.println("WiFi接続が切断されました");
+    TRACE_INSTANT(TRACE_WIFI_LOST, 0);
+    breadcrumbs.add(CRUMB_WIFI_LOST);
+    app_state.setWiFi(false, nullptr);
+  }
+}
+
+// システム監視（10秒ごと）
+void onHeartbeatTimer(void* user) {
+  Serial.printf("Avatar=%s, WiFi=%s, Memory=%dKB, Uptime=%lus\n", 
+                avatar_initialized ? "OK" : "NG",
+                app_state.snapshot().wifi_connected ? "OK" : "NG", 
+                ESP.getFreeHeap() / 1024, 
+                (unsigned long)(app_clock.uptime() / 1000));
+}
+
+// HUDの空きヒープ表示（1秒ごと、KB単位で変わったときだけ描き直される）
+void onHudHeapTimer(void* user) {
+  hud_overlay.setFreeHeap(ESP.getFreeHeap());
+}
+
+// 空きヒープ・最大の空きブロックの最小値をRTCメモリに残す（1秒ごと）
+void onBreadcrumbHeapTimer(void* user) {
+  breadcrumbs.sampleHeap();
+}
+
+#if LOOP_PROFILER_ENABLED
+// loop() の段階ごとの所要時間をシリアルへ出す
+void onProfileTimer(void* user) {
+  loop_profiler.printSerial();
+}
+#endif
+
+void setupLoopTimers() {
+  uint32_t now = app_clock.now();
+  loop_timers.begin(now);
+  loop_timers.addPeriodic("wifi_check", 30000, onWifiCheckTimer, nullptr, now);
+  loop_timers.addPeriodic("heartbeat", 10000, onHeartbeatTimer, nullptr, now);
+  loop_timers.addPeriodic("hud_heap", 1000, onHudHeapTimer, nullptr, now);
+  loop_timers.addPeriodic("crumb_heap", 1000, onBreadcrumbHeapTimer, nullptr, now);
+  // セリフの自動クリア・ランダムセリフ（単発、セリフ設定のたびにやり直す）
+  speech_timer = loop_timers.addOneShot("speech", SPEECH_AUTO_CLEAR_TIME, onSpeechTimer, nullptr, now);
+  if (!app_state.snapshot().random_speech_enabled) loop_timers.stop(speech_timer);
+#if LOOP_PROFILER_ENABLED && LOOP_PROFILE_SERIAL_MS > 0
+  loop_timers.addPeriodic("profile", LOOP_PROFILE_SERIAL_MS, onProfileTimer, nullptr, now);
+#endif
+}
+
+// ユーザーがセリフ・表情・色を設定した（他タスクからも呼べる。反映は loop() で行う）
+void restartSpeechTimer() {
+  speech_timer_restart = true;
+}
+
+// 各リクエストの振り分け開始時刻を記録するだけのハンドラ（常に後ろのハンドラへ回す）
+class RequestProbe : public RequestHandler {
+public:
+  bool canHandle(HTTPMethod method, String uri) override {
+    loop_events.requestStarted();
+    if (!http_request_open) {
+      http_request_open = true;
+      TRACE_BEGIN(TRACE_HTTP_REQUEST);
+      stall_detector.enter(STALL_HTTP_REQUEST);
+    }
+    return false;
+  }
+};
+
+RequestProbe request_probe;
+
+// ルートは一度だけ登録する（再接続のたびに登録すると同じハンドラが積み重なる）
+static void addWebServerRoutes() {
+  // 遅延計測用（ハンドラは登録順に調べられるので最初に登録する）
+  server.addHandler(&request_probe);
+  
   // ルート設定
   server.on("/", handleRoot);
   server.on("/api/expression", HTTP_GET, handleApiExpression);
   server.on("/api/color", HTTP_GET, handleApiColor);
   server.on("/api/setcolor", HTTP_GET, handleApiSetColor);
   server.on("/api/set", HTTP_GET, handleApiSet);
+  server.on("/api/status", HTTP_GET, handleApiStatus);
+  server.on("/api/glyphbench", HTTP_GET, handleApiGlyphBench);
+  server.on("/api/palette", HTTP_GET, handleApiPalette);
+  server.on("/api/marquee", HTTP_GET, handleApiMarquee);
+  server.on("/api/hud", HTTP_GET, handleApiHud);
+  server.on("/api/power", HTTP_GET, handleApiPower);
+  server.on("/api/timers", HTTP_GET, handleApiTimers);
+  server.on("/api/profile", HTTP_GET, handleApiProfile);
+  server.on("/api/loop", HTTP_GET, handleApiLoop);
+  server.on("/api/trace", HTTP_GET, handleApiTrace);
+  server.on("/api/stalls", HTTP_GET, handleApiStalls);
+  server.on("/api/sleep", HTTP_GET, handleApiSleep);
+#if APP_CLOCK_DEBUG_API
+  server.on("/api/clock", HTTP_GET, handleApiClock);
+#endif
+  server.on("/api/palettes", HTTP_GET, handleApiPalettes);
+  server.on("/api/render", HTTP_GET, handleApiRender);
+  server.on("/api/screenshot", HTTP_GET, handleApiScreenshot);
+  server.on("/api/renderbench", HTTP_GET, handleApiRenderBench);
   
   server.onNotFound(handle404);
+}
+
+static bool web_server_routes_added = false;
+static bool web_server_running = false;
+
+// WebServer設定関数（どの経路でWiFiがつながっても onWiFiConnected() から呼ぶ。動いていれば何もしない）
+void setupWebServer() {
+  if (web_server_running) return;
+  if (!web_server_routes_added) {
+    addWebServerRoutes();
+    web_server_routes_added = true;
+  }
   
   // サーバー開始
   server.begin();
-  Serial.printf("WebServer開始: http://%s/\n", current_ip.c_str());
+  loop_events.watchServerPort(WEBSERVER_PORT);
+  web_server_running = true;
+  Serial.printf("WebServer開始: http://%s/\n", app_state.snapshot().ip);
+}
+
+void stopWebServer() {
+  if (!web_server_running) return;
+  server.stop();
+  web_server_running = false;
 }
 
 // WiFi接続関数
+// 接続にかかった時間をトレースに残す（途中で戻る箇所が多いので本体を分けている）
 bool connectToWiFi() {
-  wifi_connected = false;
-  current_ip = "";
+  // 起動時の接続が裏でつながっていれば、切らずにその接続で完了させる
+  if (boot_wifi_network >= 0 && WiFi.status() == WL_CONNECTED) {
+    finishBootWiFi(true);
+    return true;
+  }
+  cancelBootWiFi();
+  StallGuard stall(STALL_WIFI_CONNECT);
+  TRACE_BEGIN(TRACE_WIFI_CONNECT);
+  bool connected = tryWiFiNetworks();
+  TRACE_END(TRACE_WIFI_CONNECT);
+  breadcrumbs.add(connected ? CRUMB_WIFI_CONNECTED : CRUMB_WIFI_FAILED);
+  return connected;
+}
+
+bool tryWiFiNetworks() {
+  app_state.setWiFi(false, nullptr);
   
   // 既存の接続があれば切断
   if (WiFi.status() == WL_CONNECTED) {
     WiFi.disconnect();
-    delay(100);
+    app_clock.delay(100);
   }
   
   // 設定されたWiFiネットワークを順番に試行
@@ -394,44 +696,31 @@ bool connectToWiFi() {
     Serial.printf("WiFi接続試行: %s (優先度:%d)\n", 
                   wifi_networks[i].ssid, wifi_networks[i].priority);
     
-    // Avatar表示更新
-    if (avatar_initialized) {
-      current_message = String("接続中: ") + wifi_networks[i].ssid;
-      avatar.setSpeechText(current_message.c_str());
-    }
+    // HUD表示更新
+    showStatus(String("接続中: ") + wifi_networks[i].ssid);
     
     WiFi.begin(wifi_networks[i].ssid, wifi_networks[i].password);
     
     // 接続待機（最大10秒、ボタン割り込み対応）
-    unsigned long start_time = millis();
+    uint32_t start_time = app_clock.uptime();
     while (WiFi.status() != WL_CONNECTED && 
-           (millis() - start_time) < CONNECTION_TIMEOUT) {
+           (app_clock.uptime() - start_time) < CONNECTION_TIMEOUT) {
       
-      // ボタンチェック（割り込み処理）
+      // ボタンチェック（Bボタンの押下だけ取り出し、他の操作は接続後に loop() で処理する）
       M5.update();
-      if (M5.BtnB.wasPressed()) {
+      button_input.pollM5();
+      if (button_input.take(BUTTON_B, BUTTON_PRESS)) {
         Serial.println("WiFi接続中にBボタン押下 - BLEモードに切り替え");
         WiFi.disconnect();
         return false; // WiFi接続を中止してBLEモードへ
       }
       
-      delay(100); // 短い間隔でチェック
+      app_clock.delay(100); // 短い間隔でチェック
       Serial.print(".");
     }
     
     if (WiFi.status() == WL_CONNECTED) {
-      wifi_connected = true;
-      current_ip = WiFi.localIP().toString();
-      current_message = String("IP: ") + current_ip;
-      
-      Serial.printf("\nWiFi接続成功: %s\n", current_ip.c_str());
-      Serial.printf("   SSID: %s\n", WiFi.SSID().c_str());
-      Serial.printf("   RSSI: %d dBm\n", WiFi.RSSI());
-      
-      if (avatar_initialized) {
-        avatar.setSpeechText(current_message.c_str());
-      }
-      
+      onWiFiConnected();
       return true;
     } else {
       Serial.printf("\nWiFi接続失敗: %s\n", wifi_networks[i].ssid);
@@ -439,16 +728,98 @@ bool connectToWiFi() {
   }
   
   // 全て失敗
-  current_message = "WiFi接続失敗";
-  if (avatar_initialized) {
-    avatar.setSpeechText(current_message.c_str());
-  }
+  showStatus("WiFi接続失敗");
   Serial.println("全てのWiFiネットワークへの接続に失敗");
   return false;
 }
 
+// 接続できたときの共通処理（起動時の接続・Bボタンでのやり直し・モード切り替えのどれからでも呼ばれ、何度呼んでもよい）
+void onWiFiConnected() {
+  String ip = WiFi.localIP().toString();
+  app_state.setWiFi(true, ip.c_str());
+  
+  Serial.printf("\nWiFi接続成功: %s\n", ip.c_str());
+  Serial.printf("   SSID: %s\n", WiFi.SSID().c_str());
+  Serial.printf("   RSSI: %d dBm\n", WiFi.RSSI());
+  
+  setupWebServer();
+}
+
+// === 起動時のWiFi接続（loop() から少しずつ進める） ===
+
+static void beginBootWiFiNetwork(int index) {
+  boot_wifi_network = index;
+  boot_wifi_started = app_clock.uptime();
+  Serial.printf("WiFi接続試行: %s (優先度:%d)\n", wifi_networks[index].ssid, wifi_networks[index].priority);
+  showStatus(String("接続中: ") + wifi_networks[index].ssid);
+  WiFi.begin(wifi_networks[index].ssid, wifi_networks[index].password);
+}
+
+static void finishBootWiFi(bool connected) {
+  // 完了処理は一度だけ（接続待ちのない startBootWiFi() からの失敗も含む）
+  if (boot_wifi_finished) return;
+  boot_wifi_finished = true;
+  boot_wifi_network = -1;
+  TRACE_END(TRACE_WIFI_CONNECT);
+  breadcrumbs.add(connected ? CRUMB_WIFI_CONNECTED : CRUMB_WIFI_FAILED);
+  
+  if (connected) {
+    // WiFiモード
+    Serial.println("WiFiモードで起動");
+    onWiFiConnected();
+  } else {
+    // BLEモード（WiFi失敗）
+    showStatus("WiFi接続失敗");
+    Serial.println("全てのWiFiネットワークへの接続に失敗");
+    app_state.setBleMode(true);
+    Serial.println("BLEペアリングモードで起動");
+    showStatus("BLEペアリングモード初期化中...");
+    initializeBLE();
+    showStatus("BLE: " + String(BLE_DEVICE_NAME) + " (ペアリング待機中)");
+  }
+  boot_timeline.mark(BOOT_NETWORK);
+}
+
+void startBootWiFi() {
+  app_state.setWiFi(false, nullptr);
+  TRACE_BEGIN(TRACE_WIFI_CONNECT);
+  if (wifi_networks[0].ssid == nullptr) {
+    finishBootWiFi(false);
+    return;
+  }
+  beginBootWiFiNetwork(0);
+}
+
+void pollBootWiFi() {
+  if (boot_wifi_network < 0) return;
+  if (WiFi.status() == WL_CONNECTED) {
+    finishBootWiFi(true);
+  } else if (app_clock.uptime() - boot_wifi_started >= CONNECTION_TIMEOUT) {
+    Serial.printf("WiFi接続失敗: %s\n", wifi_networks[boot_wifi_network].ssid);
+    if (wifi_networks[boot_wifi_network + 1].ssid != nullptr) {
+      beginBootWiFiNetwork(boot_wifi_network + 1);
+    } else {
+      finishBootWiFi(false);
+    }
+  }
+}
+
+// 起動時の接続をやめる（Bボタンでの切り替え・接続のやり直しの前）
+void cancelBootWiFi() {
+  if (boot_wifi_network < 0) return;
+  Serial.println("起動時のWiFi接続を中止");
+  WiFi.disconnect();
+  boot_wifi_network = -1;
+  boot_wifi_finished = true;
+  boot_timeline.mark(BOOT_NETWORK);
+  TRACE_END(TRACE_WIFI_CONNECT);
+  breadcrumbs.add(CRUMB_WIFI_FAILED);
+}
+
 // 共通WebUI HTML生成関数
 String generateWebUIHTML() {
+  // 1回の読み出しで揃った値を使う（BLE の応答は loop() と別のタスクで作る）
+  AppState state = app_state.snapshot();
   String html = "<html><head><title>Stack-chan</title>";
   html += "<meta charset='UTF-8'>";
   html += "<style>body{font-family:Arial;margin:20px;} ";
@@ -492,13 +863,13 @@ String generateWebUIHTML() {
   
   html += "<h3>System Status</h3>";
   html += "<p>Free Memory: " + String(ESP.getFreeHeap() / 1024) + " KB</p>";
-  html += "<p>Uptime: " + String(millis() / 1000) + " seconds</p>";
+  html += "<p>Uptime: " + String(app_clock.uptime() / 1000) + " seconds</p>";
   
   // 接続モードに応じた情報表示
-  if (connection_mode_ble) {
+  if (state.connection_mode_ble) {
     html += "<p>Connection Mode: BLE</p>";
     html += "<p>BLE Device: " + String(BLE_DEVICE_NAME) + "</p>";
-    if (ble_enabled && bleWebUI && bleWebUI->isConnected()) {
+    if (state.ble_enabled && bleWebUI && bleWebUI->isConnected()) {
       html += "<p>BLE Status: Connected</p>";
     } else {
       html += "<p>BLE Status: Advertising</p>";
@@ -506,7 +877,7 @@ String generateWebUIHTML() {
   } else {
     html += "<p>Connection Mode: WiFi</p>";
     html += "<p>WiFi SSID: " + WiFi.SSID() + "</p>";
-    html += "<p>IP Address: " + WiFi.localIP().toString() + "</p>";
+    html += "<p>IP Address: " + String(state.ip) + "</p>";
     html += "<p>Signal: " + String(WiFi.RSSI()) + " dBm</p>";
   }
   
@@ -565,16 +936,18 @@ void handleRoot() {
 
 void handleApiExpression() {
   if (avatar_initialized) {
-    current_expression = (current_expression + 1) % 4;
-    switch (current_expression) {
-      case 0: avatar.setExpression(Expression::Neutral); current_message = "普通"; break;
-      case 1: avatar.setExpression(Expression::Happy); current_message = "嬉しい"; break;
-      case 2: avatar.setExpression(Expression::Sleepy); current_message = "眠い"; break;
-      case 3: avatar.setExpression(Expression::Doubt); current_message = "困った"; break;
+    int expression = app_state.cycleExpression();
+    const char* message = "";
+    switch (expression) {
+      case 0: message = "普通"; break;
+      case 1: message = "嬉しい"; break;
+      case 2: message = "眠い"; break;
+      case 3: message = "困った"; break;
     }
-    avatar.setSpeechText(current_message.c_str());
-    server.send(200, "text/plain", "Expression changed to: " + current_message);
-    Serial.println("API: 表情変更 -> " + current_message);
+    app_state.setMessage(message);
+    power_governor.wake();
+    server.send(200, "text/plain", String("Expression changed to: ") + message);
+    Serial.println(String("API: 表情変更 -> ") + message);
   } else {
     server.send(500, "text/plain", "Avatar not initialized");
   }
@@ -582,19 +955,12 @@ void handleApiExpression() {
 
 void handleApiColor() {
   if (avatar_initialized) {
-    // 次の色に切り替え（6色をサイクル）
-    current_color_index = (current_color_index + 1) % 6;
-    
-    const char* color_names[] = {
-      "標準色", "青系", "緑系", "赤系", "紫系", "オレンジ系"
-    };
-    
-    avatar.setColorPalette(*cps[current_color_index]);
-    current_message = String(color_names[current_color_index]);
-    
-    avatar.setSpeechText(current_message.c_str());
-    server.send(200, "text/plain", "Color changed to: " + current_message);
-    Serial.println("API: 色変更 -> " + current_message);
+    // 次の色に切り替え（登録済みパレットをサイクル）
+    int fade = server.hasArg("fade") ? constrain(server.arg("fade").toInt(), 0, PALETTE_FADE_MAX_MS) : PALETTE_FADE_MS;
+    applyColorPalette(palette_bank.nextIndex(palette_bank.activeIndex()), fade);
+    String name = palette_bank.active()->name;
+    server.send(200, "text/plain", "Color changed to: " + name);
+    Serial.println("API: 色変更 -> " + name);
   } else {
     server.send(500, "text/plain", "Avatar not initialized");
   }
@@ -612,22 +978,15 @@ void handleApiSetColor() {
   }
   
   int color_index = server.arg("index").toInt();
-  if (color_index < 0 || color_index >= 6) {
-    server.send(400, "text/plain", "Invalid color index (0-5)");
+  int fade = server.hasArg("fade") ? constrain(server.arg("fade").toInt(), 0, PALETTE_FADE_MAX_MS) : PALETTE_FADE_MS;
+  if (!applyColorPalette(color_index, fade)) {
+    server.send(400, "text/plain", "Invalid color index (0-" + String(PALETTE_COUNT - 1) + ", custom slot must be set)");
     return;
   }
   
-  const char* color_names[] = {
-    "標準色", "青系", "緑系", "赤系", "紫系", "オレンジ系"
-  };
-  
-  current_color_index = color_index;
-  avatar.setColorPalette(*cps[current_color_index]);
-  current_message = String(color_names[current_color_index]);
-  avatar.setSpeechText(current_message.c_str());
-  
-  server.send(200, "text/plain", "Color set to: " + current_message);
-  Serial.println("API: 色直接設定 -> " + current_message);
+  String name = palette_bank.active()->name;
+  server.send(200, "text/plain", "Color set to: " + name);
+  Serial.println("API: 色直接設定 -> " + name);
 }
 
 void handleApiSet() {
@@ -637,30 +996,32 @@ void handleApiSet() {
   }
   
   String response = "";
+  power_governor.wake();
   
   // 表情パラメータの処理
   if (server.hasArg("expression")) {
     int expr = server.arg("expression").toInt();
     if (expr >= 0 && expr <= 3) {
-      current_expression = expr;
       switch (expr) {
         case 0: 
-          avatar.setExpression(Expression::Neutral); 
           response += "表情: 普通";
           break;
         case 1: 
-          avatar.setExpression(Expression::Happy); 
           response += "表情: 嬉しい";
           break;
         case 2: 
-          avatar.setExpression(Expression::Sleepy); 
           response += "表情: 眠い";
           break;
         case 3: 
-          avatar.setExpression(Expression::Doubt); 
           response += "表情: 困った";
           break;
       }
+      // duration: 表情切り替えの補間時間（ms、省略時 FACE_TRANSITION_MS）
+      int duration = FACE_TRANSITION_MS;
+      if (server.hasArg("duration")) {
+        duration = constrain(server.arg("duration").toInt(), 0, 5000);
+      }
+      app_state.setExpression(expr, duration);
     } else {
       server.send(400, "text/plain", "Invalid expression value (0-3)");
       return;
@@ -670,12 +1031,10 @@ void handleApiSet() {
   // セリフパラメータの処理
   if (server.hasArg("speech")) {
     String speech = server.arg("speech");
-    current_message = speech;
-    avatar.setSpeechText(speech.c_str());
+    app_state.setMessage(speech.c_str());
     
     // ユーザーがセリフを設定したことを記録
-    speech_set_by_user = (speech.length() > 0);
-    last_speech_time = millis();
+    app_state.setSpeechByUser(speech.length() > 0);
     
     if (response.length() > 0) response += ", ";
     response += "セリフ: \"" + speech + "\"";
@@ -689,6 +1048,595 @@ void handleApiSet() {
   Serial.println("API: 設定変更 -> " + response);
 }
 
+void handleApiStatus() {
+  server.send(200, "application/json", getSystemStatusJSON());
+}
+
+void handleApiGlyphBench() {
+  if (!app_state.snapshot().random_speech_enabled) {
+    server.send(400, "text/plain", "random_speeches is empty");
+    return;
+  }
+  
+  int rounds = server.hasArg("rounds") ? server.arg("rounds").toInt() : 20;
+  if (rounds < 1 || rounds > 200) rounds = 20;
+  
+  GlyphBenchResult r = GlyphCache::benchmark(speech_balloon.getFont(), random_speeches, rounds);
+  
+  String json = "{";
+  json += "\"glyphs\":" + String(r.glyphs) + ",";
+  json += "\"uncached_us\":" + String(r.uncached_us) + ",";
+  json += "\"cached_us\":" + String(r.cached_us) + ",";
+  json += "\"uncached_glyphs_per_sec\":" + String(r.uncached_gps) + ",";
+  json += "\"cached_glyphs_per_sec\":" + String(r.cached_gps) + ",";
+  json += "\"hits\":" + String(r.hits) + ",";
+  json += "\"misses\":" + String(r.misses);
+  json += "}";
+  
+  server.send(200, "application/json", json);
+  Serial.printf("API: グリフベンチ -> キャッシュなし %lu glyphs/s, キャッシュあり %lu glyphs/s\n",
+                (unsigned long)r.uncached_gps, (unsigned long)r.cached_gps);
+}
+
+// 長文セリフの横スクロール設定（例: /api/marquee?speed=60&enabled=1）
+void handleApiMarquee() {
+  if (server.hasArg("speed")) {
+    speech_balloon.getMarquee().setSpeed(constrain(server.arg("speed").toInt(), 0, SPEECH_MARQUEE_SPEED_MAX));
+  }
+  if (server.hasArg("enabled")) {
+    speech_balloon.setMarquee(server.arg("enabled").toInt() != 0);
+  }
+  
+  String json = "{\"enabled\":" + String(speech_balloon.isMarqueeEnabled() ? "true" : "false") +
+                ",\"speed\":" + String(speech_balloon.getMarquee().getSpeed()) + "}";
+  server.send(200, "application/json", json);
+  Serial.printf("API: マーキー設定 -> %s, %u px/s\n", speech_balloon.isMarqueeEnabled() ? "有効" : "無効",
+                speech_balloon.getMarquee().getSpeed());
+}
+
+// HUD（接続状態・ヒープ・fps）の表示切り替え（例: /api/hud?visible=0）
+void handleApiHud() {
+  if (server.hasArg("visible")) {
+    hud_overlay.setVisible(server.arg("visible").toInt() != 0);
+  }
+  HudStats hud = hud_overlay.getStats();
+  String json = "{\"visible\":" + String(hud_overlay.isVisible() ? "true" : "false") +
+                ",\"fps\":" + String(hud.fps) +
+                ",\"renders\":" + String(hud.renders) +
+                ",\"frames\":" + String(hud.frames) + "}";
+  server.send(200, "application/json", json);
+}
+
+// 周期処理の一覧と実行の遅れ（予定時刻からのずれ）
+void handleApiTimers() {
+  server.send(200, "application/json", getTimersJSON());
+}
+
+#if APP_CLOCK_DEBUG_API
+// 周期処理の時計を進める（例: /api/clock?advance=30000 でセリフの自動クリアをすぐ起こす）
+// 期限の来たジョブはこの応答の後、同じ loop() の周期処理で実行される（周期ジョブは1回にまとめる）
+void handleApiClock() {
+  if (server.hasArg("advance")) {
+    long ms = server.arg("advance").toInt();
+    if (ms < 0 || ms > APP_CLOCK_MAX_ADVANCE_MS) {
+      server.send(400, "text/plain", "advance must be 0-" + String(APP_CLOCK_MAX_ADVANCE_MS) + " ms");
+      return;
+    }
+    app_clock.advance(ms);
+  }
+  server.send(200, "application/json",
+              "{\"now_ms\":" + String(app_clock.now()) + ",\"offset_ms\":" + String(app_clock.offset()) + "}");
+}
+#endif
+
+// loop() の段階ごとの所要時間（例: /api/profile?reset=1 で集計をやり直す）
+// loop() の起床と遅延（scripts/measure_loop_latency.py が読む）
+String getLoopJSON() {
+  LoopStats loop_stats = loop_events.getStats();
+  String json = "{\"event_driven\":" + String(LOOP_EVENT_DRIVEN ? "true" : "false") +
+                ",\"iterations\":" + String(loop_stats.iterations) +
+                ",\"iterations_per_s\":" + String(loop_stats.iterations_per_s) +
+                ",\"wakes\":{\"input\":" + String(loop_stats.wakes_input) +
+                ",\"network\":" + String(loop_stats.wakes_network) +
+                ",\"ble\":" + String(loop_stats.wakes_ble) +
+                ",\"timeout\":" + String(loop_stats.wakes_timeout) + "}" +
+                ",\"input_latency_us\":{\"count\":" + String(loop_stats.input.count) +
+                ",\"last\":" + String(loop_stats.input.last_us) +
+                ",\"avg\":" + String(loop_stats.input.avg_us) +
+                ",\"max\":" + String(loop_stats.input.max_us) + "}" +
+                ",\"request_latency_us\":{\"count\":" + String(loop_stats.request.count) +
+                ",\"last\":" + String(loop_stats.request.last_us) +
+                ",\"avg\":" + String(loop_stats.request.avg_us) +
+                ",\"max\":" + String(loop_stats.request.max_us) + "}}";
+  return json;
+}
+
+// reset=1: 遅延の集計を空にしてから返す
+void handleApiLoop() {
+  if (server.arg("reset") == "1") {
+    loop_events.resetLatency();
+    Serial.println("API: ループ遅延の集計をリセット");
+  }
+  server.send(200, "application/json", getLoopJSON());
+}
+
+void handleApiProfile() {
+#if LOOP_PROFILER_ENABLED
+  if (server.arg("reset") == "1") {
+    loop_profiler.reset();
+    Serial.println("API: ループ計測をリセット");
+  }
+#endif
+  server.send(200, "application/json", getProfileJSON());
+}
+
+// トレースのダウンロード（バイナリ、scripts/trace_to_chrome.py で変換）
+// enable=0/1: 記録の停止・再開、clear=1: リングを空にする（どちらかを指定したときは状態をJSONで返す）
+void handleApiTrace() {
+#if TRACE_ENABLED
+  if (server.hasArg("enable") || server.hasArg("clear")) {
+    if (server.hasArg("enable")) trace_recorder.setEnabled(server.arg("enable").toInt() != 0);
+    if (server.arg("clear") == "1") trace_recorder.clear();
+    server.send(200, "application/json", getTraceJSON());
+    return;
+  }
+  
+  // 記録を止めてから数える（ヘッダを送る間に増えたレコードで Content-Length とずれないように）
+  size_t bytes = trace_recorder.beginDump();
+  TraceStats before = trace_recorder.getStats();
+  server.sendHeader("Content-Disposition", "attachment; filename=\"stackchan.trace\"");
+  server.setContentLength(bytes);
+  server.send(200, "application/octet-stream", "");
+  bool ok = trace_recorder.dump(sendImageBytes, nullptr);
+  Serial.printf("API: トレース出力 %lu レコード, %lu bytes%s\n", (unsigned long)before.count, (unsigned long)bytes,
+                ok ? "" : " (中断)");
+#else
+  server.send(404, "application/json", getTraceJSON());
+#endif
+}
+
+// 長く止まりうる区間の所要時間と、前回ウォッチドッグで再起動したときに止まっていた区間
+void handleApiStalls() {
+  server.send(200, "application/json", getStallsJSON());
+}
+
+String getStallsJSON() {
+  String json = "{\"regions\":{";
+  for (int i = 0; i < STALL_REGION_COUNT; i++) {
+    StallRegionStats r = stall_detector.getStats((StallRegion)i);
+    if (i > 0) json += ",";
+    json += "\"" + String(StallDetector::regionName(i)) + "\":{" +
+            "\"budget_ms\":" + String(r.budget_ms) +
+            ",\"limit_ms\":" + String(r.limit_ms) +
+            ",\"count\":" + String(r.count) +
+            ",\"over_budget\":" + String(r.over_budget) +
+            ",\"last_ms\":" + String(r.last_ms) +
+            ",\"max_ms\":" + String(r.max_ms) +
+            ",\"active_ms\":" + String(r.active ? (long)r.active_ms : -1L) + "}";
+  }
+  json += "}";
+  const StallResetInfo& reset = stall_detector.getResetInfo();
+  if (reset.valid) {
+    json += ",\"last_reset\":{\"region\":\"" + String(StallDetector::regionName(reset.region)) +
+            "\",\"elapsed_ms\":" + String(reset.elapsed_ms) +
+            ",\"task\":\"" + String(reset.task) + "\"}";
+  } else {
+    json += ",\"last_reset\":null";
+  }
+  json += "}";
+  return json;
+}
+
+// 待機中の自動ライトスリープ（?enable=0/1 で切り替え）
+void handleApiSleep() {
+  if (server.hasArg("enable")) {
+    sleep_manager.setEnabled(server.arg("enable").toInt() != 0);
+  }
+  server.send(200, "application/json", getSleepJSON());
+}
+
+String getSleepJSON() {
+  SleepStats s = sleep_manager.getStats();
+  const SleepPolicy& policy = sleep_manager.getPolicy();
+  float elapsed = s.elapsed_us ? (float)s.elapsed_us : 1.0f;
+  String json = "{\"mode\":\"" + String(s.mode) + "\"" +
+                ",\"mode_reason\":\"" + String(s.mode_reason) + "\"" +
+                ",\"enabled\":" + String(s.enabled ? "true" : "false") +
+                ",\"allowed_fraction\":" + String(s.allowed_us / elapsed, 3) +
+                ",\"sleep_fraction\":" + String(s.asleep_us / elapsed, 3) +
+                ",\"sleeps\":" + String(s.sleeps) +
+                ",\"asleep_ms\":" + String((unsigned long)(s.asleep_us / 1000)) +
+                ",\"wake_latency_us\":{\"count\":" + String(s.wake.count) +
+                ",\"last\":" + String(s.wake.last_us) +
+                ",\"avg\":" + String(s.wake.avg_us) +
+                ",\"max\":" + String(s.wake.max_us) + "}" +
+                ",\"awake_latency_us\":{\"count\":" + String(s.awake.count) +
+                ",\"avg\":" + String(s.awake.avg_us) +
+                ",\"max\":" + String(s.awake.max_us) + "}" +
+                ",\"timer_late_us\":{\"count\":" + String(s.timer_late.count) +
+                ",\"avg\":" + String(s.timer_late.avg_us) +
+                ",\"max\":" + String(s.timer_late.max_us) + "}" +
+                ",\"awake_timer_late_us\":{\"count\":" + String(s.awake_timer_late.count) +
+                ",\"avg\":" + String(s.awake_timer_late.avg_us) +
+                ",\"max\":" + String(s.awake_timer_late.max_us) + "}" +
+                ",\"last_decision\":\"" + String(SleepPolicy::blockerName(s.last_decision)) + "\"" +
+                ",\"decisions\":{";
+  for (int i = 0; i < SLEEP_BLOCKER_COUNT; i++) {
+    if (i > 0) json += ",";
+    json += "\"" + String(SleepPolicy::blockerName((SleepBlocker)i)) + "\":" +
+            String(policy.decisions((SleepBlocker)i));
+  }
+  json += "}}";
+  return json;
+}
+
+static String breadcrumbLogJSON(const BreadcrumbLog& log) {
+  String json = "{\"uptime_ms\":" + String(log.uptime_ms) +
+                ",\"last_stage\":\"" + String(Breadcrumbs::stageName(log.last_stage)) + "\"" +
+                ",\"min_free_heap\":" + String(log.min_free_heap) +
+                ",\"min_largest_block\":" + String(log.min_largest_block) +
+                ",\"events\":[";
+  for (int i = 0; i < log.count; i++) {
+    const Breadcrumb& c = Breadcrumbs::at(log, i);
+    if (i > 0) json += ",";
+    json += "{\"ms\":" + String(c.uptime_ms) +
+            ",\"event\":\"" + String(Breadcrumbs::eventName(c.event)) + "\"" +
+            ",\"arg\":" + String(c.arg) +
+            ",\"stage\":\"" + String(Breadcrumbs::stageName(c.stage)) + "\"}";
+  }
+  json += "]}";
+  return json;
+}
+
+// 起動の各段階に達した時刻（起動からのms、まだなら null）
+String getBootJSON() {
+  String json = "{";
+  for (int i = 0; i < BOOT_PHASE_COUNT; i++) {
+    if (i > 0) json += ",";
+    json += "\"" + String(BootTimeline::phaseName(i)) + "_ms\":";
+    json += boot_timeline.reached((BootPhase)i) ? String(boot_timeline.atUs((BootPhase)i) / 1000.0f, 1) : String("null");
+  }
+  json += "}";
+  return json;
+}
+
+// RTCメモリに残した記録（previous はリセット前の起動の分、電源投入後は null）
+String getBreadcrumbsJSON() {
+  const BreadcrumbLog& current = breadcrumbs.getCurrent();
+  String json = "{\"boot_count\":" + String(current.boot_count) +
+                ",\"reset_reason\":\"" + String(Breadcrumbs::resetReasonName(current.reset_reason)) + "\"" +
+                ",\"previous\":" + (breadcrumbs.hasPrevious() ? breadcrumbLogJSON(breadcrumbs.getPrevious()) : String("null")) +
+                ",\"current\":" + breadcrumbLogJSON(current) + "}";
+  return json;
+}
+
+String getTraceJSON() {
+#if TRACE_ENABLED
+  TraceStats t = trace_recorder.getStats();
+  String json = "{\"enabled\":" + String(t.enabled ? "true" : "false") +
+                ",\"capacity\":" + String(t.capacity) +
+                ",\"count\":" + String(t.count) +
+                ",\"recorded\":" + String(t.recorded) +
+                ",\"overwritten\":" + String(t.overwritten) +
+                ",\"tasks\":" + String(t.tasks) + "}";
+  return json;
+#else
+  return "{\"enabled\":false}";
+#endif
+}
+
+String getProfileJSON() {
+#if LOOP_PROFILER_ENABLED
+  return loop_profiler.toJSON();
+#else
+  return "{\"enabled\":false}";
+#endif
+}
+
+String getTimersJSON() {
+  String json = "[";
+  bool first = true;
+  for (int id = 0; id < loop_timers.jobCount(); id++) {
+    TimerJobStats t;
+    if (!loop_timers.getStats(id, t)) continue;
+    if (!first) json += ",";
+    first = false;
+    json += "{\"name\":\"" + String(t.name) +
+            "\",\"period_ms\":" + String(t.period_ms) +
+            ",\"active\":" + String(t.active ? "true" : "false") +
+            ",\"runs\":" + String(t.runs) +
+            ",\"overruns\":" + String(t.overruns) +
+            ",\"jitter_ms\":{\"last\":" + String(t.last_jitter_ms) +
+            ",\"avg\":" + String(t.avg_jitter_ms) +
+            ",\"max\":" + String(t.max_jitter_ms) + "}}";
+  }
+  json += "]";
+  return json;
+}
+
+// 省電力の状態と設定（例: /api/power?dim=30&sleep=300）
+// dim / sleep: 無操作から減光・休止までの秒数（0 で無効）、wake=1: 即座に通常表示へ戻す
+void handleApiPower() {
+  if (server.hasArg("dim") || server.hasArg("sleep")) {
+    const IdleGovernorConfig& config = power_governor.getGovernor().getConfig();
+    uint32_t dim_ms = server.hasArg("dim") ? (uint32_t)constrain(server.arg("dim").toInt(), 0, 86400) * 1000 : config.dim_after_ms;
+    uint32_t sleep_ms = server.hasArg("sleep") ? (uint32_t)constrain(server.arg("sleep").toInt(), 0, 86400) * 1000 : config.sleep_after_ms;
+    power_governor.setTimeouts(dim_ms, sleep_ms);
+  }
+  if (server.hasArg("wake") && server.arg("wake").toInt() != 0) {
+    power_governor.wake();
+  }
+  server.send(200, "application/json", getPowerJSON());
+}
+
+String getPowerJSON() {
+  const IdleGovernor& gov = power_governor.getGovernor();
+  const IdleGovernorConfig& config = gov.getConfig();
+  uint32_t now = app_clock.uptime();
+  return "{\"level\":\"" + String(IdleGovernor::levelName(gov.level())) +
+         "\",\"idle_ms\":" + String(gov.idleMs(now)) +
+         ",\"brightness\":" + String(gov.levelConfig().brightness) +
+         ",\"frame_interval_ms\":" + String(gov.levelConfig().frame_interval_ms) +
+         ",\"dim_after_ms\":" + String(config.dim_after_ms) +
+         ",\"sleep_after_ms\":" + String(config.sleep_after_ms) +
+         ",\"transitions\":" + String(gov.transitions()) +
+         ",\"active_ms\":" + String(gov.timeInLevel(POWER_ACTIVE, now)) +
+         ",\"dim_ms\":" + String(gov.timeInLevel(POWER_DIM, now)) +
+         ",\"sleep_ms\":" + String(gov.timeInLevel(POWER_SLEEP, now)) + "}";
+}
+
+// パレット切り替え（ポインタ差し替え＋表示は描画タスクでクロスフェード）
+bool applyColorPalette(int index, uint16_t fade_ms) {
+  if (!palette_bank.select(index)) return false;
+  
+  const PaletteDef* def = palette_bank.active();
+  avatar_commands.setPalette(*def, fade_ms);
+  power_governor.wake();
+  app_state.setMessage(def->name);
+  return true;
+}
+
+// カスタムパレットを登録する（ヒープは使わず固定スロットへ書き込む）
+// 例: /api/palette?slot=0&name=夜&primary=FFE000&background=000040
+void handleApiPalette() {
+  if (!avatar_initialized) {
+    server.send(503, "text/plain", "Avatar not initialized");
+    return;
+  }
+  
+  if (!server.hasArg("slot")) {
+    server.send(400, "text/plain", "Missing slot parameter");
+    return;
+  }
+  
+  int slot = server.arg("slot").toInt();
+  if (slot < 0 || slot >= PALETTE_CUSTOM_SLOTS) {
+    server.send(400, "text/plain", "Invalid slot (0-" + String(PALETTE_CUSTOM_SLOTS - 1) + ")");
+    return;
+  }
+  int index = PALETTE_BUILTIN_COUNT + slot;
+  
+  if (server.hasArg("clear")) {
+    if (!palette_bank.clearCustom(slot)) {
+      server.send(409, "text/plain", "Palette slot is in use");
+      return;
+    }
+    server.send(200, "text/plain", "Palette slot cleared: " + String(slot));
+    return;
+  }
+  
+  // 省略した色は標準色のまま
+  PaletteDef colors = *palette_bank.get(0);
+  const char* keys[] = { "primary", "secondary", "background", "balloon_fg", "balloon_bg" };
+  uint16_t* targets[] = { &colors.primary, &colors.secondary, &colors.background,
+                          &colors.balloon_foreground, &colors.balloon_background };
+  for (int i = 0; i < 5; i++) {
+    if (server.hasArg(keys[i]) && !PaletteBank::parseHexColor(server.arg(keys[i]), *targets[i])) {
+      server.send(400, "text/plain", String("Invalid color for ") + keys[i] + " (RRGGBB)");
+      return;
+    }
+  }
+  
+  String name = server.hasArg("name") ? server.arg("name") : "";
+  palette_bank.setCustom(slot, name.c_str(), colors);
+  
+  // 表示中のスロットを書き換えた場合はそのまま反映
+  if (palette_bank.activeIndex() == index) {
+    avatar_commands.setPalette(*palette_bank.active(), 0);
+  }
+  
+  server.send(200, "application/json",
+              "{\"index\":" + String(index) + ",\"name\":\"" + jsonEscape(palette_bank.get(index)->name) + "\"}");
+  Serial.printf("API: カスタムパレット登録 slot=%d index=%d\n", slot, index);
+}
+
+void handleApiPalettes() {
+  String json = "{\"active\":" + String(palette_bank.activeIndex()) + ",\"palettes\":[";
+  bool first = true;
+  for (int i = 0; i < PALETTE_COUNT; i++) {
+    const PaletteDef* def = palette_bank.get(i);
+    if (!def) continue;
+    char colors[128];
+    snprintf(colors, sizeof(colors),
+             "\"primary\":%u,\"secondary\":%u,\"background\":%u,\"balloon_fg\":%u,\"balloon_bg\":%u",
+             def->primary, def->secondary, def->background, def->balloon_foreground, def->balloon_background);
+    if (!first) json += ",";
+    json += "{\"index\":" + String(i) + ",\"name\":\"" + jsonEscape(def->name) + "\",\"custom\":" +
+            String(i >= PALETTE_BUILTIN_COUNT ? "true" : "false") + "," + colors + "}";
+    first = false;
+  }
+  json += "]}";
+  server.send(200, "application/json", json);
+}
+
+// JSON の文字列値へ埋め込めるようにする（" \\ と制御文字。UTF-8 の文字はそのまま）
+String jsonEscape(const char* text) {
+  String out;
+  for (const char* p = text; *p; p++) {
+    char c = *p;
+    if (c == '"' || c == '\\') {
+      out += '\\';
+      out += c;
+    } else if ((uint8_t)c < 0x20) {
+      char esc[8];
+      snprintf(esc, sizeof(esc), "\\u%04x", (uint8_t)c);
+      out += esc;
+    } else {
+      out += c;
+    }
+  }
+  return out;
+}
+
+// 符号化した画像をそのままHTTPへ流す（フレーム全体はメモリに持たない）
+bool sendImageBytes(const uint8_t* data, size_t bytes, void* user) {
+  if (!server.client().connected()) return false;
+  server.sendContent((const char*)data, bytes);
+  return true;
+}
+
+// オフスクリーン描画の帯を画像エンコーダへ渡す
+bool encodeFrameBand(const uint8_t* pixels, size_t bytes, int y, int rows, void* user) {
+  return static_cast<ImageStreamEncoder*>(user)->writeBand((const uint16_t*)pixels, rows);
+}
+
+ScreenshotFormat imageFormatArg() {
+  return server.arg("format") == "png" ? SCREENSHOT_PNG : SCREENSHOT_BMP;
+}
+
+// 画像の寸法を確かめてからヘッダを送る（符号化できなければ 400 を返して false）
+bool sendImageHeaders(ScreenshotFormat format, int width, int height, int band_rows) {
+  if (!ImageStreamEncoder::supports(format, width, height)) {
+    server.send(400, "text/plain", String("Unsupported size for ") + (format == SCREENSHOT_PNG ? "PNG" : "BMP") +
+                ": " + String(width) + "x" + String(height) + " (BMP needs an even width, use format=png)");
+    return false;
+  }
+  server.setContentLength(ImageStreamEncoder::encodedSize(format, width, height, band_rows));
+  server.send(200, ImageStreamEncoder::contentType(format), "");
+  return true;
+}
+
+// 指定パレット・表情・セリフで1フレームをBMP/PNGとして返す（画面の状態には影響しない）
+void handleApiRender() {
+  int palette = server.hasArg("palette") ? server.arg("palette").toInt() : palette_bank.activeIndex();
+  int expression = server.hasArg("expression") ? server.arg("expression").toInt() : FACE_NEUTRAL;
+  if (!palette_bank.isDefined(palette) || expression < 0 || expression >= FACE_EXPRESSION_COUNT) {
+    server.send(400, "text/plain", "palette must be a defined palette index, expression 0-3");
+    return;
+  }
+  
+  if (!frame_renderer.begin(speech_balloon.getFont())) {
+    server.send(503, "text/plain", "render buffer allocation failed");
+    return;
+  }
+  frame_renderer.setText(server.hasArg("text") ? server.arg("text").c_str() : "");
+  
+  ScreenshotFormat format = imageFormatArg();
+  if (!sendImageHeaders(format, FRAME_WIDTH, FRAME_HEIGHT, frame_renderer.getBandHeight())) {
+    frame_renderer.end();
+    return;
+  }
+  
+  ImageStreamEncoder encoder;
+  uint32_t us = 0;
+  if (encoder.begin(format, FRAME_WIDTH, FRAME_HEIGHT, frame_renderer.getBandHeight(), sendImageBytes, nullptr)) {
+    us = frame_renderer.render(frameColorsFor(palette_bank.get(palette)), FaceAnimator::poseForExpression(expression),
+                               encodeFrameBand, &encoder);
+    if (us) encoder.finish();
+  }
+  encoder.end();
+  frame_renderer.end();
+  Serial.printf("API: フレーム出力 palette=%d expression=%d -> %lu us\n", palette, expression, (unsigned long)us);
+}
+
+// 表示中の画面を返す（例: /api/screenshot?format=png）
+// source=panel: パネルから帯ごとに読み出す（既定）
+// source=render: 現在の状態（色・表情・セリフ）をオフスクリーンで描き直す（パネル読み出し非対応機向け）
+// hold=1: 全帯を同じフレームから読む（その間アニメーションは止まる）
+void handleApiScreenshot() {
+  TRACE_BEGIN(TRACE_SCREENSHOT);
+  ScreenshotFormat format = imageFormatArg();
+  bool use_render = server.arg("source") == "render";
+  bool hold = server.hasArg("hold") && server.arg("hold").toInt() != 0;
+  
+  if (use_render) {
+    if (!frame_renderer.begin(speech_balloon.getFont())) {
+      server.send(503, "text/plain", "render buffer allocation failed");
+      TRACE_END(TRACE_SCREENSHOT);
+      return;
+    }
+    frame_renderer.setText(app_state.snapshot().message);
+    
+    uint32_t start = app_clock.uptimeUs();
+    if (!sendImageHeaders(format, FRAME_WIDTH, FRAME_HEIGHT, frame_renderer.getBandHeight())) {
+      frame_renderer.end();
+      TRACE_END(TRACE_SCREENSHOT);
+      return;
+    }
+    ImageStreamEncoder encoder;
+    size_t bytes = ImageStreamEncoder::encodedSize(format, FRAME_WIDTH, FRAME_HEIGHT, frame_renderer.getBandHeight());
+    
+    PaletteDef shown = palette_fader.getShown();
+    bool ok = encoder.begin(format, FRAME_WIDTH, FRAME_HEIGHT, frame_renderer.getBandHeight(), sendImageBytes, nullptr);
+    uint32_t render_us = ok ? frame_renderer.render(frameColorsFor(&shown), face_animator.getPose(), encodeFrameBand, &encoder) : 0;
+    ok = render_us && encoder.finish();
+    encoder.end();
+    frame_renderer.end();
+    
+    screen_capture.recordCapture(ok, app_clock.uptimeUs() - start, render_us, bytes);
+  } else {
+    int w = M5.Display.width();
+    int h = M5.Display.height();
+    int band_rows = ImageStreamEncoder::clampBandRows(format, w, SCREEN_CAPTURE_BAND_ROWS);
+    if (!sendImageHeaders(format, w, h, band_rows)) {
+      TRACE_END(TRACE_SCREENSHOT);
+      return;
+    }
+    screen_capture.capturePanel(&M5.Display, format, hold, sendImageBytes, nullptr);
+  }
+  
+  TRACE_END(TRACE_SCREENSHOT);
+  ScreenCaptureStats cap = screen_capture.getStats();
+  Serial.printf("API: スクリーンショット(%s, %s) -> 合計 %lu us, 読み出し %lu us, 描画停止 %lu us, %lu bytes\n",
+                format == SCREENSHOT_PNG ? "png" : "bmp", use_render ? "render" : "panel",
+                (unsigned long)cap.last_total_us, (unsigned long)cap.last_read_us,
+                (unsigned long)cap.last_paused_us, (unsigned long)cap.last_bytes);
+}
+
+// 登録済みパレット×4表情を巡回しながら描画だけを行い fps を測る
+void handleApiRenderBench() {
+  int frames = server.hasArg("frames") ? server.arg("frames").toInt() : 60;
+  if (frames < 1 || frames > 600) frames = 60;
+  int band = server.hasArg("band") ? server.arg("band").toInt() : FRAME_BAND_HEIGHT;
+  
+  if (!frame_renderer.begin(speech_balloon.getFont(), band)) {
+    server.send(503, "text/plain", "render buffer allocation failed");
+    return;
+  }
+  frame_renderer.setText(server.hasArg("text") ? server.arg("text").c_str() : "こんにちは、スタックチャンです");
+  
+  FrameColors palettes[PALETTE_COUNT];
+  int palette_count = 0;
+  for (int i = 0; i < PALETTE_COUNT; i++) {
+    if (palette_bank.isDefined(i)) palettes[palette_count++] = frameColorsFor(palette_bank.get(i));
+  }
+  FrameBenchResult r = frame_renderer.benchmark(palettes, palette_count, frames);
+  frame_renderer.end();
+  
+  String json = "{";
+  json += "\"frames\":" + String(r.frames) + ",";
+  json += "\"bands_per_frame\":" + String(r.bands_per_frame) + ",";
+  json += "\"total_us\":" + String(r.total_us) + ",";
+  json += "\"avg_frame_us\":" + String(r.avg_frame_us) + ",";
+  json += "\"max_frame_us\":" + String(r.max_frame_us) + ",";
+  json += "\"fps\":" + String(r.fps, 1);
+  json += "}";
+  
+  server.send(200, "application/json", json);
+  Serial.printf("API: 描画ベンチ -> %lu frames, 平均 %lu us, %.1f fps\n",
+                (unsigned long)r.frames, (unsigned long)r.avg_frame_us, r.fps);
+}
+
 void handle404() {
   server.send(404, "text/plain", "404 Not Found - Stack-chan WebUI");
 }
@@ -696,9 +1644,10 @@ void handle404() {
 // ランダムセリフ設定確認
 void checkRandomSpeechConfig() {
   // random_speeches配列の最初の要素をチェック
-  random_speech_enabled = (random_speeches[0] != nullptr);
+  bool enabled = (random_speeches[0] != nullptr);
+  app_state.setRandomSpeech(enabled);
   
-  if (random_speech_enabled) {
+  if (enabled) {
     Serial.println("ランダムセリフ機能: 有効");
     int count = 0;
     while (random_speeches[count] != nullptr) count++;
@@ -710,7 +1659,7 @@ void checkRandomSpeechConfig() {
 
 // ランダムセリフ取得
 String getRandomSpeech() {
-  if (!random_speech_enabled) return "";
+  if (!app_state.snapshot().random_speech_enabled) return "";
   
   // 配列のサイズを数える
   int count = 0;
@@ -723,94 +1672,89 @@ String getRandomSpeech() {
   return String(random_speeches[index]);
 }
 
-// セリフ自動ループ更新
-void updateSpeechLoop() {
+// セリフ自動ループ（最後にセリフを設定してから SPEECH_AUTO_CLEAR_TIME 後に呼ばれる）
+void onSpeechTimer(void* user) {
   if (!avatar_initialized) return;
   
-  unsigned long current_time = millis();
-  
-  // ユーザーがセリフを設定してから30秒経過した場合
-  if (speech_set_by_user && 
-      (current_time - last_speech_time) > SPEECH_AUTO_CLEAR_TIME) {
-    
+  AppState state = app_state.snapshot();
+  if (state.speech_set_by_user) {
+    // ユーザーがセリフを設定してから30秒経過した場合
     Serial.println("セリフ自動クリア（30秒経過）");
-    speech_set_by_user = false;
+    app_state.setSpeechByUser(false);
     
     // ランダムセリフが有効な場合は選択、無効な場合は標準メッセージ
-    if (random_speech_enabled) {
-      current_message = getRandomSpeech();
-      Serial.println("ランダムセリフ開始: " + current_message);
+    String message;
+    if (state.random_speech_enabled) {
+      message = getRandomSpeech();
+      Serial.println("ランダムセリフ開始: " + message);
     } else {
-      current_message = "スタックちゃん";
+      message = "スタックちゃん";
       Serial.println("標準メッセージに戻る");
     }
     
-    avatar.setSpeechText(current_message.c_str());
-    last_speech_time = current_time;
-  }
-  
-  // ランダムセリフが有効で、ユーザー設定でない場合の自動ループ
-  if (random_speech_enabled && !speech_set_by_user &&
-      (current_time - last_speech_time) > SPEECH_AUTO_CLEAR_TIME) {
-    
+    app_state.setMessage(message.c_str());
+  } else if (state.random_speech_enabled) {
+    // ランダムセリフが有効で、ユーザー設定でない場合の自動ループ
     String new_speech = getRandomSpeech();
-    if (new_speech != current_message) {  // 同じセリフの連続を避ける
-      current_message = new_speech;
-      avatar.setSpeechText(current_message.c_str());
-      Serial.println("ランダムセリフ変更: " + current_message);
+    if (new_speech != state.message) {  // 同じセリフの連続を避ける
+      app_state.setMessage(new_speech.c_str());
+      Serial.println("ランダムセリフ変更: " + new_speech);
     }
-    last_speech_time = current_time;
+  }
+  
+  // ランダムセリフは同じ間隔で続ける
+  if (state.random_speech_enabled) {
+    loop_timers.reschedule(speech_timer, SPEECH_AUTO_CLEAR_TIME, app_clock.now());
   }
 }
 
 // BLE初期化関数
 void initializeBLE() {
+  StallGuard stall(STALL_BLE_INIT);
   Serial.println("BLE初期化開始...");
   
   // BLE WebUIハンドラー作成
   bleWebUI = new BLEWebUIHandler();
   bleWebUI->begin();
   
-  ble_enabled = true;
+  app_state.setBleEnabled(true);
   Serial.println("BLE初期化完了");
 }
 
 // 通信モード切り替え関数
 void toggleConnectionMode() {
-  if (connection_mode_ble) {
+  StallGuard stall(STALL_MODE_SWITCH);
+  TRACE_BEGIN(TRACE_MODE_SWITCH);
+  AppState state = app_state.snapshot();
+  breadcrumbs.add(CRUMB_MODE_SWITCH, state.connection_mode_ble ? 0 : 1);
+  cancelBootWiFi();
+  if (state.connection_mode_ble) {
     // BLE → WiFiモードに切り替え
     Serial.println("BLE → WiFiモードに切り替え中...");
     
     // BLE停止
-    if (ble_enabled) {
+    if (state.ble_enabled) {
       if (bleWebUI) {
         delete bleWebUI;
         bleWebUI = nullptr;
       }
+      stall_detector.enter(STALL_BLE_DEINIT);
       BLEDevice::deinit();
-      ble_enabled = false;
+      stall_detector.exit(STALL_BLE_DEINIT);
+      app_state.setBleEnabled(false);
     }
     
-    connection_mode_ble = false;
-    current_message = "WiFi接続中... (Bボタン=BLE切替)";
-    if (avatar_initialized) {
-      avatar.setSpeechText(current_message.c_str());
-    }
+    app_state.setBleMode(false);
+    showStatus("WiFi接続中... (Bボタン=BLE切替)");
     
     // WiFi接続試行（割り込み可能）
-    if (connectToWiFi()) {
-      setupWebServer();
-      current_message = String("WiFi: ") + current_ip;
-    } else {
+    if (!connectToWiFi()) {
       // WiFi失敗またはBボタン割り込み - BLEモードに戻る
       Serial.println("WiFi接続失敗またはBボタン割り込み - BLEモードに戻ります");
-      connection_mode_ble = true;
-      current_message = "BLEペアリングモード初期化中...";
-      if (avatar_initialized) {
-        avatar.setSpeechText(current_message.c_str());
-      }
+      app_state.setBleMode(true);
+      showStatus("BLEペアリングモード初期化中...");
       initializeBLE();
-      current_message = "BLE: " + String(BLE_DEVICE_NAME) + " (ペアリング待機中)";
+      showStatus("BLE: " + String(BLE_DEVICE_NAME) + " (ペアリング待機中)");
     }
     
   } else {
@@ -818,67 +1762,117 @@ void toggleConnectionMode() {
     Serial.println("WiFi → BLEモードに切り替え中...");
     
     // WiFi停止
-    if (wifi_connected) {
-      server.stop();
+    stopWebServer();
+    if (state.wifi_connected) {
       WiFi.disconnect();
-      wifi_connected = false;
-      current_ip = "";
+      app_state.setWiFi(false, nullptr);
     }
     
-    connection_mode_ble = true;
-    current_message = "BLEペアリングモード初期化中...";
-    if (avatar_initialized) {
-      avatar.setSpeechText(current_message.c_str());
-    }
+    app_state.setBleMode(true);
+    showStatus("BLEペアリングモード初期化中...");
     
     // BLE開始
     initializeBLE();
-    current_message = String("BLE: ") + BLE_DEVICE_NAME + " (ペアリング待機中)";
-  }
-  
-  if (avatar_initialized) {
-    avatar.setSpeechText(current_message.c_str());
+    showStatus(String("BLE: ") + BLE_DEVICE_NAME + " (ペアリング待機中)");
   }
   
-  Serial.println("通信モード切り替え完了: " + String(connection_mode_ble ? "BLE" : "WiFi"));
+  Serial.println("通信モード切り替え完了: " + String(app_state.snapshot().connection_mode_ble ? "BLE" : "WiFi"));
+  boot_timeline.mark(BOOT_NETWORK);
+  TRACE_END(TRACE_MODE_SWITCH);
+}
+
+// 接続状態などの運用情報はHUDに表示する（ユーザーのセリフは上書きしない）
+void showStatus(const String& text) {
+  hud_overlay.setStatus(text.c_str());
+  Serial.println("状態: " + text);
 }
 
 // === BLE WebUI用の外部関数実装 ===
 
+// BLEWebUIHandler のコールバック（BLE タスクで呼ばれる）。積むだけで、反映は loop() の applyBleRequests()
+void BLEWebUIHandler::onExpressionChange(int expression) {
+  postBleRequest(BLE_REQUEST_EXPRESSION, expression, -1, "");
+}
+
+void BLEWebUIHandler::onColorChange(int colorIndex) {
+  postBleRequest(BLE_REQUEST_COLOR, colorIndex, -1, "");
+}
+
+void BLEWebUIHandler::onSpeechSet(const String& speech, int expression) {
+  postBleRequest(BLE_REQUEST_SPEECH, 0, expression, speech.c_str());
+}
+
+// BLE タスクだけが積む（onWrite() の最後で LOOP_EVENT_BLE を通知するので loop() はすぐ起きる）
+void postBleRequest(uint8_t type, int id, int expression, const char* text) {
+  BleRequest* request = ble_requests.reserve();
+  if (!request) {
+    Serial.println("BLE: 変更要求が溜まっているため破棄しました");
+    return;
+  }
+  request->type = type;
+  request->id = id;
+  request->expression = expression;
+  strncpy(request->text, text, sizeof(request->text) - 1);
+  request->text[sizeof(request->text) - 1] = '\0';
+  ble_requests.commit();
+}
+
+// loop() から呼ぶ（起床・パレットのフェード・タイマーは loop タスクで動かす）
+void applyBleRequests() {
+  BleRequest* request;
+  while ((request = ble_requests.front()) != nullptr) {
+    switch (request->type) {
+      case BLE_REQUEST_EXPRESSION:
+        changeExpressionById(request->id);
+        break;
+      case BLE_REQUEST_COLOR:
+        changeColorById(request->id);
+        break;
+      case BLE_REQUEST_SPEECH:
+        setSpeechText(String(request->text), request->expression);
+        break;
+    }
+    ble_requests.release();
+  }
+}
+
+// スクリーンショットの要求で、休止中の長い描画間隔の待ちを切り上げさせる（HTTP 側から呼ばれる）
+void wakeDrawForCapture() {
+  power_governor.interruptFrame();
+}
+
 void changeExpressionById(int id) {
   if (!avatar_initialized) return;
   
+  int expression;
   if (id == -1) {
     // サイクル変更
-    current_expression = (current_expression + 1) % 4;
+    expression = app_state.cycleExpression();
   } else {
-    current_expression = id % 4;
+    expression = id % 4;
+    app_state.setExpression(expression);
   }
   
-  switch (current_expression) {
+  const char* message = "";
+  switch (expression) {
     case 0:
-      avatar.setExpression(Expression::Neutral);
-      current_message = "普通";
+      message = "普通";
       break;
     case 1:
-      avatar.setExpression(Expression::Happy);
-      current_message = "嬉しい";
+      message = "嬉しい";
       break;
     case 2:
-      avatar.setExpression(Expression::Sleepy);
-      current_message = "眠い";
+      message = "眠い";
       break;
     case 3:
-      avatar.setExpression(Expression::Doubt);
-      current_message = "困った";
+      message = "困った";
       break;
   }
+  app_state.setMessage(message);
+  power_governor.wake();
+  app_state.setSpeechByUser(true);
   
-  avatar.setSpeechText(current_message.c_str());
-  speech_set_by_user = true;
-  last_speech_time = millis();
-  
-  Serial.println("BLE経由で表情変更: " + current_message);
+  Serial.println(String("BLE経由で表情変更: ") + message);
 }
 
 void changeColorById(int id) {
@@ -886,24 +1880,19 @@ void changeColorById(int id) {
   
   if (id == -1) {
     // サイクル変更
-    current_color_index = (current_color_index + 1) % 6;
-  } else {
-    current_color_index = id % 6;
+    applyColorPalette(palette_bank.nextIndex(palette_bank.activeIndex()));
+  } else if (!applyColorPalette(id)) {
+    return;
   }
   
-  avatar.setColorPalette(*cps[current_color_index]);
-  
-  String color_names[] = {"標準色", "青系", "緑系", "赤系", "紫系", "オレンジ系"};
-  current_message = color_names[current_color_index];
-  avatar.setSpeechText(current_message.c_str());
-  speech_set_by_user = true;
-  last_speech_time = millis();
+  app_state.setSpeechByUser(true);
   
-  Serial.println("BLE経由で色変更: " + current_message);
+  Serial.println("BLE経由で色変更: " + String(palette_bank.active()->name));
 }
 
 void setSpeechText(const String& text, int expression) {
   if (!avatar_initialized) return;
+  power_governor.wake();
   
   // 表情設定
   if (expression >= 0 && expression <= 3) {
@@ -912,45 +1901,137 @@ void setSpeechText(const String& text, int expression) {
   
   // セリフ設定
   if (text.length() > 0) {
-    current_message = text;
-    avatar.setSpeechText(current_message.c_str());
-    speech_set_by_user = true;
-    last_speech_time = millis();
+    app_state.setMessage(text.c_str());
+    app_state.setSpeechByUser(true);
     
-    Serial.println("BLE経由でセリフ設定: " + current_message);
+    Serial.println("BLE経由でセリフ設定: " + text);
   } else {
     // セリフクリア
-    current_message = "スタックちゃん";
-    avatar.setSpeechText(current_message.c_str());
-    speech_set_by_user = false;
+    app_state.setMessage("スタックちゃん");
+    app_state.setSpeechByUser(false);
     
     Serial.println("BLE経由でセリフクリア");
   }
 }
 
 String getSystemStatusJSON() {
+  // 1回の読み出しで揃った値を使う（BLE の応答は loop() と別のタスクで作る）
+  AppState state = app_state.snapshot();
   String status = "{";
-  status += "\"mode\":\"" + String(connection_mode_ble ? "BLE" : "WiFi") + "\",";
-  status += "\"wifi_connected\":" + String(wifi_connected ? "true" : "false") + ",";
-  status += "\"ble_enabled\":" + String(ble_enabled ? "true" : "false") + ",";
+  status += "\"mode\":\"" + String(state.connection_mode_ble ? "BLE" : "WiFi") + "\",";
+  status += "\"wifi_connected\":" + String(state.wifi_connected ? "true" : "false") + ",";
+  status += "\"ble_enabled\":" + String(state.ble_enabled ? "true" : "false") + ",";
   
-  if (connection_mode_ble && ble_enabled && bleWebUI) {
+  if (state.connection_mode_ble && state.ble_enabled && bleWebUI) {
     status += "\"ble_connected\":" + String(bleWebUI->isConnected() ? "true" : "false") + ",";
   } else {
     status += "\"ble_connected\":false,";
   }
   
-  if (wifi_connected) {
-    status += "\"ip_address\":\"" + current_ip + "\",";
+  if (state.wifi_connected) {
+    status += "\"ip_address\":\"" + String(state.ip) + "\",";
   } else {
     status += "\"ip_address\":\"\",";
   }
   
-  status += "\"current_message\":\"" + current_message + "\",";
-  status += "\"expression\":" + String(current_expression) + ",";
-  status += "\"color_index\":" + String(current_color_index) + ",";
+  status += "\"display\":{\"profile\":\"" + String(DisplayProfile::name) +
+            "\",\"width\":" + String(DisplayProfile::width) +
+            ",\"height\":" + String(DisplayProfile::height) + "},";
+  
+  status += "\"current_message\":\"" + jsonEscape(state.message) + "\",";
+  status += "\"expression\":" + String(state.expression) + ",";
+  status += "\"state_version\":" + String(state.version) + ",";
+  status += "\"color_index\":" + String(palette_bank.activeIndex()) + ",";
+  status += "\"palette\":\"" + jsonEscape(palette_bank.active()->name) + "\",";
   status += "\"free_heap\":" + String(ESP.getFreeHeap()) + ",";
-  status += "\"uptime\":" + String(millis() / 1000);
+  
+  GlyphCache& glyphs = speech_balloon.getGlyphCache();
+  status += "\"glyph_cache\":{\"hits\":" + String(glyphs.getHits()) +
+            ",\"misses\":" + String(glyphs.getMisses()) +
+            ",\"slots\":" + String(glyphs.getSlotCount()) +
+            ",\"bytes\":" + String((unsigned long)glyphs.getMemoryBytes()) +
+            ",\"psram\":" + String(glyphs.isInPsram() ? "true" : "false") + "},";
+  status += "\"speech_layouts\":" + String(speech_balloon.getLayoutCount()) + ",";
+  
+  BalloonCacheStats balloons = speech_balloon.getBalloonCache().getStats();
+  uint32_t balloon_lookups = balloons.hits + balloons.misses;
+  status += "\"balloon_cache\":{\"hits\":" + String(balloons.hits) +
+            ",\"misses\":" + String(balloons.misses) +
+            ",\"repeats\":" + String(balloons.repeats) +
+            ",\"hit_rate\":" + String(balloon_lookups ? balloons.hits * 100.0f / balloon_lookups : 0.0f, 1) +
+            ",\"evictions\":" + String(balloons.evictions) +
+            ",\"entries\":" + String(balloons.entries) +
+            ",\"bytes\":" + String((unsigned long)balloons.bytes) +
+            ",\"budget\":" + String((unsigned long)balloons.budget) + "},";
+  
+  MarqueeStats marquee = speech_balloon.getMarquee().getStats();
+  status += "\"marquee\":{\"speed\":" + String(speech_balloon.getMarquee().getSpeed()) +
+            ",\"frames\":" + String(marquee.frames) +
+            ",\"last_pixels\":" + String(marquee.last_pixels) +
+            ",\"avg_pixels\":" + String(marquee.avg_pixels) +
+            ",\"full_pixels\":" + String(marquee.full_pixels) +
+            ",\"copy_bytes\":" + String(marquee.copy_bytes) +
+            ",\"redraws\":" + String(marquee.redraws) + "},";
+  
+  AvatarCommandStats commands = avatar_commands.getStats();
+  status += "\"avatar_commands\":{\"pushed\":" + String(commands.pushed) +
+            ",\"applied\":" + String(commands.applied) +
+            ",\"waits\":" + String(commands.waits) +
+            ",\"dropped\":" + String(commands.dropped) +
+            ",\"max_depth\":" + String(commands.max_depth) + "},";
+  
+  AppStateStats state_stats = app_state.getStats();
+  status += "\"app_state\":{\"writes\":" + String(state_stats.writes) +
+            ",\"reads\":" + String(state_stats.reads) +
+            ",\"read_retries\":" + String(state_stats.read_retries) +
+            ",\"read_yields\":" + String(state_stats.read_yields) +
+            ",\"events\":" + String(state_stats.events) +
+            ",\"deliveries\":" + String(state_stats.deliveries) +
+            ",\"subscribers\":" + String((unsigned long)state_bus.subscriberCount()) +
+            ",\"dispatch_latency_us\":{\"last\":" + String(state_stats.dispatch.last_us) +
+            ",\"avg\":" + String(state_stats.dispatch.avg_us) +
+            ",\"max\":" + String(state_stats.dispatch.max_us) + "}},";
+  
+  status += "\"power\":" + getPowerJSON() + ",";
+  status += "\"timers\":" + getTimersJSON() + ",";
+  status += "\"profile\":" + getProfileJSON() + ",";
+  status += "\"trace\":" + getTraceJSON() + ",";
+  status += "\"stalls\":" + getStallsJSON() + ",";
+  status += "\"sleep\":" + getSleepJSON() + ",";
+  status += "\"breadcrumbs\":" + getBreadcrumbsJSON() + ",";
+  status += "\"boot\":" + getBootJSON() + ",";
+  
+  status += "\"loop\":" + getLoopJSON() + ",";
+  
+  ButtonInputStats buttons = button_input.getStats();
+  status += "\"buttons\":{\"interrupt\":" + String(button_input.isInterruptDriven() ? "true" : "false") +
+            ",\"events\":" + String(buttons.events) +
+            ",\"dropped\":" + String(buttons.dropped) +
+            ",\"bounces\":" + String(buttons.bounces) + "},";
+  
+  ScreenCaptureStats cap = screen_capture.getStats();
+  status += "\"screenshot\":{\"captures\":" + String(cap.captures) +
+            ",\"failures\":" + String(cap.failures) +
+            ",\"last_total_us\":" + String(cap.last_total_us) +
+            ",\"last_read_us\":" + String(cap.last_read_us) +
+            ",\"last_paused_us\":" + String(cap.last_paused_us) +
+            ",\"last_bytes\":" + String(cap.last_bytes) +
+            ",\"abandoned\":" + String(cap.abandoned) + "},";
+  
+  HudStats hud = hud_overlay.getStats();
+  status += "\"hud\":{\"visible\":" + String(hud_overlay.isVisible() ? "true" : "false") +
+            ",\"fps\":" + String(hud.fps) +
+            ",\"renders\":" + String(hud.renders) +
+            ",\"frames\":" + String(hud.frames) + "},";
+  
+  PaletteFadeStats fade = palette_fader.getStats();
+  status += "\"palette_fade\":{\"fades\":" + String(fade.fades) +
+            ",\"steps\":" + String(fade.steps) +
+            ",\"last_step_us\":" + String(fade.last_step_us) +
+            ",\"max_step_us\":" + String(fade.max_step_us) +
+            ",\"avg_step_us\":" + String(fade.avg_step_us) + "},";
+  status += "\"clock_offset_ms\":" + String(app_clock.offset()) + ",";
+  status += "\"uptime\":" + String(app_clock.uptime() / 1000);
   status += "}";
   
   return status;
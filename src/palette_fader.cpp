@@ -0,0 +1,120 @@
+/*
+ * Palette Fader for Stack-chan
+ * パレット切り替え時に旧パレットから新パレットへ色をクロスフェードする
+ */
+
+#include "palette_fader.h"
+
+PaletteFader palette_fader;
+
+// 表示中の色だけを守る（描画タスクが書き、HTTP 側の描画が読む）
+static portMUX_TYPE shown_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// チャンネル値×alpha の乗算済みテーブル（R/B は5bit、G は6bit）
+// 合成は (lut[a][to] + lut[LEVELS-a][from]) >> 5 の加算とシフトだけで済む
+static uint16_t blend_lut5[PALETTE_BLEND_LEVELS + 1][32];
+static uint16_t blend_lut6[PALETTE_BLEND_LEVELS + 1][64];
+static bool blend_lut_ready = false;
+
+static void buildBlendLut() {
+  if (blend_lut_ready) return;
+  for (int a = 0; a <= PALETTE_BLEND_LEVELS; a++) {
+    for (int v = 0; v < 32; v++) blend_lut5[a][v] = v * a;
+    for (int v = 0; v < 64; v++) blend_lut6[a][v] = v * a;
+  }
+  blend_lut_ready = true;
+}
+
+uint16_t blendRgb565(uint16_t from, uint16_t to, uint8_t alpha) {
+  if (alpha >= PALETTE_BLEND_LEVELS) return to;
+  if (alpha == 0) return from;
+
+  uint8_t inv = PALETTE_BLEND_LEVELS - alpha;
+  uint16_t r = (blend_lut5[inv][from >> 11] + blend_lut5[alpha][to >> 11]) >> 5;
+  uint16_t g = (blend_lut6[inv][(from >> 5) & 0x3F] + blend_lut6[alpha][(to >> 5) & 0x3F]) >> 5;
+  uint16_t b = (blend_lut5[inv][from & 0x1F] + blend_lut5[alpha][to & 0x1F]) >> 5;
+  return (r << 11) | (g << 5) | b;
+}
+
+static void blendPalette(const PaletteDef& a, const PaletteDef& b, uint8_t alpha, PaletteDef& out) {
+  out.name = b.name;
+  out.primary = blendRgb565(a.primary, b.primary, alpha);
+  out.secondary = blendRgb565(a.secondary, b.secondary, alpha);
+  out.background = blendRgb565(a.background, b.background, alpha);
+  out.balloon_foreground = blendRgb565(a.balloon_foreground, b.balloon_foreground, alpha);
+  out.balloon_background = blendRgb565(a.balloon_background, b.balloon_background, alpha);
+}
+
+PaletteFader::PaletteFader() {
+  memset(&from, 0, sizeof(from));
+  memset(&to, 0, sizeof(to));
+  memset(&shown, 0, sizeof(shown));
+  fading = false;
+  started_at = 0;
+  duration = 0;
+  last_alpha = 0;
+  step_started_us = 0;
+  total_step_us = 0;
+  memset(&stats, 0, sizeof(stats));
+}
+
+void PaletteFader::begin(const PaletteDef& initial) {
+  buildBlendLut();
+  shown = initial;
+  to = initial;
+  fading = false;
+}
+
+void PaletteFader::start(const PaletteDef& target, uint16_t duration_ms) {
+  // フェード途中で切り替えた場合も、いま表示している色から始める
+  from = shown;
+  to = target;
+  duration = duration_ms > PALETTE_FADE_MAX_MS ? PALETTE_FADE_MAX_MS : duration_ms;
+  started_at = millis();
+  last_alpha = 0;
+  fading = true;
+  stats.fades++;
+}
+
+bool PaletteFader::update(PaletteDef& out) {
+  if (!fading) return false;
+
+  unsigned long elapsed = millis() - started_at;
+  uint8_t alpha = PALETTE_BLEND_LEVELS;
+  if (duration > 0 && elapsed < duration) {
+    alpha = (elapsed * PALETTE_BLEND_LEVELS) / duration;
+  }
+  // 段階が変わらなければ再描画しない
+  if (alpha == last_alpha && alpha < PALETTE_BLEND_LEVELS) return false;
+
+  step_started_us = micros();
+  blendPalette(from, to, alpha, out);
+  last_alpha = alpha;
+  if (alpha >= PALETTE_BLEND_LEVELS) out = to;
+  portENTER_CRITICAL(&shown_lock);
+  shown = out;
+  portEXIT_CRITICAL(&shown_lock);
+  if (alpha >= PALETTE_BLEND_LEVELS) fading = false;
+  return true;
+}
+
+void PaletteFader::stepApplied() {
+  uint32_t us = micros() - step_started_us;
+  stats.steps++;
+  stats.last_step_us = us;
+  if (us > stats.max_step_us) stats.max_step_us = us;
+  total_step_us += us;
+}
+
+PaletteDef PaletteFader::getShown() const {
+  portENTER_CRITICAL(&shown_lock);
+  PaletteDef copy = shown;
+  portEXIT_CRITICAL(&shown_lock);
+  return copy;
+}
+
+PaletteFadeStats PaletteFader::getStats() const {
+  PaletteFadeStats s = stats;
+  s.avg_step_us = s.steps ? total_step_us / s.steps : 0;
+  return s;
+}
@@ -0,0 +1,71 @@
+/*
+ * Palette Fader for Stack-chan
+ * パレット切り替え時に旧パレットから新パレットへ色をクロスフェードする
+ * RGB565 のまま、チャンネルごとの乗算済みテーブルで合成する（浮動小数点なし）
+ * start() / update() は描画タスクだけが呼ぶ（AvatarCommands のパレット命令から）。他のタスクは状態を読むだけ
+ */
+
+#ifndef PALETTE_FADER_H
+#define PALETTE_FADER_H
+
+#include <M5Unified.h>
+#include "color_palettes.h"
+
+// フェード時間の既定値（ms）。0 で即時切り替え
+#ifndef PALETTE_FADE_MS
+#define PALETTE_FADE_MS 400
+#endif
+#define PALETTE_FADE_MAX_MS 5000
+
+// 合成比率の段階数（alpha は 0 - PALETTE_BLEND_LEVELS）
+#define PALETTE_BLEND_LEVELS 32
+
+struct PaletteFadeStats {
+  uint32_t fades;        // 開始したフェード数
+  uint32_t steps;        // 適用したステップ数
+  uint32_t last_step_us; // 直近ステップの所要時間（合成＋Avatarへの反映）
+  uint32_t max_step_us;
+  uint32_t avg_step_us;
+};
+
+// RGB565 の2色を alpha/PALETTE_BLEND_LEVELS で合成する（begin() 後に使う）
+uint16_t blendRgb565(uint16_t from, uint16_t to, uint8_t alpha);
+
+class PaletteFader {
+public:
+  PaletteFader();
+
+  // 合成テーブルを作成し、表示中の色を初期化する（描画タスクを動かす前に呼ぶ）
+  void begin(const PaletteDef& shown);
+
+  // 表示中の色から target へ duration_ms かけて遷移する（0 なら次の update() で即時反映）
+  void start(const PaletteDef& target, uint16_t duration_ms);
+
+  // 描画タスクからフレームごとに呼ぶ。適用すべき新しい色があれば out に入れて true
+  bool update(PaletteDef& out);
+
+  // update() の結果を反映し終えた時点で呼ぶ（ステップ時間の計測終了）
+  void stepApplied();
+
+  // どのタスクからでも
+  bool isFading() const { return fading; }
+  PaletteDef getShown() const;
+  PaletteFadeStats getStats() const;
+
+private:
+  PaletteDef from;
+  PaletteDef to;
+  PaletteDef shown;
+  volatile bool fading;
+  unsigned long started_at;
+  uint16_t duration;
+  uint8_t last_alpha;
+
+  uint32_t step_started_us;
+  uint32_t total_step_us;
+  PaletteFadeStats stats;
+};
+
+extern PaletteFader palette_fader;
+
+#endif
@@ -0,0 +1,84 @@
+/*
+ * Power Governor for Stack-chan
+ * IdleGovernor の段階に合わせてバックライトの明るさと描画フレームレートを下げる
+ * 無操作の時間とフレーム間隔は app_clock.uptime() で測る（/api/clock で進めた分は含まない）
+ */
+
+#include "power_governor.h"
+#include "trace_recorder.h"
+#include "breadcrumbs.h"
+#include "app_clock.h"
+
+PowerGovernor power_governor;
+
+PowerGovernor::PowerGovernor() {
+  wake_signal = nullptr;
+  frame_interval_ms = 0;
+  last_frame_ms = 0;
+}
+
+void PowerGovernor::begin() {
+  if (!wake_signal) {
+    wake_signal = xSemaphoreCreateBinary();
+  }
+
+  IdleGovernorConfig config;
+  config.dim_after_ms = POWER_DIM_AFTER_MS;
+  config.sleep_after_ms = POWER_SLEEP_AFTER_MS;
+  config.levels[POWER_ACTIVE].frame_interval_ms = 0;
+  config.levels[POWER_ACTIVE].brightness = M5.Display.getBrightness();
+  config.levels[POWER_DIM].frame_interval_ms = POWER_DIM_FRAME_MS;
+  config.levels[POWER_DIM].brightness = POWER_DIM_BRIGHTNESS;
+  config.levels[POWER_SLEEP].frame_interval_ms = POWER_SLEEP_FRAME_MS;
+  config.levels[POWER_SLEEP].brightness = POWER_SLEEP_BRIGHTNESS;
+  governor.configure(config, app_clock.uptime());
+  governor.activity(app_clock.uptime());
+
+  Serial.printf("PowerGovernor: 減光 %lus, 休止 %lus (明るさ %u)\n",
+                (unsigned long)(config.dim_after_ms / 1000), (unsigned long)(config.sleep_after_ms / 1000),
+                config.levels[POWER_ACTIVE].brightness);
+}
+
+void PowerGovernor::apply() {
+  const PowerLevelConfig& level = governor.levelConfig();
+  frame_interval_ms = level.frame_interval_ms;
+  M5.Display.setBrightness(level.brightness);
+  TRACE_INSTANT(TRACE_POWER_LEVEL, governor.level());
+  breadcrumbs.add(CRUMB_POWER_LEVEL, governor.level());
+  Serial.printf("PowerGovernor: %s (明るさ %u, 描画間隔 %ums)\n",
+                IdleGovernor::levelName(governor.level()), level.brightness, level.frame_interval_ms);
+}
+
+void PowerGovernor::update() {
+  if (governor.update(app_clock.uptime())) apply();
+}
+
+void PowerGovernor::wake() {
+  if (!governor.activity(app_clock.uptime())) return;
+  apply();
+  // 長い間隔で待っている描画タスクを起こす
+  if (wake_signal) xSemaphoreGive(wake_signal);
+}
+
+void PowerGovernor::interruptFrame() {
+  if (wake_signal) xSemaphoreGive(wake_signal);
+}
+
+void PowerGovernor::setTimeouts(uint32_t dim_after_ms, uint32_t sleep_after_ms) {
+  IdleGovernorConfig config = governor.getConfig();
+  config.dim_after_ms = dim_after_ms;
+  config.sleep_after_ms = sleep_after_ms;
+  governor.configure(config, app_clock.uptime());
+  apply();
+}
+
+void PowerGovernor::paceFrame() {
+  if (!wake_signal) return;
+
+  uint16_t interval = frame_interval_ms;
+  uint32_t elapsed = app_clock.uptime() - last_frame_ms;
+  if (interval && elapsed < interval) {
+    xSemaphoreTake(wake_signal, pdMS_TO_TICKS(interval - elapsed));
+  }
+  last_frame_ms = app_clock.uptime();
+}
@@ -0,0 +1,64 @@
+/*
+ * Power Governor for Stack-chan
+ * IdleGovernor の段階に合わせてバックライトの明るさと描画フレームレートを下げる
+ * ボタン・API操作で即座に通常段階へ戻す
+ */
+
+#ifndef POWER_GOVERNOR_H
+#define POWER_GOVERNOR_H
+
+#include <M5Unified.h>
+#include "idle_governor.h"
+
+// 無操作から減光・休止までの時間（build_flags で環境ごとに上書き可能、0 で無効）
+#ifndef POWER_DIM_AFTER_MS
+#define POWER_DIM_AFTER_MS   60000
+#endif
+#ifndef POWER_SLEEP_AFTER_MS
+#define POWER_SLEEP_AFTER_MS 600000
+#endif
+
+// 段階ごとの描画間隔（スクリーンショットの要求は interruptFrame() で待ちを切り上げさせる）
+#define POWER_DIM_FRAME_MS   100
+#define POWER_SLEEP_FRAME_MS 400
+
+#ifndef POWER_DIM_BRIGHTNESS
+#define POWER_DIM_BRIGHTNESS   48
+#endif
+#ifndef POWER_SLEEP_BRIGHTNESS
+#define POWER_SLEEP_BRIGHTNESS 8
+#endif
+
+class PowerGovernor {
+public:
+  PowerGovernor();
+
+  // 現在の明るさを通常段階の明るさとして使う（M5.begin() の後に呼ぶ）
+  void begin();
+
+  // loop側: 段階の判定と明るさの反映
+  void update();
+  // loop側: 操作があった（休止中でも次のフレームからすぐに元の速度で描く）
+  void wake();
+  // どのタスクからでも: 描画タスクの間隔の待ちだけを切り上げる（段階は変えない）
+  void interruptFrame();
+  // loop側: 閾値の変更（0 で無効）
+  void setTimeouts(uint32_t dim_after_ms, uint32_t sleep_after_ms);
+
+  // 描画タスク側: 毎フレーム呼ぶ（現在の段階の間隔になるまで待つ）
+  void paceFrame();
+
+  const IdleGovernor& getGovernor() const { return governor; }
+
+private:
+  IdleGovernor governor;
+  SemaphoreHandle_t wake_signal;
+  volatile uint16_t frame_interval_ms;
+  uint32_t last_frame_ms;
+
+  void apply();
+};
+
+extern PowerGovernor power_governor;
+
+#endif
@@ -0,0 +1,392 @@
+/*
+ * Screen Capture for Stack-chan
+ * 表示中の画面をパネルから横帯ごとに読み出し、BMP / PNG としてそのまま送り出す
+ */
+
+#include "screen_capture.h"
+#include <esp_rom_crc.h>
+
+ScreenCapture screen_capture;
+
+// 描画タスクの再開と HTTP 側の読み出し開始が入れ違わないようにする
+static portMUX_TYPE capture_lock = portMUX_INITIALIZER_UNLOCKED;
+
+#define BMP_HEADER_BYTES 66
+#define PNG_SIGNATURE_BYTES 8
+#define PNG_CHUNK_OVERHEAD 12      // 長さ + 種別 + CRC
+#define PNG_IHDR_BYTES 13
+#define ZLIB_HEADER_BYTES 2
+#define DEFLATE_STORED_HEADER 5
+#define DEFLATE_STORED_MAX 65535
+
+static void putLE16(uint8_t* p, uint16_t v) {
+  p[0] = v & 0xFF;
+  p[1] = v >> 8;
+}
+
+static void putLE32(uint8_t* p, uint32_t v) {
+  p[0] = v & 0xFF;
+  p[1] = (v >> 8) & 0xFF;
+  p[2] = (v >> 16) & 0xFF;
+  p[3] = v >> 24;
+}
+
+static void putBE32(uint8_t* p, uint32_t v) {
+  p[0] = v >> 24;
+  p[1] = (v >> 16) & 0xFF;
+  p[2] = (v >> 8) & 0xFF;
+  p[3] = v & 0xFF;
+}
+
+// === ImageStreamEncoder ===
+
+ImageStreamEncoder::ImageStreamEncoder() {
+  format = SCREENSHOT_BMP;
+  width = 0;
+  height = 0;
+  rows_written = 0;
+  writer = nullptr;
+  user = nullptr;
+  out = nullptr;
+  out_capacity = 0;
+  adler_a = 1;
+  adler_b = 0;
+}
+
+ImageStreamEncoder::~ImageStreamEncoder() {
+  end();
+}
+
+const char* ImageStreamEncoder::contentType(ScreenshotFormat f) {
+  return f == SCREENSHOT_PNG ? "image/png" : "image/bmp";
+}
+
+int ImageStreamEncoder::clampBandRows(ScreenshotFormat f, int w, int band_rows) {
+  if (band_rows < 1) band_rows = 1;
+  if (f == SCREENSHOT_PNG) {
+    int max_rows = DEFLATE_STORED_MAX / (1 + w * 3);
+    if (band_rows > max_rows) band_rows = max_rows;
+  }
+  return band_rows;
+}
+
+bool ImageStreamEncoder::supports(ScreenshotFormat f, int w, int h) {
+  if (w <= 0 || h <= 0) return false;
+  return f != SCREENSHOT_BMP || (w & 1) == 0;
+}
+
+size_t ImageStreamEncoder::encodedSize(ScreenshotFormat f, int w, int h, int band_rows) {
+  if (f == SCREENSHOT_BMP) {
+    return BMP_HEADER_BYTES + (size_t)w * h * 2;
+  }
+  band_rows = clampBandRows(f, w, band_rows);
+  int bands = (h + band_rows - 1) / band_rows;
+  size_t size = PNG_SIGNATURE_BYTES + PNG_CHUNK_OVERHEAD + PNG_IHDR_BYTES;
+  size += ZLIB_HEADER_BYTES;                                       // 最初の IDAT に含める
+  size += (size_t)bands * (PNG_CHUNK_OVERHEAD + DEFLATE_STORED_HEADER);
+  size += (size_t)h * (1 + w * 3);                                 // フィルタ種別 + RGB
+  size += PNG_CHUNK_OVERHEAD + 4;                                  // adler32 だけの IDAT
+  size += PNG_CHUNK_OVERHEAD;                                      // IEND
+  return size;
+}
+
+bool ImageStreamEncoder::begin(ScreenshotFormat f, int w, int h, int band_rows, CaptureWriter wr, void* u) {
+  end();
+  format = f;
+  width = w;
+  height = h;
+  rows_written = 0;
+  writer = wr;
+  user = u;
+  adler_a = 1;
+  adler_b = 0;
+
+  if (!supports(format, width, height)) return false;
+
+  if (format == SCREENSHOT_BMP) {
+    // BITMAPFILEHEADER(14) + BITMAPINFOHEADER(40) + RGB565 マスク(12)
+    // 高さを負にしてトップダウンにし、帯を上から順にそのまま書けるようにする
+    uint8_t header[BMP_HEADER_BYTES];
+    uint32_t image_bytes = (uint32_t)width * height * 2;
+    memset(header, 0, sizeof(header));
+    header[0] = 'B';
+    header[1] = 'M';
+    putLE32(header + 2, BMP_HEADER_BYTES + image_bytes);
+    putLE32(header + 10, BMP_HEADER_BYTES);
+    putLE32(header + 14, 40);
+    putLE32(header + 18, width);
+    putLE32(header + 22, (uint32_t)(-height));
+    putLE16(header + 26, 1);
+    putLE16(header + 28, 16);
+    putLE32(header + 30, 3);  // BI_BITFIELDS
+    putLE32(header + 34, image_bytes);
+    putLE32(header + 38, 2835);  // 72dpi
+    putLE32(header + 42, 2835);
+    putLE32(header + 54, 0xF800);
+    putLE32(header + 58, 0x07E0);
+    putLE32(header + 62, 0x001F);
+    return writer(header, sizeof(header), user);
+  }
+
+  // PNG: 1帯 = 1 IDAT チャンク = 1 無圧縮deflateブロック
+  band_rows = clampBandRows(format, width, band_rows);
+  out_capacity = ZLIB_HEADER_BYTES + DEFLATE_STORED_HEADER + (size_t)band_rows * (1 + width * 3);
+  out = static_cast<uint8_t*>(malloc(out_capacity));
+  if (!out) return false;
+
+  static const uint8_t signature[PNG_SIGNATURE_BYTES] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+  if (!writer(signature, sizeof(signature), user)) return false;
+
+  uint8_t ihdr[PNG_IHDR_BYTES];
+  putBE32(ihdr, width);
+  putBE32(ihdr + 4, height);
+  ihdr[8] = 8;   // 8bit
+  ihdr[9] = 2;   // RGB
+  ihdr[10] = 0;  // deflate
+  ihdr[11] = 0;  // 標準フィルタ
+  ihdr[12] = 0;  // インターレースなし
+  return writePngChunk("IHDR", ihdr, sizeof(ihdr));
+}
+
+void ImageStreamEncoder::adlerUpdate(const uint8_t* data, size_t bytes) {
+  // 5552 バイトごとに剰余を取れば32bitで溢れない（zlib の NMAX）
+  while (bytes > 0) {
+    size_t n = bytes < 5552 ? bytes : 5552;
+    bytes -= n;
+    while (n--) {
+      adler_a += *data++;
+      adler_b += adler_a;
+    }
+    adler_a %= 65521;
+    adler_b %= 65521;
+  }
+}
+
+bool ImageStreamEncoder::writePngChunk(const char* type, const uint8_t* data, size_t bytes) {
+  uint8_t head[8];
+  putBE32(head, bytes);
+  memcpy(head + 4, type, 4);
+  uint32_t crc = esp_rom_crc32_le(0, (const uint8_t*)type, 4);
+  if (bytes) crc = esp_rom_crc32_le(crc, data, bytes);
+  uint8_t tail[4];
+  putBE32(tail, crc);
+
+  if (!writer(head, sizeof(head), user)) return false;
+  if (bytes && !writer(data, bytes, user)) return false;
+  return writer(tail, sizeof(tail), user);
+}
+
+bool ImageStreamEncoder::writeBand(const uint16_t* rgb565, int rows) {
+  if (rows_written + rows > height) rows = height - rows_written;
+  if (rows <= 0) return true;
+
+  if (format == SCREENSHOT_BMP) {
+    // ESP32 はリトルエンディアンなので RGB565 の配列がそのまま BMP の画素列になる
+    rows_written += rows;
+    return writer((const uint8_t*)rgb565, (size_t)width * rows * 2, user);
+  }
+
+  size_t row_bytes = 1 + width * 3;
+  size_t payload = (size_t)rows * row_bytes;
+  uint8_t* p = out;
+  if (rows_written == 0) {
+    *p++ = 0x78;  // zlib ヘッダ（deflate, 32KB窓）
+    *p++ = 0x01;
+  }
+  bool last = (rows_written + rows >= height);
+  *p++ = last ? 1 : 0;  // BFINAL, BTYPE=00（無圧縮）
+  putLE16(p, payload);
+  putLE16(p + 2, ~payload & 0xFFFF);
+  p += 4;
+
+  uint8_t* rows_start = p;
+  for (int y = 0; y < rows; y++) {
+    *p++ = 0;  // フィルタなし
+    const uint16_t* src = rgb565 + (size_t)y * width;
+    for (int x = 0; x < width; x++) {
+      uint16_t c = src[x];
+      uint8_t r = c >> 11;
+      uint8_t g = (c >> 5) & 0x3F;
+      uint8_t b = c & 0x1F;
+      *p++ = (r << 3) | (r >> 2);
+      *p++ = (g << 2) | (g >> 4);
+      *p++ = (b << 3) | (b >> 2);
+    }
+  }
+  adlerUpdate(rows_start, payload);
+  rows_written += rows;
+  return writePngChunk("IDAT", out, p - out);
+}
+
+bool ImageStreamEncoder::finish() {
+  if (format == SCREENSHOT_BMP) return rows_written == height;
+
+  uint8_t adler[4];
+  putBE32(adler, (adler_b << 16) | adler_a);
+  if (!writePngChunk("IDAT", adler, sizeof(adler))) return false;
+  return writePngChunk("IEND", nullptr, 0);
+}
+
+void ImageStreamEncoder::end() {
+  free(out);
+  out = nullptr;
+  out_capacity = 0;
+}
+
+// === ScreenCapture ===
+
+ScreenCapture::ScreenCapture() {
+  parked = nullptr;
+  resume = nullptr;
+  requested = false;
+  last_checkpoint_ms = 0;
+  draw_wakeup = nullptr;
+  paused_at_us = 0;
+  paused_total_us = 0;
+  paused = false;
+  memset(&stats, 0, sizeof(stats));
+  park_state = PARK_NONE;
+}
+
+void ScreenCapture::begin() {
+  if (!parked) parked = xSemaphoreCreateBinary();
+  if (!resume) resume = xSemaphoreCreateBinary();
+}
+
+void ScreenCapture::setDrawWakeup(void (*wakeup)()) {
+  draw_wakeup = wakeup;
+}
+
+void ScreenCapture::drawCheckpoint() {
+  last_checkpoint_ms = millis();
+  if (!requested || !parked) return;
+
+  // ここではスプライトに描いている途中なので SPI は空いている
+  // 止まったことを HTTP 側が知る前に状態を決めておく（待ちきれずに再開したときと区別するため）
+  portENTER_CRITICAL(&capture_lock);
+  park_state = PARK_PARKED;
+  portEXIT_CRITICAL(&capture_lock);
+  xSemaphoreGive(parked);
+
+  while (xSemaphoreTake(resume, pdMS_TO_TICKS(SCREEN_CAPTURE_MAX_PAUSE_MS)) != pdTRUE) {
+    // 読み出し中の帯があれば読み終えるまで待つ。そうでなければ以降の読み出しを中断させて再開する
+    portENTER_CRITICAL(&capture_lock);
+    bool reading = park_state == PARK_READING;
+    if (!reading) park_state = PARK_ABANDONED;
+    portEXIT_CRITICAL(&capture_lock);
+    if (!reading) {
+      requested = false;
+      stats.abandoned++;
+      return;
+    }
+  }
+}
+
+bool ScreenCapture::beginRead() {
+  if (!paused) return true;  // 描画タスクが動いていない
+  portENTER_CRITICAL(&capture_lock);
+  bool ok = park_state == PARK_PARKED;
+  if (ok) park_state = PARK_READING;
+  portEXIT_CRITICAL(&capture_lock);
+  return ok;
+}
+
+void ScreenCapture::endRead() {
+  if (!paused) return;
+  portENTER_CRITICAL(&capture_lock);
+  if (park_state == PARK_READING) park_state = PARK_PARKED;
+  portEXIT_CRITICAL(&capture_lock);
+}
+
+bool ScreenCapture::pauseDrawing() {
+  if (!parked) return false;
+
+  // 描画タスクが動いていない（Avatar初期化失敗など）ならそのまま読める
+  if (millis() - last_checkpoint_ms > SCREEN_CAPTURE_STOPPED_MS) {
+    paused = false;
+    return true;
+  }
+
+  // 前回タイムアウトした分の残りを捨てる
+  xSemaphoreTake(parked, 0);
+  xSemaphoreTake(resume, 0);
+
+  requested = true;
+  // 休止中の描画間隔（400ms）は待ち合わせの上限より長いので、間隔の待ちを切り上げさせる
+  if (draw_wakeup) draw_wakeup();
+  if (xSemaphoreTake(parked, pdMS_TO_TICKS(SCREEN_CAPTURE_PARK_TIMEOUT_MS)) != pdTRUE) {
+    requested = false;
+    return false;
+  }
+  paused = true;
+  paused_at_us = micros();
+  return true;
+}
+
+void ScreenCapture::resumeDrawing() {
+  requested = false;
+  if (!paused) return;
+  paused = false;
+  paused_total_us += micros() - paused_at_us;
+  portENTER_CRITICAL(&capture_lock);
+  park_state = PARK_NONE;
+  portEXIT_CRITICAL(&capture_lock);
+  xSemaphoreGive(resume);
+}
+
+bool ScreenCapture::capturePanel(LovyanGFX* panel, ScreenshotFormat format, bool hold,
+                                 CaptureWriter writer, void* user) {
+  uint32_t start = micros();
+  uint32_t read_us = 0;
+  paused_total_us = 0;
+
+  int w = panel->width();
+  int h = panel->height();
+  int band_rows = ImageStreamEncoder::clampBandRows(format, w, SCREEN_CAPTURE_BAND_ROWS);
+
+  // 読み出し用の帯バッファだけを確保する（フレーム全体は持たない）
+  lgfx::rgb565_t* band = static_cast<lgfx::rgb565_t*>(malloc((size_t)w * band_rows * sizeof(lgfx::rgb565_t)));
+  ImageStreamEncoder encoder;
+  bool ok = band && encoder.begin(format, w, h, band_rows, writer, user);
+
+  if (ok && hold) ok = pauseDrawing();
+  for (int y = 0; ok && y < h; y += band_rows) {
+    int rows = h - y < band_rows ? h - y : band_rows;
+    if (!hold && !pauseDrawing()) {
+      ok = false;
+      break;
+    }
+    // 描画タスクが待ちきれずに再開していたら SPI を取り合うので読まずに中断する
+    if (!beginRead()) {
+      ok = false;
+      break;
+    }
+    uint32_t t = micros();
+    panel->readRect(0, y, w, rows, band);
+    read_us += micros() - t;
+    endRead();
+    // 帯ごとに止める場合は送信中は描画を続けさせる
+    if (!hold) resumeDrawing();
+    ok = encoder.writeBand((const uint16_t*)band, rows);
+  }
+  if (hold) resumeDrawing();
+  if (ok) ok = encoder.finish();
+
+  encoder.end();
+  free(band);
+
+  stats.last_paused_us = paused_total_us;
+  recordCapture(ok, micros() - start, read_us, ImageStreamEncoder::encodedSize(format, w, h, band_rows));
+  return ok;
+}
+
+void ScreenCapture::recordCapture(bool ok, uint32_t total_us, uint32_t read_us, uint32_t bytes) {
+  if (!ok) {
+    stats.failures++;
+    return;
+  }
+  stats.captures++;
+  stats.last_total_us = total_us;
+  stats.last_read_us = read_us;
+  stats.last_bytes = bytes;
+}
@@ -0,0 +1,128 @@
+/*
+ * Screen Capture for Stack-chan
+ * 表示中の画面をパネルから横帯ごとに読み出し、BMP / PNG としてそのまま送り出す
+ * フレーム全体のバッファは持たない（PSRAM非搭載機でも使える）
+ */
+
+#ifndef SCREEN_CAPTURE_H
+#define SCREEN_CAPTURE_H
+
+#include <M5Unified.h>
+
+// 1回に読み出す行数（320px幅で RGB565 10KB + PNG出力 15KB）
+#ifndef SCREEN_CAPTURE_BAND_ROWS
+#define SCREEN_CAPTURE_BAND_ROWS 16
+#endif
+
+// 描画タスクを止めておける上限（HTTP側が戻ってこなくても描画は再開する）
+// 超えたときに読み出し中の帯があれば、その帯を読み終えるまで待ってから再開し、以降の読み出しは中断させる
+#define SCREEN_CAPTURE_MAX_PAUSE_MS 2000
+#define SCREEN_CAPTURE_PARK_TIMEOUT_MS 200
+// 最後の drawCheckpoint() からこれ以上経っていたら描画タスクは動いていないとみなす（休止中の描画間隔より長く）
+#define SCREEN_CAPTURE_STOPPED_MS 1000
+
+enum ScreenshotFormat {
+  SCREENSHOT_BMP,
+  SCREENSHOT_PNG
+};
+
+// 出力先（false を返すと中断）
+typedef bool (*CaptureWriter)(const uint8_t* data, size_t bytes, void* user);
+
+// RGB565 の行を帯単位で受け取り、BMP（16bit）または PNG（8bit RGB、無圧縮deflate）に符号化する
+class ImageStreamEncoder {
+public:
+  ImageStreamEncoder();
+  ~ImageStreamEncoder();
+
+  // band_rows ごとに writeBand() を呼ぶ（最後の帯だけ少なくてよい）
+  bool begin(ScreenshotFormat format, int width, int height, int band_rows, CaptureWriter writer, void* user);
+  bool writeBand(const uint16_t* rgb565, int rows);
+  bool finish();
+  void end();
+
+  // この形式で符号化できる寸法か（BMP は行を4バイト境界に揃えるため幅は偶数のみ）
+  // ヘッダを送る前に確かめる
+  static bool supports(ScreenshotFormat format, int width, int height);
+  // Content-Length 用の出力サイズ
+  static size_t encodedSize(ScreenshotFormat format, int width, int height, int band_rows);
+  // PNG の1ブロック（65535バイト）に収まる帯の行数に丸める
+  static int clampBandRows(ScreenshotFormat format, int width, int band_rows);
+  static const char* contentType(ScreenshotFormat format);
+
+private:
+  ScreenshotFormat format;
+  int width;
+  int height;
+  int rows_written;
+  CaptureWriter writer;
+  void* user;
+  uint8_t* out;          // PNG の IDAT チャンク組み立て用
+  size_t out_capacity;
+  uint32_t adler_a;
+  uint32_t adler_b;
+
+  bool writePngChunk(const char* type, const uint8_t* data, size_t bytes);
+  void adlerUpdate(const uint8_t* data, size_t bytes);
+};
+
+struct ScreenCaptureStats {
+  uint32_t captures;
+  uint32_t failures;
+  uint32_t last_total_us;   // リクエスト全体（送信含む）
+  uint32_t last_read_us;    // パネル読み出しのみ
+  uint32_t last_paused_us;  // 描画タスクを止めていた時間
+  uint32_t last_bytes;
+  uint32_t abandoned;       // 描画タスクが待ちきれずに再開し、読み出しを中断させた回数
+};
+
+class ScreenCapture {
+public:
+  ScreenCapture();
+  void begin();
+
+  // 描画タスクがフレームの間隔を空けて待っているときに起こす関数（要求を出すたびに HTTP 側から呼ぶ）
+  void setDrawWakeup(void (*wakeup)());
+
+  // 描画タスク側: SPIを使っていない位置で毎フレーム呼ぶ（要求があれば読み出しが終わるまで待つ）
+  void drawCheckpoint();
+
+  // HTTP側: 描画タスクを止めて SPI を空ける（描画タスクが動いていなければ即 true）
+  bool pauseDrawing();
+  void resumeDrawing();
+
+  // パネルを帯ごとに読み出して writer へ流す。hold=true なら全帯を同じフレームから読む
+  bool capturePanel(LovyanGFX* panel, ScreenshotFormat format, bool hold, CaptureWriter writer, void* user);
+
+  // capturePanel 以外（オフスクリーン描画など）で取った結果を記録する
+  void recordCapture(bool ok, uint32_t total_us, uint32_t read_us, uint32_t bytes);
+
+  ScreenCaptureStats getStats() const { return stats; }
+
+private:
+  enum ParkState : uint8_t {
+    PARK_NONE = 0,   // 描画タスクは止まっていない
+    PARK_PARKED,     // drawCheckpoint() で止まっている（読み出してよい）
+    PARK_READING,    // HTTP 側がパネルを読み出している（描画タスクは再開しない）
+    PARK_ABANDONED   // 描画タスクが待ちきれずに再開した（読み出しは中断する）
+  };
+
+  SemaphoreHandle_t parked;
+  SemaphoreHandle_t resume;
+  volatile uint8_t park_state;  // ParkState（capture_lock で更新）
+  volatile bool requested;
+  void (*draw_wakeup)();
+  volatile unsigned long last_checkpoint_ms;
+  uint32_t paused_at_us;
+  uint32_t paused_total_us;
+  bool paused;
+  ScreenCaptureStats stats;
+
+  // 1帯の読み出しの前後で呼ぶ。描画タスクが既に再開していたら false（読んではいけない）
+  bool beginRead();
+  void endRead();
+};
+
+extern ScreenCapture screen_capture;
+
+#endif
@@ -0,0 +1,71 @@
+/*
+ * Seqlock for Stack-chan
+ * 書き込み1つ・読み出しいくつでも の版数付き共有データ
+ * 書き込み側は版数を奇数にしてから中身を書き、偶数に戻す（読み出し側を待たない）
+ * 読み出し側は書き込みと重ならなかった版だけを受け取り、重なったら読み直す（ロックを取らない）
+ * 中身は 32bit の atomic の並びとして読み書きするので、重なった読み出しもデータ競合にならない
+ * Arduino に依存しないので、ホスト上でも複数スレッドでそのまま動かせる
+ */
+
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <atomic>
+#include <stdint.h>
+#include <string.h>
+
+// T はポインタを持たない構造体（サイズは 4 の倍数）
+template <typename T>
+class Seqlock {
+  static_assert(sizeof(T) % 4 == 0, "Seqlock payload size must be a multiple of 4");
+
+public:
+  Seqlock() : seq(0) {
+    for (uint32_t i = 0; i < WORDS; i++) words[i].store(0, std::memory_order_relaxed);
+  }
+
+  // === 書き込み側（1タスクだけ） ===
+  void write(const T& value) {
+    const uint8_t* src = reinterpret_cast<const uint8_t*>(&value);
+    uint32_t s = seq.load(std::memory_order_relaxed);
+    seq.store(s + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (uint32_t i = 0; i < WORDS; i++) {
+      uint32_t w;
+      memcpy(&w, src + i * 4, 4);
+      words[i].store(w, std::memory_order_relaxed);
+    }
+    seq.store(s + 2, std::memory_order_release);
+  }
+
+  // === 読み出し側（どのタスクからも） ===
+  // 書き込みと重ならずに読めたら true（false のとき out は壊れている）
+  bool tryRead(T& out) const {
+    uint32_t s = seq.load(std::memory_order_acquire);
+    if (s & 1) return false;
+    uint8_t* dst = reinterpret_cast<uint8_t*>(&out);
+    for (uint32_t i = 0; i < WORDS; i++) {
+      uint32_t w = words[i].load(std::memory_order_relaxed);
+      memcpy(dst + i * 4, &w, 4);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return seq.load(std::memory_order_relaxed) == s;
+  }
+
+  // 読めるまで繰り返す。読み直した回数を返す
+  uint32_t read(T& out) const {
+    uint32_t retries = 0;
+    while (!tryRead(out)) retries++;
+    return retries;
+  }
+
+  // 書き込みの回数 × 2（奇数なら書き込み中）
+  uint32_t sequence() const { return seq.load(std::memory_order_acquire); }
+
+private:
+  static const uint32_t WORDS = sizeof(T) / 4;
+  std::atomic<uint32_t> seq;
+  std::atomic<uint32_t> words[WORDS];
+};
+
+#endif
@@ -0,0 +1,198 @@
+/*
+ * Sleep Manager for Stack-chan
+ * 電源管理ロックの出し入れ・ボタンのレベル起床の切り替え・スリープ時間と起床遅延の計測
+ * arduino-esp32 の配布ライブラリは tickless idle なしでビルドされていることがあり、その場合は dfs で動く
+ */
+
+#include "sleep_manager.h"
+#include "button_input.h"
+#include <esp_freertos_hooks.h>
+#include <esp_sleep.h>
+#include <esp_timer.h>
+#include <string.h>
+
+SleepManager sleep_manager;
+
+// アイドルフック（CPU0 のアイドルタスク）が書き、loop() が読む
+static portMUX_TYPE sleep_mux = portMUX_INITIALIZER_UNLOCKED;
+static volatile bool hook_counting = false;  // ロックを放している間だけ数える
+static int64_t hook_last_us = 0;
+static uint32_t hook_sleeps = 0;
+static uint64_t hook_asleep_us = 0;
+
+SleepManager::SleepManager() {
+  mode = MODE_UNSUPPORTED;
+  mode_reason = "no_pm";
+  enabled = false;
+  no_sleep_lock = nullptr;
+  cpu_max_lock = nullptr;
+  released = false;
+  wait_deadline_us = 0;
+  released_at_us = 0;
+  begin_us = 0;
+  allowed_total_us = 0;
+  memset(&wake, 0, sizeof(wake));
+  memset(&awake, 0, sizeof(awake));
+  memset(&timer_late, 0, sizeof(timer_late));
+  memset(&awake_timer_late, 0, sizeof(awake_timer_late));
+  wake_total_us = 0;
+  awake_total_us = 0;
+  timer_late_total_us = 0;
+  awake_timer_late_total_us = 0;
+}
+
+// tickless idle で眠ると、起きるまでアイドルフックが呼ばれない（tick が止まる）
+// 呼び出しの間隔が tick 数回分より長ければ、その間は眠っていたとみなす
+// （CCOUNT は眠った後に IDF が補正するので使えない）
+bool SleepManager::idleHook() {
+  int64_t now = esp_timer_get_time();
+  portENTER_CRITICAL(&sleep_mux);
+  int64_t gap = now - hook_last_us;
+  hook_last_us = now;
+  if (hook_counting && gap > SLEEP_GAP_US) {
+    hook_sleeps++;
+    hook_asleep_us += gap;
+  }
+  portEXIT_CRITICAL(&sleep_mux);
+  return true;
+}
+
+void SleepManager::begin() {
+  begin_us = esp_timer_get_time();
+
+  SleepPolicyConfig config;
+  config.settle_ms = SLEEP_SETTLE_MS;
+  config.min_level = POWER_DIM;
+  policy.configure(config);
+
+  m5::board_t board = M5.getBoard();
+  bool battery_board = board == m5::board_t::board_M5StickC || board == m5::board_t::board_M5StickCPlus ||
+                       board == m5::board_t::board_M5StackCore2;
+  bool want = SLEEP_IDLE_MODE > 0 || (SLEEP_IDLE_MODE < 0 && battery_board);
+
+  // ロックを取ってから電源管理を有効にする（以降も loop() が動いている間は全速・スリープ禁止）
+  if (esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "loop_busy", &no_sleep_lock) != ESP_OK ||
+      esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "loop_cpu", &cpu_max_lock) != ESP_OK) {
+    Serial.println("SleepManager: 電源管理に未対応のビルド（CONFIG_PM_ENABLE）");
+    return;
+  }
+  esp_pm_lock_acquire(no_sleep_lock);
+  esp_pm_lock_acquire(cpu_max_lock);
+
+#if CONFIG_IDF_TARGET_ESP32S3
+  esp_pm_config_esp32s3_t pm;
+#else
+  esp_pm_config_esp32_t pm;
+#endif
+  pm.max_freq_mhz = ESP.getCpuFreqMHz();
+  pm.min_freq_mhz = SLEEP_MIN_CPU_MHZ;
+#if CONFIG_FREERTOS_USE_TICKLESS_IDLE
+  pm.light_sleep_enable = true;
+  if (esp_pm_configure(&pm) == ESP_OK) {
+    mode = MODE_LIGHT_SLEEP;
+    mode_reason = "";
+  } else {
+    mode_reason = "light_sleep_rejected";
+  }
+#else
+  mode_reason = "no_tickless_idle";
+#endif
+  if (mode != MODE_LIGHT_SLEEP) {
+    // tickless idle なしのビルドでは周波数を下げるだけにする
+    pm.light_sleep_enable = false;
+    mode = esp_pm_configure(&pm) == ESP_OK ? MODE_DFS : MODE_UNSUPPORTED;
+  }
+
+  if (mode == MODE_LIGHT_SLEEP) {
+    esp_sleep_enable_gpio_wakeup();
+    esp_register_freertos_idle_hook_for_cpu(idleHook, 0);
+  }
+  enabled = want && mode != MODE_UNSUPPORTED;
+  Serial.printf("SleepManager: %s%s%s（%s、待機中 %d-%dMHz）\n", getStats().mode, *mode_reason ? " / " : "",
+                mode_reason, enabled ? "有効" : "無効", SLEEP_MIN_CPU_MHZ, pm.max_freq_mhz);
+}
+
+void SleepManager::setEnabled(bool enabled) {
+  this->enabled = enabled && mode != MODE_UNSUPPORTED;
+}
+
+void SleepManager::acquire() {
+  esp_pm_lock_acquire(no_sleep_lock);
+  esp_pm_lock_acquire(cpu_max_lock);
+  portENTER_CRITICAL(&sleep_mux);
+  hook_counting = false;
+  portEXIT_CRITICAL(&sleep_mux);
+  allowed_total_us += esp_timer_get_time() - released_at_us;
+  released = false;
+}
+
+void SleepManager::release() {
+  released = true;
+  released_at_us = esp_timer_get_time();
+  portENTER_CRITICAL(&sleep_mux);
+  hook_counting = mode == MODE_LIGHT_SLEEP;
+  hook_last_us = released_at_us;
+  portEXIT_CRITICAL(&sleep_mux);
+  esp_pm_lock_release(cpu_max_lock);
+  esp_pm_lock_release(no_sleep_lock);
+}
+
+void SleepManager::beforeWait(SleepInputs inputs, uint32_t timeout_ms) {
+  inputs.enabled = enabled;
+  bool allow = policy.decide(inputs, millis()) == SLEEP_ALLOWED;
+  wait_deadline_us = esp_timer_get_time() + (int64_t)timeout_ms * 1000;
+  // 待機に入る前の通知は起床遅延に数えない（すぐに抜ける）
+  loop_events.takeNotifyTime();
+
+  // 眠っている間はボタンの変化（エッジ）を検知できないので、押されている（レベル）で起こす
+  button_input.setSleepWake(allow && mode == MODE_LIGHT_SLEEP);
+  if (allow) release();
+}
+
+void SleepManager::afterWait(EventBits_t bits) {
+  bool was_released = released;
+  if (released) acquire();
+
+  int64_t now = esp_timer_get_time();
+  uint32_t notified = loop_events.takeNotifyTime();
+  if (bits != 0 && notified) {
+    // 通知（ボタン・HTTP接続・BLE）から loop() が動き出すまで（眠っていればスリープからの復帰を含む）
+    uint32_t latency = (uint32_t)now - notified;
+    if ((int32_t)latency < 0) latency = 0;
+    if (was_released) {
+      LoopEvents::recordLatency(wake, wake_total_us, latency);
+    } else {
+      LoopEvents::recordLatency(awake, awake_total_us, latency);
+    }
+  } else if (bits == 0 && wait_deadline_us) {
+    // タイムアウトで起きたときは、期限からどれだけ遅れたか
+    int64_t late = now - wait_deadline_us;
+    if (late < 0) late = 0;
+    if (was_released) {
+      LoopEvents::recordLatency(timer_late, timer_late_total_us, (uint32_t)late);
+    } else {
+      LoopEvents::recordLatency(awake_timer_late, awake_timer_late_total_us, (uint32_t)late);
+    }
+  }
+  wait_deadline_us = 0;
+}
+
+SleepStats SleepManager::getStats() const {
+  SleepStats s;
+  s.mode = mode == MODE_LIGHT_SLEEP ? "light_sleep" : mode == MODE_DFS ? "dfs" : "unsupported";
+  s.mode_reason = mode_reason;
+  s.enabled = enabled;
+  portENTER_CRITICAL(&sleep_mux);
+  s.sleeps = hook_sleeps;
+  s.asleep_us = hook_asleep_us;
+  portEXIT_CRITICAL(&sleep_mux);
+  int64_t now = esp_timer_get_time();
+  s.allowed_us = allowed_total_us + (released ? now - released_at_us : 0);
+  s.elapsed_us = begin_us ? now - begin_us : 0;
+  s.wake = wake;
+  s.awake = awake;
+  s.timer_late = timer_late;
+  s.awake_timer_late = awake_timer_late;
+  s.last_decision = policy.lastDecision();
+  return s;
+}
@@ -0,0 +1,94 @@
+/*
+ * Sleep Manager for Stack-chan
+ * 減光・休止中に loop() が待機するあいだ、ESP-IDF の電源管理で自動ライトスリープ（tickless idle）に入れる
+ * loop() が動いている間と SleepPolicy が許さない待機の間は電源管理ロックで全速・スリープ禁止にする
+ * WiFi はモデムスリープのまま接続を保ち、BLE はコントローラが自分で起きる
+ * 起きる要因: ボタン（GPIO のレベル起床）・タイマー（次の期限）・無線
+ * 眠っていた時間はアイドルフックの呼び出し間隔から推定する
+ * 起床遅延は、通知で起きたときは通知から loop() が動き出すまで、タイムアウトで起きたときは期限からの遅れを分けて測る
+ * 自動ライトスリープには CONFIG_PM_ENABLE と CONFIG_FREERTOS_USE_TICKLESS_IDLE のビルドが要る
+ * （どちらかがなければ周波数を下げるだけ、または何もしない。どのモードで動いたかと理由は getStats() で返す）
+ */
+
+#ifndef SLEEP_MANAGER_H
+#define SLEEP_MANAGER_H
+
+#include <Arduino.h>
+#include <esp_pm.h>
+#include "loop_events.h"
+#include "sleep_policy.h"
+
+// -1: 電池で動く機種（StickC / StickC Plus / Core2）だけ有効、0: 無効、1: 有効
+// バックライトを LEDC で点けている機種はスリープ中に PWM が止まるので既定では使わない
+#ifndef SLEEP_IDLE_MODE
+#define SLEEP_IDLE_MODE -1
+#endif
+
+#define SLEEP_SETTLE_MS   200   // 最後の作業から眠るまで
+#define SLEEP_MIN_CPU_MHZ 80    // 眠れないときも待機中はこの周波数まで下げる
+#define SLEEP_GAP_US      3000  // アイドルフックの間隔がこれより長ければ眠っていたとみなす（tick 3回分）
+
+struct SleepStats {
+  const char* mode;             // "light_sleep" / "dfs" / "unsupported"
+  const char* mode_reason;      // light_sleep でない理由（"no_pm" / "no_tickless_idle" / "light_sleep_rejected"、light_sleep なら ""）
+  bool enabled;
+  uint32_t sleeps;              // 推定したスリープの回数
+  uint64_t asleep_us;           // 推定したスリープの合計
+  uint64_t allowed_us;          // 眠ってよい待機の合計
+  uint64_t elapsed_us;          // begin() から
+  LoopLatency wake;             // 眠ってよい待機を通知で抜けたとき: 通知から loop() が動き出すまで
+  LoopLatency awake;            // 比較用: 眠れない待機での同じ遅延
+  LoopLatency timer_late;       // 眠ってよい待機をタイムアウトで抜けたとき: 期限からの遅れ
+  LoopLatency awake_timer_late; // 比較用: 眠れない待機での同じ遅れ
+  SleepBlocker last_decision;
+};
+
+class SleepManager {
+public:
+  SleepManager();
+
+  // 電源管理を設定してロックを取る（setup() の最後、loop() と同じタスクから）
+  void begin();
+
+  // 実行時の切り替え（電源管理に対応していなければ何もしない）
+  void setEnabled(bool enabled);
+  bool isEnabled() const { return enabled; }
+
+  // loop() の待機の前後に呼ぶ（inputs.enabled はこちらで埋める）
+  void beforeWait(SleepInputs inputs, uint32_t timeout_ms);
+  void afterWait(EventBits_t bits);
+
+  SleepStats getStats() const;
+  const SleepPolicy& getPolicy() const { return policy; }
+
+private:
+  enum Mode { MODE_UNSUPPORTED, MODE_DFS, MODE_LIGHT_SLEEP };
+
+  SleepPolicy policy;
+  Mode mode;
+  const char* mode_reason;
+  bool enabled;
+  esp_pm_lock_handle_t no_sleep_lock;
+  esp_pm_lock_handle_t cpu_max_lock;
+  bool released;               // ロックを放して待機中
+  int64_t wait_deadline_us;
+  int64_t released_at_us;
+  int64_t begin_us;
+  uint64_t allowed_total_us;
+  LoopLatency wake;
+  LoopLatency awake;
+  LoopLatency timer_late;
+  LoopLatency awake_timer_late;
+  uint64_t wake_total_us;
+  uint64_t awake_total_us;
+  uint64_t timer_late_total_us;
+  uint64_t awake_timer_late_total_us;
+
+  void acquire();
+  void release();
+  static bool idleHook();
+};
+
+extern SleepManager sleep_manager;
+
+#endif
@@ -0,0 +1,51 @@
+/*
+ * Sleep Policy for Stack-chan
+ * 待機中の自動ライトスリープを許すかの判定
+ */
+
+#include "sleep_policy.h"
+#include <string.h>
+
+SleepPolicy::SleepPolicy() {
+  config.settle_ms = 0;
+  config.min_level = POWER_DIM;
+  last_busy_ms = 0;
+  busy_seen = false;
+  last = SLEEP_BLOCK_DISABLED;
+  memset(counts, 0, sizeof(counts));
+}
+
+SleepBlocker SleepPolicy::busyReason(const SleepInputs& inputs) const {
+  if (!inputs.enabled) return SLEEP_BLOCK_DISABLED;
+  if (inputs.power_level < config.min_level) return SLEEP_BLOCK_RENDERING;
+  if (inputs.buttons_active) return SLEEP_BLOCK_INPUT;
+  if (inputs.network_active) return SLEEP_BLOCK_NETWORK;
+  if (inputs.fading) return SLEEP_BLOCK_FADE;
+  return SLEEP_ALLOWED;
+}
+
+SleepBlocker SleepPolicy::decide(const SleepInputs& inputs, uint32_t now_ms) {
+  SleepBlocker result = busyReason(inputs);
+  if (result != SLEEP_ALLOWED) {
+    last_busy_ms = now_ms;
+    busy_seen = true;
+  } else if (busy_seen && now_ms - last_busy_ms < config.settle_ms) {
+    result = SLEEP_BLOCK_SETTLE;
+  }
+  last = result;
+  counts[result]++;
+  return result;
+}
+
+const char* SleepPolicy::blockerName(SleepBlocker blocker) {
+  switch (blocker) {
+    case SLEEP_ALLOWED:         return "allowed";
+    case SLEEP_BLOCK_DISABLED:  return "disabled";
+    case SLEEP_BLOCK_RENDERING: return "rendering";
+    case SLEEP_BLOCK_INPUT:     return "input";
+    case SLEEP_BLOCK_NETWORK:   return "network";
+    case SLEEP_BLOCK_FADE:      return "fade";
+    case SLEEP_BLOCK_SETTLE:    return "settle";
+    default:                    return "unknown";
+  }
+}
@@ -0,0 +1,63 @@
+/*
+ * Sleep Policy for Stack-chan
+ * loop() が待機に入るときに、その間の自動ライトスリープを許すかを決める
+ * 全速で描画中・ボタン操作中・HTTP応答中・フェード中、および作業の直後は許さない
+ * 時刻は呼び出し側が渡す（Arduino に依存しないので、ホスト上でも疑似時計で同じコードを動かせる）
+ */
+
+#ifndef SLEEP_POLICY_H
+#define SLEEP_POLICY_H
+
+#include <stdint.h>
+#include "idle_governor.h"
+
+enum SleepBlocker {
+  SLEEP_ALLOWED = 0,
+  SLEEP_BLOCK_DISABLED,   // 無効（設定・非対応）
+  SLEEP_BLOCK_RENDERING,  // 描画の段階が min_level より上（全速で描画中）
+  SLEEP_BLOCK_INPUT,      // ボタンが押されている・確定待ち
+  SLEEP_BLOCK_NETWORK,    // HTTP クライアントの受信・応答中
+  SLEEP_BLOCK_FADE,       // パレットのフェード中
+  SLEEP_BLOCK_SETTLE,     // 最後の作業から settle_ms 経っていない
+  SLEEP_BLOCKER_COUNT
+};
+
+struct SleepInputs {
+  bool enabled;
+  PowerLevel power_level;
+  bool buttons_active;
+  bool network_active;
+  bool fading;
+};
+
+struct SleepPolicyConfig {
+  uint32_t settle_ms;    // 作業が終わってから眠るまでの猶予（続けて来る通信・操作をまとめる）
+  PowerLevel min_level;  // この段階以下（減光・休止）で眠ってよい
+};
+
+class SleepPolicy {
+public:
+  SleepPolicy();
+
+  void configure(const SleepPolicyConfig& config) { this->config = config; }
+  const SleepPolicyConfig& getConfig() const { return config; }
+
+  // 待機に入る時点の状態から判定する（SLEEP_ALLOWED 以外は眠れない理由）
+  SleepBlocker decide(const SleepInputs& inputs, uint32_t now_ms);
+
+  SleepBlocker lastDecision() const { return last; }
+  uint32_t decisions(SleepBlocker blocker) const { return counts[blocker]; }
+
+  static const char* blockerName(SleepBlocker blocker);
+
+private:
+  SleepPolicyConfig config;
+  uint32_t last_busy_ms;
+  bool busy_seen;
+  SleepBlocker last;
+  uint32_t counts[SLEEP_BLOCKER_COUNT];
+
+  SleepBlocker busyReason(const SleepInputs& inputs) const;
+};
+
+#endif
@@ -0,0 +1,152 @@
+/*
+ * Speech Balloon for Stack-chan
+ * Avatar標準の吹き出しの代わりに、グリフキャッシュを使ってセリフを描画する
+ */
+
+#include "speech_balloon.h"
+#include "trace_recorder.h"
+
+SpeechBalloon speech_balloon;
+
+SpeechBalloon::SpeechBalloon() {
+  mutex = nullptr;
+  font = nullptr;
+  pending_text[0] = '\0';
+  pending_revision = 0;
+  marquee_enabled = SPEECH_MARQUEE_ENABLED;
+  text[0] = '\0';
+  text_revision = 0;
+  text_hash = 0;
+  cache_enabled = false;
+  memset(&layout, 0, sizeof(layout));
+  scroll_step = 0;
+  scroll_changed_at = 0;
+  layout_count = 0;
+}
+
+void SpeechBalloon::begin(const lgfx::IFont* f, int glyph_slots) {
+  font = f;
+  if (!mutex) {
+    mutex = xSemaphoreCreateMutex();
+  }
+  glyph_cache.begin(font, glyph_slots);
+  marquee.begin(&glyph_cache, SPEECH_BALLOON_WIDTH - SPEECH_BALLOON_PADDING * 2);
+}
+
+void SpeechBalloon::enableCache(size_t budget) {
+  balloon_cache.begin(budget);
+  cache_enabled = true;
+}
+
+void SpeechBalloon::end() {
+  cache_enabled = false;
+  balloon_cache.end();
+  marquee.end();
+  glyph_cache.end();
+  if (mutex) {
+    vSemaphoreDelete(mutex);
+    mutex = nullptr;
+  }
+  font = nullptr;
+}
+
+void SpeechBalloon::setText(const char* new_text) {
+  if (!mutex) return;
+  xSemaphoreTake(mutex, portMAX_DELAY);
+  strncpy(pending_text, new_text ? new_text : "", sizeof(pending_text) - 1);
+  pending_text[sizeof(pending_text) - 1] = '\0';
+  pending_revision++;
+  xSemaphoreGive(mutex);
+  TRACE_INSTANT(TRACE_SPEECH_SET, 0);
+}
+
+void SpeechBalloon::setMarquee(bool enabled) {
+  if (!mutex) return;
+  xSemaphoreTake(mutex, portMAX_DELAY);
+  marquee_enabled = enabled;
+  pending_revision++;  // 表示方法が変わるのでレイアウトし直す
+  xSemaphoreGive(mutex);
+}
+
+// 新しいセリフが来たときだけ折り返し位置を計算し直す
+void SpeechBalloon::updateLayout() {
+  xSemaphoreTake(mutex, portMAX_DELAY);
+  bool changed = (pending_revision != text_revision);
+  if (changed) {
+    memcpy(text, pending_text, sizeof(text));
+    text_revision = pending_revision;
+  }
+  xSemaphoreGive(mutex);
+
+  if (!changed) return;
+
+  int inner_w = SPEECH_BALLOON_WIDTH - SPEECH_BALLOON_PADDING * 2;
+  layoutSpeech(text, inner_w, SPEECH_VISIBLE_LINES, glyph_cache, layout);
+  text_hash = balloonTextHash(text);
+  // 表示行数に収まらない場合だけマーキーにする
+  if (marquee_enabled && layout.scroll_steps > 1) {
+    marquee.setText(text, strlen(text));
+  } else {
+    marquee.setText(nullptr, 0);
+  }
+  scroll_step = 0;
+  scroll_changed_at = millis();
+  layout_count++;
+}
+
+void SpeechBalloon::draw(M5Canvas* canvas, const BalloonStyle& style, int offset_y) {
+  if (!mutex || !font) return;
+
+  updateLayout();
+  if (layout.line_count == 0) return;
+
+  // 表示行数を超える場合は計算済みのスクロール位置を順に使う
+  if (layout.scroll_steps > 1 && millis() - scroll_changed_at > SPEECH_SCROLL_INTERVAL) {
+    scroll_step = (scroll_step + 1) % layout.scroll_steps;
+    scroll_changed_at = millis();
+  }
+
+  const int x = SPEECH_BALLOON_X;
+  const int y = SPEECH_BALLOON_Y - offset_y;
+  const int w = SPEECH_BALLOON_WIDTH;
+  const int h = SPEECH_BALLOON_HEIGHT;
+  const int pad = SPEECH_BALLOON_PADDING;
+
+  if (marquee.isActive()) {
+    canvas->fillRoundRect(x, y, w, h, SPEECH_BALLOON_RADIUS, style.background);
+    canvas->drawRoundRect(x, y, w, h, SPEECH_BALLOON_RADIUS, style.foreground);
+    marquee.draw(canvas, x + pad, y + (h - marquee.getHeight()) / 2, style.foreground, style.background);
+    return;
+  }
+
+  // 同じセリフ・配色・スクロール位置なら描画済みの画像をコピーするだけ
+  BalloonCacheKey key;
+  key.text_hash = text_hash;
+  key.foreground = style.foreground;
+  key.background = style.background;
+  key.backdrop = style.backdrop;
+  key.scroll_step = scroll_step;
+  key.color_depth = canvas->getColorDepth() & 0xFF;
+  bool cacheable = cache_enabled && BalloonCache::canCache(canvas, x, y, w, h);
+  if (cacheable && balloon_cache.blit(key, canvas, x, y, w, h)) return;
+
+  canvas->fillRoundRect(x, y, w, h, SPEECH_BALLOON_RADIUS, style.background);
+  canvas->drawRoundRect(x, y, w, h, SPEECH_BALLOON_RADIUS, style.foreground);
+
+  int shown = layout.line_count < layout.visible_lines ? layout.line_count : layout.visible_lines;
+  int content_h = shown * layout.line_height - SPEECH_LINE_SPACING;
+  int top = y + (h - content_h) / 2 - layout.scroll_offsets[scroll_step];
+
+  int first = layout.scroll_first_line[scroll_step];
+  canvas->setClipRect(x + 2, y + 2, w - 4, h - 4);
+  for (int i = first; i < first + shown && i < layout.line_count; i++) {
+    const SpeechLine& line = layout.lines[i];
+    int tx = x + pad + (w - pad * 2 - (int)line.width) / 2;
+    if (tx < x + pad) tx = x + pad;  // ぶら下げ句読点で内幅を超えた行
+    glyph_cache.drawText(canvas, tx, top + i * layout.line_height,
+                         text + line.offset, line.bytes, style.foreground);
+  }
+  canvas->clearClipRect();
+
+  if (cacheable) balloon_cache.store(key, canvas, x, y, w, h);
+}
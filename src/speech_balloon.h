@@ -0,0 +1,96 @@
+/*
+ * Speech Balloon for Stack-chan
+ * Avatar標準の吹き出しの代わりに、グリフキャッシュを使ってセリフを描画する
+ */
+
+#ifndef SPEECH_BALLOON_H
+#define SPEECH_BALLOON_H
+
+#include <M5Unified.h>
+#include "glyph_cache.h"
+#include "speech_layout.h"
+#include "speech_marquee.h"
+#include "balloon_cache.h"
+#include "display_profile.h"
+
+// セリフ最大長（UTF-8バイト数、WebUIの50文字制限＋ステータス表示に十分な長さ）
+#define SPEECH_TEXT_MAX_BYTES 256
+
+// 吹き出し配置（画面座標、口の下の帯領域。値は DisplayProfile で画面ごとに決まる）
+#define SPEECH_BALLOON_X       DisplayProfile::balloon_x
+#define SPEECH_BALLOON_Y       DisplayProfile::balloon_y
+#define SPEECH_BALLOON_WIDTH   DisplayProfile::balloon_width
+#define SPEECH_BALLOON_HEIGHT  DisplayProfile::balloon_height
+#define SPEECH_BALLOON_RADIUS  DisplayProfile::balloon_radius
+#define SPEECH_BALLOON_PADDING DisplayProfile::balloon_padding
+#define SPEECH_VISIBLE_LINES   DisplayProfile::balloon_lines
+
+// 表示行数を超えるセリフのスクロール間隔
+#ifndef SPEECH_SCROLL_INTERVAL
+#define SPEECH_SCROLL_INTERVAL 2000  // 1行送るまでの時間（ms）
+#endif
+
+// 表示行数を超えるセリフを1行の横スクロールで表示する（0 で行送り表示）
+#ifndef SPEECH_MARQUEE_ENABLED
+#define SPEECH_MARQUEE_ENABLED 1
+#endif
+
+struct BalloonStyle {
+  uint16_t foreground;  // 枠線・文字色
+  uint16_t background;  // 塗りつぶし色
+  uint16_t backdrop;    // 角の外側に見える顔の背景色（キャッシュのキー用）
+};
+
+class SpeechBalloon {
+public:
+  SpeechBalloon();
+  void begin(const lgfx::IFont* font, int glyph_slots = 0);  // 0: GlyphCache の既定値
+  void end();
+
+  // 描画済み吹き出しのキャッシュを有効にする（budget=0: PSRAMの有無から決定）
+  void enableCache(size_t budget = 0);
+
+  // セリフ設定（loop側から呼ぶ）
+  void setText(const char* text);
+
+  // 吹き出し描画（Avatar描画タスクから呼ぶ）。offset_y は帯描画時の上端Y
+  void draw(M5Canvas* canvas, const BalloonStyle& style, int offset_y = 0);
+
+  // 長文の表示方法（true: 横スクロール, false: 行送り）
+  void setMarquee(bool enabled);
+  bool isMarqueeEnabled() const { return marquee_enabled; }
+  SpeechMarquee& getMarquee() { return marquee; }
+  BalloonCache& getBalloonCache() { return balloon_cache; }
+
+  GlyphCache& getGlyphCache() { return glyph_cache; }
+  const lgfx::IFont* getFont() const { return font; }
+  uint32_t getLayoutCount() const { return layout_count; }
+
+private:
+  SemaphoreHandle_t mutex;
+  const lgfx::IFont* font;
+
+  // loop側が書き込むセリフ（mutexで保護）
+  char pending_text[SPEECH_TEXT_MAX_BYTES];
+  uint32_t pending_revision;
+  volatile bool marquee_enabled;
+
+  // 以下は描画タスク専用
+  char text[SPEECH_TEXT_MAX_BYTES];
+  uint32_t text_revision;
+  uint32_t text_hash;
+  SpeechLayout layout;
+  uint8_t scroll_step;
+  unsigned long scroll_changed_at;
+  uint32_t layout_count;
+  GlyphCache glyph_cache;
+  SpeechMarquee marquee;
+  BalloonCache balloon_cache;
+  bool cache_enabled;
+
+  void updateLayout();
+};
+
+extern SpeechBalloon speech_balloon;
+
+#endif
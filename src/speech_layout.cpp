@@ -0,0 +1,173 @@
+/*
+ * Speech Layout for Stack-chan
+ * セリフの改行位置（禁則処理込み）とスクロール位置を新しいセリフごとに1回だけ計算する
+ */
+
+#include "speech_layout.h"
+
+// 1メッセージで扱う最大文字数
+#define SPEECH_LAYOUT_MAX_CHARS 256
+
+// 作業領域（Avatar描画タスクのスタックは小さいので静的に確保、呼び出しは描画タスクのみ）
+static uint32_t cps[SPEECH_LAYOUT_MAX_CHARS];
+static uint16_t offsets[SPEECH_LAYOUT_MAX_CHARS + 1];
+static uint8_t advances[SPEECH_LAYOUT_MAX_CHARS];
+
+// 行頭禁則文字
+static const uint16_t LINE_START_PROHIBITED[] = {
+  ')', ']', '}', ',', '.', '!', '?', ':', ';',
+  0x3001, 0x3002, 0xFF0C, 0xFF0E, 0x30FB, 0xFF1A, 0xFF1B, 0xFF1F, 0xFF01,  // 、。，．・：；？！
+  0x30FC, 0x301C, 0xFF5E, 0x2025, 0x2026,                                  // ー〜～‥…
+  0xFF09, 0x300D, 0x300F, 0x3011, 0x3015, 0x3009, 0x300B, 0xFF3D, 0xFF5D,  // ）」』】〕〉》］｝
+  0x2019, 0x201D,                                                          // ’”
+  0x309D, 0x309E, 0x30FD, 0x30FE, 0x3005,                                  // ゝゞヽヾ々
+  0x3041, 0x3043, 0x3045, 0x3047, 0x3049, 0x3063, 0x3083, 0x3085, 0x3087,  // ぁぃぅぇぉっゃゅょ
+  0x308E, 0x3095, 0x3096,                                                  // ゎゕゖ
+  0x30A1, 0x30A3, 0x30A5, 0x30A7, 0x30A9, 0x30C3, 0x30E3, 0x30E5, 0x30E7,  // ァィゥェォッャュョ
+  0x30EE, 0x30F5, 0x30F6,                                                  // ヮヵヶ
+};
+
+// 行末禁則文字
+static const uint16_t LINE_END_PROHIBITED[] = {
+  '(', '[', '{',
+  0xFF08, 0x300C, 0x300E, 0x3010, 0x3014, 0x3008, 0x300A, 0xFF3B, 0xFF5B,  // （「『【〔〈《［｛
+  0x2018, 0x201C,                                                          // ‘“
+};
+
+// ぶら下げ組みを許す句読点
+static const uint16_t HANGING_PUNCTUATION[] = {
+  ',', '.', 0x3001, 0x3002, 0xFF0C, 0xFF0E,  // 、。，．
+};
+
+static bool containsCodepoint(const uint16_t* table, size_t count, uint32_t c) {
+  for (size_t i = 0; i < count; i++) {
+    if (table[i] == c) return true;
+  }
+  return false;
+}
+
+bool isLineStartProhibited(uint32_t c) {
+  return containsCodepoint(LINE_START_PROHIBITED,
+                           sizeof(LINE_START_PROHIBITED) / sizeof(LINE_START_PROHIBITED[0]), c);
+}
+
+bool isLineEndProhibited(uint32_t c) {
+  return containsCodepoint(LINE_END_PROHIBITED,
+                           sizeof(LINE_END_PROHIBITED) / sizeof(LINE_END_PROHIBITED[0]), c);
+}
+
+bool isHangingPunctuation(uint32_t c) {
+  return containsCodepoint(HANGING_PUNCTUATION,
+                           sizeof(HANGING_PUNCTUATION) / sizeof(HANGING_PUNCTUATION[0]), c);
+}
+
+static bool isDigit(uint32_t c) {
+  return c >= '0' && c <= '9';
+}
+
+// 英数字の連続（単語・IPアドレス・URL）は途中で折り返さない
+// '.' は数字に挟まれているとき（IPアドレス・小数）だけ単語の一部とみなし、文末の '.' の後ろでは折り返せる
+static bool isWordChar(const uint32_t* text, int n, int i) {
+  uint32_t c = text[i];
+  if (c == '.') return i > 0 && i + 1 < n && isDigit(text[i - 1]) && isDigit(text[i + 1]);
+  return isDigit(c) || (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') ||
+         c == ':' || c == '/' || c == '-' || c == '_' || c == '@';
+}
+
+static bool canBreakBefore(const uint32_t* text, int n, int i) {
+  if (isLineStartProhibited(text[i])) return false;
+  if (isLineEndProhibited(text[i - 1])) return false;
+  if (isWordChar(text, n, i - 1) && isWordChar(text, n, i)) return false;
+  return true;
+}
+
+void layoutSpeech(const char* text, int max_width, int visible_lines,
+                  GlyphCache& glyphs, SpeechLayout& layout) {
+  layout.line_count = 0;
+  layout.visible_lines = visible_lines > 0 ? visible_lines : 1;
+  layout.line_height = glyphs.fontHeight() + SPEECH_LINE_SPACING;
+  layout.truncated = false;
+
+  // コードポイントと送り幅を先に展開しておく（グリフキャッシュもここで温まる）
+  int n = 0;
+  const char* p = text;
+  while (n < SPEECH_LAYOUT_MAX_CHARS) {
+    offsets[n] = p - text;
+    uint32_t c = utf8NextCodepoint(p);
+    if (c == 0) break;
+    cps[n] = c;
+    if (c == '\n') {
+      advances[n] = 0;
+    } else {
+      const GlyphCache::Glyph* g = glyphs.get(c);
+      advances[n] = g ? g->advance : 0;
+    }
+    n++;
+  }
+  offsets[n] = p - text;
+  if (n == SPEECH_LAYOUT_MAX_CHARS && *p != '\0') layout.truncated = true;
+
+  int start = 0;
+  while (start < n && layout.line_count < SPEECH_LAYOUT_MAX_LINES) {
+    // 折り返し直後の行頭スペースは詰める
+    while (start < n && cps[start] == ' ') start++;
+    if (start >= n) break;
+
+    int i = start;
+    int width = 0;
+    int last_break = -1;
+    int end = n;
+    int next = n;
+
+    while (i < n) {
+      if (cps[i] == '\n') {
+        end = i;
+        next = i + 1;
+        break;
+      }
+      if (i > start && canBreakBefore(cps, n, i)) last_break = i;
+
+      if (width + advances[i] > max_width && i > start) {
+        if (isHangingPunctuation(cps[i])) {
+          // 句読点は行末にぶら下げる
+          end = i + 1;
+        } else if (last_break > start) {
+          // 追い出し: 直前の分割可能位置で改行
+          end = last_break;
+        } else {
+          // 分割可能位置がない長い単語は強制分割
+          end = i;
+        }
+        next = end;
+        break;
+      }
+      width += advances[i];
+      i++;
+    }
+
+    // 行末スペースは幅に含めない
+    int trimmed = end;
+    while (trimmed > start && cps[trimmed - 1] == ' ') trimmed--;
+    int line_width = 0;
+    for (int k = start; k < trimmed; k++) line_width += advances[k];
+
+    SpeechLine& line = layout.lines[layout.line_count++];
+    line.offset = offsets[start];
+    line.bytes = offsets[trimmed] - offsets[start];
+    line.width = line_width;
+
+    start = next;
+  }
+  if (start < n) layout.truncated = true;
+
+  // スクロール位置は1行ずつ送る。表示行数に収まる場合は固定表示
+  if (layout.line_count <= layout.visible_lines) {
+    layout.scroll_steps = 1;
+  } else {
+    layout.scroll_steps = layout.line_count - layout.visible_lines + 1;
+  }
+  for (int s = 0; s < layout.scroll_steps; s++) {
+    layout.scroll_first_line[s] = s;
+    layout.scroll_offsets[s] = s * layout.line_height;
+  }
+}
@@ -0,0 +1,46 @@
+/*
+ * Speech Layout for Stack-chan
+ * セリフの改行位置（禁則処理込み）とスクロール位置を新しいセリフごとに1回だけ計算する
+ */
+
+#ifndef SPEECH_LAYOUT_H
+#define SPEECH_LAYOUT_H
+
+#include <Arduino.h>
+#include "glyph_cache.h"
+
+#ifndef SPEECH_LAYOUT_MAX_LINES
+#define SPEECH_LAYOUT_MAX_LINES 8   // 保持する最大行数（超えた分は切り捨て）
+#endif
+#ifndef SPEECH_LINE_SPACING
+#define SPEECH_LINE_SPACING     2   // 行間（px）
+#endif
+
+struct SpeechLine {
+  uint16_t offset;  // テキスト先頭からのバイト位置
+  uint16_t bytes;   // 行のバイト数
+  uint16_t width;   // 行の描画幅（px）
+};
+
+struct SpeechLayout {
+  SpeechLine lines[SPEECH_LAYOUT_MAX_LINES];
+  uint8_t line_count;
+  uint8_t visible_lines;
+  uint16_t line_height;
+  // スクロール位置ごとの先頭行と表示Yオフセット（スクロール不要なら scroll_steps=1）
+  uint8_t scroll_steps;
+  uint8_t scroll_first_line[SPEECH_LAYOUT_MAX_LINES];
+  uint16_t scroll_offsets[SPEECH_LAYOUT_MAX_LINES];
+  bool truncated;
+};
+
+// 禁則処理の判定
+bool isLineStartProhibited(uint32_t c);  // 行頭禁則（。、ー 小書きかな 閉じ括弧 等）
+bool isLineEndProhibited(uint32_t c);    // 行末禁則（開き括弧 等）
+bool isHangingPunctuation(uint32_t c);   // ぶら下げ可能な句読点
+
+// テキストを max_width に収まるよう折り返す。幅はグリフキャッシュの送り幅で測る
+void layoutSpeech(const char* text, int max_width, int visible_lines,
+                  GlyphCache& glyphs, SpeechLayout& layout);
+
+#endif
@@ -0,0 +1,171 @@
+/*
+ * Speech Marquee for Stack-chan
+ * 吹き出しに収まらない長いセリフを1行で横スクロール表示する
+ */
+
+#include "speech_marquee.h"
+
+SpeechMarquee::SpeechMarquee() {
+  line_depth = 0;
+  line_fg = 0;
+  line_bg = 0;
+  cache = nullptr;
+  width = 0;
+  height = 0;
+  count = 0;
+  period = 1;
+  offset = 0;
+  speed = SPEECH_MARQUEE_SPEED;
+  last_ms = 0;
+  remainder = 0;
+  primed = false;
+  memset(&stats, 0, sizeof(stats));
+  total_pixels = 0;
+}
+
+bool SpeechMarquee::begin(GlyphCache* c, int w) {
+  cache = c;
+  width = (w + 7) & ~7;
+  height = cache->fontHeight();
+  if (height <= 0 || height > GLYPH_CELL_HEIGHT) height = GLYPH_CELL_HEIGHT;
+  stats.full_pixels = width * height;
+  return width > 0;
+}
+
+void SpeechMarquee::end() {
+  line.deleteSprite();
+  line_depth = 0;
+  count = 0;
+  width = 0;
+}
+
+// 行バッファを描画先と同じ色深度で用意する（深度が変わったら作り直して全体を描く）
+bool SpeechMarquee::prepareLine(int depth) {
+  if (line_depth == depth) return true;
+  line.deleteSprite();
+  line_depth = 0;
+  primed = false;
+  line.setColorDepth(depth);
+  line.setPsram(psramFound());
+  if (!line.createSprite(width, height)) {
+    Serial.println("SpeechMarquee: 行バッファ確保に失敗");
+    width = 0;  // 以降は表示しない
+    return false;
+  }
+  line_depth = depth;
+  return true;
+}
+
+void SpeechMarquee::setText(const char* utf8, size_t bytes) {
+  count = 0;
+  primed = false;
+  if (!utf8 || !width) return;
+
+  const char* p = utf8;
+  const char* end = utf8 + bytes;
+  int x = 0;
+  uint32_t c;
+  while (p < end && count < SPEECH_MARQUEE_MAX_CHARS && (c = utf8NextCodepoint(p)) != 0) {
+    const GlyphCache::Glyph* g = cache->get(c);
+    if (!g) break;
+    codepoints[count] = c;
+    positions[count] = x;
+    advances[count] = g->advance;
+    x += g->advance;
+    count++;
+  }
+  period = x + SPEECH_MARQUEE_GAP;
+  offset = 0;
+}
+
+void SpeechMarquee::setSpeed(uint16_t px_per_sec) {
+  speed = px_per_sec > SPEECH_MARQUEE_SPEED_MAX ? SPEECH_MARQUEE_SPEED_MAX : px_per_sec;
+}
+
+// 行バッファの [col, col+cols) 列を現在の offset で描き直す
+void SpeechMarquee::drawColumns(int col, int cols) {
+  line.fillRect(col, 0, cols, height, line_bg);
+  line.setClipRect(col, 0, cols, height);
+
+  int32_t v0 = offset + col;
+  int32_t v1 = v0 + cols;
+  // offset < period なので、見える範囲は高々2周期分
+  for (int32_t base = 0; base < v1; base += period) {
+    if (base + period <= v0) continue;  // 空白は GLYPH_CELL_WIDTH より広いので前周期の文字はかからない
+    for (int i = 0; i < count; i++) {
+      int32_t gx = base + positions[i];
+      if (gx + GLYPH_CELL_WIDTH <= v0) continue;
+      if (gx >= v1) break;
+      const GlyphCache::Glyph* g = cache->get(codepoints[i]);
+      if (g) line.drawBitmap(gx - offset, 0, g->bits, GLYPH_CELL_WIDTH, g->height, line_fg);
+    }
+  }
+  line.clearClipRect();
+}
+
+void SpeechMarquee::draw(M5Canvas* dst, int x, int y, uint16_t foreground, uint16_t background) {
+  if (!count || !width) return;
+  if (!prepareLine(dst->getColorDepth() & 0xFF)) return;
+  if (foreground != line_fg || background != line_bg) {
+    line_fg = foreground;
+    line_bg = background;
+    primed = false;
+  }
+
+  unsigned long now = millis();
+  uint32_t pixels = 0;
+
+  if (!primed) {
+    drawColumns(0, width);
+    pixels = width * height;
+    remainder = 0;
+    primed = true;
+    stats.redraws++;
+  } else {
+    uint32_t travel = (now - last_ms) * speed + remainder;
+    int dx = travel / 1000;
+    remainder = travel % 1000;
+    if (dx >= width) {
+      // 描画が長く止まっていた場合は丸ごと描き直す
+      offset = (offset + dx) % period;
+      drawColumns(0, width);
+      pixels = width * height;
+      stats.redraws++;
+    } else if (dx > 0) {
+      // 既存の画素は矩形コピーでずらし、右端に現れた列だけ描く
+      line.scroll(-dx, 0);
+      offset = (offset + dx) % period;
+      drawColumns(width - dx, dx);
+      pixels = dx * height;
+    }
+  }
+  last_ms = now;
+
+  // 描画先は毎フレーム作り直されるので、行バッファを丸ごと写す（行コピーできない配置なら画素単位で転送）
+  RowGeometry dg, sg;
+  if (canvasRowGeometry(dst, x, y, width, height, dg) && canvasRowGeometry(&line, 0, 0, width, height, sg) &&
+      dg.row_bytes == sg.row_bytes) {
+    uint8_t* d = (uint8_t*)dst->getBuffer() + dg.offset;
+    const uint8_t* src = (const uint8_t*)line.getBuffer();
+    for (int row = 0; row < height; row++) {
+      memcpy(d, src, sg.row_bytes);
+      d += dg.stride;
+      src += sg.stride;
+    }
+    stats.copy_bytes = sg.row_bytes * height;
+  } else {
+    line.pushSprite(dst, x, y);
+    pixels += width * height;
+    stats.copy_bytes = 0;
+  }
+
+  stats.frames++;
+  stats.last_pixels = pixels;
+  total_pixels += pixels;
+}
+
+MarqueeStats SpeechMarquee::getStats() const {
+  MarqueeStats s = stats;
+  s.avg_pixels = s.frames ? total_pixels / s.frames : 0;
+  return s;
+}
@@ -0,0 +1,84 @@
+/*
+ * Speech Marquee for Stack-chan
+ * 吹き出しに収まらない長いセリフを1行で横スクロール表示する
+ * 行バッファは描画先と同じ色深度で持ち、前フレームの内容を矩形コピーでずらして新しく見えた列だけ描く
+ * Avatar の描画先は毎フレーム作り直されるので、行バッファは画素の変換なしの行コピーで写す
+ */
+
+#ifndef SPEECH_MARQUEE_H
+#define SPEECH_MARQUEE_H
+
+#include <M5Unified.h>
+#include "glyph_cache.h"
+#include "balloon_cache.h"
+
+// スクロール速度の既定値（px/秒）
+#ifndef SPEECH_MARQUEE_SPEED
+#define SPEECH_MARQUEE_SPEED 48
+#endif
+#define SPEECH_MARQUEE_SPEED_MAX 400
+
+// 末尾と先頭の間の空白（px）
+#define SPEECH_MARQUEE_GAP       48
+#define SPEECH_MARQUEE_MAX_CHARS 128
+
+struct MarqueeStats {
+  uint32_t frames;          // マーキー表示したフレーム数
+  uint32_t last_pixels;     // 直近フレームで画素単位に書いた数（行バッファの描き直した列＋行コピーできないときの転送）
+  uint32_t avg_pixels;      // 1フレーム平均の last_pixels
+  uint32_t full_pixels;     // 行全体の画素数（毎フレーム全体を描く場合の last_pixels）
+  uint32_t redraws;         // 行全体を描き直した回数（テキスト・配色の変更、大きな飛び）
+  uint32_t copy_bytes;      // 直近フレームで描画先へ行コピーしたバイト数
+};
+
+class SpeechMarquee {
+public:
+  SpeechMarquee();
+
+  // width は8の倍数に切り上げる（1bpp行バッファの都合）。行バッファは最初の draw() で描画先に合わせて確保する
+  bool begin(GlyphCache* cache, int width);
+  void end();
+
+  // 描画タスクから呼ぶ。nullptr / 空文字で停止
+  void setText(const char* utf8, size_t bytes);
+  bool isActive() const { return count > 0; }
+
+  // どのタスクからでも呼べる
+  void setSpeed(uint16_t px_per_sec);
+  uint16_t getSpeed() const { return speed; }
+
+  // 経過時間分だけ進めて dst の (x, y) に行を描く
+  void draw(M5Canvas* dst, int x, int y, uint16_t foreground, uint16_t background);
+
+  int getHeight() const { return height; }
+  MarqueeStats getStats() const;
+
+private:
+  M5Canvas line;             // 行バッファ（描画先と同じ色深度、配色も反映済み）
+  uint8_t line_depth;        // 0: 未確保
+  uint16_t line_fg;
+  uint16_t line_bg;
+  GlyphCache* cache;
+  int width;
+  int height;
+
+  uint32_t codepoints[SPEECH_MARQUEE_MAX_CHARS];
+  int16_t positions[SPEECH_MARQUEE_MAX_CHARS];  // 行頭からのX
+  uint8_t advances[SPEECH_MARQUEE_MAX_CHARS];
+  int count;
+  int32_t period;            // テキスト幅＋空白（この周期で繰り返す）
+  int32_t offset;            // 行バッファ左端の仮想X（0 - period-1）
+
+  volatile uint16_t speed;
+  unsigned long last_ms;
+  uint32_t remainder;        // 1px未満の移動量（px*ms）
+  bool primed;
+
+  MarqueeStats stats;
+  uint64_t total_pixels;
+
+  bool prepareLine(int depth);
+  void drawColumns(int col, int cols);
+};
+
+#endif
@@ -0,0 +1,71 @@
+/*
+ * SPSC Queue for Stack-chan
+ * 生産者1つ・消費者1つのロックフリーなリングバッファ
+ * 生産者は head だけ、消費者は tail だけを書き、相手の値は acquire で読む（要素の中身は release で公開する）
+ * 要素はその場で書き込む（reserve() → commit()、front() → release()）ので大きな構造体でもコピーは1回で済む
+ * Arduino に依存しないので、ホスト上でも2スレッドでそのまま動かせる
+ */
+
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <stdint.h>
+
+// Capacity は 2 のべき乗
+template <typename T, uint32_t Capacity>
+class SpscQueue {
+  static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+  SpscQueue() : head(0), tail(0) {}
+
+  // === 生産側 ===
+  // 空きがあれば書き込み先を返す（満杯なら nullptr）。書き終えたら commit()
+  T* reserve() {
+    uint32_t h = head.load(std::memory_order_relaxed);
+    if (h - tail.load(std::memory_order_acquire) >= Capacity) return nullptr;
+    return &slots[h & (Capacity - 1)];
+  }
+  void commit() {
+    head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+  bool push(const T& value) {
+    T* slot = reserve();
+    if (!slot) return false;
+    *slot = value;
+    commit();
+    return true;
+  }
+
+  // === 消費側 ===
+  // 先頭の要素（空なら nullptr）。読み終えたら release()
+  T* front() {
+    uint32_t t = tail.load(std::memory_order_relaxed);
+    if (head.load(std::memory_order_acquire) == t) return nullptr;
+    return &slots[t & (Capacity - 1)];
+  }
+  void release() {
+    tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+  bool pop(T& out) {
+    T* slot = front();
+    if (!slot) return false;
+    out = *slot;
+    release();
+    return true;
+  }
+
+  // どちらの側からも呼べる（相手が動いていれば目安）
+  uint32_t size() const {
+    return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+  }
+  static uint32_t capacity() { return Capacity; }
+
+private:
+  std::atomic<uint32_t> head;  // 次に書く位置（生産側だけが進める）
+  std::atomic<uint32_t> tail;  // 次に読む位置（消費側だけが進める）
+  T slots[Capacity];
+};
+
+#endif
@@ -0,0 +1,104 @@
+/*
+ * Stack-chan Face
+ * FaceAnimator の姿勢で目・眉・口を描き、独自の吹き出しレイヤーを重ねる
+ */
+
+#include "stackchan_face.h"
+#include "screen_capture.h"
+#include "power_governor.h"
+#include "loop_events.h"
+#include "trace_recorder.h"
+#include "boot_timeline.h"
+#include "avatar_commands.h"
+
+PartStyle partStyleFromContext(DrawContext* ctx) {
+  PartStyle style;
+  if (ctx->getColorDepth() == 1) {
+    // 1bitスプライトでは 0=背景色, 1=前景色 のパレット番号
+    style.primary = 1;
+    style.background = 0;
+    style.balloon_foreground = 1;
+    style.balloon_background = 0;
+  } else {
+    ColorPalette* cp = ctx->getColorPalette();
+    style.primary = cp->get(COLOR_PRIMARY);
+    style.background = cp->get(COLOR_BACKGROUND);
+    style.balloon_foreground = cp->get(COLOR_BALLOON_FOREGROUND);
+    style.balloon_background = cp->get(COLOR_BALLOON_BACKGROUND);
+  }
+  float breath = fmin(1.0f, ctx->getBreath());
+  style.breath_px = breath * FACE_BREATH_PX;
+  return style;
+}
+
+// === 目 ===
+
+AnimatedEye::AnimatedEye(uint16_t r, bool isLeft, FaceAnimator* a)
+    : radius(r), is_left(isLeft), animator(a) {}
+
+void AnimatedEye::draw(M5Canvas* spi, BoundingRect rect, DrawContext* ctx) {
+  drawEyePart(spi, rect.getCenterX(), rect.getCenterY(), radius, partStyleFromContext(ctx), animator->getPose());
+}
+
+// === 眉 ===
+
+AnimatedEyebrow::AnimatedEyebrow(uint16_t w, bool isLeft, FaceAnimator* a)
+    : width(w), is_left(isLeft), animator(a) {}
+
+void AnimatedEyebrow::draw(M5Canvas* spi, BoundingRect rect, DrawContext* ctx) {
+  drawEyebrowPart(spi, rect.getCenterX(), rect.getCenterY(), width, is_left, partStyleFromContext(ctx),
+                  animator->getPose());
+}
+
+// === 口 + オーバーレイ ===
+
+AnimatedMouth::AnimatedMouth(uint16_t minWidth, uint16_t maxWidth, uint16_t minHeight, uint16_t maxHeight,
+                             FaceAnimator* a, SpeechBalloon* b, HudOverlay* h)
+    : min_width(minWidth), max_width(maxWidth), min_height(minHeight), max_height(maxHeight),
+      animator(a), balloon(b), hud(h) {}
+
+void AnimatedMouth::draw(M5Canvas* spi, BoundingRect rect, DrawContext* ctx) {
+  // ここに来た時点で前のフレームの転送は終わっている
+  TRACE_END(TRACE_FRAME);
+  // ボタン操作が画面に出るまでの時間を測る（休止中の待ちより前の時点）
+  loop_events.frameCheckpoint();
+  boot_timeline.frameCheckpoint();
+  // 無操作が続いているときはフレームの間隔を空ける（操作があればすぐに戻る）
+  power_governor.paceFrame();
+  // 他のタスクから届いた表情・セリフ・色の変更を、このフレームの描画の前に反映する
+  avatar_commands.drain();
+
+  // Face::draw() のパーツ描画中は SPI を使わないので、スクリーンショットの読み出しはここで待たせる
+  screen_capture.drawCheckpoint();
+  TRACE_BEGIN(TRACE_FRAME);
+
+  PartStyle style = partStyleFromContext(ctx);
+  fx8_t lip_sync = ctx->getMouthOpenRatio() * FX8_ONE;
+  drawMouthPart(spi, rect.getCenterX(), rect.getCenterY(), min_width, max_width, min_height, max_height, style,
+                animator->getPose(), lip_sync);
+
+  if (balloon) {
+    BalloonStyle balloon_style;
+    balloon_style.foreground = style.balloon_foreground;
+    balloon_style.background = style.balloon_background;
+    balloon_style.backdrop = style.background;
+    balloon->draw(spi, balloon_style);
+  }
+
+  if (hud) hud->draw(spi, style.primary);
+}
+
+// パーツ配置は M5Stack-Avatar 標準Faceと同一（小画面では DisplayProfile の倍率で縮める）
+// Face のスプライトは画面サイズで確保し、拡大縮小せずに転送する
+StackchanFace::StackchanFace(FaceAnimator* animator, SpeechBalloon* balloon, HudOverlay* hud)
+    : Face(new AnimatedMouth(FACE_MOUTH_MIN_W, FACE_MOUTH_MAX_W, FACE_MOUTH_MIN_H, FACE_MOUTH_MAX_H,
+                             animator, balloon, hud),
+           new BoundingRect(FACE_MOUTH_Y, FACE_MOUTH_X),
+           new AnimatedEye(FACE_EYE_RADIUS, false, animator), new BoundingRect(FACE_EYE_R_Y, FACE_EYE_R_X),
+           new AnimatedEye(FACE_EYE_RADIUS, true, animator), new BoundingRect(FACE_EYE_L_Y, FACE_EYE_L_X),
+           new AnimatedEyebrow(FACE_EYEBROW_WIDTH, false, animator),
+           new BoundingRect(FACE_EYEBROW_R_Y, FACE_EYEBROW_R_X),
+           new AnimatedEyebrow(FACE_EYEBROW_WIDTH, true, animator),
+           new BoundingRect(FACE_EYEBROW_L_Y, FACE_EYEBROW_L_X),
+           new BoundingRect(0, 0, DisplayProfile::width, DisplayProfile::height),
+           new M5Canvas(&M5.Display), new M5Canvas(&M5.Display)) {}
@@ -0,0 +1,66 @@
+/*
+ * Stack-chan Face
+ * FaceAnimator の姿勢で目・眉・口を描き、独自の吹き出しレイヤーを重ねる
+ */
+
+#ifndef STACKCHAN_FACE_H
+#define STACKCHAN_FACE_H
+
+#include <Avatar.h>
+#include "face_animator.h"
+#include "face_parts.h"
+#include "speech_balloon.h"
+#include "hud_overlay.h"
+#include "display_profile.h"
+
+using namespace m5avatar;
+
+// Avatar の DrawContext（パレット・呼吸）からパーツの色を決める
+PartStyle partStyleFromContext(DrawContext* ctx);
+
+class AnimatedEye : public Drawable {
+public:
+  AnimatedEye(uint16_t radius, bool isLeft, FaceAnimator* animator);
+  void draw(M5Canvas* spi, BoundingRect rect, DrawContext* ctx) override;
+
+private:
+  uint16_t radius;
+  bool is_left;
+  FaceAnimator* animator;
+};
+
+class AnimatedEyebrow : public Drawable {
+public:
+  AnimatedEyebrow(uint16_t width, bool isLeft, FaceAnimator* animator);
+  void draw(M5Canvas* spi, BoundingRect rect, DrawContext* ctx) override;
+
+private:
+  uint16_t width;
+  bool is_left;
+  FaceAnimator* animator;
+};
+
+// 口の描画後にオーバーレイ（吹き出し・HUD）をFaceのスプライトへ重ねる
+// Face::draw() はパーツ描画後にまとめて画面転送するため、ここで描けばちらつかない
+class AnimatedMouth : public Drawable {
+public:
+  AnimatedMouth(uint16_t minWidth, uint16_t maxWidth, uint16_t minHeight, uint16_t maxHeight,
+                FaceAnimator* animator, SpeechBalloon* balloon, HudOverlay* hud = nullptr);
+  void draw(M5Canvas* spi, BoundingRect rect, DrawContext* ctx) override;
+
+private:
+  uint16_t min_width;
+  uint16_t max_width;
+  uint16_t min_height;
+  uint16_t max_height;
+  FaceAnimator* animator;
+  SpeechBalloon* balloon;
+  HudOverlay* hud;
+};
+
+class StackchanFace : public Face {
+public:
+  StackchanFace(FaceAnimator* animator, SpeechBalloon* balloon, HudOverlay* hud = nullptr);
+};
+
+#endif
@@ -0,0 +1,208 @@
+/*
+ * Stall Detector for Stack-chan
+ * 区間の出入りの記録・予算超過のログ・タスクウォッチドッグへの餌やり
+ * 時刻はすべて millis() の32ビット（約49日で一周するが、差は符号なしの引き算で正しく出る）
+ */
+
+#include "stall_detector.h"
+#include "breadcrumbs.h"
+#include <esp_debug_helpers.h>
+#include <esp_system.h>
+#include <esp_task_wdt.h>
+#include <string.h>
+
+StallDetector stall_detector;
+
+struct StallRegionDef {
+  const char* name;
+  uint32_t budget_ms;
+  uint32_t limit_ms;
+};
+
+// 予算は普段の所要時間の上限の目安、上限はこれを超えたら戻らないと判断する時間
+static const StallRegionDef region_defs[STALL_REGION_COUNT] = {
+  {"loop",         500,   STALL_LOOP_LIMIT_MS},
+  {"wifi_connect", 12000, 90000},
+  {"mode_switch",  15000, 120000},
+  {"ble_init",     3000,  20000},
+  {"ble_restart",  3000,  20000},
+  {"ble_deinit",   2000,  15000},
+  {"http_request", 2000,  30000},
+};
+
+#define STALL_RESET_MAGIC 0x5354414cUL  // "STAL"
+
+// 再起動しても消えない領域（電源を切ると消える）
+RTC_NOINIT_ATTR static uint32_t rtc_stall_magic;
+RTC_NOINIT_ATTR static uint32_t rtc_stall_region;
+RTC_NOINIT_ATTR static uint32_t rtc_stall_elapsed_ms;
+RTC_NOINIT_ATTR static char rtc_stall_task[16];
+
+StallDetector::StallDetector() {
+  memset((void*)entered_ms, 0, sizeof(entered_ms));
+  memset((void*)inside, 0, sizeof(inside));
+  memset(owners, 0, sizeof(owners));
+  memset((void*)flagged, 0, sizeof(flagged));
+  memset(counts, 0, sizeof(counts));
+  memset(over_budget, 0, sizeof(over_budget));
+  memset(last_ms, 0, sizeof(last_ms));
+  memset(max_ms, 0, sizeof(max_ms));
+  loop_resumed_ms = 0;
+  nested_ran = false;
+  tripped = false;
+  tripped_ms = 0;
+  memset(&reset_info, 0, sizeof(reset_info));
+}
+
+void StallDetector::begin() {
+  // 前回ウォッチドッグで再起動する前に止まっていた区間
+  esp_reset_reason_t reason = esp_reset_reason();
+  // 監視タスクが esp_restart() で再起動する（パニックが有効な設定ならウォッチドッグが先に再起動する）
+  bool stall_reset = reason == ESP_RST_SW || reason == ESP_RST_TASK_WDT;
+  if (rtc_stall_magic == STALL_RESET_MAGIC && stall_reset && rtc_stall_region < STALL_REGION_COUNT) {
+    reset_info.valid = true;
+    reset_info.region = rtc_stall_region;
+    reset_info.elapsed_ms = rtc_stall_elapsed_ms;
+    memcpy(reset_info.task, rtc_stall_task, sizeof(reset_info.task));
+    reset_info.task[sizeof(reset_info.task) - 1] = '\0';
+    Serial.printf("StallDetector: 前回は %s で %lums 止まり再起動しました (%s)\n", regionName(reset_info.region),
+                  (unsigned long)reset_info.elapsed_ms, reset_info.task);
+  }
+  rtc_stall_magic = 0;
+
+  xTaskCreatePinnedToCore(monitorTask, "stall_mon", 3072, this, 2, nullptr, ARDUINO_RUNNING_CORE);
+  Serial.printf("StallDetector: 監視開始（ウォッチドッグ %s）\n", STALL_WATCHDOG_ENABLED ? "有効" : "無効");
+}
+
+void StallDetector::enter(StallRegion region) {
+  uint32_t now = millis();
+  owners[region] = xTaskGetCurrentTaskHandle();
+  flagged[region] = false;
+  if (region == STALL_LOOP) {
+    nested_ran = false;
+    loop_resumed_ms = now;
+  }
+  entered_ms[region] = now;
+  inside[region] = true;
+}
+
+void StallDetector::exit(StallRegion region) {
+  if (!inside[region]) return;
+  inside[region] = false;
+
+  uint32_t ms = millis() - entered_ms[region];
+  counts[region]++;
+  last_ms[region] = ms;
+  if (ms > max_ms[region]) max_ms[region] = ms;
+  if (region == STALL_LOOP) {
+    // WiFi接続などの区間を含んだ回は、その区間のほうで報告済み
+    if (ms > region_defs[region].budget_ms && !nested_ran) {
+      over_budget[region]++;
+      breadcrumbs.add(CRUMB_STALL, region);
+      Serial.printf("StallDetector: loop が予算超過 %lums > %lums\n", (unsigned long)ms,
+                    (unsigned long)region_defs[region].budget_ms);
+    }
+    return;
+  }
+  if (ms > region_defs[region].budget_ms) {
+    over_budget[region]++;
+    breadcrumbs.add(CRUMB_STALL, region);
+    // 区間を抜けた場所のバックトレースでどの経路だったかがわかる
+    Serial.printf("StallDetector: %s が予算超過 %lums > %lums\n", regionName(region), (unsigned long)ms,
+                  (unsigned long)region_defs[region].budget_ms);
+    esp_backtrace_print(STALL_BACKTRACE_DEPTH);
+  }
+  // 中の区間の時間は loop() の上限の判定に含めない
+  nested_ran = true;
+  loop_resumed_ms = millis();
+}
+
+void StallDetector::check() {
+  uint32_t now = millis();
+  bool any_active = false;
+
+  for (int i = STALL_LOOP + 1; i < STALL_REGION_COUNT; i++) {
+    if (!inside[i]) continue;
+    any_active = true;
+    // 読む間に抜けて入り直しても、新しい入った時刻との差になるだけ（書きかけの値は読まない）
+    uint32_t elapsed = now - entered_ms[i];
+    if ((int32_t)elapsed < 0) elapsed = 0;
+    // 実行中の予算超過はここで先に知らせる（バックトレースは抜けたとき、またはウォッチドッグが出す）
+    if (elapsed > region_defs[i].budget_ms && !flagged[i]) {
+      flagged[i] = true;
+      Serial.printf("StallDetector: %s が %lums 経っても終わらない (%s)\n", regionName(i), (unsigned long)elapsed,
+                    owners[i] ? pcTaskGetName(owners[i]) : "?");
+    }
+    if (elapsed > region_defs[i].limit_ms && !tripped) trip(i, elapsed, owners[i]);
+  }
+
+  // 他の区間の外で loop() が待機まで戻らない
+  if (inside[STALL_LOOP] && !any_active && !tripped) {
+    uint32_t elapsed = now - loop_resumed_ms;
+    if ((int32_t)elapsed < 0) elapsed = 0;
+    if (elapsed > region_defs[STALL_LOOP].limit_ms) trip(STALL_LOOP, elapsed, owners[STALL_LOOP]);
+  }
+}
+
+void StallDetector::trip(uint8_t region, uint32_t elapsed_ms, TaskHandle_t task) {
+  tripped = true;
+  tripped_ms = millis();
+  rtc_stall_region = region;
+  rtc_stall_elapsed_ms = elapsed_ms;
+  memset(rtc_stall_task, 0, sizeof(rtc_stall_task));
+  strncpy(rtc_stall_task, task ? pcTaskGetName(task) : "?", sizeof(rtc_stall_task) - 1);
+  rtc_stall_magic = STALL_RESET_MAGIC;
+  breadcrumbs.add(CRUMB_STALL_TRIP, region);
+  Serial.printf("StallDetector: %s が上限 %lums を超えて戻らない%s\n", regionName(region),
+                (unsigned long)region_defs[region].limit_ms,
+                STALL_WATCHDOG_ENABLED ? "。ウォッチドッグで再起動します" : "");
+}
+
+// 起動済みのウォッチドッグにこのタスクだけを登録し、止まった区間がない間だけ餌を与える
+// 餌が止まるとウォッチドッグが各CPUの実行中タスクのバックトレースを出す。そのあと自分で再起動する
+// （ウォッチドッグの設定は変えないので、アイドルタスクなど他の監視対象の扱いは元のまま）
+void StallDetector::monitorTask(void* arg) {
+  StallDetector* self = static_cast<StallDetector*>(arg);
+#if STALL_WATCHDOG_ENABLED
+  bool watched = esp_task_wdt_add(nullptr) == ESP_OK;
+  if (!watched) Serial.println("StallDetector: ウォッチドッグに登録できないため、上限を超えたら直接再起動します");
+#endif
+  for (;;) {
+    self->check();
+#if STALL_WATCHDOG_ENABLED
+    if (!self->tripped) {
+      if (watched) esp_task_wdt_reset();
+    } else if (millis() - self->tripped_ms >= (watched ? STALL_RESTART_DELAY_MS : 0)) {
+      Serial.println("StallDetector: 再起動します");
+      Serial.flush();
+      esp_restart();
+    }
+#endif
+    vTaskDelay(pdMS_TO_TICKS(STALL_CHECK_MS));
+  }
+}
+
+StallRegionStats StallDetector::getStats(StallRegion region) const {
+  StallRegionStats s;
+  s.budget_ms = region_defs[region].budget_ms;
+  s.limit_ms = region_defs[region].limit_ms;
+  s.count = counts[region];
+  s.over_budget = over_budget[region];
+  s.last_ms = last_ms[region];
+  s.max_ms = max_ms[region];
+  s.active = inside[region];
+  s.active_ms = s.active ? millis() - entered_ms[region] : 0;
+  return s;
+}
+
+const char* StallDetector::regionName(uint8_t region) {
+  return region < STALL_REGION_COUNT ? region_defs[region].name : "unknown";
+}
+
+StallGuard::StallGuard(StallRegion region) : region(region) {
+  stall_detector.enter(region);
+}
+
+StallGuard::~StallGuard() {
+  stall_detector.exit(region);
+}
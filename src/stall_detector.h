@@ -0,0 +1,111 @@
+/*
+ * Stall Detector for Stack-chan
+ * 長く止まりうる処理（WiFi接続・BLEの初期化/再起動/停止・通信モード切り替え・HTTP応答）を区間として登録し、
+ * 入った時刻と出た時刻を記録する。予算を超えた区間はログとバックトレースで知らせる
+ * 監視タスクがタスクウォッチドッグに餌を与え、区間が上限を超えて戻らない（loop() が戻らない）ときは
+ * 餌をやめてウォッチドッグにバックトレースを出させてから再起動する。止まった区間は RTC メモリに残し、再起動後に報告する
+ */
+
+#ifndef STALL_DETECTOR_H
+#define STALL_DETECTOR_H
+
+#include <Arduino.h>
+#include <esp_timer.h>
+
+// 0 にするとウォッチドッグで再起動しない（検知とログだけ、デバッガ接続時など）
+#ifndef STALL_WATCHDOG_ENABLED
+#define STALL_WATCHDOG_ENABLED 1
+#endif
+
+// ウォッチドッグの設定（タイムアウト・パニックの有無）は変えない。餌をやめてからウォッチドッグが
+// バックトレースを出し終わるまで待ち、監視タスクが自分で再起動する
+#ifdef CONFIG_ESP_TASK_WDT_TIMEOUT_S
+#define STALL_RESTART_DELAY_MS ((CONFIG_ESP_TASK_WDT_TIMEOUT_S + 1) * 1000)
+#else
+#define STALL_RESTART_DELAY_MS 6000
+#endif
+#define STALL_CHECK_MS         250   // 監視の間隔
+#define STALL_LOOP_LIMIT_MS    15000 // 他の区間の外で loop() が待機まで戻らない上限
+#define STALL_BACKTRACE_DEPTH  16
+
+enum StallRegion {
+  STALL_LOOP = 0,      // loop() の先頭から待機まで（中の区間の時間は上限の判定に含めない）
+  STALL_WIFI_CONNECT,  // connectToWiFi()（ネットワークごとに CONNECTION_TIMEOUT まで待つ）
+  STALL_MODE_SWITCH,   // WiFi ⟷ BLE 切り替え（中で WiFi接続・BLE初期化を含む）
+  STALL_BLE_INIT,
+  STALL_BLE_RESTART,   // restart() は1秒待つ
+  STALL_BLE_DEINIT,    // BLEDevice::deinit() は戻らないことがある
+  STALL_HTTP_REQUEST,  // 振り分け開始 → handleClient() から戻るまで
+  STALL_REGION_COUNT
+};
+
+struct StallRegionStats {
+  uint32_t budget_ms;     // 超えたらログとバックトレース
+  uint32_t limit_ms;      // 超えたらウォッチドッグで再起動
+  uint32_t count;
+  uint32_t over_budget;
+  uint32_t last_ms;
+  uint32_t max_ms;
+  bool active;
+  uint32_t active_ms;     // 実行中ならその経過時間
+};
+
+// 前回の再起動の原因になった区間
+struct StallResetInfo {
+  bool valid;
+  uint8_t region;
+  uint32_t elapsed_ms;
+  char task[16];
+};
+
+class StallDetector {
+public:
+  StallDetector();
+
+  // 監視タスクを起動し、ウォッチドッグを設定する。前回止まった区間があればログに出す
+  void begin();
+
+  // 区間の出入り（同じ区間は同時に1つのタスクからだけ使う）
+  void enter(StallRegion region);
+  void exit(StallRegion region);
+
+  StallRegionStats getStats(StallRegion region) const;
+  const StallResetInfo& getResetInfo() const { return reset_info; }
+  bool isTripped() const { return tripped; }
+
+  static const char* regionName(uint8_t region);
+
+private:
+  // 時刻は millis() の32ビット（Xtensa では64ビットの読み書きが分かれ、監視タスクが書きかけの値を読みうる）
+  volatile uint32_t entered_ms[STALL_REGION_COUNT];
+  volatile bool inside[STALL_REGION_COUNT];         // entered_ms を書いてから立てる
+  TaskHandle_t owners[STALL_REGION_COUNT];
+  volatile bool flagged[STALL_REGION_COUNT];        // 実行中に予算超過を報告済み
+  uint32_t counts[STALL_REGION_COUNT];
+  uint32_t over_budget[STALL_REGION_COUNT];
+  uint32_t last_ms[STALL_REGION_COUNT];
+  uint32_t max_ms[STALL_REGION_COUNT];
+  volatile uint32_t loop_resumed_ms;  // loop() の区間に入った、または中の区間を抜けた時刻
+  volatile bool nested_ran;          // loop() の区間の中で他の区間があった
+  volatile bool tripped;
+  uint32_t tripped_ms;
+  StallResetInfo reset_info;
+
+  void check();
+  void trip(uint8_t region, uint32_t elapsed_ms, TaskHandle_t task);
+  static void monitorTask(void* arg);
+};
+
+// 区間をスコープで囲む（途中の return でも必ず exit する）
+class StallGuard {
+public:
+  explicit StallGuard(StallRegion region);
+  ~StallGuard();
+
+private:
+  StallRegion region;
+};
+
+extern StallDetector stall_detector;
+
+#endif
@@ -0,0 +1,233 @@
+/*
+ * Timer Wheel for Stack-chan
+ * 周期・単発の処理を階層タイマーホイールで管理する（登録・期限切れとも O(1)）
+ */
+
+#include "timer_wheel.h"
+#include <string.h>
+
+#define LEVEL_SPAN(level) (1UL << (TIMER_WHEEL_BITS * (level)))
+
+TimerWheel::TimerWheel() {
+  begin(0);
+}
+
+void TimerWheel::begin(uint32_t now_ms) {
+  memset(jobs, 0, sizeof(jobs));
+  memset(heads, -1, sizeof(heads));
+  base_ms = now_ms;
+  current = 0;
+}
+
+uint32_t TimerWheel::msToTicks(uint32_t ms) {
+  uint32_t ticks = (ms + TIMER_WHEEL_TICK_MS - 1) / TIMER_WHEEL_TICK_MS;
+  return ticks ? ticks : 1;
+}
+
+// 期限までの残りティック数で段を選ぶ（遠い期限ほど粗い段に入り、近づくと下の段へ移る）
+void TimerWheel::link(int id) {
+  Job& j = jobs[id];
+  uint32_t delta = j.expires - current;
+  uint32_t key = j.expires;
+  uint8_t level;
+  if (delta < LEVEL_SPAN(1)) {
+    level = 0;
+  } else if (delta < LEVEL_SPAN(2)) {
+    level = 1;
+  } else {
+    level = 2;
+    // 最上段より遠い期限は最上段の端に置き、降りてきたときに入れ直す
+    if (delta >= LEVEL_SPAN(3)) key = current + LEVEL_SPAN(3) - 1;
+  }
+  uint8_t slot = (key >> (TIMER_WHEEL_BITS * level)) & (TIMER_WHEEL_SLOTS - 1);
+
+  j.level = level;
+  j.slot = slot;
+  j.prev = -1;
+  j.next = heads[level][slot];
+  if (j.next >= 0) jobs[j.next].prev = id;
+  heads[level][slot] = id;
+  j.linked = true;
+}
+
+void TimerWheel::unlink(int id) {
+  Job& j = jobs[id];
+  if (!j.linked) return;
+  if (j.prev >= 0) {
+    jobs[j.prev].next = j.next;
+  } else {
+    heads[j.level][j.slot] = j.next;
+  }
+  if (j.next >= 0) jobs[j.next].prev = j.prev;
+  j.linked = false;
+}
+
+// 上の段の現在スロットを1つ下の段へ振り分け直す
+void TimerWheel::cascade(int level) {
+  int slot = (current >> (TIMER_WHEEL_BITS * level)) & (TIMER_WHEEL_SLOTS - 1);
+  while (heads[level][slot] >= 0) {
+    int id = heads[level][slot];
+    unlink(id);
+    link(id);
+  }
+}
+
+// linked なジョブの最も早い期限（limit より遅ければ limit）
+uint32_t TimerWheel::nextExpiry(uint32_t limit) const {
+  uint32_t earliest = limit;
+  for (int id = 0; id < TIMER_WHEEL_MAX_JOBS; id++) {
+    if (jobs[id].linked && (int32_t)(jobs[id].expires - earliest) < 0) earliest = jobs[id].expires;
+  }
+  return earliest;
+}
+
+// 処理済みのティックを tick まで進め、全ジョブを新しい位置から入れ直す（途中のティックに期限がないときだけ呼ぶ）
+void TimerWheel::skipTo(uint32_t tick) {
+  current = tick;
+  for (int id = 0; id < TIMER_WHEEL_MAX_JOBS; id++) {
+    if (!jobs[id].linked) continue;
+    unlink(id);
+    link(id);
+  }
+}
+
+int TimerWheel::add(const char* name, uint32_t period_ms, uint32_t delay_ms, TimerCallback callback, void* user,
+                    uint32_t now_ms) {
+  for (int id = 0; id < TIMER_WHEEL_MAX_JOBS; id++) {
+    if (jobs[id].used) continue;
+    Job& j = jobs[id];
+    memset(&j, 0, sizeof(j));
+    j.name = name;
+    j.callback = callback;
+    j.user = user;
+    j.period_ticks = period_ms ? msToTicks(period_ms) : 0;
+    j.used = true;
+    reschedule(id, delay_ms, now_ms);
+    return id;
+  }
+  return -1;
+}
+
+int TimerWheel::addPeriodic(const char* name, uint32_t period_ms, TimerCallback callback, void* user,
+                            uint32_t now_ms) {
+  return add(name, period_ms, period_ms, callback, user, now_ms);
+}
+
+int TimerWheel::addOneShot(const char* name, uint32_t delay_ms, TimerCallback callback, void* user, uint32_t now_ms) {
+  return add(name, 0, delay_ms, callback, user, now_ms);
+}
+
+void TimerWheel::reschedule(int id, uint32_t delay_ms, uint32_t now_ms) {
+  if (id < 0 || id >= TIMER_WHEEL_MAX_JOBS || !jobs[id].used) return;
+  Job& j = jobs[id];
+  unlink(id);
+  // 予定時刻より前には実行しない（ティックは切り上げ）
+  uint32_t expires = (now_ms - base_ms + delay_ms + TIMER_WHEEL_TICK_MS - 1) / TIMER_WHEEL_TICK_MS;
+  if ((int32_t)(expires - current) < 1) expires = current + 1;
+  j.expires = expires;
+  link(id);
+}
+
+void TimerWheel::stop(int id) {
+  if (id < 0 || id >= TIMER_WHEEL_MAX_JOBS || !jobs[id].used) return;
+  unlink(id);
+}
+
+void TimerWheel::remove(int id) {
+  if (id < 0 || id >= TIMER_WHEEL_MAX_JOBS) return;
+  unlink(id);
+  jobs[id].used = false;
+}
+
+void TimerWheel::expire(int id, uint32_t now_ms) {
+  Job& j = jobs[id];
+  uint32_t due_ms = base_ms + j.expires * TIMER_WHEEL_TICK_MS;
+  uint32_t jitter = now_ms - due_ms;
+  j.runs++;
+  j.last_jitter_ms = jitter;
+  j.total_jitter_ms += jitter;
+  if (jitter > j.max_jitter_ms) j.max_jitter_ms = jitter;
+
+  // 周期ジョブは予定時刻を基準に次を決める（実行の遅れで周期がずれない）
+  // 遅れが周期を超えた分はまとめて実行せず飛ばす
+  if (j.period_ticks) {
+    uint32_t target = tickAt(now_ms);
+    uint32_t next = j.expires + j.period_ticks;
+    if ((int32_t)(next - target) <= 0) {
+      uint32_t missed = (target - j.expires) / j.period_ticks;
+      j.overruns += missed;
+      next = j.expires + (missed + 1) * j.period_ticks;
+    }
+    j.expires = next;
+    link(id);
+  }
+
+  // コールバック内で自分を reschedule / stop / remove してもよい
+  TimerCallback callback = j.callback;
+  void* user = j.user;
+  if (callback) callback(user);
+}
+
+uint32_t TimerWheel::run(uint32_t now_ms) {
+  uint32_t target = tickAt(now_ms);
+  uint32_t count = 0;
+  while ((int32_t)(target - current) > 0) {
+    // 最下段の一周より先へ進むとき（/api/clock で1日進めたときなど）は、空のティックを1つずつ回らずに次の期限の直前まで飛ぶ
+    if (target - current > TIMER_WHEEL_SLOTS) {
+      uint32_t stop = nextExpiry(target);
+      if (stop - current > 1) skipTo(stop - 1);
+    }
+    current++;
+    if ((current & (LEVEL_SPAN(2) - 1)) == 0) cascade(2);
+    if ((current & (LEVEL_SPAN(1) - 1)) == 0) cascade(1);
+
+    int slot = current & (TIMER_WHEEL_SLOTS - 1);
+    while (heads[0][slot] >= 0) {
+      int id = heads[0][slot];
+      unlink(id);
+      expire(id, now_ms);
+      count++;
+    }
+  }
+  return count;
+}
+
+uint32_t TimerWheel::msUntilNext(uint32_t now_ms) const {
+  bool found = false;
+  uint32_t earliest = 0;
+
+  for (int level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+    uint32_t index = current >> (TIMER_WHEEL_BITS * level);
+    // 各段で最初に見つかった空でないスロットが、その段で最も早い
+    for (uint32_t i = 1; i <= TIMER_WHEEL_SLOTS; i++) {
+      int id = heads[level][(index + i) & (TIMER_WHEEL_SLOTS - 1)];
+      if (id < 0) continue;
+      for (; id >= 0; id = jobs[id].next) {
+        if (!found || (int32_t)(jobs[id].expires - earliest) < 0) {
+          earliest = jobs[id].expires;
+          found = true;
+        }
+      }
+      break;
+    }
+  }
+  if (!found) return UINT32_MAX;
+
+  uint32_t due_ms = base_ms + earliest * TIMER_WHEEL_TICK_MS;
+  int32_t remaining = (int32_t)(due_ms - now_ms);
+  return remaining > 0 ? remaining : 0;
+}
+
+bool TimerWheel::getStats(int id, TimerJobStats& out) const {
+  if (id < 0 || id >= TIMER_WHEEL_MAX_JOBS || !jobs[id].used) return false;
+  const Job& j = jobs[id];
+  out.name = j.name;
+  out.period_ms = j.period_ticks * TIMER_WHEEL_TICK_MS;
+  out.runs = j.runs;
+  out.overruns = j.overruns;
+  out.last_jitter_ms = j.last_jitter_ms;
+  out.avg_jitter_ms = j.runs ? j.total_jitter_ms / j.runs : 0;
+  out.max_jitter_ms = j.max_jitter_ms;
+  out.active = j.linked;
+  return true;
+}
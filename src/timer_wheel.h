@@ -0,0 +1,101 @@
+/*
+ * Timer Wheel for Stack-chan
+ * 周期・単発の処理を階層タイマーホイールで管理する（登録・期限切れとも O(1)）
+ * 時刻は呼び出し側が渡す（Arduino に依存しないので、ホスト上でも仮想時計で同じコードを動かせる）
+ */
+
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <stdint.h>
+
+// 1ティックの長さと各段のスロット数（10ms x 64 = 640ms, x 64 = 41秒, x 64 = 44分）
+#define TIMER_WHEEL_TICK_MS   10
+#define TIMER_WHEEL_BITS      6
+#define TIMER_WHEEL_SLOTS     (1 << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_LEVELS    3
+
+// 登録できるジョブ数（静的確保）
+#ifndef TIMER_WHEEL_MAX_JOBS
+#define TIMER_WHEEL_MAX_JOBS  16
+#endif
+// ジョブのリストは int8_t の番号でつなぐ（-1 が終端）
+static_assert(TIMER_WHEEL_MAX_JOBS <= 127, "TIMER_WHEEL_MAX_JOBS must fit in int8_t job links");
+
+typedef void (*TimerCallback)(void* user);
+
+struct TimerJobStats {
+  const char* name;
+  uint32_t period_ms;     // 0: 単発
+  uint32_t runs;
+  uint32_t overruns;      // 遅れが周期を超えて飛ばした回数
+  uint32_t last_jitter_ms;  // 予定時刻からの遅れ
+  uint32_t avg_jitter_ms;
+  uint32_t max_jitter_ms;
+  bool active;
+};
+
+class TimerWheel {
+public:
+  TimerWheel();
+
+  void begin(uint32_t now_ms);
+
+  // 登録（戻り値はジョブ番号、空きがなければ -1）
+  int addPeriodic(const char* name, uint32_t period_ms, TimerCallback callback, void* user, uint32_t now_ms);
+  int addOneShot(const char* name, uint32_t delay_ms, TimerCallback callback, void* user, uint32_t now_ms);
+
+  // now_ms から delay_ms 後に実行し直す（単発ジョブの再開・周期ジョブの位相合わせ）
+  void reschedule(int id, uint32_t delay_ms, uint32_t now_ms);
+  // 止める（登録は残り、reschedule() で再開できる）
+  void stop(int id);
+  // 登録を消す
+  void remove(int id);
+
+  // now_ms までに期限の来たジョブを実行する。実行した数を返す
+  uint32_t run(uint32_t now_ms);
+
+  // 次のジョブの期限までの時間（ジョブがなければ UINT32_MAX）
+  uint32_t msUntilNext(uint32_t now_ms) const;
+
+  int jobCount() const { return TIMER_WHEEL_MAX_JOBS; }
+  bool getStats(int id, TimerJobStats& out) const;
+
+private:
+  struct Job {
+    const char* name;
+    TimerCallback callback;
+    void* user;
+    uint32_t expires;       // 期限（ティック）
+    uint32_t period_ticks;  // 0: 単発
+    int8_t prev;
+    int8_t next;
+    uint8_t level;
+    uint8_t slot;
+    bool used;
+    bool linked;
+    uint32_t runs;
+    uint32_t overruns;
+    uint32_t last_jitter_ms;
+    uint32_t max_jitter_ms;
+    uint64_t total_jitter_ms;
+  };
+
+  Job jobs[TIMER_WHEEL_MAX_JOBS];
+  int8_t heads[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+  uint32_t base_ms;       // ティック 0 の時刻
+  uint32_t current;       // 処理済みのティック
+
+  int add(const char* name, uint32_t period_ms, uint32_t delay_ms, TimerCallback callback, void* user,
+          uint32_t now_ms);
+  uint32_t tickAt(uint32_t now_ms) const { return (now_ms - base_ms) / TIMER_WHEEL_TICK_MS; }
+  static uint32_t msToTicks(uint32_t ms);
+  void link(int id);
+  void unlink(int id);
+  void cascade(int level);
+  uint32_t nextExpiry(uint32_t limit) const;
+  void skipTo(uint32_t tick);
+  void expire(int id, uint32_t now_ms);
+};
+
+#endif
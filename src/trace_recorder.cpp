@@ -0,0 +1,191 @@
+/*
+ * Trace Recorder for Stack-chan
+ * タスク番号付きの開始・終了・単発イベントのリングとバイナリダンプ
+ */
+
+#include "trace_recorder.h"
+
+#if TRACE_ENABLED
+
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+#include <string.h>
+
+TraceRecorder trace_recorder;
+
+// 複数のタスク（loop・描画・BLE・ネットワーク監視）から書き込まれる
+static portMUX_TYPE trace_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// ダンプを分けて送る単位
+#define TRACE_DUMP_CHUNK_RECORDS 64
+
+TraceRecorder::TraceRecorder() {
+  ring = nullptr;
+  capacity = 0;
+  head = 0;
+  count = 0;
+  recorded = 0;
+  overwritten = 0;
+  enabled = false;
+  dumping = false;
+  dump_first = 0;
+  dump_count = 0;
+  dump_lost = 0;
+  memset(tasks, 0, sizeof(tasks));
+  memset(task_names, 0, sizeof(task_names));
+  task_count = 0;
+}
+
+bool TraceRecorder::begin() {
+  if (ring) return true;
+  bool use_psram = psramFound();
+  uint32_t n = use_psram ? TRACE_CAPACITY_PSRAM : TRACE_CAPACITY_INTERNAL;
+  uint32_t caps = use_psram ? (MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT) : MALLOC_CAP_8BIT;
+  ring = static_cast<TraceRecord*>(heap_caps_malloc(n * sizeof(TraceRecord), caps));
+  if (!ring) {
+    Serial.println("TraceRecorder: リングの確保に失敗");
+    return false;
+  }
+  capacity = n;
+  enabled = true;
+  Serial.printf("TraceRecorder: %u レコード (%s)\n", (unsigned)capacity, use_psram ? "PSRAM" : "内部RAM");
+  return true;
+}
+
+// 呼び出し元タスクの番号（初めてのタスクは名前と一緒に登録する）。trace_lock の中で呼ぶ
+uint8_t TraceRecorder::taskId() {
+  TaskHandle_t self = xTaskGetCurrentTaskHandle();
+  for (uint8_t i = 0; i < task_count; i++) {
+    if (tasks[i] == self) return i;
+  }
+  if (task_count >= TRACE_MAX_TASKS) return TRACE_MAX_TASKS - 1;  // 溢れたら最後の番号にまとめる
+  uint8_t id = task_count++;
+  tasks[id] = self;
+  strncpy(task_names[id], pcTaskGetName(self), TRACE_NAME_LEN - 1);
+  return id;
+}
+
+void TraceRecorder::record(TracePhase phase, TraceEvent event, uint8_t arg) {
+  if (!enabled || !ring) return;
+  portENTER_CRITICAL(&trace_lock);
+  if (!dumping) {
+    TraceRecord& r = ring[head];
+    r.ts_us = (uint32_t)esp_timer_get_time();
+    r.phase = phase;
+    r.task = taskId();
+    r.event = event;
+    r.arg = arg;
+    head = (head + 1) % capacity;
+    if (count < capacity) {
+      count++;
+    } else {
+      overwritten++;
+    }
+    recorded++;
+  }
+  portEXIT_CRITICAL(&trace_lock);
+}
+
+void TraceRecorder::clear() {
+  portENTER_CRITICAL(&trace_lock);
+  head = 0;
+  count = 0;
+  recorded = 0;
+  overwritten = 0;
+  portEXIT_CRITICAL(&trace_lock);
+}
+
+size_t TraceRecorder::beginDump() {
+  portENTER_CRITICAL(&trace_lock);
+  dumping = true;
+  dump_count = count;
+  dump_first = capacity ? (head + capacity - count) % capacity : 0;
+  dump_lost = overwritten;
+  portEXIT_CRITICAL(&trace_lock);
+  return 16 + 1 + TRACE_MAX_TASKS * TRACE_NAME_LEN + 1 + TRACE_EVENT_COUNT * TRACE_NAME_LEN +
+         dump_count * sizeof(TraceRecord);
+}
+
+bool TraceRecorder::dump(TraceWriter write, void* user) {
+  if (!ring) {
+    dumping = false;
+    return false;
+  }
+  if (!dumping) beginDump();
+
+  // beginDump() で止めた時点のリングをそのまま送る（タスク表は未使用分も固定長で送り、サイズを合わせる）
+  uint32_t n = dump_count;
+  uint32_t first = dump_first;
+  uint32_t lost = dump_lost;
+
+  uint8_t header[16];
+  memcpy(header, "STKT", 4);
+  uint16_t version = TRACE_DUMP_VERSION;
+  uint16_t record_size = sizeof(TraceRecord);
+  memcpy(header + 4, &version, 2);
+  memcpy(header + 6, &record_size, 2);
+  memcpy(header + 8, &n, 4);
+  memcpy(header + 12, &lost, 4);
+  bool ok = write(header, sizeof(header), user);
+
+  uint8_t table_count = TRACE_MAX_TASKS;
+  ok = ok && write(&table_count, 1, user);
+  ok = ok && write((const uint8_t*)task_names, sizeof(task_names), user);
+
+  table_count = TRACE_EVENT_COUNT;
+  ok = ok && write(&table_count, 1, user);
+  char name[TRACE_NAME_LEN];
+  for (int i = 0; ok && i < TRACE_EVENT_COUNT; i++) {
+    memset(name, 0, sizeof(name));
+    strncpy(name, eventName((TraceEvent)i), TRACE_NAME_LEN - 1);
+    ok = write((const uint8_t*)name, sizeof(name), user);
+  }
+
+  // リングの折り返しをまたがないよう分けて送る
+  uint32_t sent = 0;
+  while (ok && sent < n) {
+    uint32_t index = (first + sent) % capacity;
+    uint32_t chunk = n - sent;
+    if (chunk > TRACE_DUMP_CHUNK_RECORDS) chunk = TRACE_DUMP_CHUNK_RECORDS;
+    if (chunk > capacity - index) chunk = capacity - index;
+    ok = write((const uint8_t*)&ring[index], chunk * sizeof(TraceRecord), user);
+    sent += chunk;
+  }
+
+  dumping = false;
+  return ok;
+}
+
+TraceStats TraceRecorder::getStats() const {
+  TraceStats s;
+  portENTER_CRITICAL(&trace_lock);
+  s.enabled = enabled;
+  s.capacity = capacity;
+  s.count = count;
+  s.recorded = recorded;
+  s.overwritten = overwritten;
+  s.tasks = task_count;
+  portEXIT_CRITICAL(&trace_lock);
+  return s;
+}
+
+const char* TraceRecorder::eventName(TraceEvent event) {
+  switch (event) {
+    case TRACE_FRAME:          return "frame";
+    case TRACE_HTTP_REQUEST:   return "http_request";
+    case TRACE_TIMERS:         return "timers";
+    case TRACE_WIFI_CONNECT:   return "wifi_connect";
+    case TRACE_WIFI_LOST:      return "wifi_lost";
+    case TRACE_MODE_SWITCH:    return "mode_switch";
+    case TRACE_BLE_CONNECT:    return "ble_connect";
+    case TRACE_BLE_DISCONNECT: return "ble_disconnect";
+    case TRACE_BLE_WRITE:      return "ble_write";
+    case TRACE_BUTTON:         return "button";
+    case TRACE_SPEECH_SET:     return "speech_set";
+    case TRACE_POWER_LEVEL:    return "power_level";
+    case TRACE_SCREENSHOT:     return "screenshot";
+    default:                   return "unknown";
+  }
+}
+
+#endif
@@ -0,0 +1,135 @@
+/*
+ * Trace Recorder for Stack-chan
+ * 区間の開始・終了と単発イベントをタスク番号付きの8バイトのレコードでRAMのリングに残す
+ * /api/trace でバイナリのまま取り出し、scripts/trace_to_chrome.py で Chrome Trace Event JSON に変換する
+ * TRACE_ENABLED=0 でビルドすると記録コードは完全に消える
+ */
+
+#ifndef TRACE_RECORDER_H
+#define TRACE_RECORDER_H
+
+#include <Arduino.h>
+
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED 1
+#endif
+
+// リングに保持するレコード数（1レコード8バイト）
+#ifndef TRACE_CAPACITY_PSRAM
+#define TRACE_CAPACITY_PSRAM    8192
+#endif
+#ifndef TRACE_CAPACITY_INTERNAL
+#define TRACE_CAPACITY_INTERNAL 1024
+#endif
+
+#define TRACE_MAX_TASKS   12
+#define TRACE_NAME_LEN    16  // タスク名・イベント名の長さ（ダンプでは固定長）
+
+// ダンプ形式（リトルエンディアン）
+//   ヘッダ 16バイト: "STKT", version(u16), record_size(u16), record_count(u32), overwritten(u32)
+//   タスク表: count(u8), 名前 char[16] x count
+//   イベント表: count(u8), 名前 char[16] x count
+//   レコード x record_count（古い順）
+#define TRACE_DUMP_VERSION 1
+
+enum TracePhase {
+  TRACE_PHASE_BEGIN = 'B',
+  TRACE_PHASE_END = 'E',
+  TRACE_PHASE_INSTANT = 'i'
+};
+
+enum TraceEvent {
+  TRACE_FRAME = 0,     // 描画タスク: パーツ描画〜転送
+  TRACE_HTTP_REQUEST,  // 振り分け開始 → handleClient() から戻るまで
+  TRACE_TIMERS,        // タイマーホイールの実行（期限の来たジョブがあるとき）
+  TRACE_WIFI_CONNECT,  // connectToWiFi()
+  TRACE_WIFI_LOST,     // 切断を検知
+  TRACE_MODE_SWITCH,   // WiFi ⟷ BLE 切り替え
+  TRACE_BLE_CONNECT,
+  TRACE_BLE_DISCONNECT,
+  TRACE_BLE_WRITE,     // BLE書き込みの処理（BLEタスク）
+  TRACE_BUTTON,        // arg: 上位4ビットが種類（0=押下 1=長押し 2=離した）、下位4ビットがボタン（0=A 1=B 2=C）
+  TRACE_SPEECH_SET,
+  TRACE_POWER_LEVEL,   // arg: PowerLevel
+  TRACE_SCREENSHOT,
+  TRACE_EVENT_COUNT
+};
+
+struct TraceRecord {
+  uint32_t ts_us;  // esp_timer の下位32ビット（約71分で一周、変換時に補正）
+  uint8_t phase;
+  uint8_t task;
+  uint8_t event;
+  uint8_t arg;
+};
+
+struct TraceStats {
+  bool enabled;
+  uint32_t capacity;
+  uint32_t count;        // リング内のレコード数
+  uint32_t recorded;     // 記録した総数
+  uint32_t overwritten;  // リングが一周して上書きした数
+  uint8_t tasks;
+};
+
+typedef bool (*TraceWriter)(const uint8_t* data, size_t bytes, void* user);
+
+#if TRACE_ENABLED
+
+class TraceRecorder {
+public:
+  TraceRecorder();
+
+  // リングを確保して記録を始める（PSRAM があればそちらに大きく取る）
+  bool begin();
+
+  void record(TracePhase phase, TraceEvent event, uint8_t arg = 0);
+
+  void setEnabled(bool enabled) { this->enabled = enabled; }
+  bool isEnabled() const { return enabled; }
+  void clear();
+
+  // ダンプ中は記録を止める（送信自体がトレースを押し流さないように）
+  // beginDump() で記録を止めてその時点のリングを固定し、出力サイズを返す（Content-Length に使う）
+  // dump() は固定した分だけを送り、終わったら記録を再開する
+  size_t beginDump();
+  bool dump(TraceWriter write, void* user);
+
+  TraceStats getStats() const;
+
+  static const char* eventName(TraceEvent event);
+
+private:
+  TraceRecord* ring;
+  uint32_t capacity;
+  uint32_t head;
+  uint32_t count;
+  uint32_t recorded;
+  uint32_t overwritten;
+  volatile bool enabled;
+  volatile bool dumping;
+  uint32_t dump_first;  // beginDump() で固定したリングの範囲
+  uint32_t dump_count;
+  uint32_t dump_lost;
+  TaskHandle_t tasks[TRACE_MAX_TASKS];
+  char task_names[TRACE_MAX_TASKS][TRACE_NAME_LEN];
+  uint8_t task_count;
+
+  uint8_t taskId();
+};
+
+extern TraceRecorder trace_recorder;
+
+#define TRACE_BEGIN(event)         trace_recorder.record(TRACE_PHASE_BEGIN, event)
+#define TRACE_END(event)           trace_recorder.record(TRACE_PHASE_END, event)
+#define TRACE_INSTANT(event, arg)  trace_recorder.record(TRACE_PHASE_INSTANT, event, arg)
+
+#else
+
+#define TRACE_BEGIN(event)         do {} while (0)
+#define TRACE_END(event)           do {} while (0)
+#define TRACE_INSTANT(event, arg)  do {} while (0)
+
+#endif
+
+#endif
@@ -0,0 +1,205 @@
+/*
+ * ホスト上のテスト用 Arduino の代用品
+ * 時刻は mock_clock.h の時計（実時間に mock::advanceMs() で進めた分を足したもの）
+ * delay() は待たずに時計だけ進めるので、長い待ちを含む処理も一瞬で終わる
+ * GPIO の割り込みは登録するだけで、テストが mock::setPin() でピンを変えると呼ばれる
+ */
+
+#ifndef MOCK_ARDUINO_H
+#define MOCK_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+#include <string>
+#include "mock_clock.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_heap_caps.h"
+#include "esp_system.h"
+
+#define IRAM_ATTR
+#define RTC_NOINIT_ATTR
+#define RTC_DATA_ATTR
+#define PROGMEM
+#define ARDUINO_RUNNING_CORE 1
+
+#define LOW     0
+#define HIGH    1
+#define INPUT        0x01
+#define INPUT_PULLUP 0x05
+#define RISING  0x01
+#define FALLING 0x02
+#define CHANGE  0x03
+#define ONLOW   0x04
+
+namespace mock {
+
+// true にすると Serial の出力を標準出力へ出す（既定は捨てる）
+inline bool& serialEcho() {
+  static bool echo = false;
+  return echo;
+}
+
+}  // namespace mock
+
+inline uint32_t millis() { return (uint32_t)(mock::nowUs() / 1000); }
+inline uint32_t micros() { return (uint32_t)mock::nowUs(); }
+inline void delay(uint32_t ms) { mock::advanceMs(ms); }
+inline void yield() {}
+inline bool psramFound() { return false; }
+inline void* ps_malloc(size_t bytes) { return malloc(bytes); }
+
+// Arduino の String のうち、ホストでビルドするモジュールが使う分だけ
+class String {
+public:
+  String(const char* text = "") : value(text ? text : "") {}
+  String(const std::string& text) : value(text) {}
+  explicit String(char c) : value(1, c) {}
+  explicit String(long v) : value(std::to_string(v)) {}
+  explicit String(unsigned long v) : value(std::to_string(v)) {}
+  explicit String(int v) : value(std::to_string(v)) {}
+  explicit String(unsigned int v) : value(std::to_string(v)) {}
+  explicit String(long long v) : value(std::to_string(v)) {}
+  explicit String(unsigned long long v) : value(std::to_string(v)) {}
+  explicit String(double v, unsigned int decimals = 2) {
+    char text[32];
+    snprintf(text, sizeof(text), "%.*f", decimals, v);
+    value = text;
+  }
+
+  const char* c_str() const { return value.c_str(); }
+  unsigned int length() const { return value.size(); }
+  bool isEmpty() const { return value.empty(); }
+  long toInt() const { return atol(value.c_str()); }
+  float toFloat() const { return atof(value.c_str()); }
+  void reserve(unsigned int bytes) { value.reserve(bytes); }
+  char operator[](unsigned int i) const { return i < value.size() ? value[i] : '\0'; }
+
+  int indexOf(const String& s, unsigned int from = 0) const { return found(value.find(s.value, from)); }
+  int indexOf(const char* s, unsigned int from = 0) const { return found(value.find(s, from)); }
+  int indexOf(char c, unsigned int from = 0) const { return found(value.find(c, from)); }
+  bool startsWith(const String& prefix) const { return value.compare(0, prefix.value.size(), prefix.value) == 0; }
+  bool endsWith(const String& suffix) const {
+    return value.size() >= suffix.value.size() &&
+           value.compare(value.size() - suffix.value.size(), suffix.value.size(), suffix.value) == 0;
+  }
+  String substring(unsigned int from) const { return from < value.size() ? String(value.substr(from)) : String(); }
+  String substring(unsigned int from, unsigned int to) const {
+    if (to > value.size()) to = value.size();
+    return from < to ? String(value.substr(from, to - from)) : String();
+  }
+  void replace(const String& from, const String& to) {
+    if (from.value.empty()) return;
+    for (size_t pos = value.find(from.value); pos != std::string::npos; pos = value.find(from.value, pos + to.value.size())) {
+      value.replace(pos, from.value.size(), to.value);
+    }
+  }
+  void trim() {
+    size_t begin = value.find_first_not_of(" \t\r\n");
+    size_t end = value.find_last_not_of(" \t\r\n");
+    value = begin == std::string::npos ? std::string() : value.substr(begin, end - begin + 1);
+  }
+
+  String& operator+=(const String& other) { value += other.value; return *this; }
+  String& operator+=(const char* other) { value += other; return *this; }
+  String& operator+=(char c) { value += c; return *this; }
+  friend String operator+(const String& a, const String& b) { return String(a.value + b.value); }
+  friend String operator+(const String& a, const char* b) { return String(a.value + b); }
+  friend String operator+(const char* a, const String& b) { return String(a + b.value); }
+  friend String operator+(const String& a, char c) { return String(a.value + c); }
+  bool operator==(const String& other) const { return value == other.value; }
+  bool operator==(const char* other) const { return value == other; }
+  bool operator!=(const String& other) const { return value != other.value; }
+  bool operator!=(const char* other) const { return value != other; }
+
+private:
+  std::string value;
+
+  static int found(size_t pos) { return pos == std::string::npos ? -1 : (int)pos; }
+};
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+inline long random(long max) { return max > 0 ? rand() % max : 0; }
+inline long random(long min, long max) { return max > min ? min + rand() % (max - min) : min; }
+inline void randomSeed(unsigned long seed) { srand(seed); }
+
+// === GPIO ===
+namespace mock {
+
+struct Pin {
+  int level;
+  void (*handler)();
+  int mode;
+};
+
+inline Pin& pin(int number) {
+  static Pin pins[64] = {};
+  static bool initialized = false;
+  if (!initialized) {
+    for (int i = 0; i < 64; i++) pins[i].level = HIGH;
+    initialized = true;
+  }
+  return pins[number & 63];
+}
+
+// ピンの電圧を変え、登録された割り込みの条件に合えば呼ぶ（ボタンは押すと LOW）
+inline void setPin(int number, int level) {
+  Pin& p = pin(number);
+  bool edge = p.level != level;
+  p.level = level;
+  if (!p.handler) return;
+  if ((p.mode == CHANGE && edge) || (p.mode == FALLING && edge && level == LOW) ||
+      (p.mode == RISING && edge && level == HIGH) || (p.mode == ONLOW && level == LOW)) {
+    p.handler();
+  }
+}
+
+}  // namespace mock
+
+inline void pinMode(int pin, int mode) {}
+inline int digitalRead(int pin) { return mock::pin(pin).level; }
+inline int digitalPinToInterrupt(int pin) { return pin; }
+inline void attachInterrupt(int pin, void (*handler)(), int mode) {
+  mock::pin(pin).handler = handler;
+  mock::pin(pin).mode = mode;
+}
+inline void detachInterrupt(int pin) { mock::pin(pin).handler = nullptr; }
+
+inline void setCpuFrequencyMhz(uint32_t mhz) {}
+inline uint32_t getCpuFrequencyMhz() { return 240; }
+
+class MockSerial {
+public:
+  void begin(unsigned long) {}
+  size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+    if (!mock::serialEcho()) return 0;
+    va_list args;
+    va_start(args, format);
+    int n = vprintf(format, args);
+    va_end(args);
+    return n < 0 ? 0 : n;
+  }
+  size_t print(const char* text) {
+    if (!mock::serialEcho()) return 0;
+    fputs(text, stdout);
+    return strlen(text);
+  }
+  size_t println(const char* text = "") { return print(text) + print("\n"); }
+  size_t print(const String& text) { return print(text.c_str()); }
+  size_t println(const String& text) { return println(text.c_str()); }
+  void flush() {}
+  size_t print(long v) { return printf("%ld", v); }
+  size_t println(long v) { return printf("%ld\n", v); }
+};
+
+static MockSerial Serial;
+
+#endif
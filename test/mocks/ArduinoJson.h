@@ -0,0 +1,9 @@
+/*
+ * ホスト上のテスト用 ArduinoJson の代用品
+ * ble_webui.h が取り込むだけで使っていない（JSON は String の連結で作る）ので中身はない
+ */
+
+#ifndef MOCK_ARDUINO_JSON_H
+#define MOCK_ARDUINO_JSON_H
+
+#endif
@@ -0,0 +1,122 @@
+/*
+ * ホスト上のテスト用 M5Stack-Avatar の代用品
+ * ColorPalette は本物と同じく色の名前から RGB565 を引く表で、set() のたびにヒープを使う
+ * Avatar は最後に渡された色と Face を覚えるだけで、init() しても描画タスクは動かさない
+ * （描画タスクの代わりにテストが avatar_commands.drain() を呼ぶ）
+ */
+
+#ifndef MOCK_AVATAR_H
+#define MOCK_AVATAR_H
+
+#include <M5Unified.h>
+#include <map>
+#include <string>
+
+#define COLOR_PRIMARY            "primary"
+#define COLOR_SECONDARY          "secondary"
+#define COLOR_BACKGROUND         "background"
+#define COLOR_BALLOON_FOREGROUND "balloon_foreground"
+#define COLOR_BALLOON_BACKGROUND "balloon_background"
+
+namespace m5avatar {
+
+class ColorPalette {
+public:
+  uint16_t get(const char* key) const {
+    std::map<std::string, uint16_t>::const_iterator it = colors.find(key);
+    return it == colors.end() ? 0 : it->second;
+  }
+  void set(const char* key, uint16_t value) { colors[key] = value; }
+  void clear() { colors.clear(); }
+
+private:
+  std::map<std::string, uint16_t> colors;
+};
+
+enum class Expression { Happy, Angry, Sad, Doubt, Sleepy, Neutral };
+
+class BoundingRect {
+public:
+  BoundingRect(int top, int left) : top(top), left(left), width(0), height(0) {}
+  BoundingRect(int top, int left, int width, int height) : top(top), left(left), width(width), height(height) {}
+  int getTop() const { return top; }
+  int getLeft() const { return left; }
+  int getRight() const { return left + width; }
+  int getBottom() const { return top + height; }
+  int getWidth() const { return width; }
+  int getHeight() const { return height; }
+  int getCenterX() const { return left + width / 2; }
+  int getCenterY() const { return top + height / 2; }
+  void setPosition(int t, int l) {
+    top = t;
+    left = l;
+  }
+
+private:
+  int top;
+  int left;
+  int width;
+  int height;
+};
+
+class DrawContext {
+public:
+  DrawContext(ColorPalette* palette, int color_depth) : palette(palette), color_depth(color_depth) {}
+  Expression getExpression() const { return Expression::Neutral; }
+  float getBreath() const { return 0; }
+  float getEyeOpenRatio() const { return 1; }
+  float getMouthOpenRatio() const { return 0; }
+  ColorPalette* getColorPalette() const { return palette; }
+  int getColorDepth() const { return color_depth; }
+
+private:
+  ColorPalette* palette;
+  int color_depth;
+};
+
+class Drawable {
+public:
+  virtual ~Drawable() {}
+  virtual void draw(M5Canvas* spi, BoundingRect rect, DrawContext* ctx) = 0;
+};
+
+// パーツと位置を持つだけ（描画はしない）
+class Face {
+public:
+  Face(Drawable* mouth, BoundingRect* mouth_pos, Drawable* eye_r, BoundingRect* eye_r_pos, Drawable* eye_l,
+       BoundingRect* eye_l_pos, Drawable* eyebrow_r, BoundingRect* eyebrow_r_pos, Drawable* eyebrow_l,
+       BoundingRect* eyebrow_l_pos, BoundingRect* bounding_rect, M5Canvas* sprite, M5Canvas* tmp_sprite)
+      : mouth(mouth), eye_r(eye_r), eye_l(eye_l), eyebrow_r(eyebrow_r), eyebrow_l(eyebrow_l),
+        bounding_rect(bounding_rect) {}
+  virtual ~Face() {}
+  Drawable* getMouth() const { return mouth; }
+  BoundingRect* getBoundingRect() const { return bounding_rect; }
+
+private:
+  Drawable* mouth;
+  Drawable* eye_r;
+  Drawable* eye_l;
+  Drawable* eyebrow_r;
+  Drawable* eyebrow_l;
+  BoundingRect* bounding_rect;
+};
+
+class Avatar {
+public:
+  Avatar() : face(nullptr), initialized(false) {}
+  void init(int color_depth = 1) { initialized = true; }
+  void setFace(Face* f) { face = f; }
+  Face* getFace() const { return face; }
+  bool isDrawing() const { return initialized; }
+  void setColorPalette(const ColorPalette& palette) { colors = palette; }
+  const ColorPalette& getColorPalette() const { return colors; }
+
+private:
+  ColorPalette colors;
+  Face* face;
+  bool initialized;
+};
+
+}  // namespace m5avatar
+
+#endif
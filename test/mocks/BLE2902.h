@@ -0,0 +1,12 @@
+/*
+ * ホスト上のテスト用 BLE2902（通知の許可の記述子。中身は持たない）
+ */
+
+#ifndef MOCK_BLE2902_H
+#define MOCK_BLE2902_H
+
+#include "BLEDevice.h"
+
+class BLE2902 : public BLEDescriptor {};
+
+#endif
@@ -0,0 +1,200 @@
+/*
+ * ホスト上のテスト用 ESP32 BLE Arduino の代用品
+ * サーバー・サービス・特性を作ったとおりに持つだけで、電波は出さない
+ * テストは mock::bleConnect() / mock::bleWrite() でクライアントの接続・書き込みを起こし、
+ * 通知した値は mock::bleNotified() で読む（コールバックは呼んだタスクでそのまま動く）
+ */
+
+#ifndef MOCK_BLE_DEVICE_H
+#define MOCK_BLE_DEVICE_H
+
+#include <Arduino.h>
+#include <string>
+#include <vector>
+
+typedef enum {
+  ESP_PWR_LVL_N12 = 0,
+  ESP_PWR_LVL_P9 = 7,
+} esp_power_level_t;
+
+class BLEServer;
+class BLECharacteristic;
+
+class BLEServerCallbacks {
+public:
+  virtual ~BLEServerCallbacks() {}
+  virtual void onConnect(BLEServer* server) {}
+  virtual void onDisconnect(BLEServer* server) {}
+};
+
+class BLECharacteristicCallbacks {
+public:
+  virtual ~BLECharacteristicCallbacks() {}
+  virtual void onWrite(BLECharacteristic* characteristic) {}
+};
+
+class BLEDescriptor {
+public:
+  virtual ~BLEDescriptor() {}
+};
+
+class BLECharacteristic {
+public:
+  static const uint32_t PROPERTY_READ = 1 << 0;
+  static const uint32_t PROPERTY_WRITE = 1 << 1;
+  static const uint32_t PROPERTY_NOTIFY = 1 << 2;
+
+  BLECharacteristic(const char* uuid, uint32_t properties)
+      : uuid(uuid), properties(properties), callbacks(nullptr), notifications(0) {}
+
+  std::string getValue() const { return value; }
+  void setValue(const char* text) { value = text; }
+  void setValue(const std::string& text) { value = text; }
+  void setValue(uint8_t* data, size_t bytes) { value.assign((const char*)data, bytes); }
+  void notify() {
+    notified = value;
+    notifications++;
+  }
+  void setCallbacks(BLECharacteristicCallbacks* c) { callbacks = c; }
+  void addDescriptor(BLEDescriptor* descriptor) { descriptors.push_back(descriptor); }
+
+  // === テスト用 ===
+  BLECharacteristicCallbacks* getCallbacks() const { return callbacks; }
+  const std::string& lastNotified() const { return notified; }
+  uint32_t notifyCount() const { return notifications; }
+
+private:
+  std::string uuid;
+  uint32_t properties;
+  std::string value;
+  std::string notified;
+  BLECharacteristicCallbacks* callbacks;
+  std::vector<BLEDescriptor*> descriptors;
+  uint32_t notifications;
+};
+
+class BLEService {
+public:
+  explicit BLEService(const char* uuid) : uuid(uuid), started(false) {}
+  BLECharacteristic* createCharacteristic(const char* c_uuid, uint32_t properties) {
+    characteristics.push_back(new BLECharacteristic(c_uuid, properties));
+    return characteristics.back();
+  }
+  void start() { started = true; }
+
+  // === テスト用 ===
+  BLECharacteristic* characteristic(size_t i) const { return i < characteristics.size() ? characteristics[i] : nullptr; }
+
+private:
+  std::string uuid;
+  bool started;
+  std::vector<BLECharacteristic*> characteristics;
+};
+
+class BLEServer {
+public:
+  BLEServer() : callbacks(nullptr), connected(0) {}
+  void setCallbacks(BLEServerCallbacks* c) { callbacks = c; }
+  BLEService* createService(const char* uuid) {
+    services.push_back(new BLEService(uuid));
+    return services.back();
+  }
+  uint32_t getConnectedCount() const { return connected; }
+
+  // === テスト用 ===
+  BLEServerCallbacks* getCallbacks() const { return callbacks; }
+  BLEService* service(size_t i) const { return i < services.size() ? services[i] : nullptr; }
+  void setConnected(uint32_t n) { connected = n; }
+
+private:
+  BLEServerCallbacks* callbacks;
+  std::vector<BLEService*> services;
+  uint32_t connected;
+};
+
+class BLEAdvertising {
+public:
+  void addServiceUUID(const char* uuid) {}
+  void setScanResponse(bool enable) {}
+  void setMinPreferred(uint16_t interval) {}
+  void setMaxPreferred(uint16_t interval) {}
+};
+
+namespace mock {
+
+struct Ble {
+  bool initialized;
+  bool advertising;
+  uint32_t inits;
+  BLEServer* server;  // 最後に作ったサーバー（deinit() しても残す）
+};
+
+inline Ble& ble() {
+  static Ble b = { false, false, 0, nullptr };
+  return b;
+}
+
+}  // namespace mock
+
+class BLEDevice {
+public:
+  static void init(const std::string& name) {
+    mock::ble().initialized = true;
+    mock::ble().inits++;
+  }
+  static void deinit(bool release_memory = false) {
+    mock::ble().initialized = false;
+    mock::ble().advertising = false;
+  }
+  static void setPower(esp_power_level_t level) {}
+  static BLEServer* createServer() {
+    mock::ble().server = new BLEServer();
+    return mock::ble().server;
+  }
+  static BLEAdvertising* getAdvertising() {
+    static BLEAdvertising advertising;
+    return &advertising;
+  }
+  static void startAdvertising() { mock::ble().advertising = true; }
+  static void stopAdvertising() { mock::ble().advertising = false; }
+};
+
+namespace mock {
+
+// クライアントがつながった・切れた
+inline void bleConnect(bool connected) {
+  BLEServer* server = ble().server;
+  if (!server || !server->getCallbacks()) return;
+  server->setConnected(connected ? 1 : 0);
+  if (connected) {
+    ble().advertising = false;
+    server->getCallbacks()->onConnect(server);
+  } else {
+    server->getCallbacks()->onDisconnect(server);
+  }
+}
+
+// 最初のサービスの最初の特性（ble_webui が作る唯一の特性）
+inline BLECharacteristic* bleCharacteristic() {
+  BLEServer* server = ble().server;
+  BLEService* service = server ? server->service(0) : nullptr;
+  return service ? service->characteristic(0) : nullptr;
+}
+
+// クライアントが特性に text を書き込んだ
+inline void bleWrite(const char* text) {
+  BLECharacteristic* c = bleCharacteristic();
+  if (!c) return;
+  c->setValue(text);
+  if (c->getCallbacks()) c->getCallbacks()->onWrite(c);
+}
+
+// 最後にクライアントへ通知した値
+inline std::string bleNotified() {
+  BLECharacteristic* c = bleCharacteristic();
+  return c ? c->lastNotified() : std::string();
+}
+
+}  // namespace mock
+
+#endif
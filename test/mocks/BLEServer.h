@@ -0,0 +1,10 @@
+/*
+ * ホスト上のテスト用 BLEServer（代用品は BLEDevice.h にまとめてある）
+ */
+
+#ifndef MOCK_BLE_SERVER_H
+#define MOCK_BLE_SERVER_H
+
+#include "BLEDevice.h"
+
+#endif
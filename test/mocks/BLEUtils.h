@@ -0,0 +1,10 @@
+/*
+ * ホスト上のテスト用 BLEUtils（代用品は BLEDevice.h にまとめてある）
+ */
+
+#ifndef MOCK_BLE_UTILS_H
+#define MOCK_BLE_UTILS_H
+
+#include "BLEDevice.h"
+
+#endif
@@ -0,0 +1,111 @@
+/*
+ * ホスト上のテスト用 M5Unified の代用品
+ * 描画（M5Canvas・フォント）は M5GFX のホスト版をそのまま使う
+ * M5 は画面（明るさ）・ボタン・機種を持つ
+ * 機種は既定でタッチボタンの Core2（ボタンは M5.update() で読む）。mock::pressButton() で押したことにする
+ */
+
+#ifndef MOCK_M5UNIFIED_H
+#define MOCK_M5UNIFIED_H
+
+#include <Arduino.h>
+#include <M5GFX.h>
+
+namespace m5 {
+
+enum board_t {
+  board_unknown,
+  board_M5Stack,
+  board_M5StackCore2,
+  board_M5StickC,
+  board_M5StickCPlus,
+  board_M5StackCoreS3,
+  board_M5AtomS3,
+};
+
+// M5.update() の時点で押された・離された・長押しになったかを返す（次の update() まで）
+class Button_Class {
+public:
+  Button_Class() : pressed(false), was_pressed(false), was_released(false), was_hold(false), hold_sent(false),
+                   pending_press(false), pending_release(false), hold_pending(false), pressed_ms(0) {}
+
+  bool isPressed() const { return pressed; }
+  bool wasPressed() const { return was_pressed; }
+  bool wasReleased() const { return was_released; }
+  bool wasHold() const { return was_hold; }
+  bool wasClicked() const { return was_released && !hold_sent; }
+
+  // M5.update() から呼ぶ（押す・離すの予約を反映する）
+  void update(uint32_t now_ms) {
+    was_pressed = was_released = was_hold = false;
+    if (pending_press && !pressed) {
+      pressed = true;
+      was_pressed = true;
+      pressed_ms = now_ms;
+      hold_sent = false;
+      hold_pending = true;
+    } else if (pending_release && pressed) {
+      pressed = false;
+      was_released = true;
+      hold_pending = false;
+    } else if (pressed && hold_pending && now_ms - pressed_ms >= 500) {
+      was_hold = true;
+      hold_sent = true;
+      hold_pending = false;
+    }
+    pending_press = pending_release = false;
+  }
+
+  void press() { pending_press = true; }
+  void release() { pending_release = true; }
+
+private:
+  bool pressed;
+  bool was_pressed;
+  bool was_released;
+  bool was_hold;
+  bool hold_sent;
+  bool pending_press;
+  bool pending_release;
+  bool hold_pending;
+  uint32_t pressed_ms;
+};
+
+class M5Unified {
+public:
+  struct config_t {
+    bool serial_baudrate;
+  };
+
+  M5Unified() : board(board_M5StackCore2) {}
+
+  config_t config() const { return config_t(); }
+  void begin(const config_t& cfg) { Display.init(); }
+  void update() {
+    uint32_t now = millis();
+    BtnA.update(now);
+    BtnB.update(now);
+    BtnC.update(now);
+  }
+  board_t getBoard() const { return board; }
+
+  M5GFX Display;
+  Button_Class BtnA;
+  Button_Class BtnB;
+  Button_Class BtnC;
+  board_t board;  // テストが機種を変える
+};
+
+}  // namespace m5
+
+static m5::M5Unified M5;
+
+namespace mock {
+
+// 次の M5.update() で押した・離したことになる（押している間に update() が 500ms 進めば長押し）
+inline void pressButton(m5::Button_Class& button) { button.press(); }
+inline void releaseButton(m5::Button_Class& button) { button.release(); }
+
+}  // namespace mock
+
+#endif
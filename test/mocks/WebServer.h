@@ -0,0 +1,244 @@
+/*
+ * ホスト上のテスト用 WebServer の代用品
+ * ハンドラは本物と同じく登録順（addHandler()・on()）に canHandle() → handle() を調べ、どれも受けなければ onNotFound()
+ * ソケットは開かない。テストが queueRequest() で積んだリクエストを、次の handleClient() が1件ずつ処理する
+ * 最後の応答（コード・種類・本文）は lastResponse() で読める
+ */
+
+#ifndef MOCK_WEBSERVER_H
+#define MOCK_WEBSERVER_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <deque>
+#include <functional>
+#include <string>
+#include <vector>
+
+enum HTTPMethod {
+  HTTP_ANY,
+  HTTP_GET,
+  HTTP_HEAD,
+  HTTP_POST,
+  HTTP_PUT,
+  HTTP_DELETE,
+};
+
+#define CONTENT_LENGTH_UNKNOWN ((size_t)-1)
+#define CONTENT_LENGTH_NOT_SET ((size_t)-2)
+
+class WebServer;
+
+// 接続中のクライアント（リクエストを処理している間だけ connected()）
+class WiFiClient {
+public:
+  WiFiClient(const bool* open = nullptr, std::string* body = nullptr) : open(open), body(body) {}
+  bool connected() const { return open && *open; }
+  IPAddress remoteIP() const { return IPAddress(192, 168, 0, 2); }
+  size_t write(const uint8_t* data, size_t bytes) {
+    if (!connected()) return 0;
+    body->append((const char*)data, bytes);
+    return bytes;
+  }
+
+private:
+  const bool* open;
+  std::string* body;
+};
+
+class RequestHandler {
+public:
+  RequestHandler() : next_handler(nullptr) {}
+  virtual ~RequestHandler() {}
+  virtual bool canHandle(HTTPMethod method, String uri) { return false; }
+  virtual bool handle(WebServer& server, HTTPMethod method, String uri) { return false; }
+
+  RequestHandler* next() const { return next_handler; }
+  void next(RequestHandler* r) { next_handler = r; }
+
+private:
+  RequestHandler* next_handler;
+};
+
+namespace mock {
+
+struct HttpResponse {
+  int code;
+  String content_type;
+  std::string body;
+  size_t content_length;  // setContentLength() で宣言した長さ（CONTENT_LENGTH_NOT_SET: 宣言なし）
+};
+
+}  // namespace mock
+
+class WebServer {
+public:
+  typedef std::function<void(void)> THandlerFunction;
+
+  WebServer(int port = 80) : port(port), first(nullptr), last(nullptr), running(false), open(false), handled_count(0) {
+    response.code = 0;
+    response.content_length = CONTENT_LENGTH_NOT_SET;
+  }
+
+  void begin() { running = true; }
+  void stop() {
+    running = false;
+    pending.clear();
+  }
+
+  void addHandler(RequestHandler* handler) { append(handler); }
+  void on(const char* uri, THandlerFunction fn) { on(uri, HTTP_ANY, fn); }
+  void on(const char* uri, HTTPMethod method, THandlerFunction fn) { append(new FunctionHandler(uri, method, fn)); }
+  void onNotFound(THandlerFunction fn) { not_found = fn; }
+
+  // 積まれたリクエストを1件処理する（本物と同じく1回の呼び出しで1件）
+  void handleClient() {
+    if (!running || pending.empty()) return;
+    std::string url = pending.front();
+    pending.pop_front();
+    parse(url);
+
+    open = true;
+    response.code = 0;
+    response.content_type = "";
+    response.body.clear();
+    response.content_length = CONTENT_LENGTH_NOT_SET;
+    bool handled = false;
+    for (RequestHandler* h = first; h; h = h->next()) {
+      if (h->canHandle(HTTP_GET, current_uri) && h->handle(*this, HTTP_GET, current_uri)) {
+        handled = true;
+        break;
+      }
+    }
+    if (!handled) {
+      if (not_found) {
+        not_found();
+      } else {
+        send(404, "text/plain", String("Not found: ") + current_uri);
+      }
+    }
+    open = false;
+    handled_count++;
+  }
+
+  void send(int code, const char* content_type, const String& content) {
+    response.code = code;
+    response.content_type = content_type ? content_type : "";
+    response.body += content.c_str();
+  }
+  void send(int code, const char* content_type = nullptr, const char* content = "") {
+    send(code, content_type, String(content));
+  }
+  void setContentLength(size_t length) { response.content_length = length; }
+  void sendHeader(const String& name, const String& value, bool first = false) {}
+  void sendContent(const String& content) { response.body += content.c_str(); }
+  void sendContent(const char* content, size_t length) { response.body.append(content, length); }
+  void sendContent_P(const char* content, size_t length) { sendContent(content, length); }
+
+  String uri() const { return current_uri; }
+  HTTPMethod method() const { return HTTP_GET; }
+  int args() const { return arg_names.size(); }
+  String argName(int i) const { return i < args() ? arg_names[i] : String(); }
+  String arg(int i) const { return i < args() ? arg_values[i] : String(); }
+  String arg(const String& name) const {
+    for (size_t i = 0; i < arg_names.size(); i++) {
+      if (arg_names[i] == name) return arg_values[i];
+    }
+    return String();
+  }
+  bool hasArg(const String& name) const {
+    for (size_t i = 0; i < arg_names.size(); i++) {
+      if (arg_names[i] == name) return true;
+    }
+    return false;
+  }
+  WiFiClient client() { return WiFiClient(&open, &response.body); }
+
+  // === テスト用 ===
+  void queueRequest(const char* url) { pending.push_back(url); }
+  size_t pendingRequests() const { return pending.size(); }
+  const mock::HttpResponse& lastResponse() const { return response; }
+  uint32_t handledRequests() const { return handled_count; }
+
+private:
+  class FunctionHandler : public RequestHandler {
+  public:
+    FunctionHandler(const char* uri, HTTPMethod method, THandlerFunction fn) : uri(uri), method(method), fn(fn) {}
+    bool canHandle(HTTPMethod m, String u) override { return (method == HTTP_ANY || method == m) && u == uri; }
+    bool handle(WebServer& server, HTTPMethod m, String u) override {
+      if (!canHandle(m, u)) return false;
+      fn();
+      return true;
+    }
+
+  private:
+    String uri;
+    HTTPMethod method;
+    THandlerFunction fn;
+  };
+
+  void append(RequestHandler* handler) {
+    if (last) {
+      last->next(handler);
+    } else {
+      first = handler;
+    }
+    last = handler;
+  }
+
+  static int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+  }
+
+  // %XX と + を戻す（本物の urlDecode() と同じ）
+  static String decode(const std::string& text) {
+    std::string out;
+    for (size_t i = 0; i < text.size(); i++) {
+      if (text[i] == '+') {
+        out += ' ';
+      } else if (text[i] == '%' && i + 2 < text.size() && hexValue(text[i + 1]) >= 0 && hexValue(text[i + 2]) >= 0) {
+        out += (char)(hexValue(text[i + 1]) * 16 + hexValue(text[i + 2]));
+        i += 2;
+      } else {
+        out += text[i];
+      }
+    }
+    return String(out);
+  }
+
+  void parse(const std::string& url) {
+    arg_names.clear();
+    arg_values.clear();
+    size_t query = url.find('?');
+    current_uri = String(url.substr(0, query));
+    if (query == std::string::npos) return;
+    std::string rest = url.substr(query + 1);
+    while (!rest.empty()) {
+      size_t amp = rest.find('&');
+      std::string pair = rest.substr(0, amp);
+      size_t eq = pair.find('=');
+      arg_names.push_back(decode(pair.substr(0, eq)));
+      arg_values.push_back(eq == std::string::npos ? String() : decode(pair.substr(eq + 1)));
+      if (amp == std::string::npos) break;
+      rest = rest.substr(amp + 1);
+    }
+  }
+
+  int port;
+  RequestHandler* first;
+  RequestHandler* last;
+  THandlerFunction not_found;
+  bool running;
+  bool open;
+  uint32_t handled_count;
+  std::deque<std::string> pending;
+  String current_uri;
+  std::vector<String> arg_names;
+  std::vector<String> arg_values;
+  mock::HttpResponse response;
+};
+
+#endif
@@ -0,0 +1,104 @@
+/*
+ * ホスト上のテスト用 WiFi の代用品
+ * 接続先の網はテストが mock::network() で決める（つながるか・つながるまでの時間・電波強度）
+ * begin() から connect_ms 経ち、網が使えれば WL_CONNECTED。網が落ちれば切断になり、戻れば自動で再接続する
+ * 時間は Arduino の代用品の millis()（app_clock を進めても接続の待ちは変わらない）
+ */
+
+#ifndef MOCK_WIFI_H
+#define MOCK_WIFI_H
+
+#include <Arduino.h>
+
+typedef enum {
+  WL_IDLE_STATUS = 0,
+  WL_NO_SSID_AVAIL = 1,
+  WL_SCAN_COMPLETED = 2,
+  WL_CONNECTED = 3,
+  WL_CONNECT_FAILED = 4,
+  WL_CONNECTION_LOST = 5,
+  WL_DISCONNECTED = 6,
+} wl_status_t;
+
+typedef enum {
+  WIFI_OFF = 0,
+  WIFI_STA = 1,
+} wifi_mode_t;
+
+class IPAddress {
+public:
+  IPAddress(uint8_t a = 0, uint8_t b = 0, uint8_t c = 0, uint8_t d = 0) {
+    octets[0] = a;
+    octets[1] = b;
+    octets[2] = c;
+    octets[3] = d;
+  }
+  String toString() const {
+    char text[16];
+    snprintf(text, sizeof(text), "%u.%u.%u.%u", octets[0], octets[1], octets[2], octets[3]);
+    return String(text);
+  }
+
+private:
+  uint8_t octets[4];
+};
+
+namespace mock {
+
+struct Network {
+  const char* ssid;      // つながる SSID（nullptr ならどれでも）
+  bool up;               // false なら接続できず、接続中なら切れる
+  uint32_t connect_ms;   // begin() からつながるまで
+  int rssi;
+  IPAddress ip;
+  uint32_t begins;       // begin() が呼ばれた回数
+};
+
+inline Network& network() {
+  static Network n = { nullptr, true, 3000, -55, IPAddress(192, 168, 0, 10), 0 };
+  return n;
+}
+
+}  // namespace mock
+
+class WiFiClass {
+public:
+  WiFiClass() : begun(false), begin_ms(0) {}
+
+  wl_status_t begin(const char* ssid, const char* password = nullptr) {
+    mock::network().begins++;
+    begun = true;
+    begin_ms = millis();
+    current_ssid = ssid;
+    return status();
+  }
+
+  bool disconnect(bool wifi_off = false) {
+    begun = false;
+    return true;
+  }
+
+  wl_status_t status() const {
+    const mock::Network& n = mock::network();
+    if (!begun) return WL_DISCONNECTED;
+    if (n.ssid && current_ssid != n.ssid) return WL_NO_SSID_AVAIL;
+    if (!n.up || millis() - begin_ms < n.connect_ms) return WL_DISCONNECTED;
+    return WL_CONNECTED;
+  }
+
+  bool isConnected() const { return status() == WL_CONNECTED; }
+  IPAddress localIP() const { return isConnected() ? mock::network().ip : IPAddress(); }
+  String SSID() const { return isConnected() ? current_ssid : String(); }
+  int8_t RSSI() const { return isConnected() ? mock::network().rssi : 0; }
+  bool mode(wifi_mode_t m) { return true; }
+  bool setSleep(bool enable) { return true; }
+
+private:
+  bool begun;
+  uint32_t begin_ms;
+  String current_ssid;
+};
+
+static WiFiClass WiFi;
+
+#endif
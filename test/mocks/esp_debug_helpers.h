@@ -0,0 +1,12 @@
+/*
+ * ホスト上のテスト用 esp_debug_helpers の代用品（バックトレースは出さない）
+ */
+
+#ifndef MOCK_ESP_DEBUG_HELPERS_H
+#define MOCK_ESP_DEBUG_HELPERS_H
+
+#include "esp_err.h"
+
+inline esp_err_t esp_backtrace_print(int depth) { return ESP_OK; }
+
+#endif
@@ -0,0 +1,16 @@
+/*
+ * ホスト上のテスト用 FreeRTOS アイドルフックの代用品（登録するだけで呼ばない）
+ */
+
+#ifndef MOCK_ESP_FREERTOS_HOOKS_H
+#define MOCK_ESP_FREERTOS_HOOKS_H
+
+#include "esp_err.h"
+
+typedef bool (*esp_freertos_idle_cb_t)(void);
+
+inline esp_err_t esp_register_freertos_idle_hook_for_cpu(esp_freertos_idle_cb_t hook, unsigned int cpu) {
+  return ESP_OK;
+}
+
+#endif
@@ -0,0 +1,12 @@
+/*
+ * ホスト上のテスト用 BLE GAP API の代用品（デバイス名の設定だけ）
+ */
+
+#ifndef MOCK_ESP_GAP_BLE_API_H
+#define MOCK_ESP_GAP_BLE_API_H
+
+#include "esp_err.h"
+
+inline esp_err_t esp_ble_gap_set_device_name(const char* name) { return ESP_OK; }
+
+#endif
@@ -0,0 +1,21 @@
+/*
+ * ホスト上のテスト用 heap_caps の代用品（どの指定も malloc で確保する）
+ */
+
+#ifndef MOCK_ESP_HEAP_CAPS_H
+#define MOCK_ESP_HEAP_CAPS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#define MALLOC_CAP_8BIT     (1 << 2)
+#define MALLOC_CAP_DMA      (1 << 3)
+#define MALLOC_CAP_SPIRAM   (1 << 10)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+#define MALLOC_CAP_DEFAULT  (1 << 12)
+
+inline void* heap_caps_malloc(size_t bytes, uint32_t caps) { return malloc(bytes); }
+inline void heap_caps_free(void* p) { free(p); }
+
+#endif
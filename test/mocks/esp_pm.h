@@ -0,0 +1,74 @@
+/*
+ * ホスト上のテスト用 esp_pm の代用品
+ * 電源管理の設定とロックの取得・解放を数えるだけ（CPU周波数・自動ライトスリープは変わらない）
+ */
+
+#ifndef MOCK_ESP_PM_H
+#define MOCK_ESP_PM_H
+
+#include <stdint.h>
+#include "esp_err.h"
+
+typedef enum {
+  ESP_PM_CPU_FREQ_MAX,
+  ESP_PM_APB_FREQ_MAX,
+  ESP_PM_NO_LIGHT_SLEEP,
+} esp_pm_lock_type_t;
+
+struct esp_pm_lock {
+  esp_pm_lock_type_t type;
+  int held;
+};
+typedef esp_pm_lock* esp_pm_lock_handle_t;
+
+typedef struct {
+  int max_freq_mhz;
+  int min_freq_mhz;
+  bool light_sleep_enable;
+} esp_pm_config_esp32_t;
+typedef esp_pm_config_esp32_t esp_pm_config_esp32s3_t;
+
+namespace mock {
+
+struct PowerManagement {
+  bool configured;
+  bool light_sleep_enable;
+  uint32_t acquires;
+  uint32_t releases;
+};
+
+inline PowerManagement& powerManagement() {
+  static PowerManagement pm = {};
+  return pm;
+}
+
+}  // namespace mock
+
+inline esp_err_t esp_pm_lock_create(esp_pm_lock_type_t type, int arg, const char* name, esp_pm_lock_handle_t* out) {
+  esp_pm_lock* lock = new esp_pm_lock();
+  lock->type = type;
+  lock->held = 0;
+  *out = lock;
+  return ESP_OK;
+}
+
+inline esp_err_t esp_pm_lock_acquire(esp_pm_lock_handle_t lock) {
+  lock->held++;
+  mock::powerManagement().acquires++;
+  return ESP_OK;
+}
+
+inline esp_err_t esp_pm_lock_release(esp_pm_lock_handle_t lock) {
+  if (lock->held == 0) return ESP_ERR_INVALID_STATE;
+  lock->held--;
+  mock::powerManagement().releases++;
+  return ESP_OK;
+}
+
+inline esp_err_t esp_pm_configure(const void* config) {
+  mock::powerManagement().configured = true;
+  mock::powerManagement().light_sleep_enable = static_cast<const esp_pm_config_esp32_t*>(config)->light_sleep_enable;
+  return ESP_OK;
+}
+
+#endif
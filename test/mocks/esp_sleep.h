@@ -0,0 +1,12 @@
+/*
+ * ホスト上のテスト用 esp_sleep の代用品（ライトスリープの起床要因を設定したことにするだけ）
+ */
+
+#ifndef MOCK_ESP_SLEEP_H
+#define MOCK_ESP_SLEEP_H
+
+#include "esp_err.h"
+
+inline esp_err_t esp_sleep_enable_gpio_wakeup() { return ESP_OK; }
+
+#endif
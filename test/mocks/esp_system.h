@@ -0,0 +1,47 @@
+/*
+ * ホスト上のテスト用 esp_system の代用品
+ * リセット理由は常に電源投入、ヒープの空きは固定値を返す
+ * esp_restart() は呼ばれた回数を数えるだけ（テストが mock::restarts() で確かめる）
+ */
+
+#ifndef MOCK_ESP_SYSTEM_H
+#define MOCK_ESP_SYSTEM_H
+
+#include <stdint.h>
+
+typedef enum {
+  ESP_RST_UNKNOWN = 0,
+  ESP_RST_POWERON,
+  ESP_RST_EXT,
+  ESP_RST_SW,
+  ESP_RST_PANIC,
+  ESP_RST_INT_WDT,
+  ESP_RST_TASK_WDT,
+  ESP_RST_WDT,
+  ESP_RST_DEEPSLEEP,
+  ESP_RST_BROWNOUT,
+  ESP_RST_SDIO,
+} esp_reset_reason_t;
+
+inline esp_reset_reason_t esp_reset_reason() { return ESP_RST_POWERON; }
+
+namespace mock {
+inline uint32_t& restarts() {
+  static uint32_t count = 0;
+  return count;
+}
+}  // namespace mock
+
+inline void esp_restart() { mock::restarts()++; }
+
+class MockEsp {
+public:
+  uint32_t getFreeHeap() const { return 200 * 1024; }
+  uint32_t getMaxAllocHeap() const { return 100 * 1024; }
+  uint32_t getCpuFreqMHz() const { return 240; }
+  void restart() { esp_restart(); }
+};
+
+static MockEsp ESP;
+
+#endif
@@ -0,0 +1,18 @@
+/*
+ * ホスト上のテスト用タスクウォッチドッグの代用品（登録と餌やりを受け付けるだけで、期限切れにはならない）
+ */
+
+#ifndef MOCK_ESP_TASK_WDT_H
+#define MOCK_ESP_TASK_WDT_H
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+inline esp_err_t esp_task_wdt_init(uint32_t timeout_s, bool panic) { return ESP_OK; }
+inline esp_err_t esp_task_wdt_add(TaskHandle_t task) { return ESP_OK; }
+inline esp_err_t esp_task_wdt_delete(TaskHandle_t task) { return ESP_OK; }
+inline esp_err_t esp_task_wdt_reset() { return ESP_OK; }
+
+#endif
@@ -0,0 +1,74 @@
+/*
+ * ホスト上のテスト用 esp_timer の代用品
+ * esp_timer_get_time() は Arduino の代用品と同じ時計（mock::advanceMs() で進む）
+ * タイマーは作るだけで自動では発火しない（テストが mock::fireTimer() で呼ぶ）
+ */
+
+#ifndef MOCK_ESP_TIMER_H
+#define MOCK_ESP_TIMER_H
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "Arduino.h"
+
+typedef void (*esp_timer_cb_t)(void* arg);
+
+typedef enum {
+  ESP_TIMER_TASK,
+} esp_timer_dispatch_t;
+
+typedef struct {
+  esp_timer_cb_t callback;
+  void* arg;
+  esp_timer_dispatch_t dispatch_method;
+  const char* name;
+  bool skip_unhandled_events;
+} esp_timer_create_args_t;
+
+struct esp_timer {
+  esp_timer_create_args_t args;
+  uint64_t period_us;
+  bool running;
+};
+typedef esp_timer* esp_timer_handle_t;
+
+inline int64_t esp_timer_get_time() { return mock::nowUs(); }
+
+inline esp_err_t esp_timer_create(const esp_timer_create_args_t* args, esp_timer_handle_t* out) {
+  esp_timer* t = new esp_timer();
+  t->args = *args;
+  t->period_us = 0;
+  t->running = false;
+  *out = t;
+  return ESP_OK;
+}
+
+inline esp_err_t esp_timer_start_periodic(esp_timer_handle_t t, uint64_t period_us) {
+  t->period_us = period_us;
+  t->running = true;
+  return ESP_OK;
+}
+
+inline esp_err_t esp_timer_start_once(esp_timer_handle_t t, uint64_t timeout_us) {
+  t->period_us = timeout_us;
+  t->running = true;
+  return ESP_OK;
+}
+
+inline esp_err_t esp_timer_stop(esp_timer_handle_t t) {
+  t->running = false;
+  return ESP_OK;
+}
+
+inline esp_err_t esp_timer_delete(esp_timer_handle_t t) {
+  delete t;
+  return ESP_OK;
+}
+
+namespace mock {
+inline void fireTimer(esp_timer_handle_t t) {
+  if (t && t->running) t->args.callback(t->args.arg);
+}
+}  // namespace mock
+
+#endif
@@ -0,0 +1,50 @@
+/*
+ * ホスト上のテスト用 FreeRTOS の代用品
+ * タスクはスレッド、portMUX はスピンロックとして振る舞う（複数スレッドの試験でもそのまま使える）
+ */
+
+#ifndef MOCK_FREERTOS_H
+#define MOCK_FREERTOS_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdTRUE  1
+#define pdFALSE 0
+#define pdPASS  1
+#define pdFAIL  0
+#define portMAX_DELAY 0xFFFFFFFFUL
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+
+#define configASSERT(x)                                                       \
+  do {                                                                        \
+    if (!(x)) {                                                               \
+      fprintf(stderr, "configASSERT(%s) failed at %s:%d\n", #x, __FILE__, __LINE__); \
+      abort();                                                                \
+    }                                                                         \
+  } while (0)
+
+struct portMUX_TYPE {
+  std::atomic<int> locked;
+};
+#define portMUX_INITIALIZER_UNLOCKED {}
+
+inline void vPortEnterCritical(portMUX_TYPE* mux) {
+  while (mux->locked.exchange(1, std::memory_order_acquire)) {
+  }
+}
+inline void vPortExitCritical(portMUX_TYPE* mux) { mux->locked.store(0, std::memory_order_release); }
+
+#define portENTER_CRITICAL(mux)     vPortEnterCritical(mux)
+#define portEXIT_CRITICAL(mux)      vPortExitCritical(mux)
+#define portENTER_CRITICAL_ISR(mux) vPortEnterCritical(mux)
+#define portEXIT_CRITICAL_ISR(mux)  vPortExitCritical(mux)
+
+#endif
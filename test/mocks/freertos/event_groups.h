@@ -0,0 +1,65 @@
+/*
+ * ホスト上のテスト用 FreeRTOS イベントグループの代用品（mutex と条件変数）
+ * mock::instantWaits() が true なら、揃わないときは期限まで時計を進めて戻る
+ */
+
+#ifndef MOCK_FREERTOS_EVENT_GROUPS_H
+#define MOCK_FREERTOS_EVENT_GROUPS_H
+
+#include "FreeRTOS.h"
+#include "mock_clock.h"
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+typedef uint32_t EventBits_t;
+
+struct MockEventGroup {
+  std::mutex lock;
+  std::condition_variable changed;
+  EventBits_t bits;
+};
+typedef MockEventGroup* EventGroupHandle_t;
+
+inline EventGroupHandle_t xEventGroupCreate() {
+  MockEventGroup* g = new MockEventGroup();
+  g->bits = 0;
+  return g;
+}
+
+inline EventBits_t xEventGroupSetBits(EventGroupHandle_t g, EventBits_t bits) {
+  std::lock_guard<std::mutex> guard(g->lock);
+  g->bits |= bits;
+  g->changed.notify_all();
+  return g->bits;
+}
+
+inline EventBits_t xEventGroupClearBits(EventGroupHandle_t g, EventBits_t bits) {
+  std::lock_guard<std::mutex> guard(g->lock);
+  EventBits_t before = g->bits;
+  g->bits &= ~bits;
+  return before;
+}
+
+inline EventBits_t xEventGroupGetBits(EventGroupHandle_t g) {
+  std::lock_guard<std::mutex> guard(g->lock);
+  return g->bits;
+}
+
+inline EventBits_t xEventGroupWaitBits(EventGroupHandle_t g, EventBits_t bits, BaseType_t clear_on_exit,
+                                       BaseType_t wait_for_all, TickType_t ticks) {
+  std::unique_lock<std::mutex> guard(g->lock);
+  auto ready = [&] { return wait_for_all ? (g->bits & bits) == bits : (g->bits & bits) != 0; };
+  if (ticks == portMAX_DELAY) {
+    g->changed.wait(guard, ready);
+  } else if (mock::instantWaits()) {
+    if (!ready()) mock::advanceMs(ticks * portTICK_PERIOD_MS);
+  } else {
+    g->changed.wait_for(guard, std::chrono::milliseconds(ticks), ready);
+  }
+  EventBits_t result = g->bits;
+  if (ready() && clear_on_exit) g->bits &= ~bits;
+  return result;
+}
+
+#endif
@@ -0,0 +1,59 @@
+/*
+ * ホスト上のテスト用 FreeRTOS キューの代用品（固定長の要素を mutex で守るリングバッファ）
+ * 期限つきで待つ使い方はしないので、満杯・空ならすぐ失敗を返す
+ */
+
+#ifndef MOCK_FREERTOS_QUEUE_H
+#define MOCK_FREERTOS_QUEUE_H
+
+#include "FreeRTOS.h"
+#include <mutex>
+#include <string.h>
+
+struct MockQueue {
+  std::mutex lock;
+  uint8_t* items;
+  UBaseType_t length;
+  UBaseType_t item_size;
+  UBaseType_t head;
+  UBaseType_t count;
+};
+typedef MockQueue* QueueHandle_t;
+
+inline QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size) {
+  MockQueue* q = new MockQueue();
+  q->items = new uint8_t[length * item_size];
+  q->length = length;
+  q->item_size = item_size;
+  q->head = 0;
+  q->count = 0;
+  return q;
+}
+
+inline BaseType_t xQueueSend(QueueHandle_t q, const void* item, TickType_t ticks) {
+  std::lock_guard<std::mutex> guard(q->lock);
+  if (q->count >= q->length) return pdFALSE;
+  memcpy(q->items + ((q->head + q->count) % q->length) * q->item_size, item, q->item_size);
+  q->count++;
+  return pdTRUE;
+}
+
+inline BaseType_t xQueueSendFromISR(QueueHandle_t q, const void* item, BaseType_t* woken) {
+  return xQueueSend(q, item, 0);
+}
+
+inline BaseType_t xQueueReceive(QueueHandle_t q, void* item, TickType_t ticks) {
+  std::lock_guard<std::mutex> guard(q->lock);
+  if (q->count == 0) return pdFALSE;
+  memcpy(item, q->items + q->head * q->item_size, q->item_size);
+  q->head = (q->head + 1) % q->length;
+  q->count--;
+  return pdTRUE;
+}
+
+inline UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q) {
+  std::lock_guard<std::mutex> guard(q->lock);
+  return q->count;
+}
+
+#endif
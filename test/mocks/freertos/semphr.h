@@ -0,0 +1,55 @@
+/*
+ * ホスト上のテスト用 FreeRTOS セマフォの代用品（mutex と条件変数による計数セマフォ）
+ * mock::instantWaits() が true なら、取れないときは期限まで時計を進めて戻る
+ */
+
+#ifndef MOCK_FREERTOS_SEMPHR_H
+#define MOCK_FREERTOS_SEMPHR_H
+
+#include "FreeRTOS.h"
+#include "mock_clock.h"
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+struct MockSemaphore {
+  std::mutex lock;
+  std::condition_variable changed;
+  UBaseType_t count;
+  UBaseType_t max_count;
+};
+typedef MockSemaphore* SemaphoreHandle_t;
+
+inline SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max_count, UBaseType_t initial) {
+  MockSemaphore* s = new MockSemaphore();
+  s->count = initial;
+  s->max_count = max_count;
+  return s;
+}
+inline SemaphoreHandle_t xSemaphoreCreateBinary() { return xSemaphoreCreateCounting(1, 0); }
+inline SemaphoreHandle_t xSemaphoreCreateMutex() { return xSemaphoreCreateCounting(1, 1); }
+inline void vSemaphoreDelete(SemaphoreHandle_t s) { delete s; }
+
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t s, TickType_t ticks) {
+  std::unique_lock<std::mutex> guard(s->lock);
+  if (ticks == portMAX_DELAY) {
+    s->changed.wait(guard, [s] { return s->count > 0; });
+  } else if (mock::instantWaits() && s->count == 0) {
+    mock::advanceMs(ticks * portTICK_PERIOD_MS);
+    return pdFALSE;
+  } else if (!s->changed.wait_for(guard, std::chrono::milliseconds(ticks), [s] { return s->count > 0; })) {
+    return pdFALSE;
+  }
+  s->count--;
+  return pdTRUE;
+}
+
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t s) {
+  std::lock_guard<std::mutex> guard(s->lock);
+  if (s->count >= s->max_count) return pdFALSE;
+  s->count++;
+  s->changed.notify_one();
+  return pdTRUE;
+}
+
+#endif
@@ -0,0 +1,71 @@
+/*
+ * ホスト上のテスト用 FreeRTOS タスク API の代用品
+ * タスクハンドルはスレッドごとに異なる値になる
+ * mock::runTasks() が false ならタスクは作るだけで動かさない（ハンドルは渡す）
+ * mock::instantWaits() が true なら期限つきの待ちは時計を進めてすぐ戻る
+ */
+
+#ifndef MOCK_FREERTOS_TASK_H
+#define MOCK_FREERTOS_TASK_H
+
+#include "FreeRTOS.h"
+#include "mock_clock.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+typedef void* TaskHandle_t;
+typedef void (*TaskFunction_t)(void* arg);
+
+inline TaskHandle_t xTaskGetCurrentTaskHandle() {
+  static thread_local char tag;
+  return &tag;
+}
+
+inline const char* pcTaskGetName(TaskHandle_t task) {
+  return task == xTaskGetCurrentTaskHandle() ? "host" : "other";
+}
+
+// タスクは切り離したスレッドとして動かす（handle にはそのスレッドのタスクハンドルが入る）
+inline BaseType_t xTaskCreatePinnedToCore(TaskFunction_t task, const char* name, uint32_t stack_bytes, void* arg,
+                                          UBaseType_t priority, TaskHandle_t* handle, BaseType_t core) {
+  if (!mock::runTasks()) {
+    static char parked[16];
+    static int parked_count = 0;
+    if (handle) *handle = &parked[parked_count++ & 15];
+    return pdPASS;
+  }
+  std::atomic<TaskHandle_t> started(nullptr);
+  std::thread([task, arg, &started] {
+    started.store(xTaskGetCurrentTaskHandle());
+    task(arg);
+  }).detach();
+  while (!started.load()) std::this_thread::yield();
+  if (handle) *handle = started.load();
+  return pdPASS;
+}
+
+inline void vTaskDelay(TickType_t ticks) {
+  if (mock::instantWaits()) {
+    mock::advanceMs(ticks * portTICK_PERIOD_MS);
+  } else if (ticks == 0) {
+    std::this_thread::yield();
+  } else {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks * portTICK_PERIOD_MS));
+  }
+}
+
+inline TickType_t xTaskGetTickCount() {
+  return (TickType_t)(mock::nowUs() / 1000 / portTICK_PERIOD_MS);
+}
+
+// タスク通知は数えない（通知で眠るタスク＝ボタンの読み取りはホストでは動かさない前提で、期限まで待って戻る）
+inline void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* woken) {}
+inline BaseType_t xTaskNotifyGive(TaskHandle_t task) { return pdPASS; }
+inline uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks) {
+  if (ticks != portMAX_DELAY) vTaskDelay(ticks);
+  return 0;
+}
+#define portYIELD_FROM_ISR()
+
+#endif
@@ -0,0 +1,19 @@
+/*
+ * ホスト上のテスト用 lwIP ソケットの代用品（ホストの BSD ソケットをそのまま使う）
+ */
+
+#ifndef MOCK_LWIP_SOCKETS_H
+#define MOCK_LWIP_SOCKETS_H
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define LWIP_SOCKET_OFFSET 0
+#ifndef CONFIG_LWIP_MAX_SOCKETS
+#define CONFIG_LWIP_MAX_SOCKETS 16
+#endif
+
+#endif
@@ -0,0 +1,43 @@
+/*
+ * ホスト上のテスト用の時計とスケジューラの設定
+ * 時刻は実時間（steady_clock）に mock::advanceMs() で進めた分を足したもの
+ * 1日分の動作を回すテストは、タスクを動かさず（loop() だけを回す）、期限つきの待ちを時計を進めて済ませる
+ */
+
+#ifndef MOCK_CLOCK_H
+#define MOCK_CLOCK_H
+
+#include <stdint.h>
+#include <chrono>
+
+namespace mock {
+
+inline int64_t& clockOffsetUs() {
+  static int64_t offset = 0;
+  return offset;
+}
+
+inline int64_t nowUs() {
+  static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  int64_t real = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+  return real + clockOffsetUs();
+}
+
+inline void advanceUs(int64_t us) { clockOffsetUs() += us; }
+inline void advanceMs(uint32_t ms) { advanceUs((int64_t)ms * 1000); }
+
+// false にすると xTaskCreatePinnedToCore() はタスクを作ったことにするだけで動かさない
+inline bool& runTasks() {
+  static bool run = true;
+  return run;
+}
+
+// true にすると期限つきの待ち（vTaskDelay・セマフォ・イベントグループ）は、待つ代わりに時計を進めてすぐ戻る
+inline bool& instantWaits() {
+  static bool instant = false;
+  return instant;
+}
+
+}  // namespace mock
+
+#endif
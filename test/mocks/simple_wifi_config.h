@@ -0,0 +1,33 @@
+/*
+ * ホスト上のテスト用 WiFi・セリフ設定
+ * src/simple_wifi_config.h がない環境（リポジトリには含めない）で main.cpp を取り込むテストが使う
+ * 接続先は WiFi の代用品（mock::network()）がつなぐので、SSID・パスワードは何でもよい
+ */
+
+#ifndef SIMPLE_WIFI_CONFIG_H
+#define SIMPLE_WIFI_CONFIG_H
+
+struct WiFiCredentials {
+  const char* ssid;
+  const char* password;
+  int priority;
+};
+
+const WiFiCredentials wifi_networks[] = {
+  {"home", "password", 1},
+  {"spare", "password", 2},
+  {nullptr, nullptr, 0}  // 終端マーカー
+};
+
+#define CONNECTION_TIMEOUT 10000      // 1つのネットワークの接続待ち（ms）
+#define WEBSERVER_PORT 80
+#define SPEECH_AUTO_CLEAR_TIME 30000  // セリフの自動クリア・ランダムセリフの間隔（ms）
+
+const char* random_speeches[] = {
+  "こんにちは",
+  "いい天気だね",
+  "スタックチャンだよ",
+  nullptr  // 終端マーカー
+};
+
+#endif
@@ -0,0 +1,172 @@
+/*
+ * Seqlock と AppStateStore のホスト上のテスト
+ * 書き込み1つ・読み出し複数のスレッドで数百万回読み書きし、書きかけの値を受け取らないことを確かめる
+ * 他のタスクから読んでも書いた値と版数がそろって見え、表情を進めた回数が失われないことを確かめる
+ */
+
+#include <unity.h>
+#include <atomic>
+#include <thread>
+#include <signal.h>
+#include <sys/wait.h>
+#include "loop_events.cpp"
+#include "app_state.cpp"
+
+#define STRESS_WRITES 1000000
+#define STRESS_READERS 3
+#define CYCLES 10001
+
+// 状態の変化を数えるだけの購読者
+static std::atomic<uint32_t> expression_events(0);
+static void onStateCount(const StateEvent& event) {
+  expression_events.fetch_add(1, std::memory_order_relaxed);
+}
+
+static const EventSubscriber<StateEvent> state_subscribers[] = {
+  { "count", EVENT_BIT(APP_FIELD_EXPRESSION), onStateCount },
+};
+const EventBus<StateEvent> state_bus(state_subscribers);
+
+// 全部の語が同じ値なら揃っている（書きかけなら前後の版が混ざる）
+struct Payload {
+  uint32_t words[64];
+};
+
+void setUp() {
+  expression_events.store(0);
+}
+
+void tearDown() {}
+
+static void test_seqlock_stress() {
+  static Seqlock<Payload> lock;
+  std::atomic<bool> done(false);
+  std::atomic<uint32_t> torn(0);
+  std::atomic<uint32_t> backwards(0);
+  std::atomic<uint32_t> reads(0);
+
+  std::thread readers[STRESS_READERS];
+  for (int r = 0; r < STRESS_READERS; r++) {
+    readers[r] = std::thread([&] {
+      Payload p;
+      uint32_t last = 0;
+      while (!done.load(std::memory_order_relaxed)) {
+        lock.read(p);
+        for (int i = 1; i < 64; i++) {
+          if (p.words[i] != p.words[0]) {
+            torn.fetch_add(1);
+            break;
+          }
+        }
+        if (p.words[0] < last) backwards.fetch_add(1);
+        last = p.words[0];
+        reads.fetch_add(1, std::memory_order_relaxed);
+      }
+    });
+  }
+
+  Payload p;
+  for (uint32_t v = 1; v <= STRESS_WRITES; v++) {
+    for (int i = 0; i < 64; i++) p.words[i] = v;
+    lock.write(p);
+  }
+  done.store(true);
+  for (int r = 0; r < STRESS_READERS; r++) readers[r].join();
+
+  TEST_ASSERT_EQUAL_UINT32(0, torn.load());
+  TEST_ASSERT_EQUAL_UINT32(0, backwards.load());
+  TEST_ASSERT_GREATER_THAN(0, reads.load());
+  TEST_ASSERT_EQUAL_UINT32(STRESS_WRITES * 2, lock.sequence());
+  lock.read(p);
+  TEST_ASSERT_EQUAL_UINT32(STRESS_WRITES, p.words[63]);
+}
+
+// 書いた値は他のタスクの snapshot() からすぐ見え、版数は最後の通し番号になる
+static void test_snapshot_from_other_task() {
+  AppStateStore* store = new AppStateStore();
+  store->begin();
+  store->setMessage("from loop");
+  store->setExpression(3);
+
+  AppState state;
+  std::thread reader([store, &state] { store->snapshot(state); });
+  reader.join();
+  TEST_ASSERT_EQUAL_STRING("from loop", state.message);
+  TEST_ASSERT_EQUAL_INT(3, state.expression);
+  TEST_ASSERT_EQUAL_UINT32(store->version(), state.version);
+
+  AppStateStats stats = store->getStats();
+  TEST_ASSERT_EQUAL_UINT32(2, stats.writes);
+  delete store;
+}
+
+// 読み出しと重なっても、表情は進めた回数どおりになり、版数は戻らない
+static void test_cycle_expression_while_reading() {
+  AppStateStore* store = new AppStateStore();
+  store->begin();
+  std::atomic<bool> done(false);
+  std::atomic<uint32_t> bad(0);
+  std::thread readers[STRESS_READERS];
+  for (int r = 0; r < STRESS_READERS; r++) {
+    readers[r] = std::thread([store, &done, &bad] {
+      uint32_t last = 0;
+      while (!done.load(std::memory_order_relaxed)) {
+        AppState state = store->snapshot();
+        if (state.expression < 0 || state.expression >= FACE_EXPRESSION_COUNT || state.version < last) {
+          bad.fetch_add(1);
+        }
+        last = state.version;
+      }
+    });
+  }
+  for (int i = 0; i < CYCLES; i++) store->cycleExpression();
+  done.store(true);
+  for (int r = 0; r < STRESS_READERS; r++) readers[r].join();
+
+  TEST_ASSERT_EQUAL_UINT32(0, bad.load());
+  TEST_ASSERT_EQUAL_INT(CYCLES % FACE_EXPRESSION_COUNT, store->snapshot().expression);
+  TEST_ASSERT_EQUAL_UINT32(CYCLES, expression_events.load());
+  delete store;
+}
+
+// 登録していないタスクが書いたり、2つ目のタスクが書き手として登録しようとすると止まる
+static void expectAbort(void (*body)()) {
+  pid_t pid = fork();
+  if (pid == 0) {
+    fclose(stderr);
+    body();
+    _exit(0);
+  }
+  int status = 0;
+  waitpid(pid, &status, 0);
+  TEST_ASSERT_TRUE(WIFSIGNALED(status));
+  TEST_ASSERT_EQUAL_INT(SIGABRT, WTERMSIG(status));
+}
+
+static void writeFromUnregisteredTask() {
+  static AppStateStore store;
+  store.begin();
+  std::thread other([] { store.setMessage("x"); });
+  other.join();
+}
+
+static void registerSecondWriter() {
+  static AppStateStore store;
+  store.begin();
+  std::thread other([] { store.registerWriter(); });
+  other.join();
+}
+
+static void test_unregistered_writer_asserts() {
+  expectAbort(writeFromUnregisteredTask);
+  expectAbort(registerSecondWriter);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_seqlock_stress);
+  RUN_TEST(test_snapshot_from_other_task);
+  RUN_TEST(test_cycle_expression_while_reading);
+  RUN_TEST(test_unregistered_writer_asserts);
+  return UNITY_END();
+}
@@ -0,0 +1,84 @@
+/*
+ * BalloonCache のホスト上のテスト
+ * ヒットは表示が切り替わったときに描き直しを省けた数で、同じ吹き出しが続くフレームは repeats に分ける
+ */
+
+#include <unity.h>
+#include "balloon_cache.cpp"
+
+#define W 64
+#define H 24
+
+static M5Canvas canvas;
+
+void setUp() {
+  canvas.fillSprite((uint16_t)0);
+}
+void tearDown() {}
+
+static BalloonCacheKey keyFor(const char* text) {
+  BalloonCacheKey key;
+  memset(&key, 0, sizeof(key));
+  key.text_hash = balloonTextHash(text);
+  key.foreground = 0x0000;
+  key.background = 0xFFFF;
+  key.color_depth = 16;
+  return key;
+}
+
+// SpeechBalloon::draw() と同じ手順で1フレーム描く（ミスなら text の色で塗って取り込む）
+static void drawFrame(BalloonCache& cache, const char* text, uint16_t color) {
+  BalloonCacheKey key = keyFor(text);
+  if (cache.blit(key, &canvas, 8, 8, W, H)) return;
+  canvas.fillRect(8, 8, W, H, color);
+  cache.store(key, &canvas, 8, 8, W, H);
+}
+
+static void test_same_balloon_frames_are_repeats() {
+  BalloonCache cache;
+  cache.begin(64 * 1024);
+
+  drawFrame(cache, "こんにちは", 0x1111);
+  for (int i = 0; i < 30; i++) drawFrame(cache, "こんにちは", 0x1111);
+  BalloonCacheStats s = cache.getStats();
+  TEST_ASSERT_EQUAL_UINT32(0, s.hits);
+  TEST_ASSERT_EQUAL_UINT32(1, s.misses);
+  TEST_ASSERT_EQUAL_UINT32(30, s.repeats);
+}
+
+// 一度表示したセリフに戻ると、描き直さずにコピーで済みヒットになる
+static void test_reshown_message_is_hit() {
+  BalloonCache cache;
+  cache.begin(64 * 1024);
+
+  drawFrame(cache, "おはよう", 0x1111);
+  drawFrame(cache, "おやすみ", 0x2222);
+  drawFrame(cache, "おはよう", 0x3333);  // ヒットなら 0x1111 のまま
+  drawFrame(cache, "おはよう", 0x3333);
+  BalloonCacheStats s = cache.getStats();
+  TEST_ASSERT_EQUAL_UINT32(1, s.hits);
+  TEST_ASSERT_EQUAL_UINT32(2, s.misses);
+  TEST_ASSERT_EQUAL_UINT32(1, s.repeats);
+  TEST_ASSERT_EQUAL_HEX16(0x1111, canvas.readPixel(8, 8));
+}
+
+// 予算に収まらず取り込めない吹き出しは毎フレーム描き直す（ミス）
+static void test_uncacheable_balloon_misses_every_frame() {
+  BalloonCache cache;
+  cache.begin(16);
+
+  for (int i = 0; i < 5; i++) drawFrame(cache, "長いセリフ", 0x1111);
+  BalloonCacheStats s = cache.getStats();
+  TEST_ASSERT_EQUAL_UINT32(0, s.hits + s.repeats);
+  TEST_ASSERT_EQUAL_UINT32(5, s.misses);
+}
+
+int main(int argc, char** argv) {
+  canvas.setColorDepth(16);
+  canvas.createSprite(96, 48);
+  UNITY_BEGIN();
+  RUN_TEST(test_same_balloon_frames_are_repeats);
+  RUN_TEST(test_reshown_message_is_hit);
+  RUN_TEST(test_uncacheable_balloon_misses_every_frame);
+  return UNITY_END();
+}
@@ -0,0 +1,62 @@
+/*
+ * PaletteBank のホスト上のテスト
+ * カスタムパレット名の切り詰めと、Avatar へ渡す変換済みの色の使い回し
+ */
+
+#include <unity.h>
+#include "color_palettes.cpp"
+
+void setUp() {}
+void tearDown() {}
+
+static PaletteDef colors(uint16_t primary) {
+  PaletteDef def = *palette_bank.get(0);
+  def.primary = primary;
+  return def;
+}
+
+// 長い名前は UTF-8 の文字の途中で切らない
+static void test_long_name_is_cut_on_char_boundary() {
+  PaletteBank bank;
+  // 3バイト文字×8＝24バイト。23バイトに収めると7文字（21バイト）になる
+  TEST_ASSERT_TRUE(bank.setCustom(0, "あいうえおかきく", colors(TFT_RED)));
+  TEST_ASSERT_EQUAL_STRING("あいうえおかき", bank.get(PALETTE_BUILTIN_COUNT)->name);
+
+  // 収まる名前はそのまま
+  TEST_ASSERT_TRUE(bank.setCustom(1, "abcdefghijklmnopqrstuvw", colors(TFT_RED)));
+  TEST_ASSERT_EQUAL_STRING("abcdefghijklmnopqrstuvw", bank.get(PALETTE_BUILTIN_COUNT + 1)->name);
+}
+
+// 変換済みの色は同じものを返し、setCustom() で書き換えると作り直す
+static void test_color_palette_is_cached() {
+  PaletteBank bank;
+  const ColorPalette& builtin = bank.colorPalette(1);
+  TEST_ASSERT_EQUAL_PTR(&builtin, &bank.colorPalette(1));
+  TEST_ASSERT_EQUAL_HEX16(TFT_BLUE, builtin.get(COLOR_BACKGROUND));
+
+  int index = PALETTE_BUILTIN_COUNT + 2;
+  bank.setCustom(2, "夜", colors(TFT_RED));
+  TEST_ASSERT_EQUAL_HEX16(TFT_RED, bank.colorPalette(index).get(COLOR_PRIMARY));
+  bank.setCustom(2, "夜", colors(TFT_GREEN));
+  TEST_ASSERT_EQUAL_HEX16(TFT_GREEN, bank.colorPalette(index).get(COLOR_PRIMARY));
+
+  // 未登録のスロットは標準色
+  TEST_ASSERT_EQUAL_PTR(&bank.colorPalette(0), &bank.colorPalette(PALETTE_BUILTIN_COUNT + 3));
+}
+
+static void test_same_colors_ignores_name() {
+  PaletteDef a = colors(TFT_RED);
+  PaletteDef b = a;
+  b.name = "別名";
+  TEST_ASSERT_TRUE(PaletteBank::sameColors(a, b));
+  b.balloon_background = TFT_BLACK;
+  TEST_ASSERT_FALSE(PaletteBank::sameColors(a, b));
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_long_name_is_cut_on_char_boundary);
+  RUN_TEST(test_color_palette_is_cached);
+  RUN_TEST(test_same_colors_ignores_name);
+  return UNITY_END();
+}
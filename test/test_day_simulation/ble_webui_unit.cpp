@@ -0,0 +1,5 @@
+/*
+ * ble_webui.cpp は main.cpp が上書きする weak の関数を持つので、test_main.cpp とは別の翻訳単位でビルドする
+ */
+
+#include "ble_webui.cpp"
@@ -0,0 +1,275 @@
+/*
+ * 1日分の動作を仮想時間で回すホスト上のテスト
+ * main.cpp をそのまま取り込み、setup() の後は loop() だけを回す（描画タスクの代わりに命令キューを取り出す）
+ * タスクは動かさず、loop() の待ちは時計を進めて済ませるので、24時間分が数秒で終わる
+ * M5・WiFi・WebServer・BLE は test/mocks の代用品で、テストが網の断・ボタン・HTTP・BLE の操作を起こす
+ * 周期処理の回数・セリフの自動クリア・WiFi切断の検知・省電力の段階・/api/clock が通信の待ちに効かないことを確かめる
+ */
+
+#include <unity.h>
+#include <chrono>
+
+// /api/clock はデバッグ用ビルドでだけ登録されるので、このテストでは有効にする
+#define APP_CLOCK_DEBUG_API 1
+#include "main.cpp"
+#include "app_clock.cpp"
+#include "app_state.cpp"
+#include "avatar_commands.cpp"
+#include "balloon_cache.cpp"
+#include "boot_timeline.cpp"
+#include "breadcrumbs.cpp"
+#include "button_input.cpp"
+#include "color_palettes.cpp"
+#include "face_animator.cpp"
+#include "face_parts.cpp"
+#include "frame_renderer.cpp"
+#include "glyph_cache.cpp"
+#include "hud_overlay.cpp"
+#include "idle_governor.cpp"
+#include "loop_events.cpp"
+#include "loop_profiler.cpp"
+#include "palette_fader.cpp"
+#include "power_governor.cpp"
+#include "screen_capture.cpp"
+#include "sleep_manager.cpp"
+#include "sleep_policy.cpp"
+#include "speech_balloon.cpp"
+#include "speech_layout.cpp"
+#include "speech_marquee.cpp"
+#include "stackchan_face.cpp"
+#include "stall_detector.cpp"
+#include "timer_wheel.cpp"
+#include "trace_recorder.cpp"
+
+#define HOUR_MS (60UL * 60 * 1000)
+#define DAY_MS  (24 * HOUR_MS)
+#define MAX_LOOPS_PER_REQUEST 100
+
+static uint32_t loops = 0;
+
+// loop() を1回回し、描画タスクの代わりに命令を反映する（AnimatedMouth::draw() と同じくフレームごとに drain()）
+static void loopOnce() {
+  loop();
+  avatar_commands.drain();
+  loops++;
+}
+
+// 起動からの時間で ms だけ回す
+static void runFor(uint32_t ms) {
+  uint32_t end = app_clock.uptime() + ms;
+  while ((int32_t)(end - app_clock.uptime()) > 0) loopOnce();
+}
+
+// 条件が成り立つまで回す（limit_ms 経っても成り立たなければ false）
+static bool runUntil(bool (*done)(), uint32_t limit_ms) {
+  uint32_t end = app_clock.uptime() + limit_ms;
+  while (!done()) {
+    if ((int32_t)(end - app_clock.uptime()) <= 0) return false;
+    loopOnce();
+  }
+  return true;
+}
+
+// HTTP リクエストを積んで loop() を起こし（networkTask の代わり）、応答するまで回す
+static const mock::HttpResponse& httpGet(const char* url) {
+  uint32_t handled = server.handledRequests();
+  server.queueRequest(url);
+  loop_events.notify(LOOP_EVENT_NETWORK);
+  for (int i = 0; i < MAX_LOOPS_PER_REQUEST && server.handledRequests() == handled; i++) loopOnce();
+  TEST_ASSERT_TRUE(server.handledRequests() != handled);
+  return server.lastResponse();
+}
+
+// 次の M5.update() で押し、離すまで回す
+static void pressButton(m5::Button_Class& button) {
+  mock::pressButton(button);
+  loopOnce();
+  mock::releaseButton(button);
+  loopOnce();
+}
+
+static uint32_t timerRuns(const char* name) {
+  TimerJobStats s;
+  for (int id = 0; id < loop_timers.jobCount(); id++) {
+    if (loop_timers.getStats(id, s) && strcmp(s.name, name) == 0) return s.runs;
+  }
+  return 0;
+}
+
+static long jsonNumber(const std::string& json, const char* key) {
+  std::string needle = std::string("\"") + key + "\":";
+  size_t pos = json.find(needle);
+  TEST_ASSERT_TRUE(pos != std::string::npos);
+  return atol(json.c_str() + pos + needle.size());
+}
+
+static bool wifiConnected() { return app_state.snapshot().wifi_connected; }
+static bool wifiLost() { return !app_state.snapshot().wifi_connected; }
+static bool speechCleared() { return !app_state.snapshot().speech_set_by_user; }
+
+void setUp() {}
+void tearDown() {}
+
+// 網が落ちたまま起動しても、接続は loop() で進み、周期処理の時計を1日進めても接続待ちは打ち切られない
+static void test_boot_wifi_waits_in_uptime() {
+  mock::network().up = false;
+  setup();
+  TEST_ASSERT_TRUE(avatar_initialized);
+  TEST_ASSERT_EQUAL_INT(0, boot_wifi_network);
+
+  // /api/clock?advance の上限と同じだけ進める
+  uint32_t uptime = app_clock.uptime();
+  app_clock.advance(APP_CLOCK_MAX_ADVANCE_MS);
+  loopOnce();
+  TEST_ASSERT_EQUAL_INT(0, boot_wifi_network);
+  TEST_ASSERT_LESS_THAN(CONNECTION_TIMEOUT, app_clock.uptime() - uptime);
+
+  runFor(CONNECTION_TIMEOUT / 2);
+  TEST_ASSERT_EQUAL_INT(0, boot_wifi_network);
+  TEST_ASSERT_EQUAL_UINT32(1, mock::network().begins);
+
+  // 待っている間に網が戻れば、その接続で完了する
+  mock::network().up = true;
+  TEST_ASSERT_TRUE(runUntil(wifiConnected, BOOT_WIFI_POLL_MS * 2));
+  TEST_ASSERT_EQUAL_INT(-1, boot_wifi_network);
+  TEST_ASSERT_EQUAL_STRING("192.168.0.10", app_state.snapshot().ip);
+}
+
+// /api/clock?advance は周期処理の時計だけを進め、稼働時間の表示は変えない
+static void test_clock_endpoint_leaves_uptime() {
+  uint32_t offset = app_clock.offset();
+  const mock::HttpResponse& clock = httpGet("/api/clock?advance=3600000");
+  TEST_ASSERT_EQUAL_INT(200, clock.code);
+  TEST_ASSERT_EQUAL_UINT32(offset + HOUR_MS, app_clock.offset());
+  TEST_ASSERT_EQUAL_INT(400, httpGet("/api/clock?advance=-1").code);
+
+  const mock::HttpResponse& status = httpGet("/api/status");
+  TEST_ASSERT_EQUAL_INT(200, status.code);
+  long uptime_s = jsonNumber(status.body, "uptime");
+  TEST_ASSERT_LESS_OR_EQUAL(1, labs(uptime_s - (long)(app_clock.uptime() / 1000)));
+}
+
+// WebUI で設定したセリフは SPEECH_AUTO_CLEAR_TIME 後にランダムセリフへ戻る
+static void test_speech_auto_clear() {
+  const mock::HttpResponse& set = httpGet("/api/set?speech=%E3%81%8A%E3%81%AF%E3%82%88%E3%81%86&expression=1");
+  TEST_ASSERT_EQUAL_INT(200, set.code);
+  AppState state = app_state.snapshot();
+  TEST_ASSERT_EQUAL_STRING("おはよう", state.message);
+  TEST_ASSERT_EQUAL_INT(1, state.expression);
+  TEST_ASSERT_TRUE(state.speech_set_by_user);
+
+  runFor(SPEECH_AUTO_CLEAR_TIME - 1000);
+  TEST_ASSERT_TRUE(app_state.snapshot().speech_set_by_user);
+  TEST_ASSERT_TRUE(runUntil(speechCleared, 2000 + TIMER_WHEEL_TICK_MS));
+  TEST_ASSERT_FALSE(strcmp("おはよう", app_state.snapshot().message) == 0);
+}
+
+// 網が落ちると WiFi監視（30秒ごと）が気づく。BLE に切り替えて操作し、網が戻ったら WiFi に戻る
+static void test_wifi_drop_and_mode_switch() {
+  mock::network().up = false;
+  uint32_t start = app_clock.uptime();
+  TEST_ASSERT_TRUE(runUntil(wifiLost, 30000 + TIMER_WHEEL_TICK_MS));
+  TEST_ASSERT_LESS_OR_EQUAL(30000 + TIMER_WHEEL_TICK_MS, app_clock.uptime() - start);
+
+  // Bボタン: BLE ペアリングモードへ
+  pressButton(M5.BtnB);
+  TEST_ASSERT_TRUE(app_state.snapshot().connection_mode_ble);
+  TEST_ASSERT_TRUE(mock::ble().advertising);
+
+  // BLE で表情を変える（要求は BLE のコールバックで積まれ、loop() で反映される）
+  mock::bleConnect(true);
+  loopOnce();
+  TEST_ASSERT_TRUE(bleWebUI->isConnected());
+  mock::bleWrite("GET /api/set?expression=3&speech=BLE%20OK HTTP/1.1");
+  TEST_ASSERT_TRUE(mock::bleNotified().find("200") != std::string::npos);
+  loopOnce();
+  AppState state = app_state.snapshot();
+  TEST_ASSERT_EQUAL_INT(3, state.expression);
+  TEST_ASSERT_EQUAL_STRING("BLE OK", state.message);
+  mock::bleConnect(false);
+  loopOnce();
+
+  // 網が戻ってから Bボタン: WiFi へ（接続待ちは loop() の中で進む）
+  mock::network().up = true;
+  pressButton(M5.BtnB);
+  TEST_ASSERT_TRUE(runUntil(wifiConnected, CONNECTION_TIMEOUT));
+  TEST_ASSERT_FALSE(app_state.snapshot().connection_mode_ble);
+  TEST_ASSERT_FALSE(mock::ble().initialized);
+  TEST_ASSERT_EQUAL_INT(200, httpGet("/").code);
+}
+
+// 操作がなければ減光・休止へ進み、ボタンを押せばすぐ戻る
+static void test_idle_sleep_and_button_wake() {
+  runFor(POWER_DIM_AFTER_MS + 1000);
+  TEST_ASSERT_EQUAL_INT(POWER_DIM, power_governor.getGovernor().level());
+  runFor(POWER_SLEEP_AFTER_MS - POWER_DIM_AFTER_MS);
+  TEST_ASSERT_EQUAL_INT(POWER_SLEEP, power_governor.getGovernor().level());
+  TEST_ASSERT_EQUAL_UINT8(POWER_SLEEP_BRIGHTNESS, M5.Display.getBrightness());
+
+  int expression = app_state.snapshot().expression;
+  pressButton(M5.BtnA);
+  TEST_ASSERT_EQUAL_INT(POWER_ACTIVE, power_governor.getGovernor().level());
+  TEST_ASSERT_EQUAL_INT((expression + 1) % FACE_EXPRESSION_COUNT, app_state.snapshot().expression);
+}
+
+// 24時間: 毎時 WebUI からセリフを設定し、3時間ごとにボタンを押す。周期処理の回数と所要時間を見る
+static void test_simulated_day() {
+  uint32_t heartbeat = timerRuns("heartbeat");
+  uint32_t wifi_check = timerRuns("wifi_check");
+  uint32_t hud_heap = timerRuns("hud_heap");
+  uint32_t loops_before = loops;
+  uint32_t requests = server.handledRequests();
+  uint32_t cleared = 0;
+  uint32_t slept = 0;
+  LoopStats loop_before = loop_events.getStats();
+  uint32_t start = app_clock.uptime();
+  std::chrono::steady_clock::time_point wall_start = std::chrono::steady_clock::now();
+
+  for (int hour = 0; hour < 24; hour++) {
+    uint32_t hour_start = start + hour * HOUR_MS;
+    TEST_ASSERT_EQUAL_INT(200, httpGet("/api/set?speech=hello").code);
+    if (runUntil(speechCleared, SPEECH_AUTO_CLEAR_TIME + 2000)) cleared++;
+    if (hour % 3 == 0) pressButton(M5.BtnC);
+    runFor(hour_start + HOUR_MS / 2 - app_clock.uptime());
+    if (power_governor.getGovernor().level() == POWER_SLEEP) slept++;
+    runFor(hour_start + HOUR_MS - app_clock.uptime());
+  }
+
+  double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+  uint32_t simulated_ms = app_clock.uptime() - start;
+  uint32_t day_loops = loops - loops_before;
+  LoopStats loop_after = loop_events.getStats();
+
+  TEST_ASSERT_TRUE(app_state.snapshot().wifi_connected);
+  TEST_ASSERT_EQUAL_UINT32(24, cleared);
+  TEST_ASSERT_EQUAL_UINT32(24, slept);
+  TEST_ASSERT_EQUAL_UINT32(24, server.handledRequests() - requests);
+  // 周期ジョブは起動からの時間どおりに回る（±1回は区切りの端数）
+  TEST_ASSERT_UINT32_WITHIN(1, DAY_MS / 10000, timerRuns("heartbeat") - heartbeat);
+  TEST_ASSERT_UINT32_WITHIN(1, DAY_MS / 30000, timerRuns("wifi_check") - wifi_check);
+  TEST_ASSERT_UINT32_WITHIN(1, DAY_MS / 1000, timerRuns("hud_heap") - hud_heap);
+  TEST_ASSERT_EQUAL_UINT32(0, mock::restarts());
+  // 1日が数秒で終わる（遅いマシンでも実時間の100倍以上）
+  TEST_ASSERT_TRUE(wall_s * 100 < simulated_ms / 1000.0);
+
+  printf("simulated %.1f h in %.2f s wall (x%.0f), %u loop() calls (%.2f us each)\n", simulated_ms / 3600000.0,
+         wall_s, simulated_ms / 1000.0 / wall_s, day_loops, wall_s * 1e6 / day_loops);
+  printf("wakes: timeout %u, network %u, input %u, ble %u\n", loop_after.wakes_timeout - loop_before.wakes_timeout,
+         loop_after.wakes_network - loop_before.wakes_network, loop_after.wakes_input - loop_before.wakes_input,
+         loop_after.wakes_ble - loop_before.wakes_ble);
+}
+
+int main(int argc, char** argv) {
+  // タスクは動かさず、期限つきの待ちは時計を進めて済ませる
+  mock::runTasks() = false;
+  mock::instantWaits() = true;
+
+  UNITY_BEGIN();
+  RUN_TEST(test_boot_wifi_waits_in_uptime);
+  RUN_TEST(test_clock_endpoint_leaves_uptime);
+  RUN_TEST(test_speech_auto_clear);
+  RUN_TEST(test_wifi_drop_and_mode_switch);
+  RUN_TEST(test_idle_sleep_and_button_wake);
+  RUN_TEST(test_simulated_day);
+  return UNITY_END();
+}
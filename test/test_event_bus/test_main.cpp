@@ -0,0 +1,198 @@
+/*
+ * EventBus と AppStateStore の配信のホスト上のテスト
+ * 種類ごとの振り分け・表の順での呼び出し・配信中にヒープを使わないことを確かめる
+ * 描画への命令キューが満杯でも、状態を書いたタスクを待たせない（購読者は積めなかったことだけ記録する）ことを確かめる
+ */
+
+#include <unity.h>
+#include <stdlib.h>
+#include <new>
+#include "loop_events.cpp"
+#include "app_state.cpp"
+#include "avatar_commands.cpp"
+#include "breadcrumbs.cpp"
+#include "loop_profiler.cpp"
+#include "power_governor.cpp"
+#include "app_clock.cpp"
+#include "idle_governor.cpp"
+#include "palette_fader.cpp"
+#include "color_palettes.cpp"
+#include "face_animator.cpp"
+#include "glyph_cache.cpp"
+#include "speech_layout.cpp"
+#include "speech_marquee.cpp"
+#include "balloon_cache.cpp"
+#include "speech_balloon.cpp"
+
+Avatar avatar;
+
+// 配信の間に使ったヒープを数える
+static bool count_allocations = false;
+static uint32_t allocations = 0;
+
+void* operator new(size_t bytes) {
+  if (count_allocations) allocations++;
+  void* p = malloc(bytes ? bytes : 1);
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+
+// 上の operator new は malloc で取るので free で返す（GCC は組み合わせを判別できずに警告する）
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+void operator delete(void* p) noexcept {
+  free(p);
+}
+#pragma GCC diagnostic pop
+
+// === EventBus 単体 ===
+struct TestEvent {
+  uint8_t type;
+};
+
+static char call_log[16];
+static int call_count;
+
+static void onA(const TestEvent& event) { call_log[call_count++] = 'a'; }
+static void onB(const TestEvent& event) { call_log[call_count++] = 'b'; }
+static void onC(const TestEvent& event) { call_log[call_count++] = 'c'; }
+
+static const EventSubscriber<TestEvent> test_subscribers[] = {
+  { "a", EVENT_BIT(0) | EVENT_BIT(1), onA },
+  { "b", EVENT_BIT(1), onB },
+  { "c", EVENT_BIT(0) | EVENT_BIT(1) | EVENT_BIT(31), onC },
+};
+static const EventBus<TestEvent> test_bus(test_subscribers);
+
+// === AppStateStore から配る表（main.cpp の "avatar" と同じく待たずに積む） ===
+static AppStateStore* store = nullptr;
+static bool avatar_resync = false;
+static char seen_message[SPEECH_TEXT_MAX_BYTES];
+static uint32_t seen_version;
+
+static void onStateAvatar(const StateEvent& event) {
+  bool queued;
+  if (event.type == APP_FIELD_EXPRESSION) {
+    queued = avatar_commands.setExpression(event.value, event.arg, false);
+  } else {
+    queued = avatar_commands.setSpeech(event.text, false);
+  }
+  if (!queued) avatar_resync = true;
+}
+
+// 配信の途中で読んだ状態を覚える
+static void onStateProbe(const StateEvent& event) {
+  AppState state;
+  store->snapshot(state);
+  strncpy(seen_message, state.message, sizeof(seen_message) - 1);
+  seen_version = state.version;
+}
+
+static const EventSubscriber<StateEvent> state_subscribers[] = {
+  { "avatar", EVENT_BIT(APP_FIELD_EXPRESSION) | EVENT_BIT(APP_FIELD_MESSAGE), onStateAvatar },
+  { "probe", EVENT_BIT(APP_FIELD_MESSAGE), onStateProbe },
+};
+const EventBus<StateEvent> state_bus(state_subscribers);
+
+void setUp() {
+  call_count = 0;
+  memset(call_log, 0, sizeof(call_log));
+  memset(seen_message, 0, sizeof(seen_message));
+  seen_version = 0;
+  avatar_resync = false;
+  allocations = 0;
+}
+
+void tearDown() {}
+
+static void test_mask_selects_subscribers_in_table_order() {
+  TestEvent event;
+  event.type = 1;
+  TEST_ASSERT_EQUAL_UINT32(3, test_bus.publish(event));
+  TEST_ASSERT_EQUAL_STRING("abc", call_log);
+
+  call_count = 0;
+  memset(call_log, 0, sizeof(call_log));
+  event.type = 0;
+  TEST_ASSERT_EQUAL_UINT32(2, test_bus.publish(event));
+  TEST_ASSERT_EQUAL_STRING("ac", call_log);
+
+  event.type = 31;
+  TEST_ASSERT_EQUAL_UINT32(1, test_bus.publish(event));
+  event.type = 5;
+  TEST_ASSERT_EQUAL_UINT32(0, test_bus.publish(event));
+
+  TEST_ASSERT_EQUAL_UINT32(3, test_bus.subscriberCount());
+  TEST_ASSERT_EQUAL_STRING("b", test_bus.subscriber(1).name);
+}
+
+// 購読者が呼ばれた時点で、書いた変化はもう snapshot() から見える
+static void test_subscriber_sees_new_state() {
+  store->setMessage("hello");
+  TEST_ASSERT_EQUAL_STRING("hello", seen_message);
+  TEST_ASSERT_EQUAL_UINT32(store->version(), seen_version);
+
+  AppStateStats before = store->getStats();
+  store->setMessage("again");
+  store->setSpeaking(true);  // 誰も購読していない
+  AppStateStats after = store->getStats();
+  TEST_ASSERT_EQUAL_UINT32(2, after.events - before.events);
+  TEST_ASSERT_EQUAL_UINT32(2, after.deliveries - before.deliveries);
+  TEST_ASSERT_EQUAL_UINT32(before.dispatch.count + 2, after.dispatch.count);
+  avatar_commands.drain();
+}
+
+// 配信はヒープを使わない（命令キューへ積むところまで含めて）
+static void test_publish_does_not_allocate() {
+  count_allocations = true;
+  for (int i = 0; i < 4; i++) {
+    store->setMessage("no heap");
+    store->cycleExpression();
+    store->setWiFi(i & 1, "192.168.0.10");
+  }
+  count_allocations = false;
+  TEST_ASSERT_EQUAL_UINT32(0, allocations);
+  avatar_commands.drain();
+}
+
+// 命令キューが満杯でも書いたタスクは待たず、積めなかった分は後で最新の状態から積み直せる
+static void test_full_queue_does_not_block_writer() {
+  for (int i = 0; i < AVATAR_COMMAND_DEPTH; i++) store->setExpression(i % FACE_EXPRESSION_COUNT, 0);
+  TEST_ASSERT_FALSE(avatar_resync);
+
+  AvatarCommandStats before = avatar_commands.getStats();
+  uint32_t start = millis();
+  store->setMessage("dropped");
+  store->setExpression(2, 0);
+  uint32_t elapsed = millis() - start;
+  AvatarCommandStats after = avatar_commands.getStats();
+
+  TEST_ASSERT_TRUE(avatar_resync);
+  TEST_ASSERT_EQUAL_UINT32(before.waits, after.waits);
+  TEST_ASSERT_EQUAL_UINT32(before.dropped + 2, after.dropped);
+  TEST_ASSERT_LESS_THAN(AVATAR_COMMAND_WAIT_MS, elapsed);
+  // 状態そのものは書けている
+  TEST_ASSERT_EQUAL_STRING("dropped", store->snapshot().message);
+
+  // 描画タスクが取り出した後、loop() と同じく最新の状態を積み直す
+  avatar_commands.drain();
+  avatar_resync = false;
+  AppState latest = store->snapshot();
+  TEST_ASSERT_TRUE(avatar_commands.setExpression(latest.expression, 0, false));
+  TEST_ASSERT_TRUE(avatar_commands.setSpeech(latest.message, false));
+  avatar_commands.drain();
+  TEST_ASSERT_EQUAL_UINT32(after.applied + AVATAR_COMMAND_DEPTH + 2, avatar_commands.getStats().applied);
+}
+
+int main(int argc, char** argv) {
+  store = &app_state;
+  app_state.begin();
+  avatar_commands.begin();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_mask_selects_subscribers_in_table_order);
+  RUN_TEST(test_subscriber_sees_new_state);
+  RUN_TEST(test_publish_does_not_allocate);
+  RUN_TEST(test_full_queue_does_not_block_writer);
+  return UNITY_END();
+}
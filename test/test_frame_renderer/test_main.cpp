@@ -0,0 +1,268 @@
+/*
+ * FrameRenderer のホスト上のテストとゴールデン画像比較
+ * 実機の /api/render と同じ描画コード（face_parts・SpeechBalloon・GlyphCache）を M5GFX のホスト版で動かし、
+ * 6パレット×4表情のフレームを golden/ の PNG（scripts/golden_frames.py と共通）と1画素ずつ比べる
+ * golden/ に無いフレームは失敗にする。作り直すときは GOLDEN_UPDATE=1 pio test -e native -f test_frame_renderer
+ */
+
+#include <unity.h>
+#include <vector>
+#include <string>
+#include <sys/stat.h>
+#include <zlib.h>
+#include "glyph_cache.cpp"
+#include "speech_layout.cpp"
+#include "speech_marquee.cpp"
+#include "balloon_cache.cpp"
+#include "speech_balloon.cpp"
+#include "face_animator.cpp"
+#include "face_parts.cpp"
+#include "color_palettes.cpp"
+#include "frame_renderer.cpp"
+
+// scripts/golden_frames.py と同じセリフ
+#define GOLDEN_TEXT "こんにちは、スタックチャンです"
+
+typedef std::vector<uint16_t> Frame;
+
+void setUp() {}
+void tearDown() {}
+
+static bool collectBand(const uint8_t* pixels, size_t bytes, int y, int rows, void* user) {
+  Frame* frame = static_cast<Frame*>(user);
+  memcpy(&(*frame)[(size_t)y * FRAME_WIDTH], pixels, bytes);
+  return true;
+}
+
+static Frame renderFrame(int palette, int expression, int band_height) {
+  Frame frame((size_t)FRAME_WIDTH * FRAME_HEIGHT, 0);
+  TEST_ASSERT_TRUE(frame_renderer.begin(DisplayProfile::font(), band_height));
+  frame_renderer.setText(GOLDEN_TEXT);
+  uint32_t us = frame_renderer.render(frameColorsFor(palette_bank.get(palette)),
+                                      FaceAnimator::poseForExpression(expression), collectBand, &frame);
+  frame_renderer.end();
+  TEST_ASSERT_GREATER_THAN(0, us);
+  return frame;
+}
+
+// === PNG（scripts/golden_frames.py と同じ 8bit RGB・フィルタなし） ===
+
+static void put32be(std::string& out, uint32_t v) {
+  out += (char)((v >> 24) & 0xFF);
+  out += (char)((v >> 16) & 0xFF);
+  out += (char)((v >> 8) & 0xFF);
+  out += (char)(v & 0xFF);
+}
+
+static uint32_t get32be(const std::string& in, size_t pos) {
+  return ((uint32_t)(uint8_t)in[pos] << 24) | ((uint32_t)(uint8_t)in[pos + 1] << 16) |
+         ((uint32_t)(uint8_t)in[pos + 2] << 8) | (uint32_t)(uint8_t)in[pos + 3];
+}
+
+static void putChunk(std::string& out, const char* kind, const std::string& body) {
+  put32be(out, body.size());
+  std::string typed = std::string(kind, 4) + body;
+  out += typed;
+  put32be(out, crc32(0, (const Bytef*)typed.data(), typed.size()));
+}
+
+// RGB565 を RGB888 に広げる（golden_frames.py の decode_bmp565 と同じ丸め）
+static std::string frameToRows(const Frame& frame) {
+  std::string raw;
+  raw.reserve((size_t)(FRAME_WIDTH * 3 + 1) * FRAME_HEIGHT);
+  for (int y = 0; y < FRAME_HEIGHT; y++) {
+    raw += '\0';
+    for (int x = 0; x < FRAME_WIDTH; x++) {
+      uint16_t v = frame[(size_t)y * FRAME_WIDTH + x];
+      uint8_t r = (v >> 11) & 0x1F, g = (v >> 5) & 0x3F, b = v & 0x1F;
+      raw += (char)((r << 3) | (r >> 2));
+      raw += (char)((g << 2) | (g >> 4));
+      raw += (char)((b << 3) | (b >> 2));
+    }
+  }
+  return raw;
+}
+
+static std::string encodePng(const Frame& frame) {
+  std::string raw = frameToRows(frame);
+  uLongf packed_size = compressBound(raw.size());
+  std::string packed(packed_size, '\0');
+  TEST_ASSERT_EQUAL_INT(Z_OK, compress2((Bytef*)&packed[0], &packed_size, (const Bytef*)raw.data(), raw.size(), 9));
+  packed.resize(packed_size);
+
+  std::string header;
+  put32be(header, FRAME_WIDTH);
+  put32be(header, FRAME_HEIGHT);
+  header += (char)8;  // 8bit
+  header += (char)2;  // RGB
+  header += std::string(3, '\0');
+
+  std::string out("\x89PNG\r\n\x1a\n", 8);
+  putChunk(out, "IHDR", header);
+  putChunk(out, "IDAT", packed);
+  putChunk(out, "IEND", std::string());
+  return out;
+}
+
+// encodePng で書いたPNGを展開した行データ（各行の先頭にフィルタ種別0）にする
+static bool decodePng(const std::string& png, std::string& raw) {
+  if (png.size() < 8 || png.compare(0, 8, std::string("\x89PNG\r\n\x1a\n", 8)) != 0) return false;
+  std::string idat;
+  uint32_t width = 0, height = 0;
+  size_t pos = 8;
+  while (pos + 12 <= png.size()) {
+    uint32_t length = get32be(png, pos);
+    std::string kind = png.substr(pos + 4, 4);
+    if (pos + 12 + length > png.size()) return false;
+    if (kind == "IHDR") {
+      width = get32be(png, pos + 8);
+      height = get32be(png, pos + 12);
+      if (png[pos + 16] != 8 || png[pos + 17] != 2) return false;
+    } else if (kind == "IDAT") {
+      idat.append(png, pos + 8, length);
+    }
+    pos += 12 + length;
+  }
+  if (width != FRAME_WIDTH || height != FRAME_HEIGHT) return false;
+  uLongf raw_size = (uLongf)(width * 3 + 1) * height;
+  raw.assign(raw_size, '\0');
+  if (uncompress((Bytef*)&raw[0], &raw_size, (const Bytef*)idat.data(), idat.size()) != Z_OK) return false;
+  if (raw_size != raw.size()) return false;
+  for (uint32_t y = 0; y < height; y++) {
+    if (raw[(size_t)y * (width * 3 + 1)] != 0) return false;
+  }
+  return true;
+}
+
+static std::string goldenDir() {
+  std::string file = __FILE__;
+  size_t slash = file.find_last_of("/\\");
+  return (slash == std::string::npos ? std::string(".") : file.substr(0, slash)) + "/golden";
+}
+
+static bool readFile(const std::string& path, std::string& out) {
+  FILE* f = fopen(path.c_str(), "rb");
+  if (!f) return false;
+  char buf[4096];
+  size_t n;
+  out.clear();
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) out.append(buf, n);
+  fclose(f);
+  return true;
+}
+
+static bool writeFile(const std::string& path, const std::string& data) {
+  FILE* f = fopen(path.c_str(), "wb");
+  if (!f) return false;
+  bool ok = fwrite(data.data(), 1, data.size(), f) == data.size();
+  fclose(f);
+  return ok;
+}
+
+// === テスト ===
+
+// 帯の高さを変えても同じフレームになる（帯の境目で描き漏らしがない）
+static void test_band_height_does_not_change_frame() {
+  for (int expression = 0; expression < FACE_EXPRESSION_COUNT; expression++) {
+    Frame banded = renderFrame(1, expression, FRAME_BAND_HEIGHT);
+    Frame whole = renderFrame(1, expression, FRAME_HEIGHT);
+    Frame thin = renderFrame(1, expression, 7);
+    TEST_ASSERT_TRUE(banded == whole);
+    TEST_ASSERT_TRUE(thin == whole);
+  }
+}
+
+// 背景・吹き出しの色がパレットどおり（RGB565 のまま、バイト順も入れ替え済み）
+static void test_palette_colors() {
+  for (int palette = 0; palette < PALETTE_BUILTIN_COUNT; palette++) {
+    const PaletteDef* def = palette_bank.get(palette);
+    Frame frame = renderFrame(palette, FACE_NEUTRAL, FRAME_BAND_HEIGHT);
+    TEST_ASSERT_EQUAL_HEX16(def->background, frame[0]);
+    // 吹き出しの内側（左端の余白の中）
+    size_t inside = (size_t)(SPEECH_BALLOON_Y + SPEECH_BALLOON_HEIGHT / 2) * FRAME_WIDTH + SPEECH_BALLOON_X + 4;
+    TEST_ASSERT_EQUAL_HEX16(def->balloon_background, frame[inside]);
+  }
+}
+
+static void test_golden_frames() {
+  std::string dir = goldenDir();
+  mkdir(dir.c_str(), 0755);
+  const char* update_env = getenv("GOLDEN_UPDATE");
+  bool update = update_env && update_env[0] == '1';
+  int created = 0;
+  int failed = 0;
+  char line[200];
+
+  for (int palette = 0; palette < PALETTE_BUILTIN_COUNT; palette++) {
+    for (int expression = 0; expression < FACE_EXPRESSION_COUNT; expression++) {
+      char name[48];
+      snprintf(name, sizeof(name), "palette%d_expr%d.png", palette, expression);
+      std::string path = dir + "/" + name;
+      Frame frame = renderFrame(palette, expression, FRAME_BAND_HEIGHT);
+
+      if (update) {
+        TEST_ASSERT_TRUE_MESSAGE(writeFile(path, encodePng(frame)), path.c_str());
+        created++;
+        continue;
+      }
+      std::string golden, golden_rows;
+      if (!readFile(path, golden)) {
+        snprintf(line, sizeof(line), "%s: ゴールデン画像がありません（GOLDEN_UPDATE=1 で作成）", name);
+        TEST_MESSAGE(line);
+        failed++;
+        continue;
+      }
+      if (!decodePng(golden, golden_rows)) {
+        snprintf(line, sizeof(line), "%s: 読めないPNGです（%dx%d の 8bit RGB・フィルタなしのみ）", name, FRAME_WIDTH, FRAME_HEIGHT);
+        TEST_MESSAGE(line);
+        failed++;
+        continue;
+      }
+      std::string actual = frameToRows(frame);
+      int diff = 0;
+      const size_t stride = FRAME_WIDTH * 3 + 1;
+      for (size_t row = 0; row < actual.size(); row += stride) {
+        for (size_t i = row + 1; i < row + stride; i += 3) {
+          if (actual.compare(i, 3, golden_rows, i, 3) != 0) diff++;
+        }
+      }
+      if (diff) {
+        writeFile(dir + "/actual_" + name, encodePng(frame));
+        snprintf(line, sizeof(line), "%s: 差分 %d px（actual_%s に保存）", name, diff, name);
+        TEST_MESSAGE(line);
+        failed++;
+      }
+    }
+  }
+
+  if (created) {
+    snprintf(line, sizeof(line), "%d 枚のゴールデン画像を %s に保存しました", created, dir.c_str());
+    TEST_MESSAGE(line);
+  }
+  TEST_ASSERT_EQUAL_INT_MESSAGE(0, failed, "ゴールデン画像と一致しないフレームがあります");
+}
+
+static void test_render_benchmark() {
+  FrameColors palettes[PALETTE_BUILTIN_COUNT];
+  for (int i = 0; i < PALETTE_BUILTIN_COUNT; i++) palettes[i] = frameColorsFor(palette_bank.get(i));
+  TEST_ASSERT_TRUE(frame_renderer.begin(DisplayProfile::font()));
+  frame_renderer.setText(GOLDEN_TEXT);
+  FrameBenchResult r = frame_renderer.benchmark(palettes, PALETTE_BUILTIN_COUNT, 120);
+  frame_renderer.end();
+  TEST_ASSERT_EQUAL_UINT32(120, r.frames);
+
+  char line[120];
+  snprintf(line, sizeof(line), "%lu frames, avg %lu us/frame, max %lu us, %.1f fps (%lu bands/frame)",
+           (unsigned long)r.frames, (unsigned long)r.avg_frame_us, (unsigned long)r.max_frame_us, r.fps,
+           (unsigned long)r.bands_per_frame);
+  TEST_MESSAGE(line);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_band_height_does_not_change_frame);
+  RUN_TEST(test_palette_colors);
+  RUN_TEST(test_golden_frames);
+  RUN_TEST(test_render_benchmark);
+  return UNITY_END();
+}
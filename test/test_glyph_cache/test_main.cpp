@@ -0,0 +1,144 @@
+/*
+ * GlyphCache のホスト上のテストとベンチマーク
+ * フォントの展開・描画は M5GFX のホスト版で行い、キャッシュなし/ありの glyphs/s を出力する
+ * pio test -e native -f test_glyph_cache -v
+ */
+
+#include <unity.h>
+#include "glyph_cache.cpp"
+
+#define BENCH_ROUNDS 50
+
+static const lgfx::IFont* font = &fonts::efontJA_12;
+
+// 既定の random_speeches と同程度の長さ・文字種
+static const char* const bench_texts[] = {
+  "こんにちは！",
+  "今日もいい天気ですね",
+  "スタックチャンです。よろしくね",
+  "WiFi 192.168.1.100 に接続しました",
+  "おなかがすいたなあ…",
+  "ABCDEFGHIJKLMNOPQRSTUVWXYZ 0123456789",
+  nullptr
+};
+
+void setUp() {}
+void tearDown() {}
+
+static void test_utf8_decode() {
+  const char* p = "aあ😀";
+  TEST_ASSERT_EQUAL_UINT32('a', utf8NextCodepoint(p));
+  TEST_ASSERT_EQUAL_UINT32(0x3042, utf8NextCodepoint(p));
+  TEST_ASSERT_EQUAL_UINT32(0x1F600, utf8NextCodepoint(p));
+  TEST_ASSERT_EQUAL_UINT32(0, utf8NextCodepoint(p));
+
+  // 途中で切れた文字・不正な先頭バイトは '?' にして先へ進む
+  const char broken[] = { (char)0xE3, (char)0x81, 'b', (char)0xFF, 'c', 0 };
+  p = broken;
+  TEST_ASSERT_EQUAL_UINT32('?', utf8NextCodepoint(p));
+  TEST_ASSERT_EQUAL_UINT32('b', utf8NextCodepoint(p));
+  TEST_ASSERT_EQUAL_UINT32('?', utf8NextCodepoint(p));
+  TEST_ASSERT_EQUAL_UINT32('c', utf8NextCodepoint(p));
+}
+
+static void test_lru_eviction() {
+  GlyphCache cache;
+  TEST_ASSERT_TRUE(cache.begin(font, 4));
+
+  const uint32_t cps[] = { 'a', 'b', 'c', 'd' };
+  for (int i = 0; i < 4; i++) TEST_ASSERT_NOT_NULL(cache.get(cps[i]));
+  TEST_ASSERT_EQUAL_UINT32(4, cache.getMisses());
+
+  // a を使い直すと、次に追い出されるのは b
+  cache.get('a');
+  TEST_ASSERT_EQUAL_UINT32(1, cache.getHits());
+  cache.get('e');
+  cache.get('a');
+  cache.get('c');
+  TEST_ASSERT_EQUAL_UINT32(3, cache.getHits());
+  TEST_ASSERT_EQUAL_UINT32(5, cache.getMisses());
+  cache.get('b');
+  TEST_ASSERT_EQUAL_UINT32(6, cache.getMisses());
+}
+
+// キャッシュしたグリフは、その文字だけを drawString した結果と同じ画素になる
+static void test_cached_glyph_matches_font() {
+  GlyphCache cache;
+  TEST_ASSERT_TRUE(cache.begin(font, 32));
+
+  M5Canvas direct, cached;
+  direct.setColorDepth(1);
+  cached.setColorDepth(1);
+  TEST_ASSERT_NOT_NULL(direct.createSprite(GLYPH_CELL_WIDTH, GLYPH_CELL_HEIGHT));
+  TEST_ASSERT_NOT_NULL(cached.createSprite(GLYPH_CELL_WIDTH, GLYPH_CELL_HEIGHT));
+  direct.setFont(font);
+  direct.setTextDatum(top_left);
+  direct.setTextColor(1, 0);
+
+  const char* samples[] = { "A", "g", "あ", "漢", "。", "1" };
+  for (size_t s = 0; s < sizeof(samples) / sizeof(samples[0]); s++) {
+    direct.fillSprite(0);
+    direct.drawString(samples[s], 0, 0);
+    cached.fillSprite(0);
+    int width = cache.drawText(&cached, 0, 0, samples[s], (uint16_t)1);
+    TEST_ASSERT_EQUAL_INT(direct.textWidth(samples[s]) > GLYPH_CELL_WIDTH ? GLYPH_CELL_WIDTH
+                                                                         : direct.textWidth(samples[s]),
+                          width);
+    for (int y = 0; y < cache.fontHeight(); y++) {
+      for (int x = 0; x < width; x++) {
+        TEST_ASSERT_EQUAL_UINT32(direct.readPixel(x, y), cached.readPixel(x, y));
+      }
+    }
+  }
+}
+
+// 16bit のキャンバスへ RGB565 の色がそのまま書かれる（RGB888 として読み替えられない）
+static void test_draw_color_is_rgb565() {
+  GlyphCache cache;
+  TEST_ASSERT_TRUE(cache.begin(font, 8));
+
+  M5Canvas canvas;
+  canvas.setColorDepth(16);
+  TEST_ASSERT_NOT_NULL(canvas.createSprite(GLYPH_CELL_WIDTH, GLYPH_CELL_HEIGHT));
+  canvas.fillSprite((uint16_t)0);
+
+  const uint16_t color = 0xF81F;  // マゼンタ
+  cache.drawText(&canvas, 0, 0, "■", color);
+  bool found = false;
+  for (int y = 0; y < GLYPH_CELL_HEIGHT && !found; y++) {
+    for (int x = 0; x < GLYPH_CELL_WIDTH && !found; x++) {
+      uint16_t px = canvas.readPixel(x, y);
+      if (px == 0) continue;
+      TEST_ASSERT_EQUAL_HEX16(color, px);
+      found = true;
+    }
+  }
+  TEST_ASSERT_TRUE(found);
+}
+
+static void test_glyph_benchmark() {
+  GlyphBenchResult r = GlyphCache::benchmark(font, bench_texts, BENCH_ROUNDS);
+  TEST_ASSERT_GREATER_THAN(0, r.glyphs);
+  TEST_ASSERT_GREATER_THAN(0, r.uncached_gps);
+  TEST_ASSERT_GREATER_THAN(0, r.cached_gps);
+  // 2周目以降はすべてヒットする
+  TEST_ASSERT_EQUAL_UINT32(r.glyphs, r.hits + r.misses);
+  TEST_ASSERT_LESS_OR_EQUAL(r.glyphs / BENCH_ROUNDS, r.misses);
+
+  char line[160];
+  snprintf(line, sizeof(line), "glyphs=%lu uncached=%lu glyphs/s cached=%lu glyphs/s (x%.1f) hits=%lu misses=%lu",
+           (unsigned long)r.glyphs, (unsigned long)r.uncached_gps, (unsigned long)r.cached_gps,
+           r.uncached_gps ? (double)r.cached_gps / r.uncached_gps : 0.0, (unsigned long)r.hits,
+           (unsigned long)r.misses);
+  TEST_MESSAGE(line);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_utf8_decode);
+  RUN_TEST(test_lru_eviction);
+  RUN_TEST(test_cached_glyph_matches_font);
+  RUN_TEST(test_draw_color_is_rgb565);
+  RUN_TEST(test_glyph_benchmark);
+  return UNITY_END();
+}
@@ -0,0 +1,144 @@
+/*
+ * ScreenCapture のホスト上のテスト
+ * 描画タスク役のスレッドを drawCheckpoint() で止めてパネルを読む
+ * 送信が止まって描画タスクが待ちきれずに再開したら、以降の帯は読まずに中断する
+ * 休止中の長いフレーム間隔で待っている描画タスクも、要求で起こして待ち合わせに間に合わせる
+ */
+
+#include <unity.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "screen_capture.cpp"
+
+#define PANEL_W 32
+#define PANEL_H 40  // SCREEN_CAPTURE_BAND_ROWS=16 で3帯
+
+static M5Canvas panel;
+static std::atomic<bool> drawing(false);
+static std::atomic<uint32_t> checkpoints(0);
+static std::thread draw_task;
+static SemaphoreHandle_t pace_signal;  // PowerGovernor::paceFrame() の待ちの代わり
+
+#define PACED_FRAME_MS 400  // POWER_SLEEP_FRAME_MS と同じ（SCREEN_CAPTURE_PARK_TIMEOUT_MS より長い）
+
+static void wakePacedDraw() {
+  xSemaphoreGive(pace_signal);
+}
+
+struct Sink {
+  size_t bytes;
+  int writes;
+  uint32_t stall_ms;    // 最初の帯を書くときに止まる時間
+  uint32_t checkpoints_during_stall;
+};
+
+static bool writeSink(const uint8_t* data, size_t bytes, void* user) {
+  Sink* sink = static_cast<Sink*>(user);
+  sink->writes++;
+  sink->bytes += bytes;
+  if (sink->stall_ms && bytes == (size_t)PANEL_W * SCREEN_CAPTURE_BAND_ROWS * 2) {
+    uint32_t before = checkpoints;
+    std::this_thread::sleep_for(std::chrono::milliseconds(sink->stall_ms));
+    sink->checkpoints_during_stall = checkpoints - before;
+    sink->stall_ms = 0;
+  }
+  return true;
+}
+
+// 描画タスク: 毎フレーム drawCheckpoint() を通り、frame_ms の間隔を空ける（起こされたら切り上げる）
+static void startDrawTask(uint32_t frame_ms = 5) {
+  drawing = true;
+  draw_task = std::thread([frame_ms] {
+    while (drawing) {
+      screen_capture.drawCheckpoint();
+      checkpoints++;
+      xSemaphoreTake(pace_signal, pdMS_TO_TICKS(frame_ms));
+    }
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+}
+
+static void stopDrawTask() {
+  drawing = false;
+  screen_capture.resumeDrawing();
+  wakePacedDraw();
+  draw_task.join();
+}
+
+void setUp() {
+  startDrawTask();
+}
+
+void tearDown() {
+  stopDrawTask();
+}
+
+static void test_odd_width_bmp_is_rejected_before_output() {
+  TEST_ASSERT_FALSE(ImageStreamEncoder::supports(SCREENSHOT_BMP, 135, 240));
+  TEST_ASSERT_TRUE(ImageStreamEncoder::supports(SCREENSHOT_PNG, 135, 240));
+  TEST_ASSERT_TRUE(ImageStreamEncoder::supports(SCREENSHOT_BMP, 320, 240));
+
+  Sink sink = {};
+  ImageStreamEncoder encoder;
+  TEST_ASSERT_FALSE(encoder.begin(SCREENSHOT_BMP, 135, 240, 16, writeSink, &sink));
+  TEST_ASSERT_EQUAL_INT(0, sink.writes);
+}
+
+static void test_hold_capture_writes_whole_image() {
+  for (int f = 0; f < 2; f++) {
+    ScreenshotFormat format = f ? SCREENSHOT_PNG : SCREENSHOT_BMP;
+    Sink sink = {};
+    TEST_ASSERT_TRUE(screen_capture.capturePanel(&panel, format, true, writeSink, &sink));
+    TEST_ASSERT_EQUAL_UINT32(ImageStreamEncoder::encodedSize(format, PANEL_W, PANEL_H, SCREEN_CAPTURE_BAND_ROWS),
+                             sink.bytes);
+  }
+}
+
+// 送信が SCREEN_CAPTURE_MAX_PAUSE_MS より長く止まると、描画タスクは再開し、残りの帯は読まない
+static void test_stalled_capture_aborts_after_draw_resumes() {
+  ScreenCaptureStats before = screen_capture.getStats();
+  Sink sink = {};
+  sink.stall_ms = SCREEN_CAPTURE_MAX_PAUSE_MS + 300;
+  TEST_ASSERT_FALSE(screen_capture.capturePanel(&panel, SCREENSHOT_BMP, true, writeSink, &sink));
+
+  ScreenCaptureStats after = screen_capture.getStats();
+  TEST_ASSERT_EQUAL_UINT32(before.abandoned + 1, after.abandoned);
+  TEST_ASSERT_EQUAL_UINT32(before.failures + 1, after.failures);
+  // 描画は止まったままにならない
+  TEST_ASSERT_GREATER_THAN(0, sink.checkpoints_during_stall);
+  // ヘッダと最初の帯だけ（再開後に読んだ帯は送っていない）
+  TEST_ASSERT_EQUAL_INT(2, sink.writes);
+
+  // 次のキャプチャは普通に取れる
+  Sink next = {};
+  TEST_ASSERT_TRUE(screen_capture.capturePanel(&panel, SCREENSHOT_BMP, true, writeSink, &next));
+}
+
+// 休止中の描画間隔の途中で要求が来ても、待ちを切り上げて停止位置に来るのでキャプチャできる
+static void test_capture_wakes_paced_draw_task() {
+  stopDrawTask();
+  startDrawTask(PACED_FRAME_MS);
+  for (int i = 0; i < 3; i++) {
+    // 前のフレームの待ちの途中から要求する
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    Sink sink = {};
+    unsigned long start = millis();
+    TEST_ASSERT_TRUE(screen_capture.capturePanel(&panel, SCREENSHOT_BMP, true, writeSink, &sink));
+    TEST_ASSERT_LESS_THAN(SCREEN_CAPTURE_PARK_TIMEOUT_MS, millis() - start);
+  }
+}
+
+int main(int argc, char** argv) {
+  panel.setColorDepth(16);
+  panel.createSprite(PANEL_W, PANEL_H);
+  screen_capture.begin();
+  pace_signal = xSemaphoreCreateBinary();
+  screen_capture.setDrawWakeup(wakePacedDraw);
+  UNITY_BEGIN();
+  RUN_TEST(test_odd_width_bmp_is_rejected_before_output);
+  RUN_TEST(test_hold_capture_writes_whole_image);
+  RUN_TEST(test_stalled_capture_aborts_after_draw_resumes);
+  RUN_TEST(test_capture_wakes_paced_draw_task);
+  return UNITY_END();
+}
@@ -0,0 +1,146 @@
+/*
+ * SleepPolicy のホスト上のテスト
+ * 眠れない理由の優先順位・作業直後の猶予と、IdleGovernor と組み合わせた疑似時計の1日分の判定
+ */
+
+#include <unity.h>
+#include "idle_governor.cpp"
+#include "sleep_policy.cpp"
+
+#define SETTLE_MS 200
+
+static SleepPolicy policy;
+
+static SleepInputs idleInputs() {
+  SleepInputs in;
+  in.enabled = true;
+  in.power_level = POWER_DIM;
+  in.buttons_active = false;
+  in.network_active = false;
+  in.fading = false;
+  return in;
+}
+
+void setUp() {
+  policy = SleepPolicy();
+  SleepPolicyConfig config;
+  config.settle_ms = SETTLE_MS;
+  config.min_level = POWER_DIM;
+  policy.configure(config);
+}
+
+void tearDown() {}
+
+// 複数の理由が重なったときは表の上から（無効 → 描画 → 入力 → 通信 → フェード）
+static void test_blockers_in_priority_order() {
+  SleepInputs in = idleInputs();
+  in.buttons_active = true;
+  in.network_active = true;
+  in.fading = true;
+  in.power_level = POWER_ACTIVE;
+  in.enabled = false;
+  TEST_ASSERT_EQUAL_INT(SLEEP_BLOCK_DISABLED, policy.decide(in, 0));
+  in.enabled = true;
+  TEST_ASSERT_EQUAL_INT(SLEEP_BLOCK_RENDERING, policy.decide(in, 0));
+  in.power_level = POWER_SLEEP;
+  TEST_ASSERT_EQUAL_INT(SLEEP_BLOCK_INPUT, policy.decide(in, 0));
+  in.buttons_active = false;
+  TEST_ASSERT_EQUAL_INT(SLEEP_BLOCK_NETWORK, policy.decide(in, 0));
+  in.network_active = false;
+  TEST_ASSERT_EQUAL_INT(SLEEP_BLOCK_FADE, policy.decide(in, 0));
+  TEST_ASSERT_EQUAL_UINT32(1, policy.decisions(SLEEP_BLOCK_FADE));
+  TEST_ASSERT_EQUAL_INT(SLEEP_BLOCK_FADE, policy.lastDecision());
+}
+
+// 作業の後 settle_ms の間は眠らない（起動直後はまだ作業がないので眠ってよい）
+static void test_settle_after_work() {
+  SleepInputs in = idleInputs();
+  TEST_ASSERT_EQUAL_INT(SLEEP_ALLOWED, policy.decide(in, 1000));
+
+  in.network_active = true;
+  TEST_ASSERT_EQUAL_INT(SLEEP_BLOCK_NETWORK, policy.decide(in, 2000));
+  in.network_active = false;
+  TEST_ASSERT_EQUAL_INT(SLEEP_BLOCK_SETTLE, policy.decide(in, 2000 + SETTLE_MS - 1));
+  TEST_ASSERT_EQUAL_INT(SLEEP_ALLOWED, policy.decide(in, 2000 + SETTLE_MS));
+}
+
+// millis() が一周しても猶予の判定はずれない
+static void test_settle_across_wraparound() {
+  SleepInputs in = idleInputs();
+  uint32_t busy = UINT32_MAX - 50;
+  in.fading = true;
+  policy.decide(in, busy);
+  in.fading = false;
+  TEST_ASSERT_EQUAL_INT(SLEEP_BLOCK_SETTLE, policy.decide(in, busy + 100));
+  TEST_ASSERT_EQUAL_INT(SLEEP_ALLOWED, policy.decide(in, busy + SETTLE_MS));
+}
+
+// 1日分: 日中は1時間ごとにボタン操作と HTTP の応答、夜は操作なし
+// 描画が全速の間・作業の直後は眠らず、それ以外の減光・休止中の待機はすべて眠ってよい
+static void test_simulated_day() {
+  IdleGovernor governor;
+  IdleGovernorConfig gc;
+  gc.dim_after_ms = 60000;
+  gc.sleep_after_ms = 600000;
+  gc.levels[POWER_ACTIVE].frame_interval_ms = 0;
+  gc.levels[POWER_ACTIVE].brightness = 128;
+  gc.levels[POWER_DIM].frame_interval_ms = 100;
+  gc.levels[POWER_DIM].brightness = 48;
+  gc.levels[POWER_SLEEP].frame_interval_ms = 400;
+  gc.levels[POWER_SLEEP].brightness = 8;
+  governor.configure(gc, 0);
+
+  const uint32_t step_ms = 50;  // loop() の待機1回
+  const uint32_t day_ms = 24UL * 3600 * 1000;
+  uint32_t allowed = 0;
+  uint32_t waits = 0;
+  uint32_t last_work = 0;
+  bool worked = false;
+
+  for (uint32_t now = 0; now < day_ms; now += step_ms) {
+    uint32_t hour = now / 3600000;
+    uint32_t in_hour = now % 3600000;
+    bool daytime = hour >= 8 && hour < 22;
+    SleepInputs in = idleInputs();
+    // 毎時0分から1秒間ボタンを押し、続く1秒間 HTTP の応答
+    in.buttons_active = daytime && in_hour < 1000;
+    in.network_active = daytime && in_hour >= 1000 && in_hour < 2000;
+    if (in.buttons_active) governor.activity(now);
+    governor.update(now);
+    in.power_level = governor.level();
+    // パレットのフェードは減光に入ってから0.5秒
+    in.fading = daytime && in_hour >= gc.dim_after_ms && in_hour < gc.dim_after_ms + 500;
+
+    SleepBlocker decision = policy.decide(in, now);
+    bool busy = in.buttons_active || in.network_active || in.fading || in.power_level == POWER_ACTIVE;
+    if (busy) {
+      TEST_ASSERT_TRUE(decision != SLEEP_ALLOWED);
+      last_work = now;
+      worked = true;
+    } else if (worked && now - last_work < SETTLE_MS) {
+      TEST_ASSERT_EQUAL_INT(SLEEP_BLOCK_SETTLE, decision);
+    } else {
+      TEST_ASSERT_EQUAL_INT(SLEEP_ALLOWED, decision);
+    }
+    waits++;
+    if (decision == SLEEP_ALLOWED) allowed++;
+  }
+
+  // 起きているのは日中の毎時 約62秒（操作1秒 + 減光までの60秒 + フェード・猶予）と起動直後だけ
+  float fraction = (float)allowed / waits;
+  TEST_ASSERT_TRUE(fraction > 0.97f);
+  TEST_ASSERT_TRUE(fraction < 0.995f);
+  uint32_t counted = 0;
+  for (int i = 0; i < SLEEP_BLOCKER_COUNT; i++) counted += policy.decisions((SleepBlocker)i);
+  TEST_ASSERT_EQUAL_UINT32(waits, counted);
+  TEST_ASSERT_EQUAL_UINT32(allowed, policy.decisions(SLEEP_ALLOWED));
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_blockers_in_priority_order);
+  RUN_TEST(test_settle_after_work);
+  RUN_TEST(test_settle_across_wraparound);
+  RUN_TEST(test_simulated_day);
+  return UNITY_END();
+}
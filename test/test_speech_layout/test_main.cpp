@@ -0,0 +1,66 @@
+/*
+ * layoutSpeech の折り返し位置のホスト上のテスト
+ * 行幅はフォントに依存しないよう、試験する文字列の一部の描画幅から決める
+ */
+
+#include <unity.h>
+#include "glyph_cache.cpp"
+#include "speech_layout.cpp"
+
+static GlyphCache glyphs;
+static SpeechLayout layout;
+
+void setUp() {}
+void tearDown() {}
+
+// i 行目の文字列
+static void lineText(const char* text, int i, char* out, size_t size) {
+  const SpeechLine& line = layout.lines[i];
+  size_t bytes = line.bytes < size - 1 ? line.bytes : size - 1;
+  memcpy(out, text + line.offset, bytes);
+  out[bytes] = '\0';
+}
+
+static void assertLines(const char* text, int max_width, const char* first, const char* second) {
+  char buf[64];
+  layoutSpeech(text, max_width, 2, glyphs, layout);
+  TEST_ASSERT_EQUAL_INT(2, layout.line_count);
+  lineText(text, 0, buf, sizeof(buf));
+  TEST_ASSERT_EQUAL_STRING(first, buf);
+  lineText(text, 1, buf, sizeof(buf));
+  TEST_ASSERT_EQUAL_STRING(second, buf);
+}
+
+// IPアドレスの '.' の前後では折り返さない
+static void test_ip_address_is_not_split() {
+  const char* text = "IP 192.168.10.20";
+  assertLines(text, glyphs.textWidth("IP 192.168.10.2"), "IP", "192.168.10.20");
+}
+
+// 小数も1語として扱う
+static void test_decimal_is_not_split() {
+  const char* text = "ab 0.5";
+  assertLines(text, glyphs.textWidth("ab 0."), "ab", "0.5");
+}
+
+// 数字に挟まれていない '.'（文末）の後ろでは折り返せる
+static void test_break_after_sentence_period() {
+  const char* text = "Hi.Bye";
+  assertLines(text, glyphs.textWidth("Hi.B"), "Hi.", "Bye");
+}
+
+// 行頭禁則: 句点は前の行にぶら下げる
+static void test_hanging_period() {
+  const char* text = "あいう。えお";
+  assertLines(text, glyphs.textWidth("あいう"), "あいう。", "えお");
+}
+
+int main(int argc, char** argv) {
+  glyphs.begin(&fonts::efontJA_12, 64);
+  UNITY_BEGIN();
+  RUN_TEST(test_ip_address_is_not_split);
+  RUN_TEST(test_decimal_is_not_split);
+  RUN_TEST(test_break_after_sentence_period);
+  RUN_TEST(test_hanging_period);
+  return UNITY_END();
+}
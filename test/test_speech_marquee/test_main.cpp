@@ -0,0 +1,106 @@
+/*
+ * SpeechMarquee のホスト上のテスト
+ * スクロールで描くのは新しく見えた列だけで、結果は全体を描き直した場合と同じ画素になる
+ */
+
+#include <unity.h>
+#include <vector>
+#include "glyph_cache.cpp"
+#include "balloon_cache.cpp"
+#include "speech_marquee.cpp"
+
+#define CANVAS_W   320
+#define CANVAS_H   40
+#define LINE_X     16
+#define LINE_Y     8
+#define LINE_WIDTH 200
+#define BACKDROP   0x1234
+
+static GlyphCache glyphs;
+static const char* text = "とても長いセリフを横にスクロールして表示します 0123456789";
+static const uint16_t fg = 0x0000;
+static const uint16_t bg = 0xFFFF;
+
+void setUp() {}
+void tearDown() {}
+
+static std::vector<uint16_t> capture(M5Canvas& canvas) {
+  std::vector<uint16_t> px;
+  for (int y = 0; y < CANVAS_H; y++) {
+    for (int x = 0; x < CANVAS_W; x++) px.push_back(canvas.readPixel(x, y));
+  }
+  return px;
+}
+
+// Avatar と同じく描画先は毎フレーム作り直す
+static void drawFrame(SpeechMarquee& marquee, M5Canvas& canvas, int x, uint16_t f, uint16_t b) {
+  canvas.fillSprite((uint16_t)BACKDROP);
+  marquee.draw(&canvas, x, LINE_Y, f, b);
+}
+
+// 少しずつ進めた行は、同じ位置で全体を描き直した行と一致し、描いた画素は新しい列の分だけ
+static void test_scroll_draws_only_new_columns() {
+  SpeechMarquee marquee;
+  TEST_ASSERT_TRUE(marquee.begin(&glyphs, LINE_WIDTH));
+  marquee.setSpeed(100);
+  M5Canvas canvas;
+  canvas.setColorDepth(16);
+  TEST_ASSERT_NOT_NULL(canvas.createSprite(CANVAS_W, CANVAS_H));
+
+  marquee.setText(text, strlen(text));
+  drawFrame(marquee, canvas, LINE_X, fg, bg);
+  int h = marquee.getHeight();
+  TEST_ASSERT_EQUAL_UINT32(LINE_WIDTH * h, marquee.getStats().last_pixels);
+
+  for (int i = 0; i < 30; i++) {
+    delay(50);  // 5px
+    drawFrame(marquee, canvas, LINE_X, fg, bg);
+    MarqueeStats s = marquee.getStats();
+    // 実時間も少し進むので 1px 多く進むことがある
+    TEST_ASSERT_EQUAL_UINT32(0, s.last_pixels % h);
+    TEST_ASSERT_TRUE(s.last_pixels / h == 5 || s.last_pixels / h == 6);
+    TEST_ASSERT_EQUAL_UINT32(LINE_WIDTH * h * 2, s.copy_bytes);
+  }
+  std::vector<uint16_t> scrolled = capture(canvas);
+  TEST_ASSERT_EQUAL_UINT32(1, marquee.getStats().redraws);
+
+  // 配色を変えると全体を描き直す（止めておくので同じ位置）
+  marquee.setSpeed(0);
+  drawFrame(marquee, canvas, LINE_X, bg, fg);
+  drawFrame(marquee, canvas, LINE_X, fg, bg);
+  TEST_ASSERT_EQUAL_UINT32(3, marquee.getStats().redraws);
+  TEST_ASSERT_EQUAL_UINT32(LINE_WIDTH * h, marquee.getStats().last_pixels);
+  TEST_ASSERT_TRUE(scrolled == capture(canvas));
+
+  // 行の外側の描画先には触れない
+  TEST_ASSERT_EQUAL_HEX16(BACKDROP, canvas.readPixel(LINE_X - 1, LINE_Y));
+  TEST_ASSERT_EQUAL_HEX16(BACKDROP, canvas.readPixel(LINE_X + LINE_WIDTH, LINE_Y));
+  TEST_ASSERT_EQUAL_HEX16(BACKDROP, canvas.readPixel(LINE_X, LINE_Y + h));
+}
+
+// 行コピーできない配置では画素単位で転送し、その分も last_pixels に数える
+static void test_unaligned_destination_counts_transfer() {
+  SpeechMarquee marquee;
+  TEST_ASSERT_TRUE(marquee.begin(&glyphs, LINE_WIDTH));
+  marquee.setSpeed(100);
+  M5Canvas canvas;
+  canvas.setColorDepth(1);
+  TEST_ASSERT_NOT_NULL(canvas.createSprite(CANVAS_W, CANVAS_H));
+
+  marquee.setText(text, strlen(text));
+  drawFrame(marquee, canvas, LINE_X + 3, 1, 0);
+  marquee.setSpeed(0);
+  drawFrame(marquee, canvas, LINE_X + 3, 1, 0);
+  MarqueeStats s = marquee.getStats();
+  int h = marquee.getHeight();
+  TEST_ASSERT_EQUAL_UINT32(0, s.copy_bytes);
+  TEST_ASSERT_EQUAL_UINT32(LINE_WIDTH * h, s.last_pixels);
+}
+
+int main(int argc, char** argv) {
+  glyphs.begin(&fonts::efontJA_12, 128);
+  UNITY_BEGIN();
+  RUN_TEST(test_scroll_draws_only_new_columns);
+  RUN_TEST(test_unaligned_destination_counts_transfer);
+  return UNITY_END();
+}
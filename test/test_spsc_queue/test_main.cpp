@@ -0,0 +1,160 @@
+/*
+ * SpscQueue のホスト上のストレステスト
+ * 生産者・消費者のスレッドで数百万回やり取りし、順番の入れ替わり・取りこぼし・書きかけの要素の読み出しがないことを確かめる
+ * 生産者ごとのキューを1つの消費者がまとめて取り出す形も試す
+ */
+
+#include <unity.h>
+#include <string.h>
+#include <thread>
+#include "spsc_queue.h"
+
+#define STRESS_ITEMS 2000000
+
+// AvatarCommand と同じく大きめの要素（書きかけを読めば中身が揃わない）
+struct Item {
+  uint32_t seq;
+  uint32_t producer;
+  uint8_t payload[120];
+  uint32_t check;
+};
+
+static void fillItem(Item& item, uint32_t producer, uint32_t seq) {
+  item.seq = seq;
+  item.producer = producer;
+  memset(item.payload, (uint8_t)(seq * 31 + producer), sizeof(item.payload));
+  item.check = seq ^ 0xA5A5A5A5u ^ producer;
+}
+
+static bool itemIntact(const Item& item) {
+  if (item.check != (item.seq ^ 0xA5A5A5A5u ^ item.producer)) return false;
+  uint8_t expected = (uint8_t)(item.seq * 31 + item.producer);
+  for (size_t i = 0; i < sizeof(item.payload); i++) {
+    if (item.payload[i] != expected) return false;
+  }
+  return true;
+}
+
+void setUp() {}
+void tearDown() {}
+
+static void test_empty_and_full() {
+  SpscQueue<int, 4> queue;
+  int value;
+  TEST_ASSERT_NULL(queue.front());
+  TEST_ASSERT_FALSE(queue.pop(value));
+  for (int i = 0; i < 4; i++) TEST_ASSERT_TRUE(queue.push(i));
+  TEST_ASSERT_NULL(queue.reserve());
+  TEST_ASSERT_FALSE(queue.push(4));
+  TEST_ASSERT_EQUAL_UINT32(4, queue.size());
+  for (int i = 0; i < 4; i++) {
+    TEST_ASSERT_TRUE(queue.pop(value));
+    TEST_ASSERT_EQUAL_INT(i, value);
+  }
+  TEST_ASSERT_EQUAL_UINT32(0, queue.size());
+}
+
+// 積む・取り出すを交互に繰り返しても、積んだ順で出てきて満杯を超えない
+static void test_interleaved_push_pop() {
+  SpscQueue<uint32_t, 8> queue;
+  uint32_t pushed = 0;
+  uint32_t popped = 0;
+  uint32_t value;
+  for (uint32_t i = 0; i < 100000; i++) {
+    int n = 1 + i % 3;
+    for (int k = 0; k < n && queue.push(pushed); k++) pushed++;
+    TEST_ASSERT_LESS_OR_EQUAL(8, queue.size());
+    while (queue.size() > 2) {
+      TEST_ASSERT_TRUE(queue.pop(value));
+      TEST_ASSERT_EQUAL_UINT32(popped, value);
+      popped++;
+    }
+  }
+  TEST_ASSERT_EQUAL_UINT32(pushed - popped, queue.size());
+}
+
+// 生産者1つ・消費者1つ（reserve/commit と front/release でその場に書いて読む）
+static void test_stress_in_place() {
+  static SpscQueue<Item, 8> queue;
+  std::thread producer([] {
+    for (uint32_t seq = 0; seq < STRESS_ITEMS; seq++) {
+      Item* slot;
+      while ((slot = queue.reserve()) == nullptr) std::this_thread::yield();
+      fillItem(*slot, 0, seq);
+      queue.commit();
+    }
+  });
+
+  uint32_t expected = 0;
+  uint32_t corrupt = 0;
+  uint32_t out_of_order = 0;
+  uint32_t max_size = 0;
+  while (expected < STRESS_ITEMS) {
+    Item* item = queue.front();
+    if (!item) {
+      std::this_thread::yield();
+      continue;
+    }
+    uint32_t size = queue.size();
+    if (size > max_size) max_size = size;
+    if (!itemIntact(*item)) corrupt++;
+    if (item->seq != expected) out_of_order++;
+    queue.release();
+    expected++;
+  }
+  producer.join();
+
+  TEST_ASSERT_EQUAL_UINT32(0, corrupt);
+  TEST_ASSERT_EQUAL_UINT32(0, out_of_order);
+  TEST_ASSERT_LESS_OR_EQUAL(8, max_size);
+  TEST_ASSERT_NULL(queue.front());
+}
+
+// 生産者ごとのキューを1つの消費者が順に取り出す
+static void test_stress_per_producer_queues() {
+  static SpscQueue<Item, 8> queues[2];
+  const uint32_t per_producer = STRESS_ITEMS / 2;
+  std::thread producers[2];
+  for (uint32_t p = 0; p < 2; p++) {
+    producers[p] = std::thread([p, per_producer] {
+      Item item;
+      for (uint32_t seq = 0; seq < per_producer; seq++) {
+        fillItem(item, p, seq);
+        while (!queues[p].push(item)) std::this_thread::yield();
+      }
+    });
+  }
+
+  uint32_t next[2] = { 0, 0 };
+  uint32_t corrupt = 0;
+  uint32_t out_of_order = 0;
+  while (next[0] < per_producer || next[1] < per_producer) {
+    bool any = false;
+    for (int p = 0; p < 2; p++) {
+      Item* item;
+      while ((item = queues[p].front()) != nullptr) {
+        if (!itemIntact(*item) || item->producer != (uint32_t)p) corrupt++;
+        if (item->seq != next[p]) out_of_order++;
+        queues[p].release();
+        next[p]++;
+        any = true;
+      }
+    }
+    if (!any) std::this_thread::yield();
+  }
+  for (int p = 0; p < 2; p++) producers[p].join();
+
+  TEST_ASSERT_EQUAL_UINT32(0, corrupt);
+  TEST_ASSERT_EQUAL_UINT32(0, out_of_order);
+  TEST_ASSERT_EQUAL_UINT32(per_producer, next[0]);
+  TEST_ASSERT_EQUAL_UINT32(per_producer, next[1]);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_empty_and_full);
+  RUN_TEST(test_interleaved_push_pop);
+  RUN_TEST(test_stress_in_place);
+  RUN_TEST(test_stress_per_producer_queues);
+  return UNITY_END();
+}
@@ -0,0 +1,232 @@
+/*
+ * TimerWheel のホスト上のテスト
+ * 時刻は引数で渡すので、仮想時計で数時間分を一瞬で回し、素直な実装（期限の一覧）と実行時刻を突き合わせる
+ */
+
+#include <unity.h>
+#include <stdlib.h>
+#include <chrono>
+#include "timer_wheel.cpp"
+
+static TimerWheel wheel;
+
+struct Fired {
+  uint32_t count;
+  uint32_t last_ms;
+};
+
+static uint32_t now_ms;
+static Fired fired[TIMER_WHEEL_MAX_JOBS];
+
+static void onFire(void* user) {
+  Fired* f = static_cast<Fired*>(user);
+  f->count++;
+  f->last_ms = now_ms;
+}
+
+// 期限が来たら自分を消す
+static int self_id;
+static void onFireRemove(void* user) {
+  onFire(user);
+  wheel.remove(self_id);
+}
+
+// now_ms まで step_ms ごとに進める
+static void advanceTo(uint32_t end_ms, uint32_t step_ms) {
+  while ((int32_t)(end_ms - now_ms) > 0) {
+    uint32_t step = end_ms - now_ms < step_ms ? end_ms - now_ms : step_ms;
+    now_ms += step;
+    wheel.run(now_ms);
+  }
+}
+
+static void startAt(uint32_t start_ms) {
+  now_ms = start_ms;
+  wheel.begin(now_ms);
+  memset(fired, 0, sizeof(fired));
+}
+
+void setUp() {
+  startAt(0);
+}
+
+void tearDown() {}
+
+static void test_periodic_runs_on_schedule() {
+  int id = wheel.addPeriodic("p", 1000, onFire, &fired[0], now_ms);
+  advanceTo(60000, TIMER_WHEEL_TICK_MS);
+  TEST_ASSERT_EQUAL_UINT32(60, fired[0].count);
+
+  TimerJobStats stats;
+  TEST_ASSERT_TRUE(wheel.getStats(id, stats));
+  TEST_ASSERT_EQUAL_UINT32(0, stats.max_jitter_ms);
+  TEST_ASSERT_EQUAL_UINT32(0, stats.overruns);
+}
+
+static void test_one_shot_never_runs_early() {
+  wheel.addOneShot("o", 1234, onFire, &fired[0], now_ms);
+  advanceTo(1230, 1);
+  TEST_ASSERT_EQUAL_UINT32(0, fired[0].count);
+  advanceTo(5000, 1);
+  TEST_ASSERT_EQUAL_UINT32(1, fired[0].count);
+  TEST_ASSERT_GREATER_OR_EQUAL(1234, fired[0].last_ms);
+  TEST_ASSERT_LESS_THAN(1234 + TIMER_WHEEL_TICK_MS, fired[0].last_ms);
+  TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, wheel.msUntilNext(now_ms));
+}
+
+// 最上段（約44分）より遠い期限も、降りてくる途中で入れ直されて時刻どおりに動く
+static void test_far_deadline_cascades_down() {
+  uint32_t delay = 3 * 3600 * 1000UL + 777;
+  wheel.addOneShot("far", delay, onFire, &fired[0], now_ms);
+  uint32_t due = (delay + TIMER_WHEEL_TICK_MS - 1) / TIMER_WHEEL_TICK_MS * TIMER_WHEEL_TICK_MS;
+  TEST_ASSERT_EQUAL_UINT32(due, wheel.msUntilNext(now_ms));
+  advanceTo(delay - 10, 1000);
+  TEST_ASSERT_EQUAL_UINT32(0, fired[0].count);
+  advanceTo(delay + 1000, 1);
+  TEST_ASSERT_EQUAL_UINT32(1, fired[0].count);
+  TEST_ASSERT_LESS_THAN(delay + TIMER_WHEEL_TICK_MS, fired[0].last_ms);
+}
+
+// 止まっていた間の周期はまとめて実行せず、飛ばした数を数える
+static void test_stall_counts_overruns() {
+  int id = wheel.addPeriodic("p", 100, onFire, &fired[0], now_ms);
+  advanceTo(1050, 1050);
+  TEST_ASSERT_EQUAL_UINT32(1, fired[0].count);
+
+  TimerJobStats stats;
+  wheel.getStats(id, stats);
+  TEST_ASSERT_EQUAL_UINT32(9, stats.overruns);
+  // 次は予定の刻みに戻る
+  TEST_ASSERT_EQUAL_UINT32(50, wheel.msUntilNext(now_ms));
+}
+
+static void test_callback_may_remove_itself() {
+  self_id = wheel.addPeriodic("self", 50, onFireRemove, &fired[0], now_ms);
+  int other = wheel.addPeriodic("other", 50, onFire, &fired[1], now_ms);
+  advanceTo(500, TIMER_WHEEL_TICK_MS);
+  TEST_ASSERT_EQUAL_UINT32(1, fired[0].count);
+  TEST_ASSERT_EQUAL_UINT32(10, fired[1].count);
+  TimerJobStats stats;
+  TEST_ASSERT_FALSE(wheel.getStats(self_id, stats));
+  TEST_ASSERT_TRUE(wheel.getStats(other, stats));
+}
+
+static void test_full_wheel_rejects_jobs() {
+  for (int i = 0; i < TIMER_WHEEL_MAX_JOBS; i++) {
+    TEST_ASSERT_EQUAL_INT(i, wheel.addOneShot("o", 100, onFire, &fired[i], now_ms));
+  }
+  TEST_ASSERT_EQUAL_INT(-1, wheel.addOneShot("o", 100, onFire, &fired[0], now_ms));
+}
+
+// millis() の一周（約49日）をまたいでも期限どおりに動く
+static void test_clock_wraparound() {
+  startAt(UINT32_MAX - 5000);
+  uint32_t start = now_ms;
+  wheel.addPeriodic("p", 1000, onFire, &fired[0], now_ms);
+  advanceTo(start + 20000, 7);
+  TEST_ASSERT_EQUAL_UINT32(20, fired[0].count);
+}
+
+// 時計を1日進めても、空のティックを1つずつ回らずにすぐ戻る（loop() の停止検出に掛からない）
+static void test_day_advance_returns_quickly() {
+  int fast = wheel.addPeriodic("fast", 10, onFire, &fired[0], now_ms);
+  wheel.addPeriodic("slow", 30000, onFire, &fired[1], now_ms);
+  wheel.addOneShot("once", 3600 * 1000UL, onFire, &fired[2], now_ms);
+  advanceTo(1000, TIMER_WHEEL_TICK_MS);
+
+  auto start = std::chrono::steady_clock::now();
+  now_ms += 86400 * 1000UL;
+  uint32_t ran = wheel.run(now_ms);
+  long us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+  TEST_ASSERT_LESS_THAN(2000, us);
+
+  // どのジョブも1回だけ実行され、周期ジョブは飛ばした分を数えて予定の刻みに戻る
+  TEST_ASSERT_EQUAL_UINT32(3, ran);
+  TEST_ASSERT_EQUAL_UINT32(101, fired[0].count);
+  TEST_ASSERT_EQUAL_UINT32(1, fired[1].count);
+  TEST_ASSERT_EQUAL_UINT32(1, fired[2].count);
+  TimerJobStats stats;
+  wheel.getStats(fast, stats);
+  TEST_ASSERT_EQUAL_UINT32(86400 * 100UL - 1, stats.overruns);
+  TEST_ASSERT_EQUAL_UINT32(TIMER_WHEEL_TICK_MS, wheel.msUntilNext(now_ms));
+
+  advanceTo(now_ms + 60000, TIMER_WHEEL_TICK_MS);
+  TEST_ASSERT_EQUAL_UINT32(101 + 6000, fired[0].count);
+  TEST_ASSERT_EQUAL_UINT32(1 + 2, fired[1].count);
+}
+
+// 乱数で登録・再設定・停止を混ぜ、各ジョブの実行時刻を期限の一覧と突き合わせる
+static void test_matches_reference_schedule() {
+  struct Reference {
+    bool active;
+    uint32_t due_ms;
+    uint32_t period_ms;
+  };
+  Reference ref[TIMER_WHEEL_MAX_JOBS];
+  int ids[TIMER_WHEEL_MAX_JOBS];
+  srand(12345);
+
+  for (int i = 0; i < TIMER_WHEEL_MAX_JOBS; i++) {
+    uint32_t period = (i & 1) ? 10 + rand() % 5000 : 0;
+    uint32_t delay = 1 + rand() % (i < 4 ? 3000000 : 60000);
+    ids[i] = period ? wheel.addPeriodic("r", period, onFire, &fired[i], now_ms)
+                    : wheel.addOneShot("r", delay, onFire, &fired[i], now_ms);
+    ref[i].active = true;
+    ref[i].period_ms = ((period + TIMER_WHEEL_TICK_MS - 1) / TIMER_WHEEL_TICK_MS) * TIMER_WHEEL_TICK_MS;
+    ref[i].due_ms = now_ms + (period ? period : delay);
+  }
+
+  for (int round = 0; round < 20000; round++) {
+    // 1ティック未満から数秒まで、ばらばらの間隔で進める（loop() の起床に相当）
+    uint32_t step = 1 + rand() % (round % 100 == 0 ? 5000 : 40);
+    uint32_t before[TIMER_WHEEL_MAX_JOBS];
+    for (int i = 0; i < TIMER_WHEEL_MAX_JOBS; i++) before[i] = fired[i].count;
+    now_ms += step;
+    wheel.run(now_ms);
+
+    for (int i = 0; i < TIMER_WHEEL_MAX_JOBS; i++) {
+      Reference& r = ref[i];
+      // 期限を過ぎたティックの run() で1回だけ実行される（期限の前には実行しない）
+      uint32_t due_tick_end = ((r.due_ms + TIMER_WHEEL_TICK_MS - 1) / TIMER_WHEEL_TICK_MS) * TIMER_WHEEL_TICK_MS;
+      bool expected = r.active && (int32_t)(now_ms - due_tick_end) >= 0;
+      TEST_ASSERT_EQUAL_UINT32(before[i] + (expected ? 1 : 0), fired[i].count);
+      if (!expected) continue;
+      if (r.period_ms) {
+        while ((int32_t)(due_tick_end - now_ms) <= 0) due_tick_end += r.period_ms;
+        r.due_ms = due_tick_end;
+      } else {
+        r.active = false;
+      }
+    }
+
+    // ときどき単発ジョブを再設定・停止する
+    int i = rand() % TIMER_WHEEL_MAX_JOBS;
+    if (!(i & 1) && round % 7 == 0) {
+      if (rand() % 4 == 0) {
+        wheel.stop(ids[i]);
+        ref[i].active = false;
+      } else {
+        uint32_t delay = rand() % 20000;
+        wheel.reschedule(ids[i], delay, now_ms);
+        ref[i].active = true;
+        ref[i].due_ms = now_ms + delay;
+        uint32_t next_tick = ((now_ms / TIMER_WHEEL_TICK_MS) + 1) * TIMER_WHEEL_TICK_MS;
+        if ((int32_t)(ref[i].due_ms - next_tick) < 0) ref[i].due_ms = next_tick;
+      }
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_periodic_runs_on_schedule);
+  RUN_TEST(test_one_shot_never_runs_early);
+  RUN_TEST(test_far_deadline_cascades_down);
+  RUN_TEST(test_stall_counts_overruns);
+  RUN_TEST(test_callback_may_remove_itself);
+  RUN_TEST(test_full_wheel_rejects_jobs);
+  RUN_TEST(test_clock_wraparound);
+  RUN_TEST(test_day_advance_returns_quickly);
+  RUN_TEST(test_matches_reference_schedule);
+  return UNITY_END();
+}
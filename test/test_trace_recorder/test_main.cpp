@@ -0,0 +1,92 @@
+/*
+ * TraceRecorder のホスト上のテスト
+ * beginDump() で返したサイズと dump() が実際に送るバイト数は、その間に他のタスクが記録しても一致する
+ */
+
+// env:native は TRACE_ENABLED=0 なので、このテストだけ記録コードを入れる
+#undef TRACE_ENABLED
+#define TRACE_ENABLED 1
+
+#include <unity.h>
+#include <thread>
+#include <vector>
+#include "trace_recorder.cpp"
+
+#define HEADER_BYTES (16 + 1 + TRACE_MAX_TASKS * TRACE_NAME_LEN + 1 + TRACE_EVENT_COUNT * TRACE_NAME_LEN)
+
+static std::vector<uint8_t> output;
+
+static bool collect(const uint8_t* data, size_t bytes, void* user) {
+  output.insert(output.end(), data, data + bytes);
+  return true;
+}
+
+static uint32_t headerCount() {
+  uint32_t n;
+  memcpy(&n, &output[8], 4);
+  return n;
+}
+
+void setUp() {
+  trace_recorder.clear();
+  output.clear();
+}
+
+void tearDown() {}
+
+// ヘッダを送っている間に別のタスクが記録しても、送る量は beginDump() の時点のまま
+static void test_size_is_frozen_before_headers() {
+  for (int i = 0; i < 10; i++) TRACE_INSTANT(TRACE_BUTTON, i);
+
+  size_t bytes = trace_recorder.beginDump();
+  TEST_ASSERT_EQUAL_UINT32(HEADER_BYTES + 10 * sizeof(TraceRecord), bytes);
+
+  std::thread other([] {
+    for (int i = 0; i < 200; i++) TRACE_INSTANT(TRACE_BLE_WRITE, i);
+  });
+  other.join();
+
+  TEST_ASSERT_TRUE(trace_recorder.dump(collect, nullptr));
+  TEST_ASSERT_EQUAL_UINT32(bytes, output.size());
+  TEST_ASSERT_EQUAL_UINT32(10, headerCount());
+
+  // ダンプが終われば記録を再開する
+  TRACE_INSTANT(TRACE_BUTTON, 0);
+  TEST_ASSERT_EQUAL_UINT32(11, trace_recorder.getStats().count);
+}
+
+// 一周したリングは古い順に送り、上書きした数をヘッダに入れる
+static void test_wrapped_ring_is_sent_oldest_first() {
+  uint32_t capacity = trace_recorder.getStats().capacity;
+  uint32_t total = capacity + 76;
+  for (uint32_t i = 0; i < total; i++) TRACE_INSTANT(TRACE_BUTTON, i & 0xFF);
+
+  size_t bytes = trace_recorder.beginDump();
+  TEST_ASSERT_TRUE(trace_recorder.dump(collect, nullptr));
+  TEST_ASSERT_EQUAL_UINT32(bytes, output.size());
+  TEST_ASSERT_EQUAL_UINT32(capacity, headerCount());
+  uint32_t lost;
+  memcpy(&lost, &output[12], 4);
+  TEST_ASSERT_EQUAL_UINT32(76, lost);
+
+  for (uint32_t i = 0; i < capacity; i++) {
+    const TraceRecord* r = reinterpret_cast<const TraceRecord*>(&output[HEADER_BYTES + i * sizeof(TraceRecord)]);
+    TEST_ASSERT_EQUAL_UINT8((76 + i) & 0xFF, r->arg);
+  }
+}
+
+// beginDump() を呼ばずに dump() しても、その時点で固定して送る
+static void test_dump_without_begin() {
+  for (int i = 0; i < 3; i++) TRACE_BEGIN(TRACE_FRAME);
+  TEST_ASSERT_TRUE(trace_recorder.dump(collect, nullptr));
+  TEST_ASSERT_EQUAL_UINT32(HEADER_BYTES + 3 * sizeof(TraceRecord), output.size());
+}
+
+int main(int argc, char** argv) {
+  trace_recorder.begin();
+  UNITY_BEGIN();
+  RUN_TEST(test_size_is_frozen_before_headers);
+  RUN_TEST(test_wrapped_ring_is_sent_oldest_first);
+  RUN_TEST(test_dump_without_begin);
+  return UNITY_END();
+}